@@ -108,6 +108,22 @@ namespace AIFramework.Runner
             buffer.Push(new TurretSpinningEvent(bot, id, angle, direction));
         }
 
+        public override void UpdateTanks(long tick, GameSession.TankUpdate[] updates, 
+            Ice.Current current__)
+        {
+            foreach (GameSession.TankUpdate update in updates)
+            {
+                buffer.Push(new PlayerMoveEvent(bot, update.id, update.position, update.movementDirection));
+                buffer.Push(new PlayerRotateEvent(bot, update.id, update.angle, update.rotationDirection));
+                buffer.Push(new TurretSpinningEvent(bot, update.id, update.turretAngle, update.turretDirection));
+            }
+        }
+
+        public override void UpdateSnapshot(long tick, byte[] data, Ice.Current current__)
+        {
+            // Bots never ask for snapshot updates.
+        }
+
         public override void PlayerDamaged(int id, int projectileId, int owner,
             int damageTaken, bool killingBlow, Ice.Current current__)
         {
@@ -163,6 +163,23 @@ namespace Client.src.callbacks
             buffer.Enqueue(new TurretSpinningEvent(Game, id, angle, direction));
         }
 
+        public override void UpdateTanks(long tick, GameSession.TankUpdate[] updates, Ice.Current current__)
+        {
+            if (!ReceivingMessages())
+                return;
+
+            foreach (GameSession.TankUpdate update in updates)
+            {
+                buffer.Enqueue(new PlayerMoveEvent(Game, update.id, update.position, update.movementDirection));
+                buffer.Enqueue(new PlayerRotateEvent(Game, update.id, update.angle, update.rotationDirection));
+                buffer.Enqueue(new TurretSpinningEvent(Game, update.id, update.turretAngle, update.turretDirection));
+            }
+        }
+
+        public override void UpdateSnapshot(long tick, byte[] data, Ice.Current current__)
+        {
+            // This client never asks for snapshot updates.
+        }
 
         public override void PlayerDamaged(int id, int projectileId, int ownerId, int damageTaken, bool killingBlow,
             Ice.Current current__)
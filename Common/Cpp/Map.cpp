@@ -5,15 +5,291 @@
 
 */
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
 #include <string>
 
+#include "target.hpp"
+#if TARGET == WINTARGET
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif TARGET == LINTARGET
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "Map.hpp"
 #include "vtassert.hpp"
 
 using namespace std;
 
+//! A whole file mapped read-only into memory.
+class Mapped_File {
+private:
+    const unsigned char *data;
+    size_t               size;
+
+    Mapped_File(const Mapped_File &);
+    Mapped_File &operator=(const Mapped_File &);
+
+public:
+    Mapped_File() : data(NULL), size(0) { }
+   ~Mapped_File() { close(); }
+
+    //! Map a file. Any file mapped before is released first.
+    /*!
+     * \param file_name Name of the file.
+     * \return true if the whole file was mapped; false if it could not be opened, is empty,
+     * or could not be mapped.
+     */
+    bool open(const string &file_name)
+    {
+        close();
+#if TARGET == WINTARGET
+        const HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 ||
+                file_size.HighPart != 0) {
+            (void)CloseHandle(file);
+            return false;
+        }
+        const HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        (void)CloseHandle(file);
+        if (mapping == NULL) {
+            return false;
+        }
+        // The view keeps the mapping alive after its handle is closed.
+        void *const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        (void)CloseHandle(mapping);
+        if (view == NULL) {
+            return false;
+        }
+        data = static_cast<const unsigned char *>(view);
+        size = static_cast<size_t>(file_size.LowPart);
+#elif TARGET == LINTARGET
+        const int file = ::open(file_name.c_str(), O_RDONLY);
+        if (file < 0) {
+            return false;
+        }
+        struct stat file_status;
+        if (fstat(file, &file_status) != 0 || file_status.st_size <= 0) {
+            (void)::close(file);
+            return false;
+        }
+        // The mapping stays valid after the descriptor is closed.
+        void *const view = mmap(NULL, static_cast<size_t>(file_status.st_size), PROT_READ,
+            MAP_SHARED, file, 0);
+        (void)::close(file);
+        if (view == MAP_FAILED) {
+            return false;
+        }
+        data = static_cast<const unsigned char *>(view);
+        size = static_cast<size_t>(file_status.st_size);
+#endif
+        return true;
+    }
+
+    //! Release the mapping, if there is one.
+    void close()
+    {
+        if (data != NULL) {
+#if TARGET == WINTARGET
+            (void)UnmapViewOfFile(data);
+#elif TARGET == LINTARGET
+            (void)munmap(const_cast<unsigned char *>(data), size);
+#endif
+            data = NULL;
+            size = 0;
+        }
+    }
+
+    const unsigned char *get_data() const { return data; }
+    size_t               get_size() const { return size; }
+};
+
+unsigned int update_adler32(const unsigned int checksum, const unsigned char *data, size_t length)
+{
+    const unsigned int MODULUS = 65521;
+    // The most bytes which can be summed before the sums could overflow.
+    const size_t BLOCK_SIZE = 5552;
+
+    unsigned int a = checksum & 0xFFFF;
+    unsigned int b = checksum >> 16;
+    while (length > 0) {
+        const size_t block = min(length, BLOCK_SIZE);
+        for (size_t i = 0; i < block; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= MODULUS;
+        b %= MODULUS;
+        data += block;
+        length -= block;
+    }
+    return (b << 16) | a;
+}
+
+namespace {
+    const double DISTANCE_INFINITY = 1e20;
+
+    // Layout of the version 2 header. Every field is a 4 byte little-endian integer, except
+    // for the version byte and the signature which follows it. Unused bytes are zero.
+    const unsigned char MAPPED_SIGNATURE[7] = {'V', 'T', 'M', 'A', 'P', '\r', '\n'};
+    const int MAPPED_HEADER_SIZE_OFFSET  = 8;
+    const int MAPPED_WIDTH_OFFSET        = 12;
+    const int MAPPED_HEIGHT_OFFSET       = 16;
+    const int MAPPED_TITLE_LENGTH_OFFSET = 20;
+    const int MAPPED_MODE_COUNT_OFFSET   = 24;
+    const int MAPPED_TILE_OFFSET_OFFSET  = 28;
+    const int MAPPED_TILE_SIZE_OFFSET    = 32;
+    const int MAPPED_CHECKSUM_OFFSET     = 36;
+
+    // Read an unsigned header field.
+    size_t read_size(const unsigned char *data, const int offset)
+    {
+        return static_cast<unsigned int>(bytes_to_int(data + offset, 4));
+    }
+
+    // Compute the checksum of a whole version 2 file, with the checksum field taken as zero.
+    unsigned int compute_checksum(const unsigned char *data, const size_t length)
+    {
+        const unsigned char zero[4] = {0, 0, 0, 0};
+        unsigned int checksum = update_adler32(1, data, MAPPED_CHECKSUM_OFFSET);
+        checksum = update_adler32(checksum, zero, 4);
+        return update_adler32(checksum, data + MAPPED_CHECKSUM_OFFSET + 4,
+            length - MAPPED_CHECKSUM_OFFSET - 4);
+    }
+
+    // Tiles in files are little-endian, which is how Packed_Tile is laid out on such machines.
+    bool is_little_endian()
+    {
+        const unsigned int one = 1;
+        return *reinterpret_cast<const unsigned char *>(&one) == 1;
+    }
+
+    // Turn tiles read raw from a file into native tiles. Does nothing on little-endian machines.
+    void decode_tiles(Packed_Tile *tiles, const size_t count)
+    {
+        if (is_little_endian()) {
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const unsigned char *const bytes = reinterpret_cast<const unsigned char *>(&tiles[i]);
+            Packed_Tile tile;
+            tile.tile_id   = static_cast<unsigned int>(bytes_to_int(bytes, 4));
+            tile.object_id = static_cast<unsigned short>(bytes_to_int(bytes + 4, 2));
+            tile.event_id  = static_cast<unsigned short>(bytes_to_int(bytes + 6, 2));
+            tile.passable  = bytes[8];
+            tile.height    = bytes[9];
+            tile.type      = bytes[10];
+            tile.effect    = bytes[11];
+            tiles[i] = tile;
+        }
+    }
+
+    // Get the bytes to write for some tiles. On little-endian machines these are the tiles
+    // themselves; otherwise they are encoded into scratch.
+    const unsigned char *encode_tiles(const Packed_Tile *tiles, const size_t count,
+                                      vector<unsigned char> &scratch)
+    {
+        if (is_little_endian()) {
+            return reinterpret_cast<const unsigned char *>(tiles);
+        }
+        scratch.resize(count * TILE_BYTE_SIZE);
+        for (size_t i = 0; i < count; i++) {
+            unsigned char *const bytes = &scratch[i * TILE_BYTE_SIZE];
+            int_to_bytes(static_cast<int>(tiles[i].tile_id), bytes, 4);
+            int_to_bytes(tiles[i].object_id, bytes + 4, 2);
+            int_to_bytes(tiles[i].event_id, bytes + 6, 2);
+            bytes[8]  = tiles[i].passable;
+            bytes[9]  = tiles[i].height;
+            bytes[10] = tiles[i].type;
+            bytes[11] = tiles[i].effect;
+        }
+        return &scratch[0];
+    }
+
+    // A passable tile showing the given image, as new tiles start out.
+    Packed_Tile make_default_tile(const int tile_id)
+    {
+        Packed_Tile tile;
+        tile.tile_id   = static_cast<unsigned int>(tile_id);
+        tile.object_id = 0;
+        tile.event_id  = 0;
+        tile.passable  = 1;
+        tile.height    = 0;
+        tile.type      = 0;
+        tile.effect    = 0;
+        return tile;
+    }
+
+
+    // One dimensional squared distance transform of f (Felzenszwalb and Huttenlocher), using
+    // v and z as scratch space. v needs n entries and z needs n + 1.
+    void distance_transform(const double *f, double *d, int *v, double *z, const int n)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -DISTANCE_INFINITY;
+        z[1] = DISTANCE_INFINITY;
+        for (int q = 1; q < n; q++) {
+            double s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            while (s <= z[k]) {
+                k--;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+            }
+            k++;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = DISTANCE_INFINITY;
+        }
+
+        k = 0;
+        for (int q = 0; q < n; q++) {
+            while (z[k + 1] < q) {
+                k++;
+            }
+            d[q] = (q - v[k]) * (q - v[k]) + f[v[k]];
+        }
+    }
+
+    // Replace every cell of grid (0 for sources, DISTANCE_INFINITY otherwise) with its
+    // squared distance to the nearest source, one column and then one row at a time.
+    void distance_transform(vector<double> &grid, const int width, const int height)
+    {
+        const int longest = max(width, height);
+        vector<double> f(longest), d(longest), z(longest + 1);
+        vector<int> v(longest);
+
+        for (int x = 0; x < width; x++) {
+            for (int y = 0; y < height; y++) {
+                f[y] = grid[y * width + x];
+            }
+            distance_transform(&f[0], &d[0], &v[0], &z[0], height);
+            for (int y = 0; y < height; y++) {
+                grid[y * width + x] = d[y];
+            }
+        }
+
+        for (int y = 0; y < height; y++) {
+            distance_transform(&grid[y * width], &d[0], &v[0], &z[0], width);
+            copy(d.begin(), d.begin() + width, grid.begin() + y * width);
+        }
+    }
+}
+
 //! Default constructor.
 Map::Map()
     : map_width   (0),
@@ -23,8 +299,11 @@ Map::Map()
       default_tile(0),
       version     (0),
       supported_game_modes(),
-      tile_data   (NULL)
-      
+      tile_data   (NULL),
+      owned_tiles (),
+      mapped_file (NULL),
+      wall_bits   (),
+      distance_field()
 {
     // empty...
 }
@@ -36,23 +315,44 @@ Map::Map(const Map& obj)
       default_tile        (obj.default_tile),
       version             (obj.version),
       supported_game_modes(obj.supported_game_modes),
-      tile_data           (new Tile[static_cast<unsigned>(map_width * map_height)])
+      tile_data           (NULL),
+      owned_tiles         (),
+      mapped_file         (NULL),
+      wall_bits           (obj.wall_bits),
+      distance_field      (obj.distance_field)
 {
-    const int map_size = map_width * map_height;
-    for (int i = 0; i < map_size; i++) {
-        tile_data[i].tile_id    = obj.tile_data[i].tile_id;
-        tile_data[i].object_id  = obj.tile_data[i].object_id;
-        tile_data[i].event_id   = obj.tile_data[i].event_id;
-        tile_data[i].height     = obj.tile_data[i].height;
-        tile_data[i].type       = obj.tile_data[i].type;
-        tile_data[i].effect     = obj.tile_data[i].effect;
-        tile_data[i].passable   = obj.tile_data[i].passable;
+    // A copy always gets tiles of its own, even if the original's are mapped.
+    if (obj.tile_data != NULL) {
+        owned_tiles.assign(obj.tile_data, obj.tile_data + map_width * map_height);
+        tile_data = owned_tiles.empty() ? NULL : &owned_tiles[0];
     }
 }
 //! Destructor.
 Map::~Map()
 {
-    delete [] tile_data;
+    delete mapped_file;
+}
+
+//! Assignment operator.
+Map &Map::operator=(const Map &obj)
+{
+    if (this != &obj) {
+        Map copy(obj);
+        swap(map_width, copy.map_width);
+        swap(map_height, copy.map_height);
+        map_title.swap(copy.map_title);
+        last_error.swap(copy.last_error);
+        swap(default_tile, copy.default_tile);
+        swap(version, copy.version);
+        supported_game_modes.swap(copy.supported_game_modes);
+        // Swapping vectors keeps their buffers, so tile_data stays valid.
+        swap(tile_data, copy.tile_data);
+        owned_tiles.swap(copy.owned_tiles);
+        swap(mapped_file, copy.mapped_file);
+        wall_bits.swap(copy.wall_bits);
+        distance_field.swap(copy.distance_field);
+    }
+    return *this;
 }
 
 
@@ -73,6 +373,39 @@ string Map::get_last_error()
 }
 
 
+//! Take ownership of a new tile array.
+/*!
+ * Any mapped file is released. The caller is responsible for rebuilding the wall bits.
+ *
+ * \param tiles Tiles to use. The vector is left holding the previous tiles.
+ */
+void Map::adopt_tiles(vector<Packed_Tile> &tiles)
+{
+    owned_tiles.swap(tiles);
+    tile_data = owned_tiles.empty() ? NULL : &owned_tiles[0];
+    delete mapped_file;
+    mapped_file = NULL;
+}
+
+
+//! Get a tile which may be changed.
+/*!
+ * Mapped tiles are read-only, so they are copied the first time any tile changes.
+ *
+ * \param x The x position (column) of the tile. Must be on the map.
+ * \param y The y position (row) of the tile. Must be on the map.
+ * \return Reference to the tile.
+ */
+Packed_Tile &Map::get_writable_tile(const int x, const int y)
+{
+    if (mapped_file != NULL) {
+        vector<Packed_Tile> copy(tile_data, tile_data + map_width * map_height);
+        adopt_tiles(copy);
+    }
+    return owned_tiles[y * map_width + x];
+}
+
+
 //! Create a new map with the given details.
 /*!
  * \param width Width of the map in tiles.
@@ -94,27 +427,17 @@ bool Map::create(const int width, const int height, const string &title)
         //lint -save -e737
         // The values width and height must be positive here. Allocation request safe.
 
-        Tile *const temp_data = new Tile[width * height];
-        delete [] tile_data;
+        // Initialize every new tile in the new map.
+        vector<Packed_Tile> temp_data(width * height, make_default_tile(default_tile));
 
         // Allocation of space successful. Commit new information.
-        tile_data  = temp_data;
+        adopt_tiles(temp_data);
         map_width  = width;
         map_height = height;
         map_title  = title;
         version    = FORMAT_VERSION;
 
-        // Initialize every new tile in the new map.
-        const int map_size = map_width * map_height;
-        for (int i = 0; i < map_size; i++) {
-            tile_data[i].tile_id    = default_tile;
-            tile_data[i].object_id  = 0;
-            tile_data[i].event_id   = 0;
-            tile_data[i].passable   = true;
-            tile_data[i].height     = 0;
-            tile_data[i].type       = 0;
-            tile_data[i].effect     = 0;
-        }
+        rebuild_wall_bits();
         //lint -restore
     }
     return was_successfully_created;
@@ -123,6 +446,8 @@ bool Map::create(const int width, const int height, const string &title)
 
 //! Load a map into memory.
 /*!
+ * Both format versions can be loaded. A version 2 map is mapped into memory rather than read.
+ *
  * \param file_name Name of the file containing the map to load.
  * \return true on a successful load, false otherwise (in that case an appropriate message is
  * returned by the get_last_error() method).
@@ -131,118 +456,362 @@ bool Map::create(const int width, const int height, const string &title)
 bool Map::load(const string &input_file_name)
 {
     string file_input_name = input_file_name;
-    bool was_successfully_loaded = true;
     if (file_input_name.substr((file_input_name.size() - 6), 6) != ".vtmap") {
         file_input_name.append(".vtmap");
     }
-    fstream file(file_input_name.c_str(), ios::binary | ios::in);
+    ifstream file(file_input_name.c_str(), ios::binary | ios::in);
     if (!file) {
         last_error = "File " + file_input_name + " failed to open.";
         return false;
     }
-    // Read the map into memory.
-    char   version_byte[1];
-    string title;
-    int    width;
-    int    height;
-    string supported_game_bytes;
-    unsigned char width_bytes[4];
-    unsigned char height_bytes[4];
-
-    (void)file.read(version_byte, 1);
-    if (version_byte[0] != FORMAT_VERSION) {
-        // Version mismatch.
-        last_error = "Map " + file_input_name + " is the wrong version.";
+
+    // Both versions start with the version byte.
+    const int version_byte = file.get();
+    file.close();
+    if (version_byte == FORMAT_VERSION) {
+        return load_version_1(file_input_name);
+    }
+    if (version_byte == MAPPED_FORMAT_VERSION) {
+        return load_version_2(file_input_name);
+    }
+
+    // Version mismatch.
+    last_error = "Map " + file_input_name + " is the wrong version.";
+    return false;
+}
+
+
+//! Load a version 1 map.
+/*!
+ * The whole file is read with a single read and then parsed in memory.
+ *
+ * \param file_name Full name of the file.
+ */
+bool Map::load_version_1(const string &file_name)
+{
+    ifstream file(file_name.c_str(), ios::binary | ios::in);
+    if (!file) {
+        last_error = "File " + file_name + " failed to open.";
+        return false;
+    }
+    (void)file.seekg(0, ios::end);
+    const streamoff file_size = file.tellg();
+    (void)file.seekg(0, ios::beg);
+    if (file_size <= 0) {
+        last_error = "Map " + file_name + " is missing its header.";
+        return false;
+    }
+
+    vector<unsigned char> data(static_cast<size_t>(file_size));
+    (void)file.read(reinterpret_cast<char*>(&data[0]), static_cast<streamsize>(file_size));
+    if (file.gcount() != static_cast<streamsize>(file_size)) {
+        last_error = "File " + file_name + " could not be read.";
         return false;
     }
+    return read_version_1(&data[0], data.size(), file_name);
+}
 
-    (void)getline(file, title);
 
-    (void)file.read(reinterpret_cast<char*>(width_bytes), 4);
-    width = bytes_to_int(width_bytes, 4);
-    (void)file.read(reinterpret_cast<char*>(height_bytes), 4);
-    height = bytes_to_int(height_bytes, 4);
-    (void)getline(file, supported_game_bytes); 
+//! Parse a version 1 map held in memory.
+/*!
+ * \param data The whole map, starting with its version byte.
+ * \param size Number of bytes in 'data'.
+ * \param name Name to use for the map in error messages.
+ */
+bool Map::read_version_1(const unsigned char *const data, const size_t size, const string &name)
+{
+    // The title and the supported game modes are each ended by a new line.
+    const unsigned char *const end = data + size;
+    const unsigned char *const title_end = find(data + 1, end, '\n');
+    if (title_end == end || end - title_end < 9) {
+        last_error = "Map " + name + " is missing its header.";
+        return false;
+    }
+    const int width = bytes_to_int(title_end + 1, 4);
+    const int height = bytes_to_int(title_end + 5, 4);
+    const unsigned char *const modes = title_end + 9;
+    const unsigned char *const modes_end = find(modes, end, '\n');
+    if (modes_end == end) {
+        last_error = "Map " + name + " is missing its header.";
+        return false;
+    }
     if (width <= 0 || height <= 0) {
         last_error = "Map size cannot have a width or height less than or equal to 0";
-        was_successfully_loaded = false;
+        return false;
+    }
+
+    //lint -save -e737
+    // The values width and height must be positive here.
+    const unsigned char *const tiles = modes_end + 1;
+    const size_t tile_bytes = static_cast<size_t>(end - tiles);
+    if (static_cast<size_t>(width) > static_cast<size_t>(INT_MAX) / height ||
+            tile_bytes / TILE_BYTE_SIZE < static_cast<size_t>(width * height)) {
+        last_error = "Map " + name + " is missing tiles.";
+        return false;
+    }
+    const int map_size = width * height;
+    vector<Packed_Tile> temp_data(map_size);
+    memcpy(&temp_data[0], tiles, map_size * TILE_BYTE_SIZE);
+    decode_tiles(&temp_data[0], temp_data.size());
+
+    // Allocation of space successful. Commit new information.
+    adopt_tiles(temp_data);
+    map_width  = width;
+    map_height = height;
+    map_title.assign(reinterpret_cast<const char *>(data + 1), title_end - data - 1);
+    version    = FORMAT_VERSION;
+    supported_game_modes.clear();
+    for (const unsigned char *mode = modes; mode != modes_end; ++mode) {
+        supported_game_modes.push_back(static_cast<int>(static_cast<char>(*mode)));
+    }
+    rebuild_wall_bits();
+    //lint -restore
+    return true;
+}
+
+
+//! Load a version 1 map from memory.
+/*!
+ * This reads the same bytes a version 1 map file holds, as sent by the main server.
+ *
+ * \param data The whole map, starting with its version byte.
+ * \return true on a successful load, false otherwise (in that case an appropriate message is
+ * returned by the get_last_error() method).
+ */
+bool Map::load_from_memory(const vector<unsigned char> &data)
+{
+    if (data.empty() || data[0] != FORMAT_VERSION) {
+        last_error = "Map data is the wrong version.";
+        return false;
+    }
+    return read_version_1(&data[0], data.size(), "data");
+}
+
+
+//! Load a version 2 map.
+/*!
+ * The file is mapped into memory and checked against its checksum. On a little-endian
+ * machine the tiles are then used where they lie.
+ *
+ * \param file_name Full name of the file.
+ */
+bool Map::load_version_2(const string &file_name)
+{
+    Mapped_File *const file = new Mapped_File();
+    if (!file->open(file_name)) {
+        delete file;
+        last_error = "File " + file_name + " failed to open.";
+        return false;
+    }
+
+    const unsigned char *const data = file->get_data();
+    const size_t file_size = file->get_size();
+    const char *error = NULL;
+    size_t width = 0;
+    size_t height = 0;
+    size_t title_length = 0;
+    size_t mode_count = 0;
+    size_t tile_offset = 0;
+    if (file_size < static_cast<size_t>(MAPPED_HEADER_SIZE) ||
+            !equal(MAPPED_SIGNATURE, MAPPED_SIGNATURE + 7, data + 1)) {
+        error = " is not a map.";
     }
     else {
-        //lint -save -e737
-        // The values width and height must be positive here.
-        Tile *const temp_data = new Tile[width * height];
-        delete [] tile_data;
-        // Allocation of space successful. Commit new information.
-        tile_data  = temp_data;
-        map_width  = width;
-        map_height = height;
-        map_title  = title;
-        version    = version_byte[0];
-        supported_game_modes.clear();
-        for (string::size_type i = 0; i < supported_game_bytes.size(); i++) {
-            supported_game_modes.push_back(static_cast<int>(supported_game_bytes[i]));
-        }
-        // Read in every tile and save it locally.
-        const int map_size = width * height;
-        for (int i = 0; i < map_size; i++) {
-            unsigned char tile_buffer[TILE_BYTE_SIZE];
-            (void)file.read(reinterpret_cast<char*>(tile_buffer), TILE_BYTE_SIZE);
-            tile_data[i] = bytes_to_tile(tile_buffer);
+        const size_t header_size = read_size(data, MAPPED_HEADER_SIZE_OFFSET);
+        width = read_size(data, MAPPED_WIDTH_OFFSET);
+        height = read_size(data, MAPPED_HEIGHT_OFFSET);
+        title_length = read_size(data, MAPPED_TITLE_LENGTH_OFFSET);
+        mode_count = read_size(data, MAPPED_MODE_COUNT_OFFSET);
+        tile_offset = read_size(data, MAPPED_TILE_OFFSET_OFFSET);
+
+        // Sizes are checked by division so that nothing can overflow.
+        if (header_size < static_cast<size_t>(MAPPED_HEADER_SIZE) ||
+                read_size(data, MAPPED_TILE_SIZE_OFFSET) != static_cast<size_t>(TILE_BYTE_SIZE) ||
+                tile_offset % MAPPED_TILE_ALIGNMENT != 0 || tile_offset > file_size ||
+                title_length > tile_offset || mode_count > tile_offset - title_length ||
+                header_size > tile_offset - title_length - mode_count) {
+            error = " has a corrupt header.";
         }
-        //lint -restore
+        else if (width == 0 || height == 0 || width > static_cast<size_t>(INT_MAX) / height ||
+                (file_size - tile_offset) / TILE_BYTE_SIZE != width * height ||
+                (file_size - tile_offset) % TILE_BYTE_SIZE != 0) {
+            error = " has the wrong number of tiles.";
+        }
+        else if (read_size(data, MAPPED_CHECKSUM_OFFSET) != compute_checksum(data, file_size)) {
+            error = " is corrupt.";
+        }
+        else {
+            // Following the header are the title and the supported game modes.
+            const char *const text = reinterpret_cast<const char *>(data + header_size);
+            map_title.assign(text, title_length);
+            supported_game_modes.assign(text + title_length, text + title_length + mode_count);
+        }
+    }
+    if (error != NULL) {
+        delete file;
+        last_error = "Map " + file_name + error;
+        return false;
     }
-    return was_successfully_loaded;
+
+    //lint -save -e737
+    const Packed_Tile *const tiles = reinterpret_cast<const Packed_Tile *>(data + tile_offset);
+    if (is_little_endian()) {
+        vector<Packed_Tile> none;
+        adopt_tiles(none);
+        mapped_file = file;
+        tile_data   = tiles;
+    }
+    else {
+        vector<Packed_Tile> temp_data(tiles, tiles + width * height);
+        decode_tiles(&temp_data[0], temp_data.size());
+        adopt_tiles(temp_data);
+        delete file;
+    }
+    map_width  = static_cast<int>(width);
+    map_height = static_cast<int>(height);
+    version    = MAPPED_FORMAT_VERSION;
+    rebuild_wall_bits();
+    //lint -restore
+    return true;
 }
 
 
 //! Save a map to the hard drive.
 /*!
- * Saves the map to disk.
+ * Saves the map to disk. Version 1 is the format clients read. Version 2 is only read by the
+ * game server; it must not be saved over a file which a Map currently has mapped.
  *
  * \param file_name The name of the file into which the map will be saved.
+ * \param format_version Either FORMAT_VERSION or MAPPED_FORMAT_VERSION.
  * \return true on successful save; false otherwise (in that case an appropriate message is
  * returned by the get_last_error() method).
  */
-bool Map::save(const string &output_file_name)
+bool Map::save(const string &output_file_name, const int format_version)
 {
     string file_output_name = output_file_name;
     VTANK_ASSERT(tile_data != NULL);
     if(file_output_name.substr((file_output_name.size()-6), 6) != ".vtmap") {
         file_output_name.append(".vtmap");
     }
+    VTANK_ASSERT(map_width  > 0);
+    VTANK_ASSERT(map_height > 0);
+    if (format_version == FORMAT_VERSION) {
+        return save_version_1(file_output_name);
+    }
+    if (format_version == MAPPED_FORMAT_VERSION) {
+        return save_version_2(file_output_name);
+    }
+    last_error = "Cannot save a map in an unknown format version";
+    return false;
+}
+
+
+//! Save the map in version 1 format.
+/*!
+ * \param file_name Full name of the file.
+ */
+bool Map::save_version_1(const string &file_name)
+{
     // Open the file for output, for binary writing, and replace old data with new data.
-    fstream file(file_output_name.c_str(), ios::binary | ios::out);
+    ofstream file(file_name.c_str(), ios::binary | ios::out | ios::trunc);
     if (!file) {
-        last_error = "The file " + file_output_name + " failed to open";
+        last_error = "The file " + file_name + " failed to open";
         return false;
     }
+    vector<unsigned char> data;
+    (void)save_to_memory(data);
+    (void)file.write(reinterpret_cast<const char *>(&data[0]), static_cast<streamsize>(data.size()));
+    if (!file) {
+        last_error = "The file " + file_name + " could not be written";
+        return false;
+    }
+    return true;
+}
+
+
+//! Write the map in version 1 format into memory.
+/*!
+ * The bytes are exactly those save() writes to a version 1 file.
+ *
+ * \param data Replaced with the whole map.
+ * \return true; there is nothing which can fail short of running out of memory.
+ * \throws bad_alloc thrown if memory is exhausted.
+ */
+bool Map::save_to_memory(vector<unsigned char> &data) const
+{
+    VTANK_ASSERT(tile_data != NULL);
     VTANK_ASSERT(map_width  > 0);
     VTANK_ASSERT(map_height > 0);
-    file << static_cast<char>(version); 
-    file << map_title << '\n';
-    // Convert the map width and map height to it's byte form and write it to the file.
-    std::vector<unsigned char> bytes = int_to_bytes(map_width);
-    file << bytes[0];
-    file << bytes[1];
-    file << bytes[2];
-    file << bytes[3];
-    bytes = int_to_bytes(map_height);
-    file << bytes[0];
-    file << bytes[1];
-    file << bytes[2];
-    file << bytes[3];
+    data.clear();
+    data.push_back(static_cast<unsigned char>(FORMAT_VERSION));
+    data.insert(data.end(), map_title.begin(), map_title.end());
+    data.push_back('\n');
+    // Convert the map width and map height to it's byte form.
+    unsigned char size_bytes[8];
+    int_to_bytes(map_width, size_bytes, 4);
+    int_to_bytes(map_height, size_bytes + 4, 4);
+    data.insert(data.end(), size_bytes, size_bytes + 8);
     for (std::vector<int>::size_type i = 0; i < supported_game_modes.size(); i++) {
-        file << static_cast<char>(supported_game_modes[i]);
+        data.push_back(static_cast<unsigned char>(supported_game_modes[i]));
     }
-    file << '\n';
-    // Now write out the tile data.  
-    // Loop through each tile, convert the tile to it's byte form and write it out.
-    const int map_size = map_width * map_height;
-    for (int i = 0; i < map_size; i++) {
-        bytes = tile_to_bytes(tile_data[i]);
-        for (std::vector<unsigned char>::size_type j = 0; j < bytes.size(); j++) {
-            file << bytes[j];
-        }
+    data.push_back('\n');
+
+    // Now add the tile data in one go.
+    vector<unsigned char> scratch;
+    const size_t map_size = static_cast<size_t>(map_width * map_height);
+    const unsigned char *const tiles = encode_tiles(tile_data, map_size, scratch);
+    data.insert(data.end(), tiles, tiles + map_size * TILE_BYTE_SIZE);
+    return true;
+}
+
+
+//! Save the map in version 2 format.
+/*!
+ * \param file_name Full name of the file.
+ */
+bool Map::save_version_2(const string &file_name)
+{
+    const size_t title_length = map_title.size();
+    const size_t mode_count   = supported_game_modes.size();
+    const size_t map_size     = static_cast<size_t>(map_width * map_height);
+    const size_t tile_offset  = (MAPPED_HEADER_SIZE + title_length + mode_count +
+        MAPPED_TILE_ALIGNMENT - 1) / MAPPED_TILE_ALIGNMENT * MAPPED_TILE_ALIGNMENT;
+
+    // Everything before the tiles is built in memory; the checksum is filled in last.
+    vector<unsigned char> file_data(tile_offset, 0);
+    file_data[0] = static_cast<unsigned char>(MAPPED_FORMAT_VERSION);
+    copy(MAPPED_SIGNATURE, MAPPED_SIGNATURE + 7, file_data.begin() + 1);
+    int_to_bytes(MAPPED_HEADER_SIZE, &file_data[MAPPED_HEADER_SIZE_OFFSET], 4);
+    int_to_bytes(map_width, &file_data[MAPPED_WIDTH_OFFSET], 4);
+    int_to_bytes(map_height, &file_data[MAPPED_HEIGHT_OFFSET], 4);
+    int_to_bytes(static_cast<int>(title_length), &file_data[MAPPED_TITLE_LENGTH_OFFSET], 4);
+    int_to_bytes(static_cast<int>(mode_count), &file_data[MAPPED_MODE_COUNT_OFFSET], 4);
+    int_to_bytes(static_cast<int>(tile_offset), &file_data[MAPPED_TILE_OFFSET_OFFSET], 4);
+    int_to_bytes(TILE_BYTE_SIZE, &file_data[MAPPED_TILE_SIZE_OFFSET], 4);
+    copy(map_title.begin(), map_title.end(), file_data.begin() + MAPPED_HEADER_SIZE);
+    for (size_t i = 0; i < mode_count; i++) {
+        file_data[MAPPED_HEADER_SIZE + title_length + i] =
+            static_cast<unsigned char>(supported_game_modes[i]);
+    }
+
+    vector<unsigned char> scratch;
+    const unsigned char *const tile_bytes = encode_tiles(tile_data, map_size, scratch);
+    unsigned int checksum = update_adler32(1, &file_data[0], file_data.size());
+    checksum = update_adler32(checksum, tile_bytes, map_size * TILE_BYTE_SIZE);
+    int_to_bytes(static_cast<int>(checksum), &file_data[MAPPED_CHECKSUM_OFFSET], 4);
+
+    ofstream file(file_name.c_str(), ios::binary | ios::out | ios::trunc);
+    if (!file) {
+        last_error = "The file " + file_name + " failed to open";
+        return false;
+    }
+    (void)file.write(reinterpret_cast<const char *>(&file_data[0]),
+        static_cast<streamsize>(file_data.size()));
+    (void)file.write(reinterpret_cast<const char *>(tile_bytes),
+        static_cast<streamsize>(map_size * TILE_BYTE_SIZE));
+    if (!file) {
+        last_error = "The file " + file_name + " could not be written";
+        return false;
     }
     return true;
 }
@@ -273,30 +842,17 @@ bool Map::resize(const int width, const int height)
     else {
         //lint -save -e737
         // The values width and height must be positive here. Allocation request safe.
-        Tile *const temp = new Tile[width * height];
+        vector<Packed_Tile> temp(width * height, make_default_tile(default_tile));
         // Prepare new map. Copy parts of old map as appropriate.
-        int i = 0;
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                if (x < map_width && y < map_height) {
-                    temp[i] = tile_data[y * map_width + x];
-                }
-                else {
-                    temp[i].tile_id   = default_tile;
-                    temp[i].object_id = 0;
-                    temp[i].event_id  = 0;
-                    temp[i].passable  = true;
-                    temp[i].height    = 0;
-                    temp[i].type      = 0;
-                    temp[i].effect    = 0;
-                }
-                i++;
-            }
+        const int copy_width = min(width, map_width);
+        for (int y = 0; y < height && y < map_height; ++y) {
+            copy(tile_data + y * map_width, tile_data + y * map_width + copy_width,
+                temp.begin() + y * width);
         }
-        delete [] tile_data;
-        tile_data  = temp;
+        adopt_tiles(temp);
         map_width  = width;
         map_height = height;
+        rebuild_wall_bits();
         //lint -restore
     }
     return was_successfully_resized;
@@ -356,7 +912,7 @@ Tile Map::get_tile(int x, int y) const
     if (x >= map_width || y >= map_height || x < 0 || y < 0) {
         throw OutOfBoundsException("Attempting to access a tile out of bounds", x, y);
     }
-    return tile_data[y * map_width + x];
+    return unpack_tile(tile_data[y * map_width + x]);
 }
 
 bool Map::set_tile(int x, int y, int ter_id, bool collision, short obj_id, short evt_id, int height, int type, int effect)
@@ -391,7 +947,7 @@ bool Map::set_tile_id(const int x, const int y, const int id)
         last_error = "Invalid tile id";
         return false;
     }
-    tile_data[y * map_width + x].tile_id = id;
+    get_writable_tile(x, y).tile_id = static_cast<unsigned int>(id);
     return true;
 }
 
@@ -414,7 +970,18 @@ bool Map::set_tile_collision(const int x, const int y, const bool is_passable)
         last_error = "Attempting to access a tile out of bounds";
         return false;
     }
-    tile_data[y * map_width + x].passable = is_passable;
+    const unsigned int index = static_cast<unsigned int>(y * map_width + x);
+    if ((tile_data[index].passable != 0) != is_passable) {
+        get_writable_tile(x, y).passable = is_passable ? 1 : 0;
+        if (is_passable) {
+            wall_bits[index >> 5] &= ~(1u << (index & 31));
+        }
+        else {
+            wall_bits[index >> 5] |= 1u << (index & 31);
+        }
+        // The distance field no longer describes this map.
+        distance_field.clear();
+    }
     return true;
 }
 
@@ -434,7 +1001,7 @@ bool Map::set_tile_object(const int x, const int y, const short id)
         last_error = "Invalid object id";
         return false;
     }
-    tile_data[y * map_width + x].object_id = id;
+    get_writable_tile(x, y).object_id = static_cast<unsigned short>(id);
     return true;
 }
 
@@ -454,7 +1021,7 @@ bool Map::set_tile_event(const int x, const int y, const short id)
         last_error = "Invalid event id";
         return false;
     }
-    tile_data[y * map_width + x].event_id = id;
+    get_writable_tile(x, y).event_id = static_cast<unsigned short>(id);
     return true;
 }
 
@@ -470,7 +1037,7 @@ bool Map::set_tile_height(const int x, const int y, const int height)
         last_error = "Attempting to access a tile out of bounds";
         return false;
     }
-    tile_data[y * map_width + x].height = height;
+    get_writable_tile(x, y).height = static_cast<unsigned char>(height);
     return true;
 }
 
@@ -490,7 +1057,7 @@ bool Map::set_tile_type(const int x, const int y, const int type)
         last_error = "Invalid tile type";
         return false;
     }
-    tile_data[y * map_width + x].type = type;
+    get_writable_tile(x, y).type = static_cast<unsigned char>(type);
     return true;
 }
 
@@ -510,7 +1077,7 @@ bool Map::set_tile_effect(const int x, const int y, const int effect)
         last_error = "Invalid tile effect";
         return false;
     }
-    tile_data[y * map_width + x].effect = effect;
+    get_writable_tile(x, y).effect = static_cast<unsigned char>(effect);
     return true;
 }
 
@@ -532,7 +1099,7 @@ bool Map::get_tile_collision(const int x, const int y)
         last_error = "Attempting to access a tile out of bounds";
         return false;
     }
-    return tile_data[y * map_width + x].passable;
+    return tile_data[y * map_width + x].passable != 0;
 }
 
 //! Get the tile object id.
@@ -778,3 +1345,67 @@ void Map::validate_supported_game_modes()
         }
     }
 }
+
+
+//! Rebuild the packed wall bits from the tile data.
+/*!
+ * Called whenever the tile data is replaced. Any distance field is discarded.
+ */
+void Map::rebuild_wall_bits()
+{
+    const unsigned int map_size = static_cast<unsigned int>(map_width * map_height);
+    wall_bits.assign((map_size + 31) / 32, 0);
+    for (unsigned int i = 0; i < map_size; i++) {
+        if (!tile_data[i].passable) {
+            wall_bits[i >> 5] |= 1u << (i & 31);
+        }
+    }
+    distance_field.clear();
+}
+
+
+//! Precompute the distance from every tile to the nearest wall.
+/*!
+ * For a passable tile, the distance field holds the Euclidean distance in tiles from its
+ * center to the center of the nearest wall. For a wall it holds the negated distance to the
+ * nearest passable tile. The field is discarded if the map's walls change.
+ *
+ * \throws bad_alloc thrown if memory exhausted while building the field.
+ */
+void Map::build_distance_field()
+{
+    VTANK_ASSERT(tile_data != NULL);
+    const int map_size = map_width * map_height;
+    vector<double> to_wall(map_size);
+    vector<double> to_open(map_size);
+    for (int i = 0; i < map_size; i++) {
+        const bool wall = !tile_data[i].passable;
+        to_wall[i] = wall ? 0.0 : DISTANCE_INFINITY;
+        to_open[i] = wall ? DISTANCE_INFINITY : 0.0;
+    }
+
+    distance_transform(to_wall, map_width, map_height);
+    distance_transform(to_open, map_width, map_height);
+
+    distance_field.resize(map_size);
+    for (int i = 0; i < map_size; i++) {
+        distance_field[i] = tile_data[i].passable ? 
+            static_cast<float>(sqrt(to_wall[i])) : -static_cast<float>(sqrt(to_open[i]));
+    }
+}
+
+
+//! Get the distance from a tile to the nearest wall.
+/*!
+ * \param x The x position (column) of the tile.
+ * \param y The y position (row) of the tile.
+ * \return Distance in tiles, negative inside walls (see build_distance_field()). Returns 0 if
+ * the tile is not on the map or there is no distance field.
+ */
+float Map::get_wall_distance(const int x, const int y) const
+{
+    if (distance_field.empty() || x >= map_width || y >= map_height || x < 0 || y < 0) {
+        return 0.0f;
+    }
+    return distance_field[y * map_width + x];
+}
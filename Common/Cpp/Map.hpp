@@ -14,8 +14,21 @@
 #include "vtassert.hpp"
 
 //! The format version of the map. If the format changes, this number should increment.
+/*!
+ * Map::save() writes this version unless asked for another, since it is the only one
+ * clients and the main server read.
+ */
 const int FORMAT_VERSION = 1;
 
+//! The memory-mappable format, read by the game server. \see Map::save()
+const int MAPPED_FORMAT_VERSION = 2;
+
+//! Size of the fixed header at the start of a version 2 map.
+const int MAPPED_HEADER_SIZE = 64;
+
+//! The tile array of a version 2 map starts on a multiple of this many bytes.
+const int MAPPED_TILE_ALIGNMENT = 64;
+
 //! The external tile size must be 12 because of how it writes tiles to disc.
 const int TILE_BYTE_SIZE = 12;
 
@@ -89,22 +102,20 @@ inline bool operator!=(const Tile &left, const Tile &right)
 {
     return !(left == right);
 }
-//! Convert an int to it's unsigned character equivalent.
+
+//! Write the low bytes of an int in little-endian order.
 /*!
-    Convert an integer to it's byte-form equivalent. The returned vector will always consist of 4 bytes.
+    Write an integer in it's byte-form equivalent without allocating anything.
     \param n Number to convert.
-    \return Vector of unsigned character values.
+    \param bytes Where to write the bytes.
+    \param how_many_bytes How many of the low bytes of n to write (at most 4).
 */
-static const std::vector<unsigned char> int_to_bytes(const int n)
+inline void int_to_bytes(const int n, unsigned char *const bytes, const int how_many_bytes)
 {
     const unsigned int x = static_cast<unsigned>(n);
-    std::vector<unsigned char> bytes(4);
-    bytes[0] = x         & 0xFF;
-    bytes[1] = (x >> 8 ) & 0xFF;
-    bytes[2] = (x >> 16) & 0xFF;
-    bytes[3] = (x >> 24) & 0xFF;
-    
-    return bytes;
+    for (int i = 0; i < how_many_bytes; i++) {
+        bytes[i] = static_cast<unsigned char>((x >> (8 * i)) & 0xFF);
+    }
 }
 
 //! Convert 4 bytes back into an integer.
@@ -112,73 +123,66 @@ static const std::vector<unsigned char> int_to_bytes(const int n)
     Convert 4 bytes back into it's integer form. Note that this method is not as safe as
     the overloaded one because this doesn't perform bounds checks.
     \param bytes Bytes to convert to an integer.
-    \return Result of the conversion.
+    \param how_many_bytes Either 2 or 4.
+    \return Result of the conversion, or -1 for any other number of bytes.
 */
-static const int bytes_to_int(const unsigned char *const bytes, int how_many_bytes)
+inline const int bytes_to_int(const unsigned char *const bytes, int how_many_bytes)
 { 
-    std::vector<unsigned char> byte_vector(static_cast<unsigned>(how_many_bytes));
-    for (unsigned int i = 0; i < static_cast<unsigned>(how_many_bytes); i++) {
-        byte_vector[i] = bytes[i];
-    }
-    unsigned int value = -1;
-    if(byte_vector.size() == 2)
-        value = (byte_vector[0]) + ((byte_vector[1]) << 8);
-    if(byte_vector.size() == 4)
-        value = (byte_vector[0]) + ((byte_vector[1]) << 8) + 
-        ((byte_vector[2]) << 16) + ((byte_vector[3]) << 24);
+    unsigned int value = static_cast<unsigned int>(-1);
+    if (how_many_bytes == 2)
+        value = bytes[0] | (bytes[1] << 8);
+    if (how_many_bytes == 4)
+        value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+            (static_cast<unsigned int>(bytes[3]) << 24);
     return static_cast<int>(value);
 }
 
+//! Continue an Adler-32 checksum over some more bytes.
+/*!
+    The checksum of version 2 maps and of compressed maps.
+    \param checksum Checksum of the bytes before these; start a new checksum with 1.
+    \param data Bytes to add.
+    \param length Number of bytes to add.
+    \return Checksum of everything so far.
+*/
+unsigned int update_adler32(const unsigned int checksum, const unsigned char *data, size_t length);
 
-static const Tile bytes_to_tile(const unsigned char *const bytes)
+//! A tile as it is stored in memory and on disc.
+/*!
+ * The fields are laid out exactly like the TILE_BYTE_SIZE bytes of a tile in a map file,
+ * so on a little-endian machine the tile array of a file can be used in place. Fields are
+ * as wide as the file allows: values set on a tile are truncated to fit, just as they
+ * always were when the map was saved.
+ */
+struct Packed_Tile
 {
-    Tile t;
-    t.tile_id   = bytes_to_int(bytes, 4);
-    t.object_id = bytes_to_int((bytes + 4), 2);
-    t.event_id  = bytes_to_int((bytes + 6), 2);
-    t.passable  = bytes[8] == 0 ? false : true;
-    t.height    = bytes[9];
-    t.type      = bytes[10];
-    t.effect    = bytes[11];
-    return t;
-}
+    unsigned int   tile_id;
+    unsigned short object_id;
+    unsigned short event_id;
+    unsigned char  passable;
+    unsigned char  height;
+    unsigned char  type;
+    unsigned char  effect;
+};
 
-//! Convert a tile to it's equivalent byte form.
-/*!
-    Convert a tile from it's native struct to the equivalent byte form.
-    \param tile Tile to convert.
-    \return Converted vector containing the new bytes.
-*/
-static const std::vector<unsigned char> tile_to_bytes(const Tile &tile)
+// Fails to compile if the compiler pads Packed_Tile.
+typedef char packed_tile_size_check[sizeof(Packed_Tile) == TILE_BYTE_SIZE ? 1 : -1];
+
+//! Expand a packed tile.
+inline Tile unpack_tile(const Packed_Tile &packed)
 {
-    std::vector<unsigned char> bytes(TILE_BYTE_SIZE);
-    unsigned int j = 0;
-    
-    std::vector<unsigned char> temp_bytes = int_to_bytes(tile.tile_id);
-    for (unsigned int i = 0; i < 4; i++, j++) {
-        bytes[j] = temp_bytes[i];
-    }
-    
-    temp_bytes = int_to_bytes(tile.object_id);
-    for (unsigned int i = 0; i < 2; i++, j++) {
-        bytes[j] = temp_bytes[i];
-    }
-    
-    temp_bytes = int_to_bytes(tile.event_id);
-    for (unsigned int i = 0; i < 2; i++, j++) {
-        bytes[j] = temp_bytes[i];
-    }
-    
-    bytes[j++] = static_cast<unsigned char>(tile.passable ? 0x01 : 0x00);
-    bytes[j++] = static_cast<unsigned char>(tile.height);
-    bytes[j++] = static_cast<unsigned char>(tile.type);
-    bytes[j++] = static_cast<unsigned char>(tile.effect);
-    
-    return bytes;
+    Tile t;
+    t.tile_id   = static_cast<int>(packed.tile_id);
+    t.object_id = packed.object_id;
+    t.event_id  = packed.event_id;
+    t.passable  = packed.passable != 0;
+    t.height    = packed.height;
+    t.type      = packed.type;
+    t.effect    = packed.effect;
+    return t;
 }
 
 
-
 //! A special exception for trying to access an out-of-bounds tile.
 /*!
  * The Out Of Bounds Exception is thrown from functions called where it cannot necessarily
@@ -215,10 +219,13 @@ public:
 };
 
 
+class Mapped_File;
+
 //! Representation of a map.
 /**
  * The Map class tracks tile data on an (x, y) basis. When the map is loaded, tiles are brought
- * into a 2D array.
+ * into a 2D array. A version 2 map file is mapped into memory instead, and its tiles are used
+ * where they lie until the first change to a tile, which copies them.
  *
  * In general if a method of this class encounters an error condition, it returns an appropriate
  * error code (often 'false') and records a user friendly error message that can be retrieved
@@ -235,18 +242,42 @@ private:
     int              default_tile;
     int              version;
     std::vector<int> supported_game_modes;
-    Tile             *tile_data;
+
+    // Either points into owned_tiles, or into the file mapped by mapped_file.
+    const Packed_Tile        *tile_data;
+    std::vector<Packed_Tile> owned_tiles;
+    Mapped_File              *mapped_file;
+
+    // One bit per tile, set when the tile is not passable.
+    std::vector<unsigned int> wall_bits;
+
+    // Signed distance in tiles from each tile to the nearest tile of the other kind.
+    // Empty until build_distance_field() is called.
+    std::vector<float> distance_field;
+
+    void rebuild_wall_bits();
+    void adopt_tiles(std::vector<Packed_Tile> &tiles);
+    Packed_Tile &get_writable_tile(const int x, const int y);
+    bool load_version_1(const std::string &file_name);
+    bool read_version_1(const unsigned char *data, std::size_t size, const std::string &name);
+    bool load_version_2(const std::string &file_name);
+    bool save_version_1(const std::string &file_name);
+    bool save_version_2(const std::string &file_name);
 
 public:
     Map();
     Map(const Map& obj);
    ~Map();
 
+    Map &operator=(const Map &obj);
+
     std::string get_last_error();
 
     bool create(int width, int height, const std::string &title);
     bool load  (const std::string &file_name);
-    bool save  (const std::string &file_name);
+    bool save  (const std::string &file_name, const int format_version = FORMAT_VERSION);
+    bool load_from_memory(const std::vector<unsigned char> &data);
+    bool save_to_memory  (std::vector<unsigned char> &data) const;
     bool resize(int width, int height);
 
     void        set_title(const std::string &title);
@@ -285,6 +316,29 @@ public:
     void validate_supported_game_modes();
     
     const int  get_version() const { return static_cast<int>(version); }
+
+    //! Check whether the tiles are being read straight from a mapped version 2 file.
+    bool is_mapped() const { return mapped_file != NULL; }
+
+    //! Check whether a tile is a wall, without copying the tile.
+    /*!
+     * \param x The x position (column) of the tile.
+     * \param y The y position (row) of the tile.
+     * \return true if the tile is on the map and not passable; false otherwise.
+     */
+    bool is_wall(const int x, const int y) const
+    {
+        if (static_cast<unsigned int>(x) >= static_cast<unsigned int>(map_width) ||
+            static_cast<unsigned int>(y) >= static_cast<unsigned int>(map_height)) {
+            return false;
+        }
+        const unsigned int index = static_cast<unsigned int>(y * map_width + x);
+        return ((wall_bits[index >> 5] >> (index & 31)) & 1) != 0;
+    }
+
+    void  build_distance_field();
+    bool  has_distance_field() const { return !distance_field.empty(); }
+    float get_wall_distance(const int x, const int y) const;
 };
 
 #endif
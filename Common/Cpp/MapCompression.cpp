@@ -0,0 +1,258 @@
+/*!
+    \file   MapCompression.cpp
+    \brief  Implementation of the map compression used for transfers.
+    \author (C) Copyright 2010 by Vermont Technical College
+
+*/
+
+#include <algorithm>
+#include <climits>
+#include <string>
+#include <vector>
+
+#include "MapCompression.hpp"
+#include "Map.hpp"
+#include "vtassert.hpp"
+
+using namespace std;
+
+namespace {
+
+    // Number of slots in the table of recently seen four byte sequences.
+    const size_t HASH_BITS = 16;
+
+    // Most output decompress() reserves before it has seen the tokens.
+    const size_t MAX_RESERVE = 16777216;
+
+    void write_number(vector<unsigned char> &out, size_t value)
+    {
+        while (value >= 0x80) {
+            out.push_back(static_cast<unsigned char>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<unsigned char>(value));
+    }
+
+    bool read_number(const vector<unsigned char> &in, size_t &position, size_t &value)
+    {
+        value = 0;
+        for (unsigned int shift = 0; position < in.size(); shift += 7) {
+            if (shift > sizeof(size_t) * CHAR_BIT - 7) {
+                return false;
+            }
+            const unsigned char byte = in[position++];
+            value |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void write_uint32(vector<unsigned char> &out, const unsigned long value)
+    {
+        for (int i = 0; i < 4; i++) {
+            out.push_back(static_cast<unsigned char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    unsigned long read_uint32(const vector<unsigned char> &in, const size_t position)
+    {
+        unsigned long value = 0;
+        for (int i = 3; i >= 0; i--) {
+            value = (value << 8) | in[position + i];
+        }
+        return value;
+    }
+
+    void write_literals(vector<unsigned char> &out, const unsigned char *begin,
+                        const unsigned char *end)
+    {
+        if (begin != end) {
+            write_number(out, static_cast<size_t>(end - begin) * 2);
+            out.insert(out.end(), begin, end);
+        }
+    }
+
+    size_t hash_of(const unsigned char *bytes)
+    {
+        const unsigned long value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+            (static_cast<unsigned long>(bytes[3]) << 24);
+        return static_cast<size_t>(((value * 2654435761UL) & 0xFFFFFFFFUL) >> (32 - HASH_BITS));
+    }
+}
+
+namespace MapCompression {
+
+    //! Compress a map.
+    /*!
+     * Greedy matching against the last place each four byte sequence was seen. That finds
+     * the previous tile for a run of tiles, which is where nearly all of the saving is.
+     *
+     * \param data Map to compress, usually the bytes of a version 1 map file.
+     * \param compressed Replaced with the compressed map.
+     */
+    void compress(const vector<unsigned char> &data, vector<unsigned char> &compressed)
+    {
+        compressed.clear();
+        write_uint32(compressed, static_cast<unsigned long>(data.size()));
+        write_uint32(compressed, update_adler32(1, data.empty() ? NULL : &data[0], data.size()));
+        if (data.empty()) {
+            return;
+        }
+
+        const unsigned char *const begin = &data[0];
+        const unsigned char *const end = begin + data.size();
+        vector<size_t> last_seen(static_cast<size_t>(1) << HASH_BITS, 0);
+
+        const unsigned char *literals = begin;
+        const unsigned char *position = begin;
+        while (end - position >= MIN_MATCH) {
+            const size_t hash = hash_of(position);
+            const size_t candidate = last_seen[hash];
+            last_seen[hash] = static_cast<size_t>(position - begin) + 1;
+            if (candidate == 0) {
+                ++position;
+                continue;
+            }
+
+            const unsigned char *const earlier = begin + candidate - 1;
+            size_t length = 0;
+            while (position + length < end && earlier[length] == position[length]) {
+                ++length;
+            }
+            if (length < static_cast<size_t>(MIN_MATCH)) {
+                ++position;
+                continue;
+            }
+
+            write_literals(compressed, literals, position);
+            write_number(compressed, (length - MIN_MATCH) * 2 + 1);
+            write_number(compressed, static_cast<size_t>(position - earlier));
+
+            // Remember where the copied bytes were, so later matches can start inside them.
+            const unsigned char *const match_end = position + length;
+            for (++position; position < match_end && end - position >= MIN_MATCH; ++position) {
+                last_seen[hash_of(position)] = static_cast<size_t>(position - begin) + 1;
+            }
+            position = match_end;
+            literals = position;
+        }
+        write_literals(compressed, literals, end);
+    }
+
+
+    //! Expand a compressed map.
+    /*!
+     * \param compressed Map made by compress().
+     * \param data Replaced with the original map.
+     * \return true if the map was expanded and matched its checksum; false if it is damaged.
+     */
+    bool decompress(const vector<unsigned char> &compressed, vector<unsigned char> &data)
+    {
+        data.clear();
+        if (compressed.size() < static_cast<size_t>(HEADER_SIZE)) {
+            return false;
+        }
+        const size_t size = read_uint32(compressed, 0);
+        const unsigned long checksum = read_uint32(compressed, 4);
+        // The size comes from the sender, so don't let it reserve an absurd amount up front.
+        data.reserve(min(size, static_cast<size_t>(MAX_RESERVE)));
+
+        size_t position = HEADER_SIZE;
+        while (position < compressed.size()) {
+            size_t token = 0;
+            if (!read_number(compressed, position, token)) {
+                return false;
+            }
+            const size_t length = token / 2;
+            if (token % 2 == 0) {
+                if (length == 0 || length > compressed.size() - position ||
+                        length > size - data.size()) {
+                    return false;
+                }
+                data.insert(data.end(), compressed.begin() + position,
+                    compressed.begin() + position + length);
+                position += length;
+            }
+            else {
+                size_t distance = 0;
+                const size_t copy_length = length + MIN_MATCH;
+                if (!read_number(compressed, position, distance) || distance == 0 ||
+                        distance > data.size() || copy_length > size - data.size()) {
+                    return false;
+                }
+                // Byte by byte, since the copy may overlap the bytes it produces.
+                size_t from = data.size() - distance;
+                for (size_t i = 0; i < copy_length; i++) {
+                    data.push_back(data[from++]);
+                }
+            }
+        }
+        return data.size() == size &&
+            update_adler32(1, data.empty() ? NULL : &data[0], data.size()) == checksum;
+    }
+
+
+    Chunk_Receiver::Chunk_Receiver()
+        : total_size(0)
+    {
+    }
+
+
+    //! Forget everything received, so the next chunk must start the map.
+    void Chunk_Receiver::reset()
+    {
+        digest.clear();
+        compressed.clear();
+        total_size = 0;
+    }
+
+
+    //! Add the next chunk of the map.
+    /*!
+     * A chunk for another version of the map (a different digest or size) starts the
+     * transfer again, and is only kept if it is the start of that version.
+     *
+     * \param chunk_digest Digest of the map which the chunk belongs to.
+     * \param chunk_total_size Size of the whole compressed map.
+     * \param chunk_offset Where the chunk starts in the compressed map.
+     * \param chunk_data Bytes of the chunk.
+     * \return true if the chunk was kept; false if it didn't follow on from the last chunk,
+     * in which case get_offset() says where the next one should start.
+     */
+    bool Chunk_Receiver::add_chunk(const string &chunk_digest, const int chunk_total_size,
+                                   const int chunk_offset, const vector<unsigned char> &chunk_data)
+    {
+        if (chunk_total_size < HEADER_SIZE || chunk_offset < 0) {
+            return false;
+        }
+        const size_t chunk_total = static_cast<size_t>(chunk_total_size);
+        if (chunk_digest != digest || chunk_total != total_size) {
+            reset();
+            digest = chunk_digest;
+            total_size = chunk_total;
+        }
+        if (static_cast<size_t>(chunk_offset) != compressed.size() ||
+                chunk_data.size() > total_size - compressed.size()) {
+            return false;
+        }
+        compressed.insert(compressed.end(), chunk_data.begin(), chunk_data.end());
+        return true;
+    }
+
+
+    //! Expand the map once every chunk has arrived.
+    /*!
+     * \param data Replaced with the map.
+     * \return true on success; false if the transfer isn't complete or the map is damaged.
+     */
+    bool Chunk_Receiver::finish(vector<unsigned char> &data) const
+    {
+        if (!is_complete()) {
+            data.clear();
+            return false;
+        }
+        return decompress(compressed, data);
+    }
+}
@@ -0,0 +1,76 @@
+/*!
+    \file   MapCompression.hpp
+    \brief  Compression of map files for transfer, and reassembly of the chunks they are sent in.
+    \author (C) Copyright 2010 by Vermont Technical College
+
+*/
+
+#ifndef MAPCOMPRESSION_HPP
+#define MAPCOMPRESSION_HPP
+
+#include <string>
+#include <vector>
+
+//! Compression used to send maps between the servers and the map editor.
+/*!
+ * A compressed map is laid out as follows (all fixed size integers are little-endian):
+ *
+ *   [4] Size of the original map
+ *   [4] Adler-32 of the original map
+ *   followed by tokens until the end. Each token starts with a variable length integer T
+ *   (seven bits per byte, low bits first, the top bit set on every byte but the last).
+ *   If T is even, T / 2 bytes follow which are copied out as they are. If T is odd, another
+ *   variable length integer D follows, and T / 2 + MIN_MATCH bytes are copied from D bytes
+ *   back in the output. The copy may overlap what it produces.
+ *
+ * Nearly every tile of a map is the same twelve bytes as the one before it, so a run of
+ * tiles costs a few bytes. Server/Main/lib/Map_Compression.py reads and writes the same
+ * format.
+ */
+namespace MapCompression {
+
+    //! Shortest copy a token describes.
+    const int MIN_MATCH = 4;
+
+    //! Size of the header in front of the tokens.
+    const int HEADER_SIZE = 8;
+
+    //! Largest chunk of a compressed map asked for or sent at once.
+    const int MAX_CHUNK_SIZE = 262144;
+
+    void compress(const std::vector<unsigned char> &data, std::vector<unsigned char> &compressed);
+    bool decompress(const std::vector<unsigned char> &compressed, std::vector<unsigned char> &data);
+
+    //! Collects the chunks of a compressed map as they arrive.
+    /*!
+     * Chunks must arrive in order, but a transfer which fails part way can carry on from
+     * get_offset() rather than starting again. If the map changes on the server while it is
+     * being fetched, its digest changes and the transfer starts over.
+     */
+    class Chunk_Receiver {
+    private:
+        std::string digest;
+        std::vector<unsigned char> compressed;
+        std::size_t total_size;
+
+    public:
+        Chunk_Receiver();
+
+        void reset();
+        bool add_chunk(const std::string &chunk_digest, int chunk_total_size, int chunk_offset,
+                       const std::vector<unsigned char> &chunk_data);
+
+        //! Get where the next chunk should start in the compressed map.
+        std::size_t get_offset() const { return compressed.size(); }
+
+        //! Check whether every chunk has arrived.
+        bool is_complete() const { return total_size > 0 && compressed.size() == total_size; }
+
+        //! Get the digest of the map being received, as the server sent it.
+        const std::string &get_digest() const { return digest; }
+
+        bool finish(std::vector<unsigned char> &data) const;
+    };
+}
+
+#endif
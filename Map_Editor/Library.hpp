@@ -21,6 +21,7 @@
 #include <target.hpp>
 
 // C++ Standard Library
+#include <algorithm>
 #include <cctype>
 #include <cmath>
 #include <cstdlib>
@@ -11,9 +11,16 @@
 #include "Main.h"
 #include "Exception.h"
 #include "Map.hpp"
+#include "MapCompression.hpp"
 #include "vtassert.hpp"
 
 
+namespace {
+
+    // Requests in a row which may time out before a map transfer is given up.
+    const int TRANSFER_ATTEMPTS = 3;
+}
+
 namespace ServerCommunication {
 
     Ice::CommunicatorPtr comm;
@@ -161,50 +168,52 @@ namespace ServerCommunication {
      */
     bool upload_map(const Map *const current_map, const std::string &map_name)
     {
-        VTankObject::TileList data;
-        VTankObject::Map vtmap;
-
         if(current_map->get_supported_game_modes().empty()) {
             (void)wxMessageBox(wxString("Map doesn't contain supported game modes\n"
                 "Map failed to upload.", wxConvUTF8), wxT("Error"), wxOK | wxICON_ERROR | wxSTAY_ON_TOP);
             return false;
         }
 
-        const int current_width = current_map->get_width();
-        const int current_height = current_map->get_height();
+        VTANK_ASSERT(current_map->get_width() > 0);
+        VTANK_ASSERT(current_map->get_height() > 0);
 
-        VTANK_ASSERT(current_width > 0);
-        VTANK_ASSERT(current_height > 0);
-        //lint -save -e732
-        
-        data.resize(current_width * current_height);
+        // The map goes up as compressed chunks of its version 1 file. The compressed map
+        // carries its own checksum, so the hash is left for the server to work out.
+        std::vector<unsigned char> map_data;
+        std::vector<unsigned char> compressed;
+        (void)current_map->save_to_memory(map_data);
+        MapCompression::compress(map_data, compressed);
 
-        vtmap.version   = current_map->get_version();
-        vtmap.height    = current_height;
-        vtmap.width     = current_width;
-        vtmap.title     = current_map->get_title();
-        vtmap.filename  = map_name;
+        VTankObject::MapChunk chunk;
+        chunk.filename  = map_name;
+        chunk.totalSize = static_cast<int>(compressed.size());
 
-        const std::vector<int> modes = current_map->get_supported_game_modes();        for (std::vector<int>::size_type i = 0; i < modes.size(); i++) {            vtmap.supportedGameModes.push_back(modes[i]);        }        for (int y = 0; y < current_height; y++) {
-            for (int x = 0; x < current_width; x++) {
-                VTankObject::Tile tile;
-                const Tile temp_tile = current_map->get_tile(x, y);
-                tile.id         = temp_tile.tile_id;
-                tile.objectId   = temp_tile.object_id;
-                tile.eventId    = temp_tile.event_id;
-                tile.passable   = (temp_tile.passable != 0);
-                tile.height     = temp_tile.height;
-                tile.type       = temp_tile.type;
-                tile.effect     = temp_tile.effect;
+        try {
+            std::size_t offset = 0;
+            int failures = 0;
+            while (offset < compressed.size()) {
+                const std::size_t size = std::min(compressed.size() - offset,
+                    static_cast<std::size_t>(MapCompression::MAX_CHUNK_SIZE));
+                chunk.offset = static_cast<int>(offset);
+                chunk.data.assign(compressed.begin() + offset, compressed.begin() + offset + size);
 
-                data[y * current_width + x] = tile;
-            }
-        }
-        vtmap.tileData = data;
-        //lint -restore
+                std::size_t received = offset;
+                try {
+                    received = static_cast<std::size_t>(me_session_prx->UploadMapChunk(chunk));
+                }
+                catch (const Ice::TimeoutException &) {
+                    // Send the chunk again; if it did arrive, the server says where it got to.
+                }
 
-        try {
-            me_session_prx->UploadMap(vtmap);
+                // A request which got nowhere counts as a failure, so this can't go on forever.
+                if (received > offset) {
+                    failures = 0;
+                }
+                else if (++failures >= TRANSFER_ATTEMPTS) {
+                    throw Ice::TimeoutException(__FILE__, __LINE__);
+                }
+                offset = std::min(received, compressed.size());
+            }
             return true;
         }
         catch (const Exceptions::BadInformationException &) {
@@ -252,30 +261,35 @@ namespace ServerCommunication {
     {
         Map vtmap = Map();
         try {
-            VTankObject::Map icemap = me_session_prx->DownloadMap(map_name);         
-            if(!vtmap.create(icemap.width, icemap.height, icemap.title)) {
-                return Map();
-            }
-            for (int y = 0; y < icemap.height; y++) {
-                for (int x = 0; x < icemap.width; x++) {
-                   const VTankObject::Tile temp = icemap.tileData[static_cast<unsigned>(y * icemap.width + x)];
-                   //lint -save -e534
-                   vtmap.set_tile_id(x, y, temp.id);
-                   vtmap.set_tile_object(x, y, temp.objectId);
-                   vtmap.set_tile_event(x, y, temp.eventId);
-                   vtmap.set_tile_collision(x, y, temp.passable);
-                   vtmap.set_tile_height(x, y, temp.height);
-                   vtmap.set_tile_type(x, y, temp.type);
-                   vtmap.set_tile_effect(x, y, temp.effect);
-                   //lint -restore
+            // The map comes down as compressed chunks of its version 1 file.
+            MapCompression::Chunk_Receiver receiver;
+            int failures = 0;
+            while (!receiver.is_complete()) {
+                const std::size_t offset = receiver.get_offset();
+                try {
+                    const VTankObject::MapChunk chunk = me_session_prx->DownloadMapChunk(
+                        map_name, static_cast<int>(offset), MapCompression::MAX_CHUNK_SIZE);
+                    (void)receiver.add_chunk(chunk.hash, chunk.totalSize, chunk.offset, chunk.data);
+                }
+                catch (const Ice::TimeoutException &) {
+                    // Carry on from the last chunk which arrived.
                 }
+
+                if (receiver.get_offset() > offset) {
+                    failures = 0;
+                }
+                else if (++failures >= TRANSFER_ATTEMPTS) {
+                    throw Ice::TimeoutException(__FILE__, __LINE__);
+                }
+            }
+
+            std::vector<unsigned char> map_data;
+            if (!receiver.finish(map_data) || !vtmap.load_from_memory(map_data)) {
+                (void)wxMessageBox(wxT("The downloaded map is damaged."),
+                                   wxT("Error"), wxOK | wxICON_ERROR | wxSTAY_ON_TOP);
+                return Map();
             }
 
-            for (VTankObject::SupportedGameModes::size_type i = 0;
-                 i < icemap.supportedGameModes.size(); i++) {                    
-                     vtmap.add_supported_game_mode(icemap.supportedGameModes[i]);            
-            }            
-            
             return Map(vtmap);
         }
         catch (const Exceptions::BadInformationException &) {
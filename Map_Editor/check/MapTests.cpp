@@ -2,13 +2,55 @@
     \brief   Tests for the Map Class.
     \author  (C) Copyright 2009 by Vermont Technical College
 */
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <iterator>
 #include <stdio.h>
 #include "MapTests.hpp"
 #include <UnitTestManager.hpp>
 #include <Map.hpp>
+#include <MapCompression.hpp>
 
 namespace {
+    //! Convert an int to the 4 bytes it is stored as.
+    const std::vector<unsigned char> int_to_bytes(const int n)
+    {
+        std::vector<unsigned char> bytes(4);
+        ::int_to_bytes(n, &bytes[0], 4);
+
+        return bytes;
+    }
+
+    //! Read a tile from the TILE_BYTE_SIZE bytes it is stored as.
+    const Tile bytes_to_tile(const unsigned char *const bytes)
+    {
+        Tile t;
+        t.tile_id   = bytes_to_int(bytes, 4);
+        t.object_id = bytes_to_int((bytes + 4), 2);
+        t.event_id  = bytes_to_int((bytes + 6), 2);
+        t.passable  = bytes[8] == 0 ? false : true;
+        t.height    = bytes[9];
+        t.type      = bytes[10];
+        t.effect    = bytes[11];
+        return t;
+    }
+
+    //! Convert a tile to the TILE_BYTE_SIZE bytes it is stored as.
+    const std::vector<unsigned char> tile_to_bytes(const Tile &tile)
+    {
+        std::vector<unsigned char> bytes(TILE_BYTE_SIZE);
+        ::int_to_bytes(tile.tile_id, &bytes[0], 4);
+        ::int_to_bytes(tile.object_id, &bytes[4], 2);
+        ::int_to_bytes(tile.event_id, &bytes[6], 2);
+        bytes[8]  = static_cast<unsigned char>(tile.passable ? 0x01 : 0x00);
+        bytes[9]  = static_cast<unsigned char>(tile.height);
+        bytes[10] = static_cast<unsigned char>(tile.type);
+        bytes[11] = static_cast<unsigned char>(tile.effect);
+
+        return bytes;
+    }
+
     bool test_create()
     {
         Map test;
@@ -888,6 +930,281 @@ namespace {
         UNIT_CHECK(x == y);
         return true;
     }
+
+    bool test_is_wall()
+    {
+        Map test;
+        test.create(40, 3, "test");
+        //Test a new map has no walls
+        UNIT_CHECK(!test.is_wall(0, 0));
+        test.set_tile_collision(35, 1, false);
+        test.set_tile(2, 2, 0, false, 0, 0, 0, 0, 0);
+        //Test walls set either way are seen, including past the first word of bits
+        UNIT_CHECK(test.is_wall(35, 1));
+        UNIT_CHECK(test.is_wall(2, 2));
+        UNIT_CHECK(!test.is_wall(34, 1));
+        //Test tiles off the map are not walls
+        UNIT_CHECK(!test.is_wall(-1, 0));
+        UNIT_CHECK(!test.is_wall(40, 1));
+        UNIT_CHECK(!test.is_wall(0, 3));
+        //Test clearing a wall
+        test.set_tile_collision(2, 2, true);
+        UNIT_CHECK(!test.is_wall(2, 2));
+        //Test walls survive a resize
+        test.resize(36, 5);
+        UNIT_CHECK(test.is_wall(35, 1));
+        //Test walls survive a save and load
+        test.save("testmap.vtmap");
+        Map loaded;
+        UNIT_CHECK(loaded.load("testmap.vtmap"));
+        UNIT_CHECK(loaded.is_wall(35, 1));
+        UNIT_CHECK(!loaded.is_wall(2, 2));
+        remove("testmap.vtmap");
+        //Test a copy has the same walls
+        Map copy(loaded);
+        UNIT_CHECK(copy.is_wall(35, 1));
+        return true;
+    }
+
+    bool test_distance_field()
+    {
+        Map test;
+        test.create(12, 9, "test");
+        test.set_tile_collision(3, 4, false);
+        test.set_tile_collision(4, 4, false);
+        test.set_tile_collision(10, 1, false);
+        //Test there is no distance field until it is built
+        UNIT_CHECK(!test.has_distance_field());
+        UNIT_CHECK(test.get_wall_distance(0, 0) == 0.0f);
+        test.build_distance_field();
+        UNIT_CHECK(test.has_distance_field());
+        //Test every tile against a brute force search
+        for (int y = 0; y < 9; y++) {
+            for (int x = 0; x < 12; x++) {
+                double nearest = 1e9;
+                for (int wy = 0; wy < 9; wy++) {
+                    for (int wx = 0; wx < 12; wx++) {
+                        if (test.is_wall(wx, wy) != test.is_wall(x, y)) {
+                            nearest = std::min(nearest, std::sqrt(
+                                static_cast<double>((wx - x) * (wx - x) + (wy - y) * (wy - y))));
+                        }
+                    }
+                }
+                const double expected = test.is_wall(x, y) ? -nearest : nearest;
+                UNIT_CHECK(std::fabs(test.get_wall_distance(x, y) - expected) < 0.001);
+            }
+        }
+        //Test off the map
+        UNIT_CHECK(test.get_wall_distance(-1, 0) == 0.0f);
+        //Test changing a wall discards the field
+        test.set_tile_collision(0, 0, false);
+        UNIT_CHECK(!test.has_distance_field());
+        return true;
+    }
+    bool test_save_load_version_2()
+    {
+        Map test;
+        test.create(7, 5, "mapped");
+        test.add_supported_game_mode(DEATH_MATCH);
+        test.add_supported_game_mode(CAPTURE_THE_FLAG);
+        test.set_tile(3, 2, 42, false, 7, SPAWN_POINT, 2, 1, 3);
+        test.set_tile_id(6, 4, 70000);
+        //Test saving in an unknown version fails
+        UNIT_CHECK(!test.save("testmap.vtmap", 3));
+        UNIT_CHECK(test.save("testmap.vtmap", MAPPED_FORMAT_VERSION));
+        Map loaded;
+        UNIT_CHECK(loaded.load("testmap.vtmap"));
+        //Test the tiles are used straight from the file
+        UNIT_CHECK(loaded.is_mapped());
+        UNIT_CHECK(loaded.get_version() == MAPPED_FORMAT_VERSION);
+        UNIT_CHECK(loaded.get_title() == "mapped");
+        UNIT_CHECK(loaded.get_width() == 7 && loaded.get_height() == 5);
+        UNIT_CHECK(loaded.get_supported_game_modes() == test.get_supported_game_modes());
+        for (int y = 0; y < 5; y++) {
+            for (int x = 0; x < 7; x++) {
+                UNIT_CHECK(loaded.get_tile(x, y) == test.get_tile(x, y));
+                UNIT_CHECK(loaded.is_wall(x, y) == test.is_wall(x, y));
+            }
+        }
+        //Test a copy has tiles of its own
+        Map copy;
+        copy = loaded;
+        UNIT_CHECK(!copy.is_mapped());
+        UNIT_CHECK(copy.get_tile(3, 2) == test.get_tile(3, 2));
+        //Test changing a tile copies the mapped tiles first
+        UNIT_CHECK(loaded.set_tile_height(0, 0, 9));
+        UNIT_CHECK(!loaded.is_mapped());
+        UNIT_CHECK(loaded.get_tile_height(0, 0) == 9);
+        UNIT_CHECK(loaded.get_tile(3, 2) == test.get_tile(3, 2));
+        //Test converting back to version 1
+        UNIT_CHECK(loaded.save("testmap.vtmap"));
+        Map converted;
+        UNIT_CHECK(converted.load("testmap.vtmap"));
+        UNIT_CHECK(!converted.is_mapped());
+        UNIT_CHECK(converted.get_version() == FORMAT_VERSION);
+        UNIT_CHECK(converted.get_tile(6, 4).tile_id == 70000);
+        UNIT_CHECK(converted.get_tile_height(0, 0) == 9);
+        UNIT_CHECK(converted.get_supported_game_modes() == test.get_supported_game_modes());
+        remove("testmap.vtmap");
+        return true;
+    }
+
+    bool test_load_corrupt_version_2()
+    {
+        Map test;
+        test.create(4, 4, "corrupt");
+        test.add_supported_game_mode(DEATH_MATCH);
+        UNIT_CHECK(test.save("testmap.vtmap", MAPPED_FORMAT_VERSION));
+        std::vector<char> bytes;
+        {
+            std::ifstream file("testmap.vtmap", std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        //Test the tile array is aligned
+        UNIT_CHECK(bytes.size() % MAPPED_TILE_ALIGNMENT == 
+            (4 * 4 * TILE_BYTE_SIZE) % MAPPED_TILE_ALIGNMENT);
+        //Test a changed tile is caught by the checksum
+        bytes[bytes.size() - 3] ^= 0x10;
+        {
+            std::ofstream file("testmap.vtmap", std::ios::binary | std::ios::trunc);
+            file.write(&bytes[0], static_cast<std::streamsize>(bytes.size()));
+        }
+        Map loaded;
+        UNIT_CHECK(!loaded.load("testmap.vtmap"));
+        UNIT_CHECK(loaded.get_last_error() == "Map testmap.vtmap is corrupt.");
+        //Test a truncated file is refused
+        {
+            std::ofstream file("testmap.vtmap", std::ios::binary | std::ios::trunc);
+            file.write(&bytes[0], static_cast<std::streamsize>(bytes.size() - TILE_BYTE_SIZE));
+        }
+        UNIT_CHECK(!loaded.load("testmap.vtmap"));
+        UNIT_CHECK(loaded.get_last_error() == "Map testmap.vtmap has the wrong number of tiles.");
+        //Test a truncated version 1 file is refused
+        UNIT_CHECK(test.save("testmap.vtmap"));
+        {
+            std::ifstream file("testmap.vtmap", std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        {
+            std::ofstream file("testmap.vtmap", std::ios::binary | std::ios::trunc);
+            file.write(&bytes[0], static_cast<std::streamsize>(bytes.size() - 1));
+        }
+        UNIT_CHECK(!loaded.load("testmap.vtmap"));
+        remove("testmap.vtmap");
+        return true;
+    }
+
+    bool test_save_load_memory()
+    {
+        Map test;
+        test.create(5, 3, "memory");
+        test.add_supported_game_mode(DEATH_MATCH);
+        test.set_tile_id(2, 1, 42);
+        test.set_tile_height(4, 2, 3);
+        std::vector<unsigned char> bytes;
+        UNIT_CHECK(test.save_to_memory(bytes));
+        //Test the bytes are those of the saved file
+        UNIT_CHECK(test.save("testmap.vtmap"));
+        {
+            std::ifstream file("testmap.vtmap", std::ios::binary);
+            std::vector<unsigned char> saved((std::istreambuf_iterator<char>(file)),
+                std::istreambuf_iterator<char>());
+            UNIT_CHECK(saved == bytes);
+        }
+        remove("testmap.vtmap");
+        //Test loading them back
+        Map loaded;
+        UNIT_CHECK(loaded.load_from_memory(bytes));
+        UNIT_CHECK(loaded.get_title() == "memory");
+        UNIT_CHECK(loaded.get_width() == 5);
+        UNIT_CHECK(loaded.get_height() == 3);
+        UNIT_CHECK(loaded.get_tile(2, 1).tile_id == 42);
+        UNIT_CHECK(loaded.get_tile_height(4, 2) == 3);
+        UNIT_CHECK(loaded.get_supported_game_modes() == test.get_supported_game_modes());
+        //Test damaged bytes are refused
+        bytes.pop_back();
+        UNIT_CHECK(!loaded.load_from_memory(bytes));
+        bytes.clear();
+        UNIT_CHECK(!loaded.load_from_memory(bytes));
+        return true;
+    }
+
+    bool test_compression()
+    {
+        Map test;
+        test.create(100, 100, "compressed");
+        test.add_supported_game_mode(DEATH_MATCH);
+        for (int x = 0; x < 100; x++) {
+            test.set_tile_id(x, x, x * 7);
+        }
+        std::vector<unsigned char> bytes;
+        UNIT_CHECK(test.save_to_memory(bytes));
+        std::vector<unsigned char> compressed;
+        MapCompression::compress(bytes, compressed);
+        //Test runs of tiles shrink
+        UNIT_CHECK(compressed.size() < bytes.size() / 10);
+        std::vector<unsigned char> expanded;
+        UNIT_CHECK(MapCompression::decompress(compressed, expanded));
+        UNIT_CHECK(expanded == bytes);
+        //Test empty input
+        std::vector<unsigned char> empty;
+        MapCompression::compress(empty, compressed);
+        UNIT_CHECK(compressed.size() == static_cast<size_t>(MapCompression::HEADER_SIZE));
+        UNIT_CHECK(MapCompression::decompress(compressed, expanded));
+        UNIT_CHECK(expanded.empty());
+        //Test a changed byte is caught
+        MapCompression::compress(bytes, compressed);
+        compressed[compressed.size() - 1] ^= 0x01;
+        UNIT_CHECK(!MapCompression::decompress(compressed, expanded));
+        //Test a truncated map is caught
+        MapCompression::compress(bytes, compressed);
+        compressed.pop_back();
+        UNIT_CHECK(!MapCompression::decompress(compressed, expanded));
+        //Test a missing header is caught
+        compressed.resize(MapCompression::HEADER_SIZE - 1);
+        UNIT_CHECK(!MapCompression::decompress(compressed, expanded));
+        return true;
+    }
+
+    bool test_chunk_receiver()
+    {
+        std::vector<unsigned char> bytes;
+        for (int i = 0; i < 1000; i++) {
+            bytes.push_back(static_cast<unsigned char>((i * 31) % 251));
+        }
+        std::vector<unsigned char> compressed;
+        MapCompression::compress(bytes, compressed);
+        const int total = static_cast<int>(compressed.size());
+        const int half = total / 2;
+        const std::vector<unsigned char> first(compressed.begin(), compressed.begin() + half);
+        const std::vector<unsigned char> second(compressed.begin() + half, compressed.end());
+
+        MapCompression::Chunk_Receiver receiver;
+        std::vector<unsigned char> data;
+        //Test a chunk which doesn't start the map is refused
+        UNIT_CHECK(!receiver.add_chunk("a", total, half, second));
+        UNIT_CHECK(receiver.get_offset() == 0);
+        //Test the transfer resumes where it left off
+        UNIT_CHECK(receiver.add_chunk("a", total, 0, first));
+        UNIT_CHECK(!receiver.is_complete());
+        UNIT_CHECK(!receiver.finish(data));
+        UNIT_CHECK(!receiver.add_chunk("a", total, 0, first));
+        UNIT_CHECK(receiver.get_offset() == static_cast<size_t>(half));
+        UNIT_CHECK(receiver.add_chunk("a", total, half, second));
+        UNIT_CHECK(receiver.is_complete());
+        UNIT_CHECK(receiver.get_digest() == "a");
+        UNIT_CHECK(receiver.finish(data));
+        UNIT_CHECK(data == bytes);
+        //Test a map which changed part way starts over
+        receiver.reset();
+        UNIT_CHECK(receiver.add_chunk("a", total, 0, first));
+        UNIT_CHECK(!receiver.add_chunk("b", total, half, second));
+        UNIT_CHECK(receiver.get_offset() == 0);
+        UNIT_CHECK(receiver.get_digest() == "b");
+        //Test a chunk running past the end is refused
+        UNIT_CHECK(!receiver.add_chunk("b", half, 0, compressed));
+        return true;
+    }
 }
 
 void map_register_tests()
@@ -921,4 +1238,11 @@ void map_register_tests()
     UnitTestManager::register_test(test_bytes_to_int, "Map BytesToInt Test");
     UnitTestManager::register_test(test_tile_to_bytes, "Map TileToBytes Test");
     UnitTestManager::register_test(test_bytes_to_tile, "Map BytesToTile Test");
+    UnitTestManager::register_test(test_is_wall, "Map IsWall Test");
+    UnitTestManager::register_test(test_distance_field, "Map DistanceField Test");
+    UnitTestManager::register_test(test_save_load_version_2, "Map SaveLoadVersion2 Test");
+    UnitTestManager::register_test(test_load_corrupt_version_2, "Map LoadCorruptVersion2 Test");
+    UnitTestManager::register_test(test_save_load_memory, "Map SaveLoadMemory Test");
+    UnitTestManager::register_test(test_compression, "Map Compression Test");
+    UnitTestManager::register_test(test_chunk_receiver, "Map ChunkReceiver Test");
 }
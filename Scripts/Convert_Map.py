@@ -0,0 +1,149 @@
+#!/usr/bin/python
+# \file Convert_Map.py
+# \brief Converts .vtmap files between format version 1 and format version 2.
+# \author (C) Copyright 2010 by Vermont Technical College
+#
+# Version 1 is what clients and the main server read. Version 2 is the memory-mappable
+# format the game server keeps in maps/cache, laid out as follows (all integers are
+# little-endian):
+#   [1]  Version (2)
+#   [7]  Signature "VTMAP\r\n"
+#   [4]  Header size (64)
+#   [4]  Width
+#   [4]  Height
+#   [4]  Title length
+#   [4]  Number of supported game modes
+#   [4]  Offset of the tile array, a multiple of 64
+#   [4]  Size of a tile (12)
+#   [4]  Adler-32 of the whole file, taken with this field set to zero
+#   [24] Zero
+# followed by the title, one byte per game mode, zeros up to the tile array, and the tiles
+# in the same 12 byte form as version 1.
+#
+# Usage: Convert_Map.py [--version 1|2] input.vtmap output.vtmap
+# The output is version 2 unless another version is asked for.
+###########################################################################
+import struct;
+import sys;
+import zlib;
+
+HEADER_SIZE     = 64;
+TILE_SIZE       = 12;
+TILE_ALIGNMENT  = 64;
+SIGNATURE       = bytearray(b"VTMAP\r\n");
+HEADER_FORMAT   = "<B7sIIIIIIII24x";
+CHECKSUM_OFFSET = 36;
+
+def checksum(data):
+    """
+    Compute the checksum of a version 2 map.
+    @param data Whole file, as a bytearray.
+    @return Checksum as an unsigned integer.
+    """
+    data = data[:CHECKSUM_OFFSET] + bytearray(4) + data[CHECKSUM_OFFSET + 4:];
+    return zlib.adler32(bytes(data)) & 0xFFFFFFFF;
+
+def read_version_1(data):
+    """
+    Read a version 1 map.
+    @param data Whole file, as a bytearray.
+    @return Tuple of (title, width, height, game modes, tile bytes).
+    """
+    end_of_title = data.index(b"\n", 1);
+    title = data[1 : end_of_title];
+    pos = end_of_title + 1;
+    (width, height) = struct.unpack("<II", bytes(data[pos : pos + 8]));
+    pos += 8;
+    end_of_modes = data.index(b"\n", pos);
+    modes = data[pos : end_of_modes];
+    tiles = data[end_of_modes + 1 :];
+    return (title, width, height, modes, tiles);
+
+def read_version_2(data):
+    """
+    Read a version 2 map, checking its header and checksum.
+    @param data Whole file, as a bytearray.
+    @return Tuple of (title, width, height, game modes, tile bytes).
+    """
+    if len(data) < HEADER_SIZE:
+        raise RuntimeError("File is too short to be a map.");
+    (version, signature, header_size, width, height, title_length, mode_count, tile_offset,
+        tile_size, stored_checksum) = struct.unpack(HEADER_FORMAT, bytes(data[:HEADER_SIZE]));
+    if bytearray(signature) != SIGNATURE or tile_size != TILE_SIZE:
+        raise RuntimeError("File is not a version 2 map.");
+    if stored_checksum != checksum(data):
+        raise RuntimeError("Map is corrupt.");
+    title = data[header_size : header_size + title_length];
+    modes = data[header_size + title_length : header_size + title_length + mode_count];
+    tiles = data[tile_offset :];
+    if len(tiles) != width * height * TILE_SIZE:
+        raise RuntimeError("Map has the wrong number of tiles.");
+    return (title, width, height, modes, tiles);
+
+def write_version_1(title, width, height, modes, tiles):
+    """
+    Build a version 1 map.
+    @return Whole file, as a bytearray.
+    """
+    return (bytearray([1]) + title + b"\n" + bytearray(struct.pack("<II", width, height)) +
+        modes + b"\n" + tiles);
+
+def write_version_2(title, width, height, modes, tiles):
+    """
+    Build a version 2 map.
+    @return Whole file, as a bytearray.
+    """
+    prefix_size = HEADER_SIZE + len(title) + len(modes);
+    tile_offset = (prefix_size + TILE_ALIGNMENT - 1) // TILE_ALIGNMENT * TILE_ALIGNMENT;
+    header = bytearray(struct.pack(HEADER_FORMAT, 2, bytes(SIGNATURE), HEADER_SIZE, width,
+        height, len(title), len(modes), tile_offset, TILE_SIZE, 0));
+    data = header + title + modes + bytearray(tile_offset - prefix_size) + tiles;
+    data[CHECKSUM_OFFSET : CHECKSUM_OFFSET + 4] = struct.pack("<I", checksum(data));
+    return data;
+
+def convert(input_name, output_name, version):
+    """
+    Convert a map from either version into the given version.
+    @param input_name Name of the map to read.
+    @param output_name Name of the map to write. May be the same as the input.
+    @param version Format version to write, 1 or 2.
+    """
+    source = open(input_name, "rb");
+    data = bytearray(source.read());
+    source.close();
+    if not data:
+        raise RuntimeError("%s is empty." % input_name);
+
+    if data[0] == 1:
+        fields = read_version_1(data);
+    elif data[0] == 2:
+        fields = read_version_2(data);
+    else:
+        raise RuntimeError("%s has an unknown format version: %d." % (input_name, data[0]));
+
+    if version == 1:
+        result = write_version_1(*fields);
+    else:
+        result = write_version_2(*fields);
+
+    destination = open(output_name, "wb");
+    destination.write(bytes(result));
+    destination.close();
+
+def main(arguments):
+    version = 2;
+    if len(arguments) == 4 and arguments[0] == "--version" and arguments[1] in ("1", "2"):
+        version = int(arguments[1]);
+        arguments = arguments[2:];
+    if len(arguments) != 2:
+        sys.stderr.write("Usage: Convert_Map.py [--version 1|2] input.vtmap output.vtmap\n");
+        return 1;
+    try:
+        convert(arguments[0], arguments[1], version);
+    except Exception as e:
+        sys.stderr.write("Unable to convert %s: %s\n" % (arguments[0], str(e)));
+        return 1;
+    return 0;
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]));
@@ -6,6 +6,8 @@
 #ifndef ASYNCTEMPLATE
 #define ASYNCTEMPLATE
 
+#include <gameinstance.hpp>
+
 typedef void ( *response_callback_t )( );
 typedef void ( *exception_callback_t )(const Ice::Exception& ex);
 typedef void ( *player_exception_callback_t )(const int id, const Ice::Exception &ex);
@@ -20,7 +22,8 @@ typedef void ( *player_exception_callback_t )(const int id, const Ice::Exception
     whose return type is 'void'. Regardless, you may still set their own
     function callback in case they're interested in knowing when the user
     responded. You may also set an exception callback just in case a user
-    disconnects.
+    disconnects. The callbacks run on an Ice thread with the arena which sent the
+    message bound, if one was.
 */
 template<class T>
 class VoidAsyncCallback : public T
@@ -28,10 +31,17 @@ class VoidAsyncCallback : public T
 private:
     exception_callback_t exception_callback;
     response_callback_t response_callback;
+    Game_Instance *arena;
 
 public:
     VoidAsyncCallback(const exception_callback_t ex = NULL, const response_callback_t reply = NULL) 
+        : arena(Game_Instance::find_current())
     {
+        // Every callback goes with one outgoing message. Those sent outside an arena,
+        // such as to the main server, aren't counted.
+        if (arena != NULL) {
+            Atomic::increment(arena->sent_messages);
+        }
         exception_callback = ex;
         response_callback = reply;
     }
@@ -49,14 +59,26 @@ public:
     virtual void ice_exception(const Ice::Exception& ex)
     {
         if (exception_callback != NULL) {
-            exception_callback(ex);
+            if (arena != NULL) {
+                const Game_Instance::Scope scope(*arena);
+                exception_callback(ex);
+            }
+            else {
+                exception_callback(ex);
+            }
         }
     }
 
     virtual void ice_response()
     {
         if (response_callback != NULL) {
-            response_callback();
+            if (arena != NULL) {
+                const Game_Instance::Scope scope(*arena);
+                response_callback();
+            }
+            else {
+                response_callback();
+            }
         }
     }
 };
@@ -71,16 +93,20 @@ class PlayerAsyncCallback : public T
 private:
     int player_id;
     player_exception_callback_t exception_callback;
+    Game_Instance *arena;
 
 public:
+    //! Must be created with the player's arena bound.
     PlayerAsyncCallback(const int id, const player_exception_callback_t ex) 
-        : player_id(id), exception_callback(ex)
+        : player_id(id), exception_callback(ex), arena(&Game_Instance::current())
     {
+        Atomic::increment(arena->sent_messages);
     }
 
     virtual void ice_exception(const Ice::Exception& ex)
     {
         if (exception_callback != NULL) {
+            const Game_Instance::Scope scope(*arena);
             exception_callback(player_id, ex);
         }
     }
@@ -0,0 +1,119 @@
+/*!
+    \file   atomic.hpp
+    \brief  Minimal set of atomic operations used by the lock-free containers.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef ATOMIC_HPP
+#define ATOMIC_HPP
+
+/*!
+    The Atomic namespace wraps the compiler/OS primitives needed for lock-free
+    programming. Every operation acts as a full memory barrier.
+*/
+namespace Atomic
+{
+#if TARGET == WINTARGET
+    //! Atomically replace target with desired if it equals expected.
+    //! \return The value of target before the operation.
+    inline long compare_and_swap(volatile long &target, const long expected, const long desired)
+    {
+        return InterlockedCompareExchange(&target, desired, expected);
+    }
+
+    //! Atomically add value to target.
+    //! \return The value of target before the operation.
+    inline long fetch_and_add(volatile long &target, const long value)
+    {
+        return InterlockedExchangeAdd(&target, value);
+    }
+
+    //! Issue a full memory barrier.
+    inline void memory_barrier()
+    {
+        MemoryBarrier();
+    }
+#elif TARGET == LINTARGET
+    //! Atomically replace target with desired if it equals expected.
+    //! \return The value of target before the operation.
+    inline long compare_and_swap(volatile long &target, const long expected, const long desired)
+    {
+        return __sync_val_compare_and_swap(&target, expected, desired);
+    }
+
+    //! Atomically add value to target.
+    //! \return The value of target before the operation.
+    inline long fetch_and_add(volatile long &target, const long value)
+    {
+        return __sync_fetch_and_add(&target, value);
+    }
+
+    //! Issue a full memory barrier.
+    inline void memory_barrier()
+    {
+        __sync_synchronize();
+    }
+#endif
+
+    //! Read a value which other threads may be writing.
+    inline long load(const volatile long &target)
+    {
+        const long value = target;
+        memory_barrier();
+        return value;
+    }
+
+    //! Publish a value which other threads may be reading.
+    inline void store(volatile long &target, const long value)
+    {
+        memory_barrier();
+        target = value;
+        memory_barrier();
+    }
+
+    //! Atomically increment target.
+    //! \return The new value of target.
+    inline long increment(volatile long &target)
+    {
+        return fetch_and_add(target, 1) + 1;
+    }
+
+    //! Atomically decrement target.
+    //! \return The new value of target.
+    inline long decrement(volatile long &target)
+    {
+        return fetch_and_add(target, -1) - 1;
+    }
+
+    //! Read a pointer which other threads may be replacing.
+    template <typename T>
+    inline T *load_pointer(T * const volatile &target)
+    {
+        T * const value = target;
+        memory_barrier();
+        return value;
+    }
+
+    /*!
+        Publish a pointer which other threads may be reading. Aligned pointer stores
+        are atomic on every target, so readers see either the old or the new pointer.
+    */
+    template <typename T>
+    inline void store_pointer(T * volatile &target, T * const value)
+    {
+        memory_barrier();
+        target = value;
+        memory_barrier();
+    }
+
+    /*!
+        Add to a counter which is allowed to wrap around. Sequence numbers use this
+        so overflow behaves the same on every platform.
+    */
+    inline long wrapping_add(const long value, const long amount)
+    {
+        return static_cast<long>(
+            static_cast<unsigned long>(value) + static_cast<unsigned long>(amount));
+    }
+}
+
+#endif
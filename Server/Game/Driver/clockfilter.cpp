@@ -0,0 +1,69 @@
+/*!
+    \file   clockfilter.cpp
+    \brief  Implementation of the Clock_Filter class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <clockfilter.hpp>
+
+Clock_Filter::Clock_Filter()
+    : count(0), next(0), anchor(), has_anchor(false), has_drift(false)
+{
+}
+
+const Clock_Estimate &Clock_Filter::add_sample(const double sent, const Ice::Long client_time,
+    const double received)
+{
+    Sample sample;
+    sample.time = received;
+    sample.delay = std::max(received - sent, 0.0);
+    // The client read its clock halfway through the round trip, give or take.
+    sample.offset = static_cast<double>(client_time) - (sent + received) / 2.0;
+
+    samples[next] = sample;
+    next = (next + 1) % CLOCK_SYNC_SAMPLES;
+    if (count < CLOCK_SYNC_SAMPLES) {
+        ++count;
+    }
+
+    // Trust the sample with the shortest round trip; the newest wins a tie.
+    int best = 0;
+    for (int i = 1; i < count; ++i) {
+        if (samples[i].delay < samples[best].delay ||
+            (samples[i].delay == samples[best].delay && samples[i].time > samples[best].time)) {
+            best = i;
+        }
+    }
+    const Sample &trusted = samples[best];
+
+    if (!has_anchor) {
+        anchor = trusted;
+        has_anchor = true;
+    }
+    else if (trusted.time - anchor.time >= CLOCK_SYNC_MIN_DRIFT_SPAN) {
+        double drift = (trusted.offset - anchor.offset) / (trusted.time - anchor.time);
+        drift = std::max(std::min(drift, CLOCK_SYNC_MAX_DRIFT), -CLOCK_SYNC_MAX_DRIFT);
+
+        estimate.drift = has_drift ? estimate.drift + (drift - estimate.drift) / 4.0 : drift;
+        has_drift = true;
+        anchor = trusted;
+    }
+
+    // Jitter compares every sample with the trusted one, allowing for drift.
+    double squares = 0;
+    for (int i = 0; i < count; ++i) {
+        if (i != best) {
+            const double difference = samples[i].offset -
+                (trusted.offset + estimate.drift * (samples[i].time - trusted.time));
+            squares += difference * difference;
+        }
+    }
+
+    estimate.offset = trusted.offset;
+    estimate.measured = trusted.time;
+    estimate.delay = trusted.delay;
+    estimate.jitter = count > 1 ? sqrt(squares / (count - 1)) : 0.0;
+    ++estimate.samples;
+
+    return estimate;
+}
@@ -0,0 +1,96 @@
+/*!
+    \file   clockfilter.hpp
+    \brief  Declares the Clock_Filter class, which estimates how a client's clock differs
+            from the server's.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef CLOCKFILTER_HPP
+#define CLOCKFILTER_HPP
+
+/*!
+    What is known about a client's clock. Times are server times from get_precise_time(),
+    in milliseconds.
+*/
+struct Clock_Estimate
+{
+    //! How far the client's clock is ahead of the server's at 'measured'.
+    double offset;
+
+    //! How much the offset grows per millisecond.
+    double drift;
+
+    //! When the offset was measured.
+    double measured;
+
+    //! Root mean square of how far the other samples stray from the offset.
+    double jitter;
+
+    //! Round trip time of the sample the offset came from.
+    double delay;
+
+    //! Number of samples taken so far.
+    long samples;
+
+    Clock_Estimate()
+        : offset(0), drift(0), measured(0), jitter(0), delay(0), samples(0)
+    {}
+
+    /*!
+        Predict the offset at some time.
+        \param now Server time to predict it at.
+        \return Milliseconds the client's clock is ahead of the server's.
+    */
+    double offset_at(const double now) const
+    {
+        return offset + drift * (now - measured);
+    }
+};
+
+/*!
+    Filters a client's clock samples in the style of NTP. Each sample's offset assumes
+    the request and reply took equally long, so it is off by at most half the round
+    trip; the sample with the shortest round trip among the last CLOCK_SYNC_SAMPLES is
+    therefore trusted. Drift is the slope between the trusted samples chosen at least
+    CLOCK_SYNC_MIN_DRIFT_SPAN apart, averaged and kept within CLOCK_SYNC_MAX_DRIFT.
+*/
+class Clock_Filter
+{
+private:
+    struct Sample
+    {
+        double time;
+        double offset;
+        double delay;
+    };
+
+    Sample samples[CLOCK_SYNC_SAMPLES];
+    int count;
+    int next;
+
+    //! Trusted sample last used to measure drift.
+    Sample anchor;
+    bool has_anchor;
+    bool has_drift;
+
+    Clock_Estimate estimate;
+
+public:
+    Clock_Filter();
+
+    /*!
+        Add a sample.
+        \param sent Server time the request was sent.
+        \param client_time Time the client's clock gave.
+        \param received Server time the reply arrived.
+        \return The new estimate.
+    */
+    const Clock_Estimate &add_sample(const double, const Ice::Long, const double);
+
+    //! Get the current estimate.
+    const Clock_Estimate &get_estimate() const
+    {
+        return estimate;
+    }
+};
+
+#endif
@@ -0,0 +1,281 @@
+/*!
+    \file   clocksync.cpp
+    \brief  Implementation of the clock sync scheduler.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <clocksync.hpp>
+#include <clockfilter.hpp>
+#include <timerwheel.hpp>
+#include <gameinstance.hpp>
+#include <outboundqueue.hpp>
+#include <logger.hpp>
+#include <trace.hpp>
+
+namespace Clock_Sync
+{
+    namespace
+    {
+        //! One player whose clock is sampled.
+        struct Player_Clock
+        {
+            Game_Instance *arena;
+            int id;
+            boost::weak_ptr<Tank> tank;
+            GameSession::ClockSynchronizerPrx proxy;
+
+            // Guarded by mutex.
+            Clock_Filter filter;
+            int burst_left;
+            bool bursting;
+            bool removed;
+            double sent;
+        };
+
+        typedef boost::shared_ptr<Player_Clock> clock_ptr;
+        typedef std::pair<Game_Instance *, int> clock_key;
+
+        boost::mutex mutex;
+        Timer_Wheel<clock_ptr> wheel(CLOCK_SYNC_WHEEL_SLOTS);
+        std::map<clock_key, clock_ptr> clocks;
+        boost::thread scheduler_thread;
+        bool running = false;
+
+        //! Number of wheel ticks covering a delay.
+        std::size_t to_ticks(const double milliseconds)
+        {
+            return static_cast<std::size_t>(ceil(milliseconds / CLOCK_SYNC_WHEEL_RESOLUTION));
+        }
+
+        //! Forget a clock. The mutex must be held.
+        void forget(const clock_ptr &clock)
+        {
+            clock->removed = true;
+
+            const std::map<clock_key, clock_ptr>::iterator i =
+                clocks.find(clock_key(clock->arena, clock->id));
+            if (i != clocks.end() && i->second == clock) {
+                clocks.erase(i);
+            }
+        }
+
+        /*!
+            Remove a player whose client didn't reply. Run by the sender pool, since the
+            failure may be reported inside a call which holds locks that removing a player
+            takes. The ID may belong to someone else by now, so it is checked first.
+        */
+        void remove_player(const clock_ptr clock)
+        {
+            const Game_Instance::Scope scope(*clock->arena);
+            const tank_ptr tank = clock->tank.lock();
+            try {
+                if (!tank || Players::get_tank_manager()->get(clock->id) != tank) {
+                    return;
+                }
+            }
+            catch (const TankNotExistException &) {
+                // Already gone.
+                return;
+            }
+
+            (void)Players::remove_player(clock->id);
+        }
+
+        //! Handle a reply to a clock request.
+        void received(const clock_ptr &clock, const Ice::Long timestamp)
+        {
+            const double now = get_precise_time();
+            const tank_ptr tank = clock->tank.lock();
+
+            Clock_Estimate estimate;
+            bool burst_finished = false;
+            {
+                boost::lock_guard<boost::mutex> guard(mutex);
+                if (clock->removed) {
+                    return;
+                }
+                if (!tank) {
+                    forget(clock);
+                    return;
+                }
+
+                estimate = clock->filter.add_sample(clock->sent, timestamp, now);
+                if (clock->bursting && clock->burst_left == 0) {
+                    clock->bursting = false;
+                    burst_finished = true;
+                }
+
+                wheel.schedule(clock, to_ticks(clock->bursting ?
+                    CLOCK_SYNC_BURST_INTERVAL : CLOCK_SYNC_INTERVAL));
+            }
+
+            tank->set_clock(estimate);
+
+            const player_ptr player = tank->get_player_info();
+            player->set_last_sync_time(now);
+            player->set_average_latency(static_cast<long>(estimate.delay / 2.0));
+            if (burst_finished) {
+                LOG_STREAM(Logger::LOG_LEVEL_DEBUG, tank->get_name() << ": Latency="
+                    << estimate.delay / 2.0 << ", Offset=" << estimate.offset
+                    << ", Jitter=" << estimate.jitter);
+            }
+        }
+
+        //! Handle a clock request which failed.
+        void failed(const clock_ptr &clock, const Ice::Exception &ex)
+        {
+            {
+                boost::lock_guard<boost::mutex> guard(mutex);
+                if (clock->removed) {
+                    return;
+                }
+                forget(clock);
+            }
+
+            LOG_STREAM(Logger::LOG_LEVEL_ERROR, "Exception during ClockSync::Request for player #"
+                << clock->id << " in arena " << clock->arena->get_id() << ": " << ex.what());
+
+            (void)Outbound::sender_pool.schedule(boost::bind(&remove_player, clock));
+        }
+
+        //! AMI callback for one clock request.
+        class Request_Callback : public GameSession::AMI_ClockSynchronizer_Request
+        {
+        private:
+            const clock_ptr clock;
+
+        public:
+            explicit Request_Callback(const clock_ptr &player_clock)
+                : clock(player_clock)
+            {}
+
+            virtual void ice_response(Ice::Long timestamp)
+            {
+                received(clock, timestamp);
+            }
+
+            virtual void ice_exception(const Ice::Exception &ex)
+            {
+                failed(clock, ex);
+            }
+        };
+
+        //! Body of the scheduler thread.
+        void run()
+        {
+            TRACE_THREAD_NAME("Clock Sync");
+
+            std::vector<clock_ptr> due;
+            std::vector<clock_ptr> requests;
+            double next_tick = get_precise_time();
+            try {
+                for (;;) {
+                    next_tick += CLOCK_SYNC_WHEEL_RESOLUTION;
+                    const double wait = next_tick - get_precise_time();
+                    if (wait > 0) {
+                        boost::this_thread::sleep(
+                            boost::posix_time::milliseconds(static_cast<long>(wait)));
+                    }
+                    else {
+                        boost::this_thread::interruption_point();
+                    }
+
+                    {
+                        boost::lock_guard<boost::mutex> guard(mutex);
+                        wheel.advance(due);
+
+                        const double now = get_precise_time();
+                        for (std::vector<clock_ptr>::size_type i = 0; i < due.size(); ++i) {
+                            const clock_ptr &clock = due[i];
+                            if (clock->removed) {
+                                continue;
+                            }
+                            if (clock->tank.expired()) {
+                                forget(clock);
+                                continue;
+                            }
+
+                            clock->sent = now;
+                            if (clock->burst_left > 0) {
+                                --clock->burst_left;
+                            }
+                            requests.push_back(clock);
+                        }
+                        due.clear();
+                    }
+
+                    // Requests are sent without the lock, since a failure is reported at once.
+                    for (std::vector<clock_ptr>::size_type i = 0; i < requests.size(); ++i) {
+                        try {
+                            (void)requests[i]->proxy->Request_async(
+                                new Request_Callback(requests[i]));
+                        }
+                        catch (const Ice::Exception &ex) {
+                            failed(requests[i], ex);
+                        }
+                    }
+                    requests.clear();
+                }
+            }
+            catch (const boost::thread_interrupted &) {
+                // Server is shutting down.
+            }
+        }
+    }
+
+    void add(Game_Instance &arena, const tank_ptr &tank)
+    {
+        const clock_ptr clock(new Player_Clock());
+        clock->arena = &arena;
+        clock->id = tank->get_id();
+        clock->tank = tank;
+        clock->proxy = tank->get_player_info()->get_clock();
+        clock->burst_left = SYNC_REQUESTS;
+        clock->bursting = true;
+        clock->removed = false;
+        clock->sent = 0;
+
+        boost::lock_guard<boost::mutex> guard(mutex);
+
+        std::map<clock_key, clock_ptr>::iterator i = clocks.find(clock_key(&arena, clock->id));
+        if (i != clocks.end()) {
+            i->second->removed = true;
+            i->second = clock;
+        }
+        else {
+            clocks.insert(std::make_pair(clock_key(&arena, clock->id), clock));
+        }
+
+        wheel.schedule(clock, to_ticks(CLOCK_SYNC_BURST_INTERVAL));
+
+        if (!running) {
+            scheduler_thread = boost::thread(&run);
+            running = true;
+        }
+    }
+
+    void remove(Game_Instance &arena, const int id)
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+
+        const std::map<clock_key, clock_ptr>::iterator i = clocks.find(clock_key(&arena, id));
+        if (i != clocks.end()) {
+            i->second->removed = true;
+            clocks.erase(i);
+        }
+    }
+
+    void stop()
+    {
+        {
+            boost::lock_guard<boost::mutex> guard(mutex);
+            if (!running) {
+                return;
+            }
+            running = false;
+        }
+
+        scheduler_thread.interrupt();
+        scheduler_thread.join();
+    }
+}
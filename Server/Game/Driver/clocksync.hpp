@@ -0,0 +1,43 @@
+/*!
+    \file   clocksync.hpp
+    \brief  Declares the Clock_Sync namespace, which keeps every player's clock
+            synchronized from one thread.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef CLOCKSYNC_HPP
+#define CLOCKSYNC_HPP
+
+#include <tank.hpp>
+
+class Game_Instance;
+
+/*!
+    The Clock_Sync namespace samples the clock of every player on the server. One thread
+    turns a timer wheel every CLOCK_SYNC_WHEEL_RESOLUTION milliseconds and sends the
+    requests which are due asynchronously, so no thread waits on a client. A player who
+    joins is sent SYNC_REQUESTS requests CLOCK_SYNC_BURST_INTERVAL apart, then one every
+    CLOCK_SYNC_INTERVAL for as long as they play. Each reply goes through the player's
+    Clock_Filter, and the new estimate is given to their tank (see Tank::set_clock()).
+    A player whose client fails to reply is removed.
+*/
+namespace Clock_Sync
+{
+    /*!
+        Start sampling a player's clock, starting over if it already was.
+        \param arena Arena the player is in.
+        \param tank Tank of the player.
+    */
+    void add(Game_Instance &, const tank_ptr &);
+
+    /*!
+        Stop sampling a player's clock. A reply already on its way is ignored.
+        \param arena Arena the player is in.
+        \param id ID of the player.
+    */
+    void remove(Game_Instance &, const int);
+
+    //! Stop the thread. Used when the server shuts down.
+    void stop();
+}
+
+#endif
@@ -75,7 +75,7 @@ private:
         void inflict_damage(const int damage, const int projectile_id, 
 			const int projectile_type_id, const int owner)
         {
-			const Projectile type = Players::get_weapon_data()->get_projectile(projectile_type_id);
+			const Projectile &type = Players::get_weapon_data()->get_projectile(projectile_type_id);
 			const int final_damage = Utility::round(static_cast<float>(damage) * type.object_damage_factor);
 
             health -= final_damage;
@@ -88,11 +88,19 @@ private:
 					base_id, final_damage);
 			}
 
-			const tank_array tanks = Players::tanks.get_tank_list();
+			const tank_array tanks = Players::get_tank_manager()->get_tank_list();
 			// TODO: Temp work around for lasers. Do it a different way later.
 			if (type.is_instantaneous) {
-				Notifier::blanket_notify_create_projectile(owner, projectile_id,
-					projectile_type_id, position);
+				try {
+					const tank_ptr shooter = Players::get_player(owner);
+					const VTankObject::Point origin = shooter->get_position();
+					Notifier::broadcast_create_projectile(shooter, projectile_id,
+						projectile_type_id, position,
+						Utility::Line(origin.x, origin.y, position.x, position.y));
+				}
+				catch (const TankNotExistException &) {
+					// The shooter left; nobody needs to see the laser.
+				}
 			}
 			Notifier::blanket_notify_damage_base(tanks,
 				team, base_id + 8, final_damage, projectile_id, owner, killing_blow);
@@ -309,7 +317,7 @@ private:
 
 		if (game_done) {
 			// Credit the winning team.
-			const tank_array tanks = Players::tanks.get_tank_list();
+			const tank_array tanks = Players::get_tank_manager()->get_tank_list();
 			for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
 				const tank_ptr tank = tanks[i];
 				if (tank->get_team() == last_winner) {
@@ -322,17 +330,17 @@ private:
 			projectiles->add_damageable_object(&bases[blue_spawn_base_id]);
 		}
 
-		Notifier::blanket_notify_base_captured(Players::tanks.get_tank_list(),
+		Notifier::blanket_notify_base_captured(Players::get_tank_manager()->get_tank_list(),
 			old_team, team, base_id + 8, captured_by->get_id());
 
 		bases[base_id] = base;
 	}
 
 	//! Do collision and event checks against all players.
-	void do_player_checks(const tank_array &tanks)
+	void do_player_checks(const tank_state_array &tanks)
 	{
 		// Check to see if a tank will capture a base.
-		const tank_array::size_type tank_size = tanks.size();
+		const tank_state_array::size_type tank_size = tanks.size();
 		const std::vector<Base>::size_type base_size = bases.size();
 
 		for (std::vector<Base>::size_type i = 0; i < base_size; ++i) {
@@ -342,11 +350,11 @@ private:
 				continue;
 			}
 
-			for (tank_array::size_type j = 0; j < tank_size; ++j) {
-				const tank_ptr tank = tanks[j];
-				const VTankObject::Point tank_position = tank->get_position();
+			for (tank_state_array::size_type j = 0; j < tank_size; ++j) {
+				const Tank_State &tank = tanks[j];
+				const VTankObject::Point tank_position = tank.position;
 
-				if (base.get_team() == tank->get_team()) {
+				if (base.get_team() == tank.team) {
 					// Tank can't take over it's own base, so continue.
 					continue;
 				}
@@ -355,8 +363,8 @@ private:
 				if (Utility::circle_collision(tank_position, TANK_SPHERE_RADIUS, base.get_position(), BASE_RADIUS + 5.0f)) {
 					// Opponent tank has captured the base.
 					Logger::debug("[CTB] Base #%d captured by %s!",
-						base.get_base_id(), tank->get_name().c_str());
-					capture_base(base.get_base_id(), tank->get_team(), tank);
+						base.get_base_id(), tank.tank->get_name().c_str());
+					capture_base(base.get_base_id(), tank.team, tank.tank);
 					break;
 				}
 			}
@@ -381,7 +389,8 @@ private:
 						
 						VTANK_ASSERT(base.get_base_id() + 8 >= 8);
 						Notifier::blanket_notify_set_base_status(
-							Players::tanks.get_tank_list(), base.get_team(), base.get_base_id() + 8, base.get_health());
+							Players::get_tank_manager()->get_tank_list(), base.get_team(),
+							base.get_base_id() + 8, base.get_health());
 					}
 				}
 			}
@@ -498,9 +507,9 @@ public:
 	}
 
 	//! Update the status of the game.
-	void update(const tank_array &tank_list)
+	void update(const tank_array &tank_list, const tank_state_array &states)
 	{
-		do_player_checks(tank_list);
+		do_player_checks(states);
 		do_base_checks();
 		
 		if (game_done) {
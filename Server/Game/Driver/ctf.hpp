@@ -32,6 +32,8 @@ namespace CTF {
 class CTF_Helper : public Game_Handler
 {
 private:
+	typedef std::vector<const Tank_State *> tank_state_list;
+
 	Map *map;
 	int holder_red_ID;
 	int holder_blue_ID;
@@ -92,18 +94,18 @@ done:
 		VTANK_ASSERT(red_found && blue_found);
 	}
 	
-	//! Attempt to find a tank by it's ID in a given tank list.
+	//! Attempt to find a tank by it's ID in a given list of tank states.
 	/*!
-		\param tank_list List of tanks to search from.
+		\param tank_list List of tank states to search from.
 		\param tank_id ID of the tank to search for.
 		\param found [out] True if found; false if not.
-		\return Index in the tank list of the tank. Ignore this value if 'found' is false.
+		\return Index in the list of the tank. Ignore this value if 'found' is false.
 	*/
-	const tank_array::size_type find_tank_by_id(const tank_array &tank_list, int tank_id, bool &found)
+	const tank_state_list::size_type find_tank_by_id(const tank_state_list &tank_list, int tank_id, bool &found)
 	{
-		tank_array::size_type i;
+		tank_state_list::size_type i;
 		for (i = 0; i < tank_list.size(); ++i) {
-			if (tank_list[i]->get_id() == tank_id) {
+			if (tank_list[i]->id == tank_id) {
 				return i;
 			}
 		}
@@ -133,7 +135,7 @@ done:
 		red tanks and blue tanks. If the red flag should be processed, the 'team_tanks' parameter
 		should be the red tanks, and the 'opponent_tanks' parameter should be the blue tanks. The
 		opposite is true if the flag is blue.
-		\param all_tanks Full list of tanks.
+		\param all_tanks Full list of tanks, to notify.
 		\param team_tanks Red tanks if the flag is red, blue tanks otherwise.
 		\param opponent_tanks Red tanks if the flag is blue, blue tanks otherwise.
 		\param state State of whichever flag we're processing.
@@ -146,7 +148,7 @@ done:
 		\param flag_color Color of the team's flag.
 	*/
 	void process_flag(const tank_array &all_tanks,
-		const tank_array &team_tanks, const tank_array &opponent_tanks, 
+		const tank_state_list &team_tanks, const tank_state_list &opponent_tanks, 
 		CTF::Flag_State &state, VTankObject::Point &flag_position, 
 		const VTankObject::Point &team_flag_spawn_position, 
 		const VTankObject::Point &opponent_flag_spawn_position,
@@ -179,18 +181,19 @@ done:
 			// Do collision checks against opponent tanks.
 			bool picked_up = false;
 			const float relevant_radius = (at_home) ? FLAG_SPAWN_RADIUS : FLAG_RADIUS;
-			for (tank_array::size_type i = 0; i < opponent_tanks.size(); ++i) {
-				const tank_ptr tank = opponent_tanks[i];
-				if (!tank->is_alive()) {
+			for (tank_state_list::size_type i = 0; i < opponent_tanks.size(); ++i) {
+				const Tank_State &tank_state = *opponent_tanks[i];
+				if (!tank_state.alive) {
 					continue;
 				}
 
-				if (Utility::circle_collision(tank->get_position(), TANK_SPHERE_RADIUS,
+				if (Utility::circle_collision(tank_state.position, TANK_SPHERE_RADIUS,
 						flag_position, relevant_radius)) {
 					// An opponent picked up the flag.
+					const tank_ptr tank = tank_state.tank;
 					state = CTF::HELD;
-					holder_id = tank->get_id();
-					flag_position = tank->get_position();
+					holder_id = tank_state.id;
+					flag_position = tank_state.position;
 					picked_up = true;
 					at_home = false;
 					
@@ -198,23 +201,24 @@ done:
 					formatter << "[CTF] " << tank->get_name() << " picked up the flag.";
 					Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
 
-					Notifier::blanket_notify_flag_picked_up(all_tanks, tank->get_id(),
+					Notifier::blanket_notify_flag_picked_up(all_tanks, tank_state.id,
 						flag_color);
 				}
 			}
 
 			if (!picked_up && !at_home) {
 				// Check if a team tank has collected the flag in order to return it to base.
-				tank_array::size_type i;
+				tank_state_list::size_type i;
 				for (i = 0; i < team_tanks.size(); ++i) {
-					const tank_ptr tank = team_tanks[i];
-					if (!tank->is_alive()) {
+					const Tank_State &tank_state = *team_tanks[i];
+					if (!tank_state.alive) {
 						continue;
 					}
 
-					if (Utility::circle_collision(tank->get_position(), TANK_SPHERE_RADIUS,
+					if (Utility::circle_collision(tank_state.position, TANK_SPHERE_RADIUS,
 							flag_position, FLAG_RADIUS)) {
 						// A team member returned the flag.
+						const tank_ptr tank = tank_state.tank;
 						state = CTF::STATIONARY;
 						holder_id = -1;
 						flag_position = team_flag_spawn_position;
@@ -226,7 +230,7 @@ done:
 						formatter << "[CTF] " << tank->get_name() << " returned the flag.";
 						Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
 						
-						Notifier::blanket_notify_flag_returned(all_tanks, tank->get_id(),
+						Notifier::blanket_notify_flag_returned(all_tanks, tank_state.id,
 							flag_color);
 					}
 				}
@@ -236,8 +240,8 @@ done:
 			VTANK_ASSERT(holder_id >= 0);
 			VTANK_ASSERT(!at_home);
 			
-			bool found;
-			const tank_array::size_type index = find_tank_by_id(opponent_tanks, holder_id, found);
+			bool found = true;
+			const tank_state_list::size_type index = find_tank_by_id(opponent_tanks, holder_id, found);
 			if (!found) {
 				// Tank doesn't exist, so drop the flag.
 				holder_id = -1;
@@ -249,13 +253,14 @@ done:
 				Notifier::blanket_notify_flag_spawned(all_tanks, flag_position, flag_color);
 			}
 			else {
-				const tank_ptr tank = opponent_tanks[index];
+				const Tank_State &tank_state = *opponent_tanks[index];
+				const tank_ptr tank = tank_state.tank;
 				
 				// Update flag's position.
-				flag_position = tank->get_position();
+				flag_position = tank_state.position;
 				
 				// If the tank isn't alive, drop the flag.
-				if (!tank->is_alive()) {
+				if (!tank_state.alive) {
 					holder_id = -1;
 					state = CTF::STATIONARY;
 
@@ -263,7 +268,7 @@ done:
 					formatter << "[CTF] " << tank->get_name() << " dropped the flag.";
 					Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
 
-					Notifier::blanket_notify_flag_dropped(all_tanks, tank->get_id(),
+					Notifier::blanket_notify_flag_dropped(all_tanks, tank_state.id,
 						flag_position, flag_color);
 				}
 				else {
@@ -289,8 +294,8 @@ done:
 						formatter << "[CTF] " << tank->get_name() << " captured the flag.";
 						Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
 						
-						PointManager::add_objective_captured(tank->get_id());
-						Notifier::blanket_notify_flag_captured(all_tanks, tank->get_id(),
+						PointManager::add_objective_captured(tank_state.id);
+						Notifier::blanket_notify_flag_captured(all_tanks, tank_state.id,
 							flag_color);
 					}
 				}
@@ -468,28 +473,23 @@ public:
 		If a tank was holding the flag and is now dead, the tank drops the flag where he
 		was last alive.
 	*/
-    void update(const tank_array &tanks)
+    void update(const tank_array &tanks, const tank_state_array &states)
 	{
 		try {
-			tank_array red_tanks;
-			tank_array blue_tanks;
-			tank_array::size_type i;
-			for (i = 0; i < tanks.size(); ++i) {
-				try {
-					const tank_ptr tank = tanks[i];
-					if (tank->get_team() == GameSession::RED) {
-						red_tanks.push_back(tank);
-					}
-					else if (tank->get_team() == GameSession::BLUE) {
-						blue_tanks.push_back(tank);
-					}
-					else {
-						// It should never get here.
-						VTANK_ASSERT(false);
-					}
+			tank_state_list red_tanks;
+			tank_state_list blue_tanks;
+			tank_state_array::size_type i;
+			for (i = 0; i < states.size(); ++i) {
+				const Tank_State &state = states[i];
+				if (state.team == GameSession::RED) {
+					red_tanks.push_back(&state);
+				}
+				else if (state.team == GameSession::BLUE) {
+					blue_tanks.push_back(&state);
 				}
-				catch (const TankNotExistException &) {
-					// Nothing to do but ignore it...
+				else {
+					// It should never get here.
+					VTANK_ASSERT(false);
 				}
 			}
 
@@ -20,36 +20,13 @@ Environment_Manager::~Environment_Manager()
 {
 }
 
-int Environment_Manager::generate_unique_id() const
-{
-	const int size = static_cast<int>(effects.size()) + 20;
-	std::map<int, environment_effect_ptr>::const_iterator i;
-	for (int id = 0; id < size; ++id) {
-		bool not_found = true;
-		
-		for (i = effects.begin(); i != effects.end(); ++i) {
-			const environment_effect_ptr env = i->second;
-			if (id == env->get_id()) {
-				not_found = false;
-				break;
-			}
-		}
-		
-		if (not_found)
-			return id;
-	}
-
-	VTANK_ASSERT(false); // it should never reach here.
-	return -1;
-}
-
 void Environment_Manager::inflict_damage(const tank_ptr &tank, 
 	const environment_effect_ptr &env, int damage)
 {
 	tank->inflict_environment_damage(damage, env->get_id(),
 		env->get_property()->id, env->get_owner_id());
 
-	Notifier::blanket_notify_damage_player_by_env(tank->get_id(),
+	Notifier::broadcast_damage_player_by_env(tank,
 		env->get_id(), damage, !tank->is_alive());
 }
 
@@ -78,8 +55,8 @@ void Environment_Manager::update(damageable_map *object_list)
 		const int damage = effect->get_damage();
 		
 		// Check to see if effect damages players.
-		const tank_array tank_list = nodes->get_relevant_players(node_id);
-		for (tank_array::size_type i = 0; i < tank_list.size(); ++i) {
+		const Node_Span tank_list = nodes->get_neighbors(node_id);
+		for (Node_Span::size_type i = 0; i < tank_list.size(); ++i) {
 			const tank_ptr tank = tank_list[i];
 			if (!tank->is_alive() || (effect->get_team() == tank->get_team() && 
 					tank->get_team() != GameSession::NONE) ||
@@ -127,16 +104,16 @@ void Environment_Manager::update(damageable_map *object_list)
 		}
 	}
 
-	while (remove_list.size() > 0) {
-		remove(remove_list[0]);
-		remove_list.erase(remove_list.begin());
+	for (std::vector<int>::size_type j = 0; j < remove_list.size(); ++j) {
+		remove(remove_list[j]);
 	}
 }
 
-int Environment_Manager::spawn(EnvironmentProperty *prop, const GameSession::Alliance &team,
+int Environment_Manager::spawn(const EnvironmentProperty *prop, const GameSession::Alliance &team,
 							   const VTankObject::Point &position, const int owner_id)
 {
-	const int new_id = generate_unique_id();
+	const int new_id = effect_ids.allocate();
+	VTANK_ASSERT(new_id >= 0);
 	const environment_effect_ptr env = environment_effect_ptr(
 		new Active_Environment_Effect(new_id, prop, team, position, owner_id));
 
@@ -149,6 +126,11 @@ int Environment_Manager::spawn(EnvironmentProperty *prop, const GameSession::All
 
 bool Environment_Manager::remove(const int id)
 {
+	if (!effect_ids.is_valid(id)) {
+		// Already removed, or its slot belongs to a newer effect.
+		return false;
+	}
+
 	std::map<int, environment_effect_ptr>::iterator i = effects.find(id);
 	if (i == effects.end()) {
 		// Did not find ID to remove.
@@ -156,6 +138,7 @@ bool Environment_Manager::remove(const int id)
 	}
 
 	(void)effects.erase(i);
+	(void)effect_ids.release(id);
 	return true;
 }
 
@@ -163,3 +146,17 @@ int Environment_Manager::size() const
 {
 	return static_cast<int>(effects.size());
 }
+
+void Environment_Manager::get_effects(std::vector<environment_effect_ptr> &list) const
+{
+	for (std::map<int, environment_effect_ptr>::const_iterator i = effects.begin();
+		i != effects.end(); ++i) {
+		list.push_back(i->second);
+	}
+}
+
+void Environment_Manager::clear()
+{
+	effects.clear();
+	effect_ids.clear();
+}
@@ -10,6 +10,7 @@
 
 #include <envproperty.hpp>
 #include <tank.hpp>
+#include <slotallocator.hpp>
 
 //! Manages in-game environmental effects.
 class Environment_Manager
@@ -17,9 +18,7 @@ class Environment_Manager
 private:
 	bool allow_overlap;
 	std::map<int, environment_effect_ptr> effects;
-	
-	//! Generates a unique ID number for an environment effect.
-	int generate_unique_id() const;
+	Slot_Allocator effect_ids;
 	
 	//! Inflicts damage to a player.
 	void inflict_damage(const tank_ptr &tank, 
@@ -34,7 +33,7 @@ public:
 	~Environment_Manager();
 
 	//! Spawn an environmental effect at a given point.
-	int spawn(EnvironmentProperty *prop, const GameSession::Alliance &team,
+	int spawn(const EnvironmentProperty *prop, const GameSession::Alliance &team,
 		const VTankObject::Point &position, const int owner_id);
 	
 	//! Update the environment manager.
@@ -45,6 +44,9 @@ public:
 
 	//! Gets the size of this container.
 	int size() const;
+
+	//! Add every active effect to the end of a list.
+	void get_effects(std::vector<environment_effect_ptr> &) const;
 	
 	//! Clear all elements from this manager.
 	void clear();
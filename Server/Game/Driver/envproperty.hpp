@@ -19,7 +19,7 @@ class Active_Environment_Effect
 private:
 	int id;
 	int owner_id;
-	EnvironmentProperty *env;
+	const EnvironmentProperty *env;
 	GameSession::Alliance alliance;
 	Point pos;
 	double expire_period;
@@ -27,7 +27,7 @@ private:
 	bool interval_flag;
 
 public:
-	Active_Environment_Effect(const int ID, EnvironmentProperty *environment_prop, 
+	Active_Environment_Effect(const int ID, const EnvironmentProperty *environment_prop, 
 		const GameSession::Alliance &team, const Point &position, const int owner_ID)
 		: id(ID), alliance(team), pos(position), interval_flag(false), owner_id(owner_ID)
 	{
@@ -10,6 +10,8 @@
 class Event
 {
 public:
+	virtual ~Event() {}
+
 	virtual void do_action() = 0;
 };
 
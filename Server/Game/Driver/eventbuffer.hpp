@@ -27,6 +27,8 @@ private:
 
 		item = buffer.front();
 		buffer.pop();
+
+		return true;
 	}
 
 public:
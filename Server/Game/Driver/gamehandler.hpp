@@ -5,6 +5,9 @@
 */
 #ifndef GAMEHANDLER_HPP
 #define GAMEHANDLER_HPP
+
+#include <tankstate.hpp>
+
 //! Abstract interface meant to be implemented by game mode controllers.
 class Game_Handler {
 public:
@@ -18,7 +21,11 @@ public:
 	virtual const GameSession::Alliance get_winning_team() const = 0;
 
 	//! Update the status of the game.
-	virtual void update(const tank_array &) = 0;
+	/*!
+		\param tanks Tanks to notify of changes.
+		\param states Published state of every tank, sorted by ID.
+	*/
+	virtual void update(const tank_array &tanks, const tank_state_array &states) = 0;
 	
 	//! Checks if the game handler has custom spawn points.
 	virtual bool has_custom_spawn_points() = 0;
@@ -0,0 +1,166 @@
+/*!
+    \file   gameinstance.cpp
+    \brief  Implementation of the Game_Instance class and the Arenas namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <gameinstance.hpp>
+#include <logger.hpp>
+#include <vtassert.hpp>
+#if TARGET == LINTARGET
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
+{
+    //! Arenas outlive every thread, so a thread finishing doesn't delete its arena.
+    void keep_instance(Game_Instance *)
+    {
+    }
+
+    boost::thread_specific_ptr<Game_Instance> bound_instance(&keep_instance);
+}
+
+Game_Instance::Scope::Scope(Game_Instance &instance)
+    : previous(bound_instance.get())
+{
+    bound_instance.reset(&instance);
+}
+
+Game_Instance::Scope::~Scope()
+{
+    bound_instance.reset(previous);
+}
+
+Game_Instance::Game_Instance(const int arena_id, const int arena_core)
+    : id(arena_id), core(arena_core), queued_messages(0), sent_messages(0),
+      dropped_messages(0), reported_sends(0), reported_drops(0), game_handler(NULL),
+      input_buffer(INPUT_BUFFER_CAPACITY), reported_overflows(0), current_tick(0),
+      tick_stats(Players::Tick_Statistics()), current_map(NULL),
+      current_game_mode(VTankObject::DEATHMATCH), rotating(false), current_map_id(-1),
+      selection_technique(MapManager::SELECT_ROUND_ROBIN), position_index(0), red_index(0),
+      blue_index(0), prefetched_map(NULL)
+{
+}
+
+std::size_t Game_Instance::get_player_count()
+{
+    std::size_t pending = 0;
+    {
+        boost::lock_guard<boost::mutex> guard(pending_mutex);
+        pending = pending_list.size();
+    }
+
+    return static_cast<std::size_t>(tanks.size()) + pending;
+}
+
+void Game_Instance::pin_thread()
+{
+    if (core < 0) {
+        return;
+    }
+
+#if TARGET == WINTARGET
+    const bool pinned = SetThreadAffinityMask(GetCurrentThread(),
+        static_cast<DWORD_PTR>(1) << core) != 0;
+#elif TARGET == LINTARGET
+    cpu_set_t cores;
+    CPU_ZERO(&cores);
+    CPU_SET(core, &cores);
+    const bool pinned = pthread_setaffinity_np(pthread_self(), sizeof(cores), &cores) == 0;
+#endif
+    if (!pinned) {
+        LOG_STREAM(Logger::LOG_LEVEL_WARNING,
+            "Unable to pin arena " << id << " to processor " << core << ".");
+    }
+}
+
+Game_Instance &Game_Instance::current()
+{
+    Game_Instance *const instance = bound_instance.get();
+    if (instance == NULL) {
+        throw std::logic_error("No arena is bound to this thread.");
+    }
+
+    return *instance;
+}
+
+Game_Instance *Game_Instance::find_current()
+{
+    return bound_instance.get();
+}
+
+namespace Arenas
+{
+    //! Every arena, indexed by number. Only changed by create().
+    std::vector<Game_Instance *> instances;
+
+    void create(const int count, const bool pin_threads)
+    {
+        VTANK_ASSERT(instances.empty());
+
+        // Pinned arenas take the processors in turn; with more arenas than processors,
+        // some share.
+        const int cores = static_cast<int>(boost::thread::hardware_concurrency());
+        for (int i = 0; i < std::max(count, 1); ++i) {
+            const int core = (pin_threads && cores > 0) ? i % cores : -1;
+            instances.push_back(new Game_Instance(i, core));
+        }
+    }
+
+    int count()
+    {
+        return static_cast<int>(instances.size());
+    }
+
+    Game_Instance &get(const int index)
+    {
+        if (index < 0 || index >= count()) {
+            throw std::out_of_range("No such arena.");
+        }
+
+        return *instances[index];
+    }
+
+    Game_Instance &get_least_loaded()
+    {
+        VTANK_ASSERT(!instances.empty());
+
+        Game_Instance *least_loaded = instances[0];
+        std::size_t fewest = least_loaded->get_player_count();
+        for (std::vector<Game_Instance *>::size_type i = 1; i < instances.size(); ++i) {
+            const std::size_t players = instances[i]->get_player_count();
+            if (players < fewest) {
+                least_loaded = instances[i];
+                fewest = players;
+            }
+        }
+
+        return *least_loaded;
+    }
+
+    Game_Instance *find_pending(const std::string &key)
+    {
+        for (std::vector<Game_Instance *>::size_type i = 0; i < instances.size(); ++i) {
+            boost::lock_guard<boost::mutex> guard(instances[i]->pending_mutex);
+            if (instances[i]->pending_list.find(key) != instances[i]->pending_list.end()) {
+                return instances[i];
+            }
+        }
+
+        return NULL;
+    }
+
+    bool manage_players()
+    {
+        for (std::vector<Game_Instance *>::size_type i = 0; i < instances.size(); ++i) {
+            const Game_Instance::Scope scope(*instances[i]);
+            if (!Players::manage_players()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
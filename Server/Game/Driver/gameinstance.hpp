@@ -0,0 +1,201 @@
+/*!
+    \file   gameinstance.hpp
+    \brief  Declares the Game_Instance class, one independent match hosted by the server.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef GAMEINSTANCE_HPP
+#define GAMEINSTANCE_HPP
+
+#include <playermanager.hpp>
+#include <gamemanager.hpp>
+#include <mapmanager.hpp>
+#include <slotallocator.hpp>
+#include <timer.hpp>
+#include <outboundqueue.hpp>
+#include <pointmanager.hpp>
+
+//! How many arenas a server hosts unless configured otherwise.
+#define DEFAULT_ARENA_COUNT 1
+
+namespace MapManager
+{
+    struct Prepared_Map;
+}
+
+/*!
+    A Game_Instance is one arena: a match with its own map, players, node grid,
+    projectiles, utilities, scores and simulation thread. A server hosts one or more of
+    them, and nothing in one arena is seen by the players of another.
+
+    The Players, MapManager and PointManager namespaces work on the arena bound to the
+    calling thread, which is set with a Game_Instance::Scope. Each arena's simulation
+    thread is bound to it for its whole life; anything else which reaches game state,
+    such as an Ice dispatch thread serving a player, binds the player's arena first.
+    Calling into those namespaces from a thread with no arena bound is a logic error.
+
+    The members are public so those namespaces can reach them. What each member holds
+    and how it is guarded is described in the namespace which uses it.
+*/
+class Game_Instance
+{
+private:
+    const int id;
+    const int core;
+
+    Game_Instance(const Game_Instance &);
+    Game_Instance &operator=(const Game_Instance &);
+
+public:
+    //! Binds an arena to the calling thread until it goes out of scope.
+    class Scope
+    {
+    private:
+        Game_Instance *previous;
+
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+
+    public:
+        explicit Scope(Game_Instance &);
+       ~Scope();
+    };
+
+    // Players (playermanager.cpp).
+    TankManager tanks;
+    boost::recursive_mutex player_mutex;
+    boost::mutex pending_mutex;
+    std::map<std::string, Players::pending_ptr> pending_list;
+
+    // Messages (notifier.cpp, outboundqueue.cpp).
+    Recipient_List recipients;
+    volatile long queued_messages;
+    volatile long sent_messages;
+    volatile long dropped_messages;
+    long reported_sends;
+    long reported_drops;
+
+    // Game (gamemanager.cpp).
+    NodeManager nodes;
+    Tank_State_Buffer tank_states;
+    Weapon_Settings weapon_data;
+    Game_Handler *game_handler;
+    Projectile_Manager projectiles;
+    UtilityManager utility_manager;
+    GameTimer timer;
+    std::vector<ActiveUtility> active_utils;
+    Slot_Allocator utility_ids;
+    Input_Buffer input_buffer;
+    long reported_overflows;
+    Ice::Long current_tick;
+    std::vector<int> changed_tanks;
+    std::vector<int> relocated_tanks;
+    boost::thread simulation_thread;
+    Players::Tick_Statistics tick_stats;
+    boost::mutex tick_mutex;
+    Frame_Profiler profiler;
+
+    // Map (mapmanager.cpp).
+    boost::shared_mutex map_mutex;
+    boost::mutex rotate_mutex;
+    Map *current_map;
+    std::string current_map_filename;
+    VTankObject::GameMode current_game_mode;
+    bool rotating;
+    int current_map_id;
+    MapManager::SelectionMode selection_technique;
+    std::vector<VTankObject::Point> generated_positions;
+    std::vector<VTankObject::Point> red_positions;
+    std::vector<VTankObject::Point> blue_positions;
+    std::vector<VTankObject::Point> utility_positions;
+    std::vector<VTankObject::Point>::size_type position_index;
+    std::vector<VTankObject::Point>::size_type red_index;
+    std::vector<VTankObject::Point>::size_type blue_index;
+    boost::thread prefetch_thread;
+    boost::mutex prefetch_mutex;
+    MapManager::Prepared_Map *prefetched_map;
+
+    // Points (pointmanager.cpp).
+    boost::mutex statistics_mutex;
+    PointManager::Statistics_Slot statistics[STATISTICS_SLOTS];
+    std::vector<VTankObject::Statistics> retired_statistics;
+
+    /*!
+        Create an empty arena. It has no map until MapManager::rotate() is called with it
+        bound, and no simulation until Players::start_game() is.
+        \param id Number of the arena, from 0.
+        \param core Processor to run the simulation thread on, or -1 to let the
+        operating system choose.
+    */
+    Game_Instance(const int, const int);
+
+    //! Get the number of the arena, from 0.
+    int get_id() const
+    {
+        return id;
+    }
+
+    /*!
+        Get the number of players in the arena, counting those the main server has sent
+        who haven't joined yet.
+    */
+    std::size_t get_player_count();
+
+    /*!
+        Pin the calling thread to the arena's processor, if it has one. Failure is
+        logged; the thread simply runs wherever the operating system puts it.
+    */
+    void pin_thread();
+
+    /*!
+        Get the arena bound to the calling thread.
+        \throws std::logic_error if no arena is bound.
+    */
+    static Game_Instance &current();
+
+    //! Get the arena bound to the calling thread, or NULL if there is none.
+    static Game_Instance *find_current();
+};
+
+/*!
+    The Arenas namespace holds every Game_Instance the server hosts. They are created
+    once at startup, before the server accepts players, and live until the process
+    exits, so the list may be read from any thread without locking.
+*/
+namespace Arenas
+{
+    /*!
+        Create the arenas. Must be called once, before anything else in this namespace.
+        \param count Number of arenas to host; at least one is created.
+        \param pin_threads True to give each arena's simulation thread its own processor.
+    */
+    void create(const int, const bool);
+
+    //! Get the number of arenas.
+    int count();
+
+    /*!
+        Get an arena by number.
+        \param index Number of the arena, from 0.
+        \throws std::out_of_range if there is no such arena.
+    */
+    Game_Instance &get(const int);
+
+    //! Get the arena with the fewest players, counting players who haven't joined yet.
+    Game_Instance &get_least_loaded();
+
+    /*!
+        Find the arena a pending player was sent to.
+        \param key Session key the main server gave the player.
+        \return Arena holding the key, or NULL if none does.
+    */
+    Game_Instance *find_pending(const std::string &);
+
+    /*!
+        Kick idle players in every arena. Clocks are kept in sync separately, by the
+        Clock_Sync thread.
+        \return False once the server has shut down.
+    */
+    bool manage_players();
+}
+
+#endif
@@ -10,36 +10,33 @@
 #include <player.hpp>
 #include <utility.hpp>
 #include <notifier.hpp>
+#include <interest.hpp>
+#include <lagcompensation.hpp>
 #include <timer.hpp>
 #include <asynctemplate.hpp>
 #include <tankmanager.hpp>
 #include <server.hpp>
 #include <mapmanager.hpp>
 #include <pointmanager.hpp>
+#include <statisticsupload.hpp>
 #include <ctf.hpp>
 #include <ctb.hpp>
 #include <weaponsettings.hpp>
+#include <inputbuffer.hpp>
+#include <slotallocator.hpp>
+#include <tankstate.hpp>
+#include <trace.hpp>
+#include <gameinstance.hpp>
 
 namespace Players
 {
-    NodeManager nodes;
-	Weapon_Settings weapon_data;
-	Game_Handler *game_handler = NULL;
-
     /*!
         The Gamespace namespace holds functions and members that only the
-        GameManager should access.
+        GameManager should access. Everything they work on belongs to the arena bound
+        to the calling thread.
     */
     namespace Gamespace
     {
-        Projectile_Manager projectiles;
-		UtilityManager utility_manager;
-        GameTimer timer;
-		std::vector<ActiveUtility> active_utils;
-
-        //! Threadpool for player tasks. This is where most threads will go.
-        boost::threadpool::pool player_pool(GAME_THREADS);
-
 		Game_Handler *create_game_handler()
 		{
 			const VTankObject::GameMode mode = MapManager::get_current_mode();
@@ -53,6 +50,24 @@ namespace Players
 			return NULL;
 		}
 
+		/*!
+			Load the weapon settings. Tanks and projectiles in play keep their weapons'
+			indices, so this is safe while players are connected. If the files can't be
+			read, the settings in use are kept.
+		*/
+		void load_weapon_data()
+		{
+			Game_Instance &arena = Game_Instance::current();
+			try {
+				arena.weapon_data.load();
+			}
+			catch (const std::exception &ex) {
+				std::ostringstream formatter;
+				formatter << "Cannot load weapon data: " << ex.what();
+				Logger::log(Logger::LOG_LEVEL_ERROR, formatter.str());
+			}
+		}
+
         /*!
             Advance a player's position based on how long they have been moving.
             It's known how long they have been moving by the timestamp given by
@@ -109,8 +124,41 @@ namespace Players
             return distance <= MAX_LEGAL_DISTANCE;
         }
 
+        //! Remember that a tank changed this tick, so it is included in the batched update.
+        void mark_changed(const int id)
+        {
+            Game_Instance &arena = Game_Instance::current();
+            if (std::find(arena.changed_tanks.begin(), arena.changed_tanks.end(), id) ==
+                arena.changed_tanks.end()) {
+                arena.changed_tanks.push_back(id);
+            }
+        }
+
+        /*!
+            Update the tank's node. If it moved to a different one, remember that and tell
+            the player of environment effects they came near.
+        */
+        void update_node(const tank_ptr &tank)
+        {
+            Game_Instance &arena = Game_Instance::current();
+            const int old_node = tank->get_node_id();
+            arena.nodes.process_position(tank);
+
+            if (tank->get_node_id() == old_node) {
+                return;
+            }
+
+            const int id = tank->get_id();
+            if (std::find(arena.relocated_tanks.begin(), arena.relocated_tanks.end(), id) ==
+                arena.relocated_tanks.end()) {
+                arena.relocated_tanks.push_back(id);
+            }
+
+            Notifier::notify_env_effects_entered(tank, old_node);
+        }
+
         /*
-            The following functions are meant to be run as a threadpool scheduled task.
+            The following functions are run on the simulation thread when queued input is drained.
             Documentation is available in the gamemanager.hpp file.
         */
         
@@ -118,10 +166,11 @@ namespace Players
         void task_process_movement(const int& id, const Ice::Long& timestamp, 
             const VTankObject::Direction direction, VTankObject::Point position)
         {
-            Logger::Stack_Logger stack("task_process_movement()", false);
+            Game_Instance &arena = Game_Instance::current();
+            TRACE_POINT("task_process_movement");
 
             try {
-                tank_ptr tank = Players::tanks.get(id);
+                tank_ptr tank = arena.tanks.get(id);
                 if (!tank->is_alive()) {
                     // Can't process the tank if he's not alive.
                     return;
@@ -152,28 +201,11 @@ namespace Players
 
                 tank->set_position(position);
 
-                nodes.process_position(tank);
-
-			    // TODO: This should not distribute the message here.
-                const tank_array tanks = Players::tanks.get_tank_list();
-                for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-                    try {
-                        if (id != tanks[i]->get_id()) {
-					        tanks[i]->get_player_info()->get_callback()->PlayerMove_async(
-                                new VoidAsyncCallback<
-                                    GameSession::AMI_ClientEventCallback_PlayerMove>(),
-                                id, position, direction);
-                        }
-                    }
-                    catch (const Ice::Exception &e) {
-                        std::ostringstream formatter;
-                        formatter << tanks[i]->get_name() 
-                            << " threw an exception while processing rotation: " << e.what();
-                        Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+                update_node(tank);
+                mark_changed(id);
 
-                        (void)Players::remove_player(tanks[i]->get_id());
-                    }
-			    }
+                // Players with update batching or snapshots receive this at the end of the tick.
+                Notifier::broadcast_player_move(id, position, direction);
             }
             catch (const TankNotExistException &) {
                 // Can't do anything: Tank doesn't exist.
@@ -184,10 +216,11 @@ namespace Players
         void task_process_rotation(const int& id, const Ice::Long& timestamp, 
             const Ice::Double& angle, const VTankObject::Direction direction)
         {
-            Logger::Stack_Logger stack("task_process_rotation()", false);
+            Game_Instance &arena = Game_Instance::current();
+            TRACE_POINT("task_process_rotation");
             
             try {
-                tank_ptr tank = Players::tanks.get(id);
+                tank_ptr tank = arena.tanks.get(id);
                 if (!tank->is_alive()) {
                     // Can't process the tank if he's not alive.
                     return;
@@ -201,30 +234,33 @@ namespace Players
                 double new_angle = angle;
                 VTankObject::Point position = tank->get_position();
                 advance_position(position, new_angle, direction, 
-                    tank->get_angular_velocity(), timer.get_delta_time());
+                    tank->get_angular_velocity(), arena.timer.get_delta_time());
 
                 tank->set_angle(new_angle);
+                mark_changed(id);
 
-			    // TODO: This should not distribute the message immediately.
-                const tank_array tanks = Players::tanks.get_tank_list();
-                for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-                    try {
-                        if (id != tanks[i]->get_id()) {
-					        tanks[i]->get_player_info()->get_callback()->PlayerRotate_async(
-                                new VoidAsyncCallback<
-                                    GameSession::AMI_ClientEventCallback_PlayerRotate>(),
-                                id, new_angle, direction);
-                        }
-                    }
-                    catch (const Ice::Exception &e) {
-                        std::ostringstream formatter;
-                        formatter << tanks[i]->get_name() << " threw an exception while processing "
-                            "rotation: " << e.what();
-                        Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+                // Players with update batching or snapshots receive this at the end of the tick.
+                Notifier::broadcast_player_rotate(id, new_angle, direction);
+            }
+            catch (const TankNotExistException &) {
+                // Can't do anything: Tank doesn't exist.
+            }
+        }
+        
+        //! Process a turret spin sent by the client.
+        void task_process_turret(const int &id, const Ice::Double &angle,
+            const VTankObject::Direction direction)
+        {
+            Game_Instance &arena = Game_Instance::current();
+            try {
+                tank_ptr tank = arena.tanks.get(id);
+                if (!tank->is_alive()) {
+                    // Can't process the tank if he's not alive.
+                    return;
+                }
 
-                        (void)Players::remove_player(tanks[i]->get_id());
-                    }
-			    }
+                tank->set_turret(angle, direction);
+                mark_changed(id);
             }
             catch (const TankNotExistException &) {
                 // Can't do anything: Tank doesn't exist.
@@ -235,10 +271,11 @@ namespace Players
         void task_process_fire(const int &id, const Ice::Long &timestamp, 
             const VTankObject::Point &point)
         {
-            Logger::Stack_Logger stack("task_process_fire()", false);
+            Game_Instance &arena = Game_Instance::current();
+            TRACE_POINT("task_process_fire");
             
             try {
-                tank_ptr tank = Players::tanks.get(id);
+                tank_ptr tank = arena.tanks.get(id);
                 if (!tank->is_alive()) {
                     // Can't process the tank if he's not alive.
                     return;
@@ -248,8 +285,16 @@ namespace Players
                 VTankObject::Point position = tank->get_position();
                 const double angle = atan2(point.y - position.y, point.x - position.x);
 
-                // Based on the offset of the player's clock, change the timestamp.
-                //const Ice::Long new_timestamp = player->transform_time(timestamp);
+                // Judge the shot against the tanks as the shooter saw them when firing,
+                // once the player's clock is known well enough to tell when that was.
+                double rewind = 0;
+                if (tank->get_clock().samples > 0) {
+                    rewind = Lag_Compensation::get_rewind_ticks(
+                        static_cast<double>(tank->transform_time(timestamp)),
+                        static_cast<double>(tank->get_player_info()->get_average_latency()),
+                        get_precise_time());
+                }
+
                 //const double calc_x = cos(angle) * PROJECTILE_SPAWN_OFFSET;
                 //const double calc_y = sin(angle) * PROJECTILE_SPAWN_OFFSET;
                 //const double x = position.x + calc_x;
@@ -258,27 +303,30 @@ namespace Players
                 position.x = (position.x + (cos(angle) * PROJECTILE_SPAWN_OFFSET));
                 position.y = (position.y + (sin(angle) * PROJECTILE_SPAWN_OFFSET));
 
-                const Weapon weapon = tank->get_weapon();
+                const weapon_type_index weapon_index = tank->get_weapon_index();
+                const Weapon &weapon = arena.weapon_data.get_table()->get_weapon(weapon_index);
 
 				if (weapon.projectiles_per_shot == 1) {
 					// Only one projectile is fired.
 					VTankObject::Point target;
-					const int projectile_id = projectiles.add(
-						tank->get_id(), angle, position, point, weapon, target);
+					const int projectile_id = arena.projectiles.add(
+						tank->get_id(), angle, position, point, weapon_index, target, rewind);
 					if (projectile_id < 0) {
 						return;
 					}
 
-					Notifier::blanket_notify_create_projectile(
-						id, projectile_id, weapon.projectile.id, target);
+					Notifier::broadcast_create_projectile(tank, projectile_id,
+						weapon.projectile.id, target,
+						Interest::get_projectile_path(position, target, weapon.projectile));
 				}
 				else {
 					// Several projectiles are fired.
 					GameSession::ProjectileDamageList projectile_list;
+					std::vector<Utility::Line> paths;
 					for (int i = 0; i < weapon.projectiles_per_shot; ++i) {
 						VTankObject::Point target;
-						const int projectile_id = projectiles.add(
-							tank->get_id(), angle, position, point, weapon, target);
+						const int projectile_id = arena.projectiles.add(
+							tank->get_id(), angle, position, point, weapon_index, target, rewind);
 						if (projectile_id < 0) {
 							continue;
 						}
@@ -292,9 +340,11 @@ namespace Players
 						projectile.target = target;
 
 						projectile_list.push_back(projectile);
+						paths.push_back(Interest::get_projectile_path(
+							position, target, weapon.projectile));
 					}
 					
-					Notifier::blanket_notify_create_projectiles(projectile_list);
+					Notifier::broadcast_create_projectiles(tank, projectile_list, paths);
 				}
 
 				
@@ -304,94 +354,116 @@ namespace Players
             }
         }
 		
-		//! Generate a unique utility ID number.
-		int generate_utility_id()
+		/*!
+			Apply the input received since the last tick, in the order it arrived. At most
+			one buffer's worth is processed so a flood of input cannot stall the tick.
+		*/
+		void process_input()
 		{
-			int utilityID = -1;
-			bool uniqueFound = false;
-			while (!uniqueFound) {
-				uniqueFound = true;
-				++utilityID;
-				std::vector<ActiveUtility>::iterator i = active_utils.begin();
-				for (; i != active_utils.end(); ++i) {
-					if (i->id == utilityID) {
-						uniqueFound = false;
+			Game_Instance &arena = Game_Instance::current();
+			Input_Command command;
+			long applied = 0;
+			for (; applied < arena.input_buffer.capacity() && arena.input_buffer.pop(command);
+				++applied) {
+				arena.profiler.record_input(command.received);
+				try {
+					switch (command.type) {
+					case Input_Command::MOVE:
+						task_process_movement(command.id, command.timestamp,
+							command.direction, command.point);
+						break;
+
+					case Input_Command::ROTATE:
+						task_process_rotation(command.id, command.timestamp,
+							command.angle, command.direction);
+						break;
+
+					case Input_Command::TURRET:
+						task_process_turret(command.id, command.angle, command.direction);
+						break;
+
+					case Input_Command::FIRE:
+						task_process_fire(command.id, command.timestamp, command.point);
 						break;
 					}
 				}
+				HANDLE_UNCAUGHT_EXCEPTIONS
 			}
+			arena.profiler.set_counter(Profiler::COUNTER_INPUT, applied);
 
-			return utilityID;
+			const long overflows = arena.input_buffer.get_statistics().overflowed;
+			if (overflows != arena.reported_overflows) {
+				std::ostringstream formatter;
+				formatter << "Input buffer overflowed: " << (overflows - arena.reported_overflows)
+					<< " command(s) discarded.";
+				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+
+				arena.reported_overflows = overflows;
+			}
 		}
 
 		//! Handle utility spawning and the like.
 		void handle_utility_spawning()
 		{
+			Game_Instance &arena = Game_Instance::current();
 			// Handle spawning of utilities.
 			const std::vector<ActiveUtility>::size_type arbitrary_maximum = 7;
-			if (active_utils.size() < arbitrary_maximum && utility_manager.is_ready()) {
+			if (arena.active_utils.size() < arbitrary_maximum && arena.utility_manager.is_ready()) {
 				// Next utility ready to spawn.
 				VTankObject::Utility util;
 				VTankObject::Point pos;
 				std::vector<VTankObject::Point> blacklist;
-				const int blacklist_size = static_cast<int>(active_utils.size());
+				const int blacklist_size = static_cast<int>(arena.active_utils.size());
 				for (int i = 0; i < blacklist_size; ++i) {
-					blacklist.push_back(active_utils[i].pos);
+					blacklist.push_back(arena.active_utils[i].pos);
 				}
 
-				utility_manager.get_next_spawn(util, pos, blacklist);
+				arena.utility_manager.get_next_spawn(util, pos, blacklist);
 
-				ActiveUtility powerup = ActiveUtility(generate_utility_id(), util, pos);
-				active_utils.push_back(powerup);
+				ActiveUtility powerup = ActiveUtility(arena.utility_ids.allocate(), util, pos);
+				arena.active_utils.push_back(powerup);
 
-				Notifier::blanket_notify_utility_spawn(Players::tanks.get_tank_list(),
+				Notifier::blanket_notify_utility_spawn(arena.tanks.get_tank_list(),
 					powerup.id, util, pos);
 			}
 		}
 
 		//! Check collision between tanks and utilities.
-		void handle_utility_collision(const tank_array &tanks)
+		void handle_utility_collision(const tank_array &tanks, const tank_state_array &states)
 		{
-			if (tanks.empty() || active_utils.empty()) {
+			Game_Instance &arena = Game_Instance::current();
+			if (states.empty() || arena.active_utils.empty()) {
 				// Nothing to do.
 				return;
 			}
 
-			std::vector<ActiveUtility>::iterator i = active_utils.begin();
-			const int num_tanks = static_cast<int>(tanks.size());
+			std::vector<ActiveUtility>::iterator i = arena.active_utils.begin();
 			
 			std::vector<int> to_remove;
 			
-			for (; i != active_utils.end(); ++i) {
+			for (; i != arena.active_utils.end(); ++i) {
 				const ActiveUtility current_util = *i;
 				const Utility::Rectangle rect(current_util.pos.x, current_util.pos.y, TILE_SIZE, TILE_SIZE);
 				
-				for (int j = 0; j < num_tanks; ++j) {
+				for (tank_state_array::size_type j = 0; j < states.size(); ++j) {
 					// TODO: Loop through only nearby tanks a la NodeManager.
-					try {
-						const tank_ptr tank = tanks[j];
-						if (!tank->is_alive()) {
-							// Dead players cannot receive buffs.
-							continue;
-						}
-
-						const VTankObject::Point position = tank->get_position();
-						
-						if (Utility::circle_to_rectangle_collision(position, TANK_SPHERE_RADIUS, rect)) {
-							// A collision exists between player and tile which has utility.
-							std::ostringstream formatter;
-							formatter << "Utility " << current_util.util.model << " applied to " 
-								<< tank->get_name();
-							Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
-
-							tank->apply_utility(current_util.util);
-							Notifier::blanket_notify_apply_utility(tanks, tank->get_id(), 
-								current_util.id, current_util.util);
-							to_remove.push_back(i->id);
-							break;
-						}
+					const Tank_State &state = states[j];
+					if (!state.alive) {
+						// Dead players cannot receive buffs.
+						continue;
 					}
-					catch (const TankNotExistException &) {
+
+					if (Utility::circle_to_rectangle_collision(state.position, TANK_SPHERE_RADIUS, rect)) {
+						// A collision exists between player and tile which has utility.
+						const tank_ptr tank = state.tank;
+						LOG_STREAM(Logger::LOG_LEVEL_DEBUG, "Utility " << current_util.util.model
+							<< " applied to " << tank->get_name());
+
+						tank->apply_utility(current_util.util);
+						Notifier::blanket_notify_apply_utility(tanks, state.id, 
+							current_util.id, current_util.util);
+						to_remove.push_back(i->id);
+						break;
 					}
 				}
 			}
@@ -399,9 +471,10 @@ namespace Players
 			// Removed expired utilities.
 			std::vector<int>::iterator j = to_remove.begin();
 			for (; j != to_remove.end(); ++j) {
-				for (i = active_utils.begin(); i != active_utils.end(); ++i) {
+				for (i = arena.active_utils.begin(); i != arena.active_utils.end(); ++i) {
 					if (i->id == *j) {
-						active_utils.erase(i);
+						arena.active_utils.erase(i);
+						arena.utility_ids.release(*j);
 						break;
 					}
 				}
@@ -411,12 +484,13 @@ namespace Players
         //! Process each player.
         void process(const tank_ptr tank)
         {
+            Game_Instance &arena = Game_Instance::current();
             if (tank->is_alive()) {
 				tank->check_utility();
 
                 VTankObject::Point position = tank->get_position();
                 double angle = tank->get_angle();
-                const double delta = timer.get_delta_time();
+                const double delta = arena.timer.get_delta_time();
 
                 if (tank->get_movement_direction() != VTankObject::NONE) {
                     // Tank is moving.
@@ -425,7 +499,7 @@ namespace Players
 
                     tank->set_position(position);
 
-                    nodes.process_position(tank);
+                    update_node(tank);
                 }
 
                 if (tank->get_rotation_direction() != VTankObject::NONE) {
@@ -443,7 +517,7 @@ namespace Players
                 if (now >= respawns_at) {
                     // Respawn.
 					generate_spawn_position(tank);
-                    nodes.process_position(tank);
+                    update_node(tank);
                     tank->respawn();
 
                     Notifier::blanket_notify_player_respawn(
@@ -452,31 +526,60 @@ namespace Players
             }
         }
 
-        //! Advance the frame by one and perform new calculations.
+        /*!
+            Add the tank states just published to each tank's position history, for
+            shots fired by lagging players (see Lag_Compensation).
+        */
+        void record_history()
+        {
+            const Tank_State_Buffer::Reader reader(Game_Instance::current().tank_states);
+            const tank_state_array &states = reader.get_states();
+            for (tank_state_array::size_type i = 0; i < states.size(); ++i) {
+                const Tank_State &state = states[i];
+                state.tank->get_history().record(reader.get_tick(), state.position,
+                    state.angle, state.alive);
+            }
+        }
+
+        /*!
+            Advance the simulation by exactly one tick. Phases always run in the
+            same order: input, projectiles, utilities, game mode, tanks.
+            \return False if the simulation should stop; true otherwise.
+        */
         bool process_frame_task()
         {
-            srand(static_cast<unsigned>(IceUtil::Time::now().toMilliSeconds()));
+            Game_Instance &arena = Game_Instance::current();
 
             try {
-                if (Server::server.communicator()->isShutdown()) {
-                    // Stop looping: The server has shut down.
-                    Logger::log(Logger::LOG_LEVEL_INFO, 
-                        "Communicator shut down -- stopping frame processor.");
+                ++arena.current_tick;
+                arena.timer.advance(FRAME_PROCESS_INTERVAL / 1000.0);
 
-                    return false;
-                }
+				process_input();
+				arena.profiler.end_phase(Profiler::PHASE_INPUT);
 
-                timer.advance();
+                // Bucket the tanks moved by input before anything asks for neighbors.
+                const tank_array tanks = arena.tanks.get_tank_list();
+                arena.nodes.rebuild(tanks);
+                arena.profiler.end_phase(Profiler::PHASE_NODES);
 
-				projectiles.process(nodes, timer.get_delta_time());
+				arena.projectiles.process(arena.nodes, arena.timer.get_delta_time());
+				arena.profiler.end_phase(Profiler::PHASE_PROJECTILES);
 
 				handle_utility_spawning();
+				arena.profiler.end_phase(Profiler::PHASE_UTILITY_SPAWNING);
 
-                const tank_array tanks = Players::tanks.get_tank_list();
-				// Do custom game mode updates if necessary.
-				if (game_handler != NULL) {
-					game_handler->update(tanks);
+				{
+					// Game rules read the tanks as they were published at the end of the
+					// previous tick, which is also what every client was last sent.
+					const Tank_State_Buffer::Reader reader(arena.tank_states);
+					handle_utility_collision(tanks, reader.get_states());
+
+					// Do custom game mode updates if necessary.
+					if (arena.game_handler != NULL) {
+						arena.game_handler->update(tanks, reader.get_states());
+					}
 				}
+				arena.profiler.end_phase(Profiler::PHASE_GAME_RULES);
 
                 for (tank_array::size_type i = 0; i < tanks.size(); i++) {
                     try {
@@ -496,13 +599,30 @@ namespace Players
                     }
                     HANDLE_UNCAUGHT_EXCEPTIONS
                 }
+                arena.profiler.end_phase(Profiler::PHASE_TANKS);
+
+                arena.nodes.rebuild(tanks);
+                arena.tank_states.publish(tanks, arena.current_tick);
+                record_history();
+                arena.profiler.end_phase(Profiler::PHASE_PUBLISH);
 
-				handle_utility_collision(tanks);
+                // Send the coalesced movement, rotation and turret changes of this tick.
+                Notifier::broadcast_tank_updates(arena.current_tick, arena.changed_tanks,
+                    arena.relocated_tanks);
+                arena.changed_tanks.clear();
+                arena.relocated_tanks.clear();
+
+                if (arena.current_tick % SNAPSHOT_INTERVAL_TICKS == 0) {
+                    Notifier::broadcast_snapshots(arena.current_tick);
+                }
+                arena.profiler.end_phase(Profiler::PHASE_BROADCAST);
+                arena.profiler.record_broadcast();
 
-                if (timer.get_time() <= 0) {
-					if (game_handler != NULL) {
+                if (arena.timer.get_time() <= 0) {
+					if (arena.game_handler != NULL) {
 						// Credit the winners with 
-						const GameSession::Alliance winning_team = game_handler->get_winning_team();
+						const GameSession::Alliance winning_team =
+							arena.game_handler->get_winning_team();
 						if (winning_team != GameSession::NONE) {
 							for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
 								try {
@@ -517,53 +637,50 @@ namespace Players
 							}
 						}
 
-						delete game_handler;
-						game_handler = NULL;
+						delete arena.game_handler;
+						arena.game_handler = NULL;
 					}
 
                     MapManager::set_rotating(true);
                     MapManager::rotate();
 
-					utility_manager.update_map(MapManager::current_map);
-					active_utils.clear();
-					projectiles.reset();
-                    Players::tanks.organize_teams();
+					arena.utility_manager.update_map(arena.current_map,
+						MapManager::get_utility_positions());
+					arena.active_utils.clear();
+					arena.utility_ids.clear();
+					arena.projectiles.reset();
+					// Pick up any balance changes to the weapon files between maps.
+					load_weapon_data();
+                    arena.tanks.organize_teams();
 					
-					game_handler = create_game_handler();
+					arena.game_handler = create_game_handler();
 
 					VTankObject::StatisticsList stats = PointManager::compile_and_calculate();
 					if (stats.size() > 0) {
-						try {
 #ifdef DEBUG
-							const VTankObject::StatisticsList::size_type size = stats.size();
-							std::ostringstream formatter;
-							formatter << "Sending statistics for ";
-							for (VTankObject::StatisticsList::size_type i = 0; i < size; ++i) {
-								formatter << stats[i].tankName;
-								if (i + 1 < size) {
-									formatter << ", ";
-								}
+						const VTankObject::StatisticsList::size_type size = stats.size();
+						std::ostringstream formatter;
+						formatter << "Queueing statistics for ";
+						for (VTankObject::StatisticsList::size_type i = 0; i < size; ++i) {
+							formatter << stats[i].tankName;
+							if (i + 1 < size) {
+								formatter << ", ";
 							}
-							formatter << ".";
-							Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
-#endif
-							Server::mtg_service.get_proxy()->SendStatistics(stats);
-						}
-						catch (const Ice::Exception &ex) {
-							std::ostringstream formatter;
-							formatter << "Ice threw an exception at SendStatistics: " << ex.what();
-
-							Logger::log(Logger::LOG_LEVEL_ERROR, formatter.str());
 						}
+						formatter << ".";
+						Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
+#endif
+						// Sent from another thread, so a slow main server can't hold up the rotation.
+						Statistics_Upload::submit(stats);
 					}
                     PointManager::reset();
 
                     // Generate a new position for each player.
-                    const tank_array tanks = Players::tanks.get_tank_list();
+                    const tank_array tanks = arena.tanks.get_tank_list();
                     for (tank_array::size_type i = 0; i < tanks.size(); i++) {
                         const tank_ptr tank = tanks[i];
 						tank->set_ready(false);
-                        tank->do_clock_sync();
+                        tank->get_history().clear();
 
                         tank->set_angle(0);
                         tank->set_health(DEFAULT_MAX_HEALTH);
@@ -571,22 +688,27 @@ namespace Players
                         tank->set_movement_direction(VTankObject::NONE);
                         tank->set_rotation_direction(VTankObject::NONE);
 
-						if (game_handler != NULL && game_handler->has_custom_spawn_points()) {
-							game_handler->spawn(tank);
+						if (arena.game_handler != NULL && arena.game_handler->has_custom_spawn_points()) {
+							arena.game_handler->spawn(tank);
 						}
 						else {
 							MapManager::generate_spawn_position(tank);
 						}
 
-                        nodes.process_position(tank);
+                        arena.nodes.process_position(tank);
 
                         PointManager::add_player(tank->get_id());
                     }
 
-                    timer.reset();
+                    // Teams and positions were all reassigned; don't let the next tick's
+                    // game rules see the previous map's state.
+                    arena.tank_states.publish(tanks, arena.current_tick);
+
+                    arena.timer.reset();
                     MapManager::set_rotating(false);
                     
                     Notifier::blanket_notify_rotate_map();
+                    arena.profiler.end_phase(Profiler::PHASE_ROTATION);
                 }
             }
 			catch (const std::logic_error &ex) {
@@ -604,144 +726,398 @@ namespace Players
             
             return true;
         }
+
+        //! Record how long a tick took, and whether it overran its time slice.
+        void record_tick(const double duration)
+        {
+            Game_Instance &arena = Game_Instance::current();
+            bool overrun = false;
+            {
+                boost::lock_guard<boost::mutex> guard(arena.tick_mutex);
+                ++arena.tick_stats.ticks;
+                arena.tick_stats.last_tick_ms = duration;
+                if (duration > arena.tick_stats.worst_tick_ms) {
+                    arena.tick_stats.worst_tick_ms = duration;
+                }
+                if (duration > FRAME_PROCESS_INTERVAL) {
+                    ++arena.tick_stats.overruns;
+                    overrun = true;
+                }
+            }
+
+            if (overrun) {
+                LOG_STREAM(Logger::LOG_LEVEL_DEBUG, "Tick overran its time slice: " << duration
+                    << " ms (limit " << FRAME_PROCESS_INTERVAL << " ms).");
+            }
+        }
+
+        //! Record ticks which were skipped because the simulation fell too far behind.
+        void record_dropped_ticks(const Ice::Long dropped)
+        {
+            Game_Instance &arena = Game_Instance::current();
+            {
+                boost::lock_guard<boost::mutex> guard(arena.tick_mutex);
+                arena.tick_stats.dropped_ticks += dropped;
+            }
+
+            std::ostringstream formatter;
+            formatter << "Simulation fell behind: dropped " << dropped << " tick(s).";
+            Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+        }
+
+        //! Write the frame profile of the interval which just ended to the log.
+        void log_frame_report()
+        {
+            Game_Instance &arena = Game_Instance::current();
+            const Frame_Report report = arena.profiler.take_interval();
+
+            std::ostringstream formatter;
+            formatter << "Frame profile of arena " << arena.get_id() << " over the last "
+                << report.phases[Profiler::PHASE_TICK].get_count()
+                << " ticks (mean / p50 / p99 / p99.9 / max ms):";
+            for (int i = 0; i < Profiler::PHASE_COUNT; ++i) {
+                const Latency_Histogram &phase = report.phases[i];
+                if (phase.get_count() == 0) {
+                    continue;
+                }
+
+                formatter << "\n    " << Profiler::get_phase_name(static_cast<Profiler::Phase>(i))
+                    << ": " << phase.get_mean() << " / " << phase.get_percentile(0.5)
+                    << " / " << phase.get_percentile(0.99) << " / "
+                    << phase.get_percentile(0.999) << " / " << phase.get_max();
+            }
+
+            const Latency_Histogram &input = report.input_latency;
+            formatter << "\n    input to broadcast: " << input.get_mean() << " / "
+                << input.get_percentile(0.5) << " / " << input.get_percentile(0.99) << " / "
+                << input.get_percentile(0.999) << " / " << input.get_max();
+
+            const Latency_Histogram &send = report.send_latency;
+            formatter << "\n    queue to send: " << send.get_mean() << " / "
+                << send.get_percentile(0.5) << " / " << send.get_percentile(0.99) << " / "
+                << send.get_percentile(0.999) << " / " << send.get_max();
+
+            for (int i = 0; i < Profiler::COUNTER_COUNT; ++i) {
+                const Counter_Statistics &counter = report.counters[i];
+                formatter << "\n    "
+                    << Profiler::get_counter_name(static_cast<Profiler::Counter>(i))
+                    << " per tick: mean " << counter.get_mean() << ", peak " << counter.peak;
+            }
+
+            Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
+        }
+
+        //! Process one tick and record how long it took.
+        bool step()
+        {
+            Game_Instance &arena = Game_Instance::current();
+            TRACE_POINT("tick");
+
+            const double tick_start = get_precise_time();
+            arena.profiler.begin_tick();
+            const bool keep_running = process_frame_task();
+
+            arena.profiler.set_counter(Profiler::COUNTER_PROJECTILES,
+                static_cast<Ice::Long>(arena.projectiles.get_projectile_count()));
+            arena.profiler.set_counter(Profiler::COUNTER_EFFECTS,
+                static_cast<Ice::Long>(arena.projectiles.get_effect_count()));
+
+            // Messages are sent, queued and dropped on other threads; the counts are sampled here.
+            const long sent = Atomic::load(arena.sent_messages);
+            const long dropped = Atomic::load(arena.dropped_messages);
+            arena.profiler.set_counter(Profiler::COUNTER_MESSAGES, sent - arena.reported_sends);
+            arena.reported_sends = sent;
+            arena.profiler.set_counter(Profiler::COUNTER_QUEUED,
+                Atomic::load(arena.queued_messages));
+            arena.profiler.set_counter(Profiler::COUNTER_DROPPED,
+                dropped - arena.reported_drops);
+            arena.reported_drops = dropped;
+            arena.profiler.end_tick();
+            record_tick(get_precise_time() - tick_start);
+
+            if (arena.current_tick % (PROFILE_LOG_INTERVAL_MS / FRAME_PROCESS_INTERVAL) == 0) {
+                log_frame_report();
+            }
+
+            return keep_running;
+        }
+
+        /*!
+            Body of the simulation thread. Wall-clock time is accumulated and consumed
+            in fixed FRAME_PROCESS_INTERVAL steps, so the simulation advances at the
+            same rate regardless of how long individual ticks take. If the thread falls
+            more than MAX_CATCH_UP_TICKS behind, the remaining time is dropped instead
+            of spiralling.
+            \param arena Arena to simulate. The thread stays bound to it.
+        */
+        void simulation_loop(Game_Instance *arena)
+        {
+            const Game_Instance::Scope scope(*arena);
+            arena->pin_thread();
+
+            std::ostringstream thread_name;
+            thread_name << "Simulation " << arena->get_id();
+            TRACE_THREAD_NAME(thread_name.str());
+
+            // Seeded once; the runtime may keep a separate rand() state for each thread.
+            srand(static_cast<unsigned>(IceUtil::Time::now().toMilliSeconds()) +
+                static_cast<unsigned>(arena->get_id()));
+
+            const double tick_length = FRAME_PROCESS_INTERVAL;
+            double accumulator = 0;
+            double previous_time = get_precise_time();
+
+            for (;;) {
+                const double current_time = get_precise_time();
+                accumulator += current_time - previous_time;
+                previous_time = current_time;
+
+                int ticks_run = 0;
+                while (accumulator >= tick_length) {
+                    if (ticks_run == MAX_CATCH_UP_TICKS) {
+                        record_dropped_ticks(static_cast<Ice::Long>(accumulator / tick_length));
+                        accumulator = 0;
+                        break;
+                    }
+
+                    if (Server::server.communicator()->isShutdown()) {
+                        // Stop looping: The server has shut down.
+                        Logger::log(Logger::LOG_LEVEL_INFO, 
+                            "Communicator shut down -- stopping frame processor.");
+
+                        return;
+                    }
+
+                    if (!step()) {
+                        return;
+                    }
+
+                    accumulator -= tick_length;
+                    ++ticks_run;
+                }
+
+                // Sleep until the next tick is due.
+                const long remaining = static_cast<long>(
+                    (tick_length - accumulator) * 1000.0);
+                if (remaining > 0) {
+                    boost::this_thread::sleep(boost::posix_time::microseconds(remaining));
+                }
+            }
+        }
     } // Gamespace
 
 	Projectile_Manager *get_projectile_manager()
 	{
-		return &Gamespace::projectiles;
+		return &Game_Instance::current().projectiles;
 	}
 
 	NodeManager *get_node_manager()
 	{
-		return &nodes;
+		return &Game_Instance::current().nodes;
 	}
 
 	void generate_spawn_position(const tank_ptr &player)
 	{
-		if (game_handler != NULL && game_handler->has_custom_spawn_points()) {
-			game_handler->spawn(player);
+		Game_Instance &arena = Game_Instance::current();
+		if (arena.game_handler != NULL && arena.game_handler->has_custom_spawn_points()) {
+			arena.game_handler->spawn(player);
 		}
 		else {
 			MapManager::generate_spawn_position(player);
 		}
 	}
 
+	Tank_State_Buffer *get_tank_states()
+	{
+		return &Game_Instance::current().tank_states;
+	}
+
 	std::vector<ActiveUtility> get_active_utilities()
 	{
-		return Gamespace::active_utils;
+		return Game_Instance::current().active_utils;
 	}
 
 	void send_status_to(const tank_ptr &tank)
 	{
-		if (game_handler != NULL) {
-			game_handler->send_status_to(tank);
+		Game_Instance &arena = Game_Instance::current();
+		if (arena.game_handler != NULL) {
+			arena.game_handler->send_status_to(tank);
 		}
 	}
 
 	Game_Handler *get_game_handler()
 	{
-		return game_handler;
+		return Game_Instance::current().game_handler;
 	}
 
 	int get_red_score()
 	{
-		if (game_handler == NULL) {
+		Game_Instance &arena = Game_Instance::current();
+		if (arena.game_handler == NULL) {
 			return 0;
 		}
 
-		return game_handler->get_red_score();
+		return arena.game_handler->get_red_score();
 	}
 
 	int get_blue_score()
 	{
-		if (game_handler == NULL) {
+		Game_Instance &arena = Game_Instance::current();
+		if (arena.game_handler == NULL) {
 			return 0;
 		}
 
-		return game_handler->get_blue_score();
+		return arena.game_handler->get_blue_score();
 	}
 
     void start_game()
     {
-		Gamespace::utility_manager.update_map(MapManager::current_map);
+        Game_Instance &arena = Game_Instance::current();
+		arena.utility_manager.update_map(arena.current_map,
+			MapManager::get_utility_positions());
 		
-		game_handler = Gamespace::create_game_handler();
+		arena.game_handler = Gamespace::create_game_handler();
 
-		try {
-			weapon_data.load();
-		}
-		catch (const std::exception &ex) {
-			std::ostringstream formatter;
-			formatter << "Cannot load weapon data: " << ex.what();
-			Logger::log(Logger::LOG_LEVEL_ERROR, formatter.str());
-		}
+		Gamespace::load_weapon_data();
+
+        // Process a new frame every tick on the simulation thread.
+        arena.simulation_thread = boost::thread(&Gamespace::simulation_loop, &arena);
+    }
 
-        // Process a new frame every so often.
-        Gamespace::player_pool.schedule(boost::threadpool::looped_task_func(
-			&Gamespace::process_frame_task, FRAME_PROCESS_INTERVAL));
+    bool step()
+    {
+        return Gamespace::step();
     }
 
     void wait_for_tasks()
     {
-        //Gamespace::player_pool.wait(1000);
+        Game_Instance &arena = Game_Instance::current();
+        arena.simulation_thread.join();
+    }
+
+    Tick_Statistics get_tick_statistics()
+    {
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::mutex> guard(arena.tick_mutex);
+        return arena.tick_stats;
+    }
+
+    Frame_Report get_frame_report()
+    {
+        return Game_Instance::current().profiler.get_report();
+    }
+
+    bool accept_input(const tank_ptr &tank)
+    {
+        Game_Instance &arena = Game_Instance::current();
+        if (!tank->get_player_info()->allow_input()) {
+            arena.input_buffer.record_rate_limited();
+            return false;
+        }
+
+        return true;
+    }
+
+    Input_Statistics get_input_statistics()
+    {
+        return Game_Instance::current().input_buffer.get_statistics();
     }
 
     double get_time_left()
     {
-        return Gamespace::timer.get_time();
+        return Game_Instance::current().timer.get_time();
     }
     
     void move(const int& id, const Ice::Long& timestamp, 
         const VTankObject::Direction direction, const VTankObject::Point& position)
     {
+        Game_Instance &arena = Game_Instance::current();
         // Valid values are: FORWARD, REVERSE, STOP.
         if (direction == VTankObject::LEFT || direction == VTankObject::RIGHT) {
             throw Exceptions::BadInformationException("Invalid direction!");
         }
 
-        Gamespace::player_pool.schedule(boost::bind<void>(Gamespace::task_process_movement, 
-            id, timestamp, direction, position));
+        Input_Command command;
+        command.type = Input_Command::MOVE;
+        command.id = id;
+        command.timestamp = timestamp;
+        command.received = get_precise_time();
+        command.direction = direction;
+        command.angle = 0;
+        command.point = position;
+
+        (void)arena.input_buffer.push(command);
     }
 
     void rotate(const int& id, const Ice::Long& timestamp, const Ice::Double& angle, 
         const VTankObject::Direction direction)
     {
+        Game_Instance &arena = Game_Instance::current();
         // Valid values are: LEFT, RIGHT, STOP.
         if (direction == VTankObject::FORWARD || direction == VTankObject::REVERSE) {
             throw Exceptions::BadInformationException("Invalid direction!");
         }
 
-        Gamespace::player_pool.schedule(boost::bind<void>(Gamespace::task_process_rotation, 
-            id, timestamp, angle, direction));
+        Input_Command command;
+        command.type = Input_Command::ROTATE;
+        command.id = id;
+        command.timestamp = timestamp;
+        command.received = get_precise_time();
+        command.direction = direction;
+        command.angle = angle;
+
+        (void)arena.input_buffer.push(command);
     }
 
     void spin_turret(const int &id, const Ice::Long &timestamp, const Ice::Double &angle,
         const VTankObject::Direction direction)
     {
+        Game_Instance &arena = Game_Instance::current();
         // Valid values are: LEFT, RIGHT, STOP.
         if (direction == VTankObject::FORWARD || direction == VTankObject::REVERSE) {
             throw Exceptions::BadInformationException("Invalid direction!");
         }
+
+        Input_Command command;
+        command.type = Input_Command::TURRET;
+        command.id = id;
+        command.timestamp = timestamp;
+        command.received = get_precise_time();
+        command.direction = direction;
+        command.angle = angle;
+
+        (void)arena.input_buffer.push(command);
     }
 
     void fire(const int &id, const Ice::Long &timestamp, const VTankObject::Point &point)
     {
-        Gamespace::player_pool.schedule(boost::bind<void>(Gamespace::task_process_fire, 
-            id, timestamp, point));
+        Game_Instance &arena = Game_Instance::current();
+        Input_Command command;
+        command.type = Input_Command::FIRE;
+        command.id = id;
+        command.timestamp = timestamp;
+        command.received = get_precise_time();
+        command.direction = VTankObject::NONE;
+        command.angle = 0;
+        command.point = point;
+
+        (void)arena.input_buffer.push(command);
     }
 
 	void update_utility_list(const VTankObject::UtilityList &list)
 	{
-		Gamespace::utility_manager.update_utility_list(list);
+		Game_Instance &arena = Game_Instance::current();
+		arena.utility_manager.update_utility_list(list);
 	}
 
 	Weapon_Settings *get_weapon_data()
 	{
-		return &weapon_data;
+		return &Game_Instance::current().weapon_data;
 	}
 
 	void force_timer_zero()
 	{
-		Gamespace::timer.force_timer_to_zero();
+		Game_Instance &arena = Game_Instance::current();
+		arena.timer.force_timer_to_zero();
 	}
 }
@@ -11,10 +11,30 @@
 #include <projectilemanager.hpp>
 #include <gamehandler.hpp>
 #include <weaponsettings.hpp>
+#include <inputbuffer.hpp>
+#include <tankstate.hpp>
+#include <profiler.hpp>
 
 namespace Players
 {
-    extern NodeManager nodes;
+    //! Counters describing how well the simulation is keeping up with its fixed tick.
+    struct Tick_Statistics
+    {
+        //! Number of ticks processed since the game started.
+        Ice::Long ticks;
+
+        //! Number of ticks which took longer than FRAME_PROCESS_INTERVAL.
+        Ice::Long overruns;
+
+        //! Number of ticks skipped because the simulation fell too far behind.
+        Ice::Long dropped_ticks;
+
+        //! Duration (in milliseconds) of the most recent tick.
+        double last_tick_ms;
+
+        //! Duration (in milliseconds) of the slowest tick so far.
+        double worst_tick_ms;
+    };
 
 	/*!
 		Gets the manager responsible for tracking in-game projectiles.
@@ -26,6 +46,11 @@ namespace Players
 	*/
 	NodeManager *get_node_manager();
 	
+	/*!
+		Gets the tanks' state as of the end of the last tick, readable from any thread.
+	*/
+	Tank_State_Buffer *get_tank_states();
+
 	/*!
 		Get the weapon data.
 	*/
@@ -50,16 +75,53 @@ namespace Players
 	std::vector<ActiveUtility> get_active_utilities();
 
     /*!
-        Start the game. This should only be called once.
+        Start the game in the bound arena, on a simulation thread of its own. This
+        should only be called once per arena.
     */
     void start_game();
 
     /*!
-        Block and wait for every task in the thread pool finishes. When this function
-        returns, the Gamespace has no more player actions to process.
+        Run one tick of the simulation on the calling thread, and count it in the tick
+        statistics. This is for tools which drive the simulation themselves, such as the
+        load test; it must not be called once start_game() has started the simulation
+        thread.
+        \return False if the tick failed in a way that would stop the simulation thread.
+    */
+    bool step();
+
+    /*!
+        Block and wait for the bound arena's simulation thread to finish. The simulation thread stops
+        once the communicator shuts down. When this function returns, the Gamespace has
+        no more player actions to process.
     */
     void wait_for_tasks();
 
+    /*!
+        Get a copy of the simulation's tick statistics.
+        \return Tick counters, including the number of overruns.
+    */
+    Tick_Statistics get_tick_statistics();
+
+    /*!
+        Get everything the frame profiler has measured since the game started.
+        \return Per-phase timings, input latency, and per-tick counters.
+    */
+    Frame_Report get_frame_report();
+
+    /*!
+        Check a player's input against their rate limit. Input which is rejected is
+        counted in the input statistics and should be discarded by the caller.
+        \param tank Tank sending the input.
+        \return True if the input may be queued; false otherwise.
+    */
+    bool accept_input(const tank_ptr &);
+
+    /*!
+        Get a copy of the input buffer's counters.
+        \return Number of commands accepted, overflowed, and rate limited.
+    */
+    Input_Statistics get_input_statistics();
+
     /*!
         Get the amount of time left on the current map.
         \return Value in milliseconds.
@@ -80,7 +142,7 @@ namespace Players
 	int get_blue_score();
 
     /*!
-        Execute a task to process a tank movement.
+        Queue a tank movement to be processed on the next tick.
         \param id ID of the tank moving.
         \param timestamp Stamp indicating when the client started to move.
         \param direction The direction the tank is moving towards. 
@@ -92,7 +154,7 @@ namespace Players
         const VTankObject::Direction, const VTankObject::Point&);
 
     /*!
-        Execute a task to process a tank rotation.
+        Queue a tank rotation to be processed on the next tick.
         \param id ID of the tank moving.
         \param timestamp Stamp indicating when the client started to rotate.
         \param angle For synchronization purposes, the client gives us the angle
@@ -104,8 +166,8 @@ namespace Players
         const VTankObject::Direction);
 
     /*!
-        Rather than actually processing this, this function immediately attempts to 
-        distribute the message to other clients.
+        Queue a turret spin to be processed on the next tick. The new turret state is
+        distributed to players which have enabled update batching.
         \param id ID of the tank spinning it's turret.
         \param timestamp Not that it matters, but a stamp indicating when the client's
                          turret starting moving.
@@ -117,7 +179,7 @@ namespace Players
         const VTankObject::Direction);
 
     /*!
-        Execute a task to procses a tank firing his weapon.
+        Queue a tank firing his weapon to be processed on the next tick.
         \param id ID of the tank firing.
         \param timestamp Stamp indicating when the client fired his weapon.
         \param point Position of the mouse-click (relative to the tank).
@@ -0,0 +1,132 @@
+/*!
+    \file   inputbuffer.hpp
+    \brief  Lock-free queue of client input, drained once per simulation tick.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef INPUTBUFFER_HPP
+#define INPUTBUFFER_HPP
+
+#include <ringbuffer.hpp>
+
+//! One piece of client input. This is a plain value type so it can be stored in a ring.
+struct Input_Command
+{
+    enum Type
+    {
+        MOVE,
+        ROTATE,
+        TURRET,
+        FIRE
+    };
+
+    //! Kind of input.
+    Type type;
+
+    //! ID of the tank which sent the input.
+    int id;
+
+    //! Client stamp indicating when the action was performed.
+    Ice::Long timestamp;
+
+    //! Server time (from get_precise_time()) at which the input arrived.
+    double received;
+
+    //! Movement, rotation or turret direction. Unused for FIRE.
+    VTankObject::Direction direction;
+
+    //! Angle of the tank for ROTATE, or of the turret for TURRET.
+    double angle;
+
+    //! Position of the tank for MOVE, or the target for FIRE.
+    VTankObject::Point point;
+};
+
+//! Counters describing the input buffer's traffic.
+struct Input_Statistics
+{
+    //! Number of commands queued.
+    long accepted;
+
+    //! Number of commands discarded because the buffer was full.
+    long overflowed;
+
+    //! Number of commands discarded because the player exceeded their rate limit.
+    long rate_limited;
+};
+
+/*!
+    Bounded multiple-producer/single-consumer queue of Input_Commands. Ice dispatch
+    threads push input as it arrives and the simulation thread drains it once per tick.
+    This is the lock-free successor to Event_Buffer: nothing is allocated per command
+    and producers never block one another.
+*/
+class Input_Buffer
+{
+private:
+    Ring_Buffer<Input_Command> ring;
+    volatile long accepted;
+    volatile long overflowed;
+    volatile long rate_limited;
+
+public:
+    /*!
+        Create the buffer.
+        \param capacity Number of commands the buffer can hold. Must be a power of two.
+    */
+    explicit Input_Buffer(const long capacity)
+        : ring(capacity), accepted(0), overflowed(0), rate_limited(0)
+    {
+    }
+
+    //! Get the maximum number of commands held at once.
+    long capacity() const
+    {
+        return ring.capacity();
+    }
+
+    /*!
+        Queue a command. Safe to call from any thread.
+        \param command Command to queue.
+        \return True if the command was queued; false if the buffer was full and the
+        command was discarded.
+    */
+    bool push(const Input_Command &command)
+    {
+        if (!ring.push(command)) {
+            Atomic::increment(overflowed);
+            return false;
+        }
+
+        Atomic::increment(accepted);
+        return true;
+    }
+
+    /*!
+        Pop the oldest command. Only the simulation thread may call this.
+        \param command [out] Storage for the command.
+        \return True if a command was popped; false if the buffer is empty.
+    */
+    bool pop(Input_Command &command)
+    {
+        return ring.pop(command);
+    }
+
+    //! Count a command which was rejected by a rate limiter before reaching the buffer.
+    void record_rate_limited()
+    {
+        Atomic::increment(rate_limited);
+    }
+
+    //! Get a copy of the buffer's counters.
+    Input_Statistics get_statistics() const
+    {
+        Input_Statistics stats;
+        stats.accepted = Atomic::load(accepted);
+        stats.overflowed = Atomic::load(overflowed);
+        stats.rate_limited = Atomic::load(rate_limited);
+
+        return stats;
+    }
+};
+
+#endif
@@ -0,0 +1,107 @@
+/*!
+    \file   interest.cpp
+    \brief  Implementation of the Interest_Area class and the Interest namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <interest.hpp>
+#include <atomic.hpp>
+#include <logger.hpp>
+
+namespace Interest
+{
+    volatile long always_broadcast =
+        EVENT_PLAYER_DAMAGED | EVENT_ENV_DAMAGE | EVENT_KILLING_BLOW;
+
+    namespace
+    {
+        struct Event_Name
+        {
+            const char *name;
+            Event_Type type;
+        };
+
+        const Event_Name event_names[] = {
+            { "CreateProjectile", EVENT_CREATE_PROJECTILE },
+            { "PlayerDamaged", EVENT_PLAYER_DAMAGED },
+            { "EnvDamage", EVENT_ENV_DAMAGE },
+            { "SpawnEnvEffect", EVENT_SPAWN_ENV_EFFECT },
+            { "KillingBlow", EVENT_KILLING_BLOW }
+        };
+    }
+
+    void set_always_broadcast(const std::string &names)
+    {
+        std::string list = names;
+        std::replace(list.begin(), list.end(), ',', ' ');
+
+        long events = 0;
+        std::istringstream stream(list);
+        std::string name;
+        while (stream >> name) {
+            std::size_t i = 0;
+            const std::size_t count = sizeof(event_names) / sizeof(event_names[0]);
+            while (i < count && name != event_names[i].name) {
+                ++i;
+            }
+
+            if (i == count) {
+                LOG_STREAM(Logger::LOG_LEVEL_WARNING, "Ignoring unknown event \"" << name
+                    << "\" in the always-broadcast list.");
+                continue;
+            }
+
+            events |= event_names[i].type;
+        }
+
+        Atomic::store(always_broadcast, events);
+    }
+
+    bool is_always_broadcast(const int events)
+    {
+        return (Atomic::load(always_broadcast) & events) != 0;
+    }
+
+    Utility::Line get_projectile_path(const VTankObject::Point &origin,
+        const VTankObject::Point &target, const Projectile &type)
+    {
+        // A projectile flies until its range runs out, wherever it was aimed.
+        const double reach = type.range + type.range_variation;
+        const double angle = atan2(target.y - origin.y, target.x - origin.x);
+
+        return Utility::Line(origin.x, origin.y,
+            origin.x + cos(angle) * reach, origin.y + sin(angle) * reach);
+    }
+}
+
+void Interest_Area::add_point(const VTankObject::Point &position)
+{
+    // A point is a line which never leaves its node.
+    paths.push_back(Utility::Line(position.x, position.y, position.x, position.y));
+}
+
+void Interest_Area::add_path(const Utility::Line &path)
+{
+    paths.push_back(path);
+}
+
+void Interest_Area::add_tank(const tank_ptr &tank)
+{
+    tanks.push_back(tank);
+}
+
+void Interest_Area::collect(const NodeManager &nodes, tank_array &players) const
+{
+    players = tanks;
+
+    tank_array near;
+    for (std::vector<Utility::Line>::size_type i = 0; i < paths.size(); ++i) {
+        const Utility::Line &path = paths[i];
+        nodes.get_players_near_line(path.x1, path.y1, path.x2, path.y2, near);
+        players.insert(players.end(), near.begin(), near.end());
+    }
+
+    // Paths cross the same nodes and involved tanks are usually near, so remove repeats.
+    std::sort(players.begin(), players.end());
+    players.erase(std::unique(players.begin(), players.end()), players.end());
+}
@@ -0,0 +1,113 @@
+/*!
+    \file   interest.hpp
+    \brief  Declares the Interest_Area class and the Interest namespace, which decide
+            which players hear about an event.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef INTEREST_HPP
+#define INTEREST_HPP
+
+#include <nodemanager.hpp>
+#include <utility.hpp>
+#include <weapon.hpp>
+
+/*!
+    Events sent to every player unless configured otherwise (see Interest::Event_Type).
+    Health isn't carried by batched updates or snapshots, so damage reaches everyone.
+*/
+#define DEFAULT_ALWAYS_BROADCAST "PlayerDamaged EnvDamage KillingBlow"
+
+/*!
+    The part of the map where an event can be seen or felt, and the players it concerns
+    no matter where they are. A player is interested in the event if their tank is
+    within one node of any point or path in the area, which is the same neighborhood
+    the NodeManager uses for movement, or if they were added by add_tank().
+*/
+class Interest_Area
+{
+private:
+    std::vector<Utility::Line> paths;
+    tank_array tanks;
+
+public:
+    /*!
+        Add a position where the event happens.
+        \param position Position to add.
+    */
+    void add_point(const VTankObject::Point &);
+
+    /*!
+        Add a line along which the event happens, such as the flight of a projectile.
+        \param path Line to add.
+    */
+    void add_path(const Utility::Line &);
+
+    /*!
+        Add a player who is told of the event wherever they are, such as its victim.
+        \param tank Tank of the player.
+    */
+    void add_tank(const tank_ptr &);
+
+    /*!
+        Find every player interested in the event, each listed once. Simulation thread
+        only, like NodeManager::get_neighbors().
+        \param nodes Node manager of the arena.
+        \param players [out] Cleared, then filled with the players found.
+    */
+    void collect(const NodeManager &, tank_array &) const;
+};
+
+/*!
+    The Interest namespace holds the list of events which are sent to every player in
+    the arena instead of those interested in them, and helpers which describe where
+    events happen.
+*/
+namespace Interest
+{
+    //! Kinds of event whose recipients are chosen by area; combined as flags.
+    enum Event_Type
+    {
+        //! "CreateProjectile": one or more projectiles were fired.
+        EVENT_CREATE_PROJECTILE = 1 << 0,
+
+        //! "PlayerDamaged": a projectile damaged a player.
+        EVENT_PLAYER_DAMAGED = 1 << 1,
+
+        //! "EnvDamage": an environment effect damaged a player.
+        EVENT_ENV_DAMAGE = 1 << 2,
+
+        //! "SpawnEnvEffect": an environment effect appeared.
+        EVENT_SPAWN_ENV_EFFECT = 1 << 3,
+
+        //! "KillingBlow": any damage which killed the player, which changes the scores.
+        EVENT_KILLING_BLOW = 1 << 4
+    };
+
+    /*!
+        Set which events are sent to every player. Safe to call at any time.
+        \param names Names of the events (see Event_Type), separated by commas or
+        spaces. Unknown names are logged and ignored; an empty list sends every event
+        by area.
+    */
+    void set_always_broadcast(const std::string &);
+
+    /*!
+        Check if an event is sent to every player.
+        \param events Event_Type flags describing the event.
+        \return True if any of the flags is on the always-broadcast list.
+    */
+    bool is_always_broadcast(const int);
+
+    /*!
+        Get the line a projectile may cover, from where it is fired until its range runs
+        out, heading for its target.
+        \param origin Where the projectile starts.
+        \param target Where the projectile is aimed.
+        \param type Type of the projectile.
+        \return Path of the projectile.
+    */
+    Utility::Line get_projectile_path(const VTankObject::Point &, const VTankObject::Point &,
+        const Projectile &);
+}
+
+#endif
@@ -0,0 +1,109 @@
+/*!
+    \file   lagcompensation.cpp
+    \brief  Implementation of the Position_History class and the Lag_Compensation namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <lagcompensation.hpp>
+#include <atomic.hpp>
+
+Position_History::Position_History()
+    : first(-1), newest(-1)
+{
+}
+
+const Position_Record *Position_History::find(const Ice::Long tick) const
+{
+    if (tick < first || tick > newest || newest - tick >= POSITION_HISTORY_TICKS) {
+        return NULL;
+    }
+
+    const Position_Record &record = records[tick % POSITION_HISTORY_TICKS];
+    return record.tick == tick ? &record : NULL;
+}
+
+void Position_History::record(const Ice::Long tick, const VTankObject::Point &position,
+    const double angle, const bool alive)
+{
+    if (first < 0) {
+        first = tick;
+    }
+    if (tick > newest) {
+        newest = tick;
+    }
+
+    Position_Record &record = records[tick % POSITION_HISTORY_TICKS];
+    record.tick = tick;
+    record.position = position;
+    record.angle = angle;
+    record.alive = alive;
+}
+
+void Position_History::clear()
+{
+    first = -1;
+    newest = -1;
+}
+
+bool Position_History::rewind(const double tick, Position_Record &state) const
+{
+    if (newest < 0) {
+        return false;
+    }
+
+    const Ice::Long oldest = std::max(first, newest - POSITION_HISTORY_TICKS + 1);
+    const double wanted = std::max(std::min(tick, static_cast<double>(newest)),
+        static_cast<double>(oldest));
+    const Ice::Long before_tick = static_cast<Ice::Long>(floor(wanted));
+
+    const Position_Record *before = find(before_tick);
+    if (before == NULL) {
+        return false;
+    }
+
+    const double fraction = wanted - before_tick;
+    const Position_Record *after = fraction > 0 ? find(before_tick + 1) : NULL;
+    if (after == NULL) {
+        state = *before;
+        return true;
+    }
+
+    state.tick = fraction < 0.5 ? before->tick : after->tick;
+    state.angle = fraction < 0.5 ? before->angle : after->angle;
+    state.alive = before->alive && after->alive;
+    if (state.alive) {
+        state.position.x = before->position.x + (after->position.x - before->position.x) * fraction;
+        state.position.y = before->position.y + (after->position.y - before->position.y) * fraction;
+    }
+    else {
+        // A tank which respawned jumps across the map; there is nothing to interpolate.
+        state.position = fraction < 0.5 ? before->position : after->position;
+    }
+
+    return true;
+}
+
+namespace Lag_Compensation
+{
+    volatile long max_rewind = DEFAULT_MAX_REWIND;
+
+    void set_max_rewind(const long milliseconds)
+    {
+        const long longest = (POSITION_HISTORY_TICKS - 1) * FRAME_PROCESS_INTERVAL;
+        Atomic::store(max_rewind, std::max(std::min(milliseconds, longest), 0L));
+    }
+
+    long get_max_rewind()
+    {
+        return Atomic::load(max_rewind);
+    }
+
+    double get_rewind_ticks(const double fired, const double latency, const double now)
+    {
+        // The shooter saw the tanks as they were when the last update left the server.
+        const double lag = now - (fired - latency);
+        const double rewind = std::max(std::min(lag, static_cast<double>(get_max_rewind())), 0.0);
+
+        return rewind / FRAME_PROCESS_INTERVAL;
+    }
+}
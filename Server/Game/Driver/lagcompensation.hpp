@@ -0,0 +1,109 @@
+/*!
+    \file   lagcompensation.hpp
+    \brief  Declares the Position_History class and the Lag_Compensation namespace, which
+            let shots be judged against where the shooter saw their targets.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef LAGCOMPENSATION_HPP
+#define LAGCOMPENSATION_HPP
+
+//! How many ticks of each tank's movement are kept. Must cover the longest rewind.
+#define POSITION_HISTORY_TICKS 128
+
+//! Longest (in milliseconds) a shot is rewound unless configured otherwise.
+#define DEFAULT_MAX_REWIND 250
+
+//! Projectiles at least this fast (units per second) are judged against rewound tanks.
+#define LAG_COMPENSATION_MIN_VELOCITY 2000.0f
+
+//! Where a tank was at the end of one tick.
+struct Position_Record
+{
+    Ice::Long tick;
+    VTankObject::Point position;
+    double angle;
+    bool alive;
+};
+
+/*!
+    The last POSITION_HISTORY_TICKS ticks of a tank's movement, kept in a ring indexed by
+    tick so that recording and looking up a tick are constant time and never allocate.
+    Only the simulation thread may use it.
+*/
+class Position_History
+{
+private:
+    Position_Record records[POSITION_HISTORY_TICKS];
+
+    //! First tick recorded since the history was cleared, or -1 if there is none.
+    Ice::Long first;
+
+    //! Last tick recorded, or -1 if there is none.
+    Ice::Long newest;
+
+    //! Get the record of a tick, or NULL if it wasn't recorded or has been overwritten.
+    const Position_Record *find(const Ice::Long) const;
+
+public:
+    Position_History();
+
+    /*!
+        Record where the tank was at the end of a tick. Ticks should be recorded in order;
+        recording the newest tick again replaces it.
+        \param tick Tick which just ended.
+        \param position Position of the tank.
+        \param angle Angle of the tank.
+        \param alive True if the tank was alive.
+    */
+    void record(const Ice::Long, const VTankObject::Point &, const double, const bool);
+
+    //! Forget every record, such as when the tank is moved to a new map.
+    void clear();
+
+    /*!
+        Find where the tank was at some point in the past. Between two ticks the position
+        is interpolated; a time older than the history is moved up to its oldest tick.
+        \param tick Tick to look up; may fall between two ticks.
+        \param state [out] Where the tank was. It only counts as alive if it was alive at
+        both ticks around the time.
+        \return False if nothing was recorded at that time, in which case the tank's
+        current state should be used.
+    */
+    bool rewind(const double, Position_Record &) const;
+
+    //! Get the last tick recorded, or -1 if there is none.
+    Ice::Long get_newest_tick() const
+    {
+        return newest;
+    }
+};
+
+/*!
+    The Lag_Compensation namespace decides how far back in time a shot is judged. A
+    player sees the other tanks as they were when the last update left the server, so
+    a shot is checked against the tanks as they were that long before it was fired,
+    up to a configurable limit.
+*/
+namespace Lag_Compensation
+{
+    /*!
+        Set the longest time a shot may be rewound. It is kept within what the position
+        histories hold; 0 turns lag compensation off.
+        \param milliseconds Longest rewind.
+    */
+    void set_max_rewind(const long);
+
+    //! Get the longest time a shot may be rewound, in milliseconds.
+    long get_max_rewind();
+
+    /*!
+        Work out how far to rewind the targets of a shot.
+        \param fired Server time the shot was fired, from Tank::transform_time().
+        \param latency How long updates take to reach the shooter, in milliseconds.
+        \param now Server time now.
+        \return Ticks to rewind by, from 0 to the longest rewind.
+    */
+    double get_rewind_ticks(const double, const double, const double);
+}
+
+#endif
@@ -5,15 +5,217 @@
 */
 #include <master.hpp>
 #include <logger.hpp>
+#include <ringbuffer.hpp>
 #include <ctime>
+#include <cstdarg>
 
 namespace Logger
 {
     Log_Level level = LOG_LEVEL_DEBUG;
-    boost::threadpool::pool log_pool(1);
+
+    namespace
+    {
+        //! One queued message. The writer thread owns and deletes the text.
+        struct Log_Record
+        {
+            Log_Level level;
+            time_t time;
+            std::string *message;
+        };
+
+        Ring_Buffer<Log_Record> records(LOG_BUFFER_CAPACITY);
+
+        //! Number of messages dropped because the ring was full.
+        volatile long dropped = 0;
+
+        //! Set to 1 to ask the writer thread to drain the ring and stop.
+        volatile long stop_requested = 0;
+
+        boost::thread writer_thread;
+        boost::once_flag writer_started = BOOST_ONCE_INIT;
+
+        //! Get the local calendar time of a moment.
+        struct tm get_local_time(const time_t t)
+        {
+            struct tm local = tm();
+#if TARGET == WINTARGET
+            (void)localtime_s(&local, &t);
+#elif TARGET == LINTARGET
+            (void)localtime_r(&t, &local);
+#endif
+            return local;
+        }
+
+        /*!
+            The day's log file. It stays open between writes, and is swapped for the
+            next day's file when the first message after midnight is written.
+        */
+        class Log_File
+        {
+        private:
+            std::ofstream out;
+            time_t next_rotation;
+
+            //! Open the file for the day containing a moment.
+            void open(const time_t t)
+            {
+#if TARGET == WINTARGET
+                // Check if "logs" directory exists.
+                if (_access("logs", 0) != 0) {
+                    // Directory doesn't exist.
+                    (void)_mkdir("logs");
+                }
+                const char format[20] = {"logs\\%m-%d-%Y.log"};
+#elif TARGET == LINTARGET
+                if (access("logs", F_OK) != 0) {
+                    // Directory doesn't exist.
+                    (void)mkdir("logs", 0777);
+                }
+                const char format[20] = {"logs/%m-%d-%Y.log"};
+#endif
+                struct tm day = get_local_time(t);
+
+                char log_file_buffer[20];
+                (void)strftime(log_file_buffer, sizeof(log_file_buffer), format, &day);
+
+                out.clear();
+                out.open(log_file_buffer, std::ios_base::app | std::ios_base::ate);
+                if (!out.is_open()) {
+                    // Try again with the next message.
+                    std::cerr << "Log file " << log_file_buffer << " cannot be opened.\n";
+                    return;
+                }
+
+                // The next file starts at the following midnight.
+                day.tm_sec = 0;
+                day.tm_min = 0;
+                day.tm_hour = 0;
+                ++day.tm_mday;
+                day.tm_isdst = -1;
+                next_rotation = mktime(&day);
+            }
+
+        public:
+            Log_File() : next_rotation(0)
+            {
+            }
+
+            //! Write one line. The file is opened, or rotated, first if needed.
+            void write(const Log_Level log_level, const time_t t, const std::string &message)
+            {
+                if (t >= next_rotation) {
+                    close();
+                    open(t);
+                }
+
+                const struct tm current_time = get_local_time(t);
+                const char time_format[12] = {"[%H:%M:%S] "};
+                char time_buffer[12];
+                (void)strftime(time_buffer, sizeof(time_buffer), time_format, &current_time);
+
+                std::string output = time_buffer + to_string(log_level) + message;
+
+                // Replace new line characters with tab-new line characters.
+                for (std::string::size_type i = 0; i < output.size(); i++) {
+                    if (output[i] == '\n') {
+                        output.replace(i, 1, "\n                    ");
+                        i += 2;
+                    }
+                }
+
+                out << output << '\n';
+
+#if defined(DEBUG) || defined(_DEBUG)
+                // It might be interesting to see the output on the console during debug mode.
+                std::cout << output << std::endl;
+#endif
+            }
+
+            void flush()
+            {
+                out.flush();
+            }
+
+            void close()
+            {
+                if (out.is_open()) {
+                    out.close();
+                }
+            }
+        };
+
+        /*!
+            Body of the writer thread. Queued messages are written as they arrive and
+            flushed every LOG_FLUSH_INTERVAL_MS; errors are flushed straight away.
+        */
+        void write_records()
+        {
+            Log_File file;
+            long reported_drops = 0;
+            double last_flush = get_current_time();
+
+            for (;;) {
+                // Checked before draining, so everything queued before shutdown() is kept.
+                const bool stopping = Atomic::load(stop_requested) != 0;
+
+                bool wrote = false;
+                bool urgent = false;
+                Log_Record record;
+                while (records.pop(record)) {
+                    file.write(record.level, record.time, *record.message);
+                    delete record.message;
+
+                    wrote = true;
+                    urgent = urgent || record.level >= LOG_LEVEL_ERROR;
+                }
+
+                const long drops = Atomic::load(dropped);
+                if (drops != reported_drops) {
+                    std::ostringstream formatter;
+                    formatter << "Log queue overflowed: " << (drops - reported_drops)
+                        << " message(s) discarded.";
+                    file.write(LOG_LEVEL_WARNING, time(0), formatter.str());
+
+                    reported_drops = drops;
+                    wrote = true;
+                }
+
+                const double now = get_current_time();
+                if (stopping || urgent || now - last_flush >= LOG_FLUSH_INTERVAL_MS) {
+                    file.flush();
+                    last_flush = now;
+                }
+
+                if (stopping) {
+                    break;
+                }
+
+                if (!wrote) {
+                    boost::this_thread::sleep(
+                        boost::posix_time::milliseconds(LOG_POLL_INTERVAL_MS));
+                }
+            }
+
+            file.close();
+        }
+
+        void start_writer()
+        {
+            writer_thread = boost::thread(&write_records);
+        }
+
+        //! Stops the writer at exit, before the ring it reads from is destroyed.
+        struct Writer_Guard
+        {
+            ~Writer_Guard()
+            {
+                shutdown();
+            }
+        } writer_guard;
+    }
 
     Stack_Logger::Stack_Logger(const std::string &function_name, bool debug)
-        : function(function_name), debug_enabled(debug)
+        : function(function_name), debug_enabled(debug && is_enabled(LOG_LEVEL_DEBUG))
     {
         if (debug_enabled)
             log(LOG_LEVEL_DEBUG, "Entering " + function);
@@ -29,7 +231,7 @@ namespace Logger
 		if (debug_enabled) {
             debug("Exiting %s (took %d ms to finish)", function.c_str(), elapsed);
 		}
-		
+
         if (elapsed >= STACK_THRESHOLD_MS) {
             std::ostringstream formatter;
             formatter << function << " took " << elapsed << " ms to finish.";
@@ -42,93 +244,52 @@ namespace Logger
         level = log_level;
     }
 
-    void log_task(const Log_Level log_level, std::string message)
+    bool is_enabled(const Log_Level log_level)
     {
-        // Replace new line characters with tab-new line characters.
-        for (std::string::size_type i = 0; i < message.size(); i++) {
-            if (message[i] == '\n') {
-                message.replace(i, 1, "\n                    ");
-                i += 2;
-            }
-        }
-
-#if TARGET == WINTARGET
-        // Check if "logs" directory exists.
-        if (_access("logs", 0) != 0) {
-            // Directory doesn't exist.
-            if (_mkdir("logs") != 0) {
-                throw std::runtime_error("Unable to create \"logs\" directory.");
-            }
-        }
-        const char format[20] = {"logs\\%m-%d-%Y.log"};
-#elif TARGET == LINTARGET
-        if (access("logs", F_OK) != 0) {
-            // Directory doesn't exist.
-            if (mkdir("logs", 0777) != 0) {
-                throw std::runtime_error("Unable to create \"logs\" directory.");
-            }
-        }
-        const char format[20] = {"logs/%m-%d-%Y.log"};
-#endif
-
-        char log_file_buffer[20];
-
-        // Get current date and time.
-        const time_t t = time(0);
-        struct tm current_time = tm();
-
-#if TARGET == WINTARGET
-        (void)localtime_s(&current_time, &t);
-#elif TARGET == LINTARGET
-        (void)localtime_r(&t, &current_time);
-#endif
-
-        (void)strftime(log_file_buffer, sizeof(log_file_buffer), format, &current_time);
-
-        // Open file in append mode and set the position of the cursor to the end.
-        std::ofstream out(log_file_buffer, std::ios_base::app | std::ios_base::ate);
-        if (!out.is_open()) {
-            // File can't be opened.
-            throw std::runtime_error("Log file cannot be opened.");
-        }
-
-        const char time_format[12] = {"[%H:%M:%S] "};
-        char time_buffer[12];
-        (void)strftime(time_buffer, sizeof(time_buffer), time_format, &current_time);
-
-        std::ostringstream formatter;
-        formatter << time_buffer << to_string(log_level) << message;
-        const std::string output = formatter.str();
-        out << output << std::endl;
-
-#if defined(DEBUG) || defined(_DEBUG)
-        // It might be interesting to see the output on the console during debug mode.
-        std::cout << output << std::endl;
-#endif
-
-        out.close();
+        return log_level >= level;
     }
 
 	void debug(const std::string message, ...)
 	{
+		if (!is_enabled(LOG_LEVEL_DEBUG)) {
+			return;
+		}
+
 		va_list list;
 		va_start(list, message);
-		
+
 		char buf[1024];
 		vsprintf_s(buf, message.c_str(), list);
 		va_end(list);
-		
+
 		log(Logger::LOG_LEVEL_DEBUG, std::string(buf));
 	}
 
-    void log(const Log_Level log_level, const std::string message)
+    void log(const Log_Level log_level, const std::string &message)
     {
-        if (log_level < level) {
+        if (!is_enabled(log_level)) {
             // Too high: we don't care about it.
             return;
         }
 
-        log_pool.schedule(boost::bind<void>(log_task, log_level, message));
+        boost::call_once(writer_started, &start_writer);
+
+        Log_Record record;
+        record.level = log_level;
+        record.time = time(0);
+        record.message = new std::string(message);
+        if (!records.push(record)) {
+            delete record.message;
+            Atomic::increment(dropped);
+        }
+    }
+
+    void shutdown()
+    {
+        Atomic::store(stop_requested, 1);
+        if (writer_thread.joinable()) {
+            writer_thread.join();
+        }
     }
 
     std::string to_string(const Log_Level log_level, const bool trailing_white_space)
@@ -6,11 +6,28 @@
 #ifndef LOGGER_HPP
 #define LOGGER_HPP
 
+/*!
+    Log a message built with stream insertions, such as "name << " joined."". Nothing is
+    formatted unless the level is enabled, so this is the cheap way to log from code
+    which runs every tick.
+    \param log_level Type of message.
+    \param message Expression to insert into a std::ostringstream.
+*/
+#define LOG_STREAM(log_level, message) \
+    do { \
+        if (Logger::is_enabled(log_level)) { \
+            std::ostringstream log_formatter; \
+            log_formatter << message; \
+            Logger::log(log_level, log_formatter.str()); \
+        } \
+    } while (false)
+
 /*!
     The Logger namespace logs events of any kind (DEBUG, WARNING, ERROR) depending
-    on what the user wishes to log. The Logger uses a threadpool with a single thread.
-    It's done in a thread so that the logger task is executed immediately while the task
-    that requested the log returns.
+    on what the user wishes to log. Messages are queued on a lock-free ring and written
+    by a single writer thread, which keeps the day's log file open, buffers its writes,
+    and flushes them every LOG_FLUSH_INTERVAL_MS. The thread which logged a message
+    never waits on the disk.
 */
 namespace Logger
 {
@@ -77,20 +94,36 @@ namespace Logger
     */
     void set_log_level(const Log_Level);
 
+    /*!
+        Check whether messages of a level would be logged. Use this to avoid building
+        a message which would be thrown away.
+        \param log_level Level to check.
+        \return True if messages of this level are logged.
+    */
+    bool is_enabled(const Log_Level);
+
 	/*!
-		Log a LOG_LEVEL_DEBUG message.
+		Log a LOG_LEVEL_DEBUG message. Nothing is formatted unless debug messages are
+		enabled.
 		\param message Message to log with formatting supported.
 		\param ... Strings to insert into the formatting.
 	*/
 	void debug(const std::string, ...);
 
     /*!
-        Execute a task to log a message.
+        Queue a message for the writer thread. If the queue is full, the message is
+        dropped and counted; the count is written to the log once there's room.
         \param log_level Type of message. If the log level given does not meet the minimum
                          log level requirement, the message will not be logged.
         \param message Message to log.
     */
-    void log(const Log_Level, const std::string);
+    void log(const Log_Level, const std::string &);
+
+    /*!
+        Write out every queued message, close the log file, and stop the writer thread.
+        Messages logged afterwards are discarded.
+    */
+    void shutdown();
 
     /*!
         Convert a log level enum type to it's string equivalent.
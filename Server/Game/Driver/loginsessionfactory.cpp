@@ -11,6 +11,8 @@
 #include <gamemanager.hpp>
 #include <tank.hpp>
 #include <mapmanager.hpp>
+#include <gameinstance.hpp>
+#include <notifier.hpp>
 
 LoginSessionFactory::LoginSessionFactory()
 {
@@ -25,6 +27,14 @@ GameSession::GameInfoPrx LoginSessionFactory::JoinServer(const std::string& key,
     const GameSession::ClientEventCallbackPrx& callback, const Ice::Current& c)
 {
     try {
+        // The key tells which arena the main server sent the player to.
+        Game_Instance *const arena = Arenas::find_pending(key);
+        if (arena == NULL) {
+            LOG_STREAM(Logger::LOG_LEVEL_WARNING, "JoinServer(): Key doesn't exist: " << key);
+            throw Exceptions::PermissionDeniedException("That session key is invalid.");
+        }
+        const Game_Instance::Scope scope(*arena);
+
         // Calling is_rotating() will block until it's actually not rotating.
         while (MapManager::is_rotating())
 			boost::this_thread::sleep(boost::posix_time::milliseconds(5));
@@ -46,17 +56,19 @@ GameSession::GameInfoPrx LoginSessionFactory::JoinServer(const std::string& key,
         Players::remove_pending(key);
 
         // Ice's garbage collector will take care of deallocating the player object.
-        const player_ptr player(new PlayerInfo(new_callback, new_clock));
+        const player_ptr player(new PlayerInfo(new_callback, new_clock,
+            outbound_ptr(new Outbound_Queue(new_callback, *arena, tank.id))));
         const tank_ptr player_tank(new Tank(
-            tank, player, Players::tanks.get_next_team_assignment()));
+            tank, player, Players::get_tank_manager()->get_next_team_assignment()));
 
 		Logger::debug("Player #%d (%s) joined the game.", tank.id, tank.attributes.name.c_str());
 
 		Players::generate_spawn_position(player_tank);
 		Players::add_player(player_tank);
-        Players::nodes.process_position(player_tank);
+        Players::get_node_manager()->process_position(player_tank);
+        Notifier::notify_env_effects_entered(player_tank, -1);
 
-        GameSession::GameInfoPtr player_servant = new Player(player_tank->get_id());
+        GameSession::GameInfoPtr player_servant = new Player(*arena, player_tank->get_id());
         Ice::ObjectPrx ice_object = c.adapter->addWithUUID(player_servant);
         player_tank->set_ice_id(ice_object->ice_getIdentity());
 
@@ -9,11 +9,8 @@
 //! Number of threads dedicated to login handling/tasklets.
 #define PLAYER_THREADS 2
 
-//! Number of threads dedicated to game tasks.
-#define GAME_THREADS 20
-
-//! Number of threads dedicated to calculating points.
-#define STATISTICS_THREADS 1
+//! Number of threads dedicated to sending messages to players.
+#define SENDER_THREADS 2
 
 //! Size of the tiles.
 #define TILE_SIZE 64
@@ -30,12 +27,54 @@
 //! Default radius for projectiles.
 #define BULLET_RADIUS 8.0f
 
-//! How often (in milliseconds) to perform a clock sync.
-#define CLOCK_SYNC_INTERVAL 60000
+//! How often (in milliseconds) a synchronized player's clock is sampled again.
+#define CLOCK_SYNC_INTERVAL 15000
+
+//! How long (in milliseconds) between the requests sent when a player joins.
+#define CLOCK_SYNC_BURST_INTERVAL 1000
+
+//! How many samples of a player's clock are kept to choose the best from.
+#define CLOCK_SYNC_SAMPLES 8
+
+//! How far apart (in milliseconds) two samples must be to measure clock drift from.
+#define CLOCK_SYNC_MIN_DRIFT_SPAN 30000.0
+
+//! Fastest a client's clock is believed to drift (milliseconds per millisecond).
+#define CLOCK_SYNC_MAX_DRIFT 0.0005
 
-//! How often (in milliseconds) to process a frame.
+//! Width (in milliseconds) of each slot of the clock sync timer wheel.
+#define CLOCK_SYNC_WHEEL_RESOLUTION 100
+
+//! Number of slots in the clock sync timer wheel.
+#define CLOCK_SYNC_WHEEL_SLOTS 256
+
+//! How often (in milliseconds) to process a frame. This is the fixed simulation tick.
 #define FRAME_PROCESS_INTERVAL 5
 
+//! How many ticks the simulation may run back-to-back to catch up before dropping time.
+#define MAX_CATCH_UP_TICKS 8
+
+//! How many input commands can be queued between ticks (must be a power of two).
+#define INPUT_BUFFER_CAPACITY 4096
+
+//! How many move, rotate, or fire commands a single player may send per second.
+#define MAX_INPUT_PER_SECOND 100
+
+//! How many ticks pass between snapshots for players using snapshot updates.
+#define SNAPSHOT_INTERVAL_TICKS 10
+
+//! How many messages may wait to be sent to one player.
+#define OUTBOUND_QUEUE_CAPACITY 256
+
+//! How many messages a sender thread sends to one player before moving to the next.
+#define OUTBOUND_BATCH_SIZE 32
+
+//! How many messages to one player Ice may hold unwritten before the queue waits.
+#define OUTBOUND_MAX_IN_FLIGHT 64
+
+//! How many idle AMI callbacks of each type are kept for reuse.
+#define OUTBOUND_CALLBACK_POOL_SIZE 256
+
 //! How many milliseconds per game.
 #define TIME_PER_GAME_MS 274000
 
@@ -51,6 +90,25 @@
     #define MAPS_DIR "maps/"
 #endif
 
+//! Define the relative path to the memory-mappable (version 2) copies of the maps.
+#if TARGET == WINTARGET
+    #define MAP_CACHE_DIR MAPS_DIR "cache\\"
+#elif TARGET == LINTARGET
+    #define MAP_CACHE_DIR MAPS_DIR "cache/"
+#endif
+
+//! File in the maps folder which remembers the digest of each map.
+#define MAP_HASH_INDEX MAPS_DIR "hashes.idx"
+
+//! How long the main server's word that a map's digest is valid is trusted.
+#define MAP_HASH_TTL_SECONDS 3600
+
+//! Bytes read at a time while hashing a map file.
+#define MAP_HASH_BLOCK_SIZE 262144
+
+//! Requests in a row which may fail before a map download is given up.
+#define MAP_DOWNLOAD_ATTEMPTS 5
+
 #define HANDLE_UNCAUGHT_EXCEPTIONS \
 catch (const std::exception &e) {\
     std::ostringstream formatter;\
@@ -74,11 +132,38 @@ catch (...) {\
 //! How long to wait until producing a warning in the stack.
 #define STACK_THRESHOLD_MS 100
 
+//! How many log messages can be waiting for the writer thread (must be a power of two).
+#define LOG_BUFFER_CAPACITY 4096
+
+//! How often (in milliseconds) the log file is flushed to disk.
+#define LOG_FLUSH_INTERVAL_MS 1000
+
+//! How long (in milliseconds) the log writer sleeps when there is nothing to write.
+#define LOG_POLL_INTERVAL_MS 10
+
+//! How often (in milliseconds) the frame profile is written to the log.
+#define PROFILE_LOG_INTERVAL_MS 60000
+
+//! How many timed scopes each thread keeps for the trace (see trace.hpp).
+#define TRACE_BUFFER_EVENTS 16384
+
+//! Default number of scopes per recorded scope when built with VTANK_TRACE.
+#define TRACE_SAMPLE_RATE 1
+
+//! Size (in bytes) of a cache line on the machines the server runs on.
+#define CACHE_LINE_SIZE 64
+
 static inline double get_current_time()
 {
 	return static_cast<double>(IceUtil::Time::now().toMilliSeconds());
 }
 
+//! Get the current time in milliseconds with sub-millisecond precision.
+static inline double get_precise_time()
+{
+	return static_cast<double>(IceUtil::Time::now().toMicroSeconds()) / 1000.0;
+}
+
 static inline int random_next(int minimum, int maximum)
 {
 	return minimum + rand() / (RAND_MAX / (maximum - minimum + 1) + 1);
@@ -60,6 +60,7 @@ int main(const int argc, const char * const argv[])
         const int return_code = Server::mtg_service.main(args);
 
         Logger::log(Logger::LOG_LEVEL_INFO, "The server finished running.");
+        Logger::shutdown();
 
         return return_code;
 	}
@@ -67,5 +68,6 @@ int main(const int argc, const char * const argv[])
         Logger::log(Logger::LOG_LEVEL_ERROR, "Unhandled exception.");
 	}
 
+    Logger::shutdown();
     return 1;
 }
@@ -0,0 +1,260 @@
+/*!
+    \file   maphashindex.cpp
+    \brief  Implementation of the Map_Hash_Index class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include "SHA1.h"
+#include <maphashindex.hpp>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if TARGET == LINTARGET
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+namespace
+{
+    //! Finish a hash and write its digest in lower-case hex.
+    std::string finish_hash(CSHA1 &sha1)
+    {
+        sha1.Final();
+        UINT_8 hash[20];
+        (void)sha1.GetHash(hash);
+
+        const char hex_digits[] = "0123456789abcdef";
+        std::string digest(40, '0');
+        for (int i = 0; i < 20; ++i) {
+            digest[2 * i] = hex_digits[hash[i] >> 4];
+            digest[2 * i + 1] = hex_digits[hash[i] & 0x0F];
+        }
+
+        return digest;
+    }
+}
+
+Map_Hash_Index::Map_Hash_Index(const std::string &path)
+    : index_path(path)
+{
+}
+
+bool Map_Hash_Index::load()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    entries.clear();
+
+    std::ifstream in(index_path.c_str());
+    if (!in.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        Entry entry;
+        if (!(fields >> entry.digest >> entry.size >> entry.modified >> entry.verified)) {
+            continue;
+        }
+
+        // The filename is everything after the single space which follows the numbers.
+        std::string filename;
+        if (fields.get() != ' ' || !std::getline(fields, filename) || filename.empty() ||
+            entry.digest.size() != 40) {
+            continue;
+        }
+
+        entries[filename] = entry;
+    }
+
+    return true;
+}
+
+bool Map_Hash_Index::save()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    const std::string new_path = index_path + ".new";
+    {
+        std::ofstream out(new_path.c_str(), std::ios_base::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+
+        for (std::map<std::string, Entry>::const_iterator i = entries.begin();
+            i != entries.end(); ++i) {
+            out << i->second.digest << ' ' << i->second.size << ' ' << i->second.modified
+                << ' ' << i->second.verified << ' ' << i->first << '\n';
+        }
+
+        out.flush();
+        if (!out) {
+            out.close();
+            (void)::remove(new_path.c_str());
+            return false;
+        }
+    }
+
+#if TARGET == WINTARGET
+    const bool replaced = MoveFileExA(new_path.c_str(), index_path.c_str(),
+        MOVEFILE_REPLACE_EXISTING) != 0;
+#elif TARGET == LINTARGET
+    const bool replaced = rename(new_path.c_str(), index_path.c_str()) == 0;
+#endif
+    if (!replaced) {
+        (void)::remove(new_path.c_str());
+    }
+
+    return replaced;
+}
+
+bool Map_Hash_Index::find_digest(const std::string &filename, const Ice::Long size,
+                                 const Ice::Long modified, std::string &digest)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    std::map<std::string, Entry>::const_iterator i = entries.find(filename);
+    if (i == entries.end() || i->second.size != size || i->second.modified != modified) {
+        return false;
+    }
+
+    digest = i->second.digest;
+    return true;
+}
+
+void Map_Hash_Index::set_digest(const std::string &filename, const Ice::Long size,
+                                const Ice::Long modified, const std::string &digest)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    Entry &entry = entries[filename];
+    if (entry.digest != digest) {
+        entry.digest = digest;
+        entry.verified = 0;
+    }
+    entry.size = size;
+    entry.modified = modified;
+}
+
+bool Map_Hash_Index::is_verified(const std::string &filename, const std::string &digest,
+                                 const Ice::Long now, const Ice::Long ttl)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    std::map<std::string, Entry>::const_iterator i = entries.find(filename);
+    if (i == entries.end() || i->second.digest != digest || i->second.verified == 0) {
+        return false;
+    }
+
+    // A clock which went backwards doesn't make an old answer good forever.
+    return now >= i->second.verified && now - i->second.verified < ttl;
+}
+
+void Map_Hash_Index::set_verified(const std::string &filename, const std::string &digest,
+                                  const Ice::Long now)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    std::map<std::string, Entry>::iterator i = entries.find(filename);
+    if (i != entries.end() && i->second.digest == digest) {
+        i->second.verified = now;
+    }
+}
+
+void Map_Hash_Index::remove(const std::string &filename)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+    entries.erase(filename);
+}
+
+std::size_t Map_Hash_Index::size()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+    return entries.size();
+}
+
+bool Map_Hash_Index::get_file_info(const std::string &path, Ice::Long &size,
+                                   Ice::Long &modified)
+{
+#if TARGET == WINTARGET
+    struct _stati64 status;
+    if (_stati64(path.c_str(), &status) != 0) {
+        return false;
+    }
+#elif TARGET == LINTARGET
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0) {
+        return false;
+    }
+#endif
+    size = static_cast<Ice::Long>(status.st_size);
+    modified = static_cast<Ice::Long>(status.st_mtime);
+    return true;
+}
+
+bool Map_Hash_Index::hash_file(const std::string &path, std::string &digest)
+{
+    std::vector<UINT_8> block(MAP_HASH_BLOCK_SIZE);
+    CSHA1 sha1;
+
+#if TARGET == WINTARGET
+    const HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    bool succeeded = true;
+    for (;;) {
+        DWORD bytes_read = 0;
+        if (!ReadFile(file, &block[0], static_cast<DWORD>(block.size()), &bytes_read, NULL)) {
+            succeeded = false;
+            break;
+        }
+        if (bytes_read == 0) {
+            break;
+        }
+        sha1.Update(&block[0], static_cast<UINT_32>(bytes_read));
+    }
+    (void)CloseHandle(file);
+#elif TARGET == LINTARGET
+    const int file = open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        return false;
+    }
+    (void)posix_fadvise(file, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    bool succeeded = true;
+    for (;;) {
+        const ssize_t bytes_read = read(file, &block[0], block.size());
+        if (bytes_read < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            succeeded = false;
+            break;
+        }
+        if (bytes_read == 0) {
+            break;
+        }
+        sha1.Update(&block[0], static_cast<UINT_32>(bytes_read));
+    }
+    (void)close(file);
+#endif
+    if (!succeeded) {
+        return false;
+    }
+
+    digest = finish_hash(sha1);
+    return true;
+}
+
+std::string Map_Hash_Index::hash_data(const std::vector<unsigned char> &data)
+{
+    CSHA1 sha1;
+    if (!data.empty()) {
+        sha1.Update(&data[0], static_cast<UINT_32>(data.size()));
+    }
+
+    return finish_hash(sha1);
+}
@@ -0,0 +1,135 @@
+/*!
+    \file   maphashindex.hpp
+    \brief  Declares the Map_Hash_Index class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef MAPHASHINDEX_HPP
+#define MAPHASHINDEX_HPP
+
+/*!
+    Remembers the SHA-1 digest of every map file, keyed by the file's name, size and
+    modification time, so a map which hasn't changed since it was last seen isn't
+    hashed again. Each digest also carries the time the main server last said it was
+    valid; within MAP_HASH_TTL_SECONDS of that, the server doesn't need to be asked.
+
+    The index lives in a text file with one map per line:
+    \code
+    digest size modified verified filename
+    \endcode
+    Times are seconds since the epoch, and a verified time of 0 means the server hasn't
+    vouched for the digest. The filename is last so that it may contain spaces. A
+    missing or damaged file only means maps are hashed and checked again.
+
+    Every method is safe to call from any thread.
+*/
+class Map_Hash_Index
+{
+private:
+    //! What is known about one map file.
+    struct Entry
+    {
+        Ice::Long size;
+        Ice::Long modified;
+        std::string digest;
+        Ice::Long verified;
+    };
+
+    boost::mutex mutex;
+    const std::string index_path;
+    std::map<std::string, Entry> entries;
+
+    Map_Hash_Index(const Map_Hash_Index &);
+    Map_Hash_Index &operator=(const Map_Hash_Index &);
+
+public:
+    //! \param path File to keep the index in.
+    explicit Map_Hash_Index(const std::string &);
+
+    /*!
+        Read the index file, replacing every entry held. Damaged lines are skipped.
+        \return False if the file couldn't be opened, which leaves the index empty.
+    */
+    bool load();
+
+    /*!
+        Write every entry to the index file. The file is replaced in one step, so a
+        crash part way through leaves the old index behind.
+        \return False if the file couldn't be written.
+    */
+    bool save();
+
+    /*!
+        Look up the digest of a map file which hasn't changed since it was stored.
+        \param filename Name of the map file.
+        \param size Current size of the file in bytes.
+        \param modified Current modification time of the file.
+        \param digest Set to the lower-case hex digest if one was found.
+        \return True if the index holds a digest for this size and modification time.
+    */
+    bool find_digest(const std::string &, const Ice::Long, const Ice::Long, std::string &);
+
+    /*!
+        Store the digest of a map file. If the digest is the one already held, the
+        server's earlier answer about it still stands; otherwise it is forgotten.
+        \param filename Name of the map file.
+        \param size Size of the file in bytes.
+        \param modified Modification time of the file.
+        \param digest Lower-case hex digest of the file.
+    */
+    void set_digest(const std::string &, const Ice::Long, const Ice::Long,
+                    const std::string &);
+
+    /*!
+        Check whether the server said a map's digest was valid recently enough to trust.
+        \param filename Name of the map file.
+        \param digest Digest to check.
+        \param now Current time in seconds since the epoch.
+        \param ttl Seconds an answer is trusted for.
+        \return True if the stored digest matches and was verified within 'ttl' of 'now'.
+    */
+    bool is_verified(const std::string &, const std::string &, const Ice::Long,
+                     const Ice::Long);
+
+    /*!
+        Record that the server said a map's digest is valid. Does nothing unless the
+        digest is the one stored for the file.
+        \param filename Name of the map file.
+        \param digest Digest the server accepted.
+        \param now Current time in seconds since the epoch.
+    */
+    void set_verified(const std::string &, const std::string &, const Ice::Long);
+
+    //! Forget everything about a map file.
+    void remove(const std::string &);
+
+    //! Get the number of map files in the index.
+    std::size_t size();
+
+    /*!
+        Get the size and modification time of a file.
+        \param path File to look at.
+        \param size Set to the size in bytes.
+        \param modified Set to the modification time in seconds since the epoch.
+        \return False if the file doesn't exist or can't be read.
+    */
+    static bool get_file_info(const std::string &, Ice::Long &, Ice::Long &);
+
+    /*!
+        Compute the SHA-1 digest of a file. The file is read front to back in blocks of
+        MAP_HASH_BLOCK_SIZE with the operating system told to read ahead, rather than
+        through a small stdio buffer.
+        \param path File to hash.
+        \param digest Set to the lower-case hex digest.
+        \return False if the file couldn't be read.
+    */
+    static bool hash_file(const std::string &, std::string &);
+
+    /*!
+        Compute the SHA-1 digest of bytes held in memory.
+        \param data Bytes to hash.
+        \return Lower-case hex digest.
+    */
+    static std::string hash_data(const std::vector<unsigned char> &);
+};
+
+#endif
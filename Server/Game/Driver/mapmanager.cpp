@@ -4,10 +4,10 @@
     \author (C) Copyright 2009 by Vermont Technical College
 */
 #include <master.hpp>
-#define SHA1_UTILITY_FUNCTIONS
-#include "SHA1.h"
 #include <Map.hpp>
 #include <mapmanager.hpp>
+#include <maphashindex.hpp>
+#include <MapCompression.hpp>
 #include <server.hpp>
 #include <vtassert.hpp>
 #include <gamemanager.hpp>
@@ -16,6 +16,13 @@
 #include <nodemanager.hpp>
 #include <playermanager.hpp>
 #include <utility.hpp>
+#include <utilitymanager.hpp>
+#include <gameinstance.hpp>
+#include <asynctemplate.hpp>
+#include <memory>
+#include <ctime>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #define EVENT_DEATHMATCH_SPAWN 1
 #define EVENT_TEAM_DEATHMATCH_RED 2
@@ -28,45 +35,42 @@
 
 namespace MapManager
 {
-    boost::shared_mutex mutex;
-    boost::mutex rotate_mutex;
-    Map * current_map = NULL;
-    std::string current_map_filename = "";
-    VTankObject::GameMode current_game_mode = VTankObject::DEATHMATCH;
     Ice::StringSeq map_list;
-    bool rotating;
-    int current_map_id = -1;
-    SelectionMode selection_technique = SELECT_ROUND_ROBIN;
 
-    std::vector<VTankObject::Point> generated_positions;
-    std::vector<VTankObject::Point> red_positions;
-    std::vector<VTankObject::Point> blue_positions;
+    // The map being played, its spawn points and the rotation state belong to the arena
+    // bound to the calling thread. The maps folder, the cache and the hash index are
+    // shared by every arena.
 
-    std::vector<VTankObject::Point>::size_type position_index = 0;
-    std::vector<VTankObject::Point>::size_type red_index = 0;
-    std::vector<VTankObject::Point>::size_type blue_index = 0;
+    //! Digests of the map files, so maps which haven't changed aren't hashed again.
+    Map_Hash_Index hash_index(MAP_HASH_INDEX);
+
+    //! Keeps arenas fetching the same map from downloading or caching it at once.
+    boost::mutex fetch_mutex;
 
     bool is_rotating()
     {
-        boost::lock_guard<boost::mutex> guard(rotate_mutex);
-        return rotating;
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::mutex> guard(arena.rotate_mutex);
+        return arena.rotating;
     }
 
     void set_rotating(bool rotating_value)
     {
-        boost::lock_guard<boost::mutex> guard(rotate_mutex);
-        rotating = rotating_value;
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::mutex> guard(arena.rotate_mutex);
+        arena.rotating = rotating_value;
     }
 
     void set_selection_technique(const SelectionMode mode) 
     {
-        boost::lock_guard<boost::mutex> guard(rotate_mutex);
-        selection_technique = mode;
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::mutex> guard(arena.rotate_mutex);
+        arena.selection_technique = mode;
     }
 
     void start()
     {
-        // Check if MAPS_DIR directory exists.
+        // Check if MAPS_DIR and MAP_CACHE_DIR directories exist.
 #if TARGET == WINTARGET
         if (_access(MAPS_DIR, 0) != 0) {
             // Directory doesn't exist.
@@ -74,6 +78,11 @@ namespace MapManager
                 throw std::runtime_error("Unable to create " MAPS_DIR " directory.");
             }
         }
+        if (_access(MAP_CACHE_DIR, 0) != 0) {
+            if (_mkdir(MAP_CACHE_DIR) != 0) {
+                throw std::runtime_error("Unable to create " MAP_CACHE_DIR " directory.");
+            }
+        }
 #elif TARGET == LINTARGET
         if (access(MAPS_DIR, F_OK) != 0) {
             // Directory doesn't exist.
@@ -81,167 +90,305 @@ namespace MapManager
                 throw std::runtime_error("Unable to create " MAPS_DIR " directory.");
             }
         }
+        if (access(MAP_CACHE_DIR, F_OK) != 0) {
+            if (mkdir(MAP_CACHE_DIR, 0777) != 0) {
+                throw std::runtime_error("Unable to create " MAP_CACHE_DIR " directory.");
+            }
+        }
 #endif
+
+        // Without an index every map is simply hashed and checked the first time.
+        (void)hash_index.load();
     }
 
-	/*!
-		Convenience function for downloading a map.
-	*/
-	void download_map()
-	{
-		const std::string file_path = MAPS_DIR + current_map_filename;
+    /*!
+        Get the time a file was last modified.
+        \param file_path Path to the file.
+        \return Modification time, or -1 if the file doesn't exist.
+    */
+    time_t get_modified_time(const std::string &file_path)
+    {
+#if TARGET == WINTARGET
+        struct _stat status;
+        if (_stat(file_path.c_str(), &status) != 0) {
+            return -1;
+        }
+#elif TARGET == LINTARGET
+        struct stat status;
+        if (stat(file_path.c_str(), &status) != 0) {
+            return -1;
+        }
+#endif
+        return status.st_mtime;
+    }
+
+    /*!
+        Write a map to the cache in the memory-mappable format, so the next rotation onto
+        it can map the file instead of parsing it. The map being played may have the old
+        copy mapped, so the new one is written under another name and moved into place.
+        Failure only costs speed.
+        \param map Map to write.
+        \param filename Name of the map file.
+    */
+    void cache_map(Map *map, const std::string &filename)
+    {
+        const std::string cache_path = MAP_CACHE_DIR + filename;
+        const std::string new_path = MAP_CACHE_DIR + ("new-" + filename);
+        if (!map->save(new_path, MAPPED_FORMAT_VERSION)) {
+            LOG_STREAM(Logger::LOG_LEVEL_WARNING,
+                "Unable to cache map " << filename << ": " << map->get_last_error());
+            return;
+        }
 
 #if TARGET == WINTARGET
-        const int access_value = _access(file_path.c_str(), 0);
+        const bool replaced = MoveFileExA(new_path.c_str(), cache_path.c_str(),
+            MOVEFILE_REPLACE_EXISTING) != 0;
 #elif TARGET == LINTARGET
-        const int access_value = access(file_path.c_str(), F_OK);
+        const bool replaced = rename(new_path.c_str(), cache_path.c_str()) == 0;
 #endif
-		bool needs_download = access_value != 0;
-		if (!needs_download) {
-			// The map exists, so check the hash for integrity.
-			CSHA1 sha1;
-			if (!sha1.HashFile(file_path.c_str())) {
-				// The hash failed for some reason -- re-download.
+        if (!replaced) {
+            (void)remove(new_path.c_str());
+            LOG_STREAM(Logger::LOG_LEVEL_WARNING,
+                "Unable to replace the cached copy of map " << filename << ".");
+        }
+    }
+
+    //! Write the hash index, logging rather than failing if it can't be written.
+    void save_hash_index()
+    {
+        if (!hash_index.save()) {
+            Logger::log(Logger::LOG_LEVEL_WARNING, "Unable to write " MAP_HASH_INDEX ".");
+        }
+    }
+
+    /*!
+        Check that a map file is the one the main server has. The file is only hashed if
+        its size or modification time changed since the hash index last saw it, and the
+        main server is only asked if it hasn't vouched for the digest in the last
+        MAP_HASH_TTL_SECONDS.
+        \param filename Name of the map file.
+        \return True if the file can be used, false if it has to be downloaded.
+    */
+    bool is_map_file_valid(const std::string &filename)
+    {
+        const std::string file_path = MAPS_DIR + filename;
+
+        Ice::Long size = 0;
+        Ice::Long modified = 0;
+        if (!Map_Hash_Index::get_file_info(file_path, size, modified)) {
+            // Map doesn't exist.
+            return false;
+        }
+
+        bool index_changed = false;
+        std::string digest;
+        if (!hash_index.find_digest(filename, size, modified, digest)) {
+            if (!Map_Hash_Index::hash_file(file_path, digest)) {
+                // The hash failed for some reason -- re-download.
                 Logger::log(Logger::LOG_LEVEL_WARNING, "Could not run hash for map file.");
-				needs_download = true;
-			}
-			else {
-				sha1.Final();
-				TCHAR hash[41];
-				sha1.ReportHash(hash, CSHA1::REPORT_HEX_SHORT);
-				hash[40] = '\0';
-
-				// Convert the TCHAR sequence to a string, then make it lower-case.
-				std::string string_hash = std::string((char *)(hash));
-				string_hash = Utility::to_lower(string_hash);
-
-				std::ostringstream formatter;
-				formatter << "Hash for " << current_map_filename << ": " << string_hash;
-
-				Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
-
-				// Ask the server if the hash is a valid one for this map.
-				if (!Server::mtg_service.get_proxy()->HashIsValid(
-					current_map_filename, string_hash)) {
-					std::ostringstream formatter;
-					formatter << "Hash for " << current_map_filename << " invalid, must re-download map.";
-
-					Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
-					needs_download = true;
-				}
-			}
-		}
+                return false;
+            }
 
-	    current_map = new Map();
-	    if (needs_download) {
-		    // Map doesn't exist.
-		    VTankObject::Map map = Server::mtg_service.get_proxy()->DownloadMap(
-                current_map_filename);
-		    if (!current_map->create(map.width, map.height, map.title)) {
-			    std::ostringstream formatter;
-			    formatter << "Map::create failed: " << current_map->get_last_error();
+            LOG_STREAM(Logger::LOG_LEVEL_DEBUG, "Hash for " << filename << ": " << digest);
 
-			    Logger::log(Logger::LOG_LEVEL_ERROR, formatter.str());
+            hash_index.set_digest(filename, size, modified, digest);
+            index_changed = true;
+        }
 
-			    throw std::runtime_error("Unable to create a new map from a downloaded map.");
-		    }
+        bool valid = true;
+        const Ice::Long now = static_cast<Ice::Long>(time(0));
+        if (!hash_index.is_verified(filename, digest, now, MAP_HASH_TTL_SECONDS)) {
+            // Ask the server if the hash is a valid one for this map.
+            valid = Server::mtg_service.get_proxy()->HashIsValid(filename, digest);
+            if (valid) {
+                hash_index.set_verified(filename, digest, now);
+            }
+            else {
+                LOG_STREAM(Logger::LOG_LEVEL_DEBUG,
+                    "Hash for " << filename << " invalid, must re-download map.");
+                hash_index.remove(filename);
+            }
+            index_changed = true;
+        }
+
+        if (index_changed) {
+            save_hash_index();
+        }
+
+        return valid;
+    }
+
+    /*!
+        Download a map file from the main server as compressed chunks, check it against
+        the digest the server sent, and write it to the maps folder. A failed request is
+        retried from the offset already reached, so an interrupted download doesn't start
+        over.
+        \param filename Name of the map file.
+        \param data Set to the contents of the map file.
+        \throws std::runtime_error if the map can't be downloaded or written.
+    */
+    void download_map_file(const std::string &filename, std::vector<unsigned char> &data)
+    {
+        MapCompression::Chunk_Receiver receiver;
+        int failures = 0;
+        while (!receiver.is_complete()) {
+            const std::size_t offset = receiver.get_offset();
+            try {
+                const VTankObject::MapChunk chunk =
+                    Server::mtg_service.get_proxy()->DownloadMapChunk(filename,
+                        static_cast<int>(offset), MapCompression::MAX_CHUNK_SIZE);
+                (void)receiver.add_chunk(chunk.hash, chunk.totalSize, chunk.offset, chunk.data);
+            }
+            catch (const Exceptions::BadInformationException &) {
+                throw std::runtime_error("The main server has no map named " + filename + ".");
+            }
+            catch (const Ice::Exception &e) {
+                LOG_STREAM(Logger::LOG_LEVEL_WARNING, "Download of map " << filename
+                    << " interrupted at byte " << offset << ": " << e.what());
+            }
 
-            for (VTankObject::SupportedGameModes::size_type i = 0;
-                i < map.supportedGameModes.size(); i++) {
-                    current_map->add_supported_game_mode(map.supportedGameModes[i]);
+            // A request which got nowhere counts as a failure, so a bad server can't
+            // keep this going forever.
+            if (receiver.get_offset() > offset) {
+                failures = 0;
+            }
+            else if (++failures >= MAP_DOWNLOAD_ATTEMPTS) {
+                throw std::runtime_error("Unable to download map " + filename + ".");
             }
+        }
 
-		    for (int y = 0; y < map.height; y++) {
-			    for (int x = 0; x < map.width; x++) {
-				    const unsigned position = y * map.width + x;
-				    VTankObject::Tile tile = map.tileData[position];
-				    current_map->set_tile_id(x, y, tile.id);
-                    current_map->set_tile_object(x, y, tile.objectId);
-                    current_map->set_tile_event(x, y, tile.eventId);
-				    current_map->set_tile_collision(x, y, tile.passable);
-                    current_map->set_tile_height(x, y, tile.height);
-                    current_map->set_tile_type(x, y, tile.type);
-                    current_map->set_tile_effect(x, y, tile.effect);
-			    }
-		    }
+        const std::string digest = receiver.get_digest();
+        if (!receiver.finish(data) || data.empty() ||
+            Map_Hash_Index::hash_data(data) != digest) {
+            throw std::runtime_error("Downloaded map " + filename + " is damaged.");
+        }
+
+        const std::string file_path = MAPS_DIR + filename;
+        {
+            std::ofstream file(file_path.c_str(), std::ios::binary | std::ios::trunc);
+            (void)file.write(reinterpret_cast<const char *>(&data[0]),
+                static_cast<std::streamsize>(data.size()));
+            if (!file) {
+                throw std::runtime_error("Unable to save downloaded map.");
+            }
+        }
+
+        // The digest came from the main server, so it needn't be asked about it again.
+        Ice::Long size = 0;
+        Ice::Long modified = 0;
+        if (Map_Hash_Index::get_file_info(file_path, size, modified)) {
+            hash_index.set_digest(filename, size, modified, digest);
+            hash_index.set_verified(filename, digest, static_cast<Ice::Long>(time(0)));
+            save_hash_index();
+        }
+    }
+
+	/*!
+		Get a map ready to play on. The map file is downloaded if it is missing or the
+		server doesn't recognize its hash; otherwise the cached copy is mapped, or the
+		file is read and a cached copy made.
+		\param filename Name of the map file.
+		\return New map, owned by the caller.
+		\throws std::runtime_error if the map can't be downloaded, saved or loaded.
+	*/
+	Map *fetch_map(const std::string &filename)
+	{
+		boost::lock_guard<boost::mutex> guard(fetch_mutex);
+
+		const std::string file_path = MAPS_DIR + filename;
+		const std::string cache_path = MAP_CACHE_DIR + filename;
+
+		const bool needs_download = !is_map_file_valid(filename);
 
-		    if (!current_map->save(file_path)) {
+	    std::auto_ptr<Map> map(new Map());
+	    if (needs_download) {
+		    // Map doesn't exist.
+            std::vector<unsigned char> map_data;
+            download_map_file(filename, map_data);
+		    if (!map->load_from_memory(map_data)) {
 			    std::ostringstream formatter;
-			    formatter << "Map::save failed: " << current_map->get_last_error();
+			    formatter << "Map::load_from_memory failed: " << map->get_last_error();
 
 			    Logger::log(Logger::LOG_LEVEL_ERROR, formatter.str());
 
-			    throw std::runtime_error("Unable to save downloaded map.");
+			    throw std::runtime_error("Unable to read a downloaded map.");
 		    }
+            cache_map(map.get(), filename);
 
             std::ostringstream formatter;
-            formatter << "Downloaded map " << current_map_filename << ".";
+            formatter << "Downloaded map " << filename << ".";
 
             Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
 	    }
-	    else {
-		    if (!current_map->load(file_path)) {
+	    else if (get_modified_time(cache_path) < get_modified_time(file_path) ||
+                !map->load(cache_path)) {
+            // There is no up to date cached copy, so read the map and make one.
+		    if (!map->load(file_path)) {
 			    std::ostringstream formatter;
-			    formatter << "Map::load failed: " << current_map->get_last_error();
+			    formatter << "Map::load failed: " << map->get_last_error();
 
 			    Logger::log(Logger::LOG_LEVEL_ERROR, formatter.str());
 
 			    throw std::runtime_error("Unable to load map.");
 		    }
+            cache_map(map.get(), filename);
 	    }
+
+        // Lets wall collision checks skip tiles far from any wall.
+        map->build_distance_field();
+
+        return map.release();
 	}
 
     /*!
         Select a map to play on.
+        \param list Maps to choose from. Must not be empty.
+        \param last_id Index of the map being played, or -1 if there isn't one.
+        \param technique How to choose.
+        \return Index of the chosen map.
     */
-    void select_map()
+    int select_map(const Ice::StringSeq &list, const int last_id, const SelectionMode technique)
     {
-        if (selection_technique == SELECT_RANDOM) {
+        const int size = static_cast<int>(list.size());
+        if (technique == SELECT_RANDOM) {
             // Random: Select any map except for the last map.
             while (true) {
-                const int last_id = current_map_id;
-                const Ice::StringSeq::size_type id = rand() % map_list.size();
+                const int id = rand() % size;
 
-                VTANK_ASSERT(id >= 0 && id < map_list.size());
+                VTANK_ASSERT(id >= 0 && id < size);
 
-                if (last_id == id && map_list.size() > 1)
+                if (last_id == id && size > 1)
                     // Don't use the same map twice.
                     continue;
 
-                current_map_filename = map_list[id];
-                current_map_id = id;
-
-                break;
+                return id;
             }
         }
-        else if (selection_technique == SELECT_ROUND_ROBIN) {
-            // Round robin: Scroll through each map one-by-one.
-			if (current_map_id < 0) {
-				int id = rand() % static_cast<int>(map_list.size());
-
-				VTANK_ASSERT(id >= 0 && id < static_cast<int>(map_list.size()));
 
-				current_map_id = id;
-			}
+        // Round robin: Scroll through each map one-by-one.
+        int id = last_id;
+        if (id < 0) {
+            id = rand() % size;
 
-            Ice::StringSeq::size_type new_id = current_map_id + 1;
-            if (new_id < 0 || new_id >= map_list.size()) {
-                new_id = 0;
-            }
+            VTANK_ASSERT(id >= 0 && id < size);
+        }
 
-            current_map_filename = map_list[new_id];
-            current_map_id = new_id;
+        ++id;
+        if (id >= size) {
+            id = 0;
         }
+
+        return id;
     }
 
     /*!
-        Ask if it's legal to play the current map. It's illegal if it is corrupted
+        Ask if it's legal to play a map. It's illegal if it is corrupted
         (it's only considered corrupted if it supports zero game modes, which should be
-        disallowed) or if there aren't enough players for the current map.
+        disallowed) or if there aren't enough players for the map.
     */
-    bool is_legal() 
+    bool is_legal(const Map *map) 
     {
-        const std::vector<int> game_modes = current_map->get_supported_game_modes();
+        const std::vector<int> game_modes = map->get_supported_game_modes();
         if (game_modes.size() == 0) {
             // We can't play on a map where no game modes are supported.
             return false;
@@ -263,22 +410,22 @@ namespace MapManager
     }
     
     /*!
-        Select a game mode.
+        Select a game mode to play on a map.
     */
-    void select_game_mode() 
+    VTankObject::GameMode select_game_mode(const Map *map) 
     {
         // TODO: Choose game mode more intelligently.
-		std::vector<int> game_modes = current_map->get_supported_game_modes();
+		std::vector<int> game_modes = map->get_supported_game_modes();
 		
 		// TODO: Temporary code. Remove me later, and uncomment below.
 		if (Utility::contains(game_modes, MODE_CAPTURETHEBASE)) {
-			current_game_mode = VTankObject::CAPTURETHEBASE;
+			return VTankObject::CAPTURETHEBASE;
 		}
 		else if (Utility::contains(game_modes, MODE_CAPTURETHEFLAG)) {
-			current_game_mode = VTankObject::CAPTURETHEFLAG;
+			return VTankObject::CAPTURETHEFLAG;
 		}
 		else {
-			current_game_mode = VTankObject::DEATHMATCH;
+			return VTankObject::DEATHMATCH;
 		}
 
         /*if (game_modes.size() > 0 && Players::tanks.size() >= 4) {
@@ -289,167 +436,347 @@ namespace MapManager
             const int game_mode = game_modes[0];
             switch (game_mode) {
             case MODE_TEAMDEATHMATCH:
-                current_game_mode = VTankObject::TEAMDEATHMATCH;
-                break;
+                return VTankObject::TEAMDEATHMATCH;
             case MODE_CAPTURETHEFLAG:
-				current_game_mode = VTankObject::CAPTURETHEFLAG;
-                break;
+				return VTankObject::CAPTURETHEFLAG;
 			case MODE_CAPTURETHEBASE:
-				current_game_mode = VTankObject::CAPTURETHEBASE;
-				break;
+				return VTankObject::CAPTURETHEBASE;
             default:
-                current_game_mode = VTankObject::DEATHMATCH;
+                return VTankObject::DEATHMATCH;
             };
 
         }
         else {
 			VTANK_ASSERT(Utility::contains(game_modes, MODE_DEATHMATCH));
-            current_game_mode = VTankObject::DEATHMATCH;
+            return VTankObject::DEATHMATCH;
         }*/
     }
 
-    void rotate()
+    /*!
+        Find every spawn point on a map in one pass over its tiles. Only the tank spawn
+        points used by the game mode are collected. Each list is shuffled.
+    */
+    void find_spawn_points(const Map *map, const VTankObject::GameMode game_mode,
+                           std::vector<VTankObject::Point> &generated,
+                           std::vector<VTankObject::Point> &red,
+                           std::vector<VTankObject::Point> &blue,
+                           std::vector<VTankObject::Point> &utility)
     {
-        //set_rotating(true);
-
-        {
-            boost::unique_lock<boost::shared_mutex> guard(mutex);
-            // De-allocate the current map, if it is not null.
-            if (current_map != NULL) {
-                delete current_map;
-				current_map = NULL;
+        generated.clear();
+        red.clear();
+        blue.clear();
+        utility.clear();
+        const bool deathmatch = game_mode == VTankObject::DEATHMATCH;
+        for (int y = 0; y < map->get_height(); y++) {
+            for (int x = 0; x < map->get_width(); x++) {
+                const int event_id = map->get_tile_event(x, y);
+
+                VTankObject::Point point;
+                point.x = (x * TILE_SIZE) + (TILE_SIZE / 2);
+                point.y = -((y * TILE_SIZE) + (TILE_SIZE / 2));
+
+                if (deathmatch && event_id == EVENT_DEATHMATCH_SPAWN) {
+                    generated.push_back(point);
+                }
+                else if (!deathmatch && event_id == EVENT_TEAM_DEATHMATCH_RED) {
+                    red.push_back(point);
+                }
+                else if (!deathmatch && event_id == EVENT_TEAM_DEATHMATCH_BLUE) {
+                    blue.push_back(point);
+                }
+                else if (event_id == EVENT_UTILITY) {
+                    utility.push_back(point);
+                }
             }
+        }
+
+        std::random_shuffle(generated.begin(), generated.end());
+        std::random_shuffle(red.begin(), red.end());
+        std::random_shuffle(blue.begin(), blue.end());
+        std::random_shuffle(utility.begin(), utility.end());
+    }
 
-            if (map_list.size() == 0) {
-                // Nothing to do, no maps.
-                return;
+    /*!
+        A map made ready to play on, with its game mode chosen and its spawn points found,
+        so that rotating onto it only swaps pointers.
+    */
+    struct Prepared_Map
+    {
+        Map *map;
+        std::string filename;
+        int map_id;
+        VTankObject::GameMode game_mode;
+        std::vector<VTankObject::Point> generated_positions;
+        std::vector<VTankObject::Point> red_positions;
+        std::vector<VTankObject::Point> blue_positions;
+        std::vector<VTankObject::Point> utility_positions;
+
+        Prepared_Map() : map(NULL), map_id(-1), game_mode(VTankObject::DEATHMATCH) {}
+       ~Prepared_Map() { delete map; }
+
+    private:
+        Prepared_Map(const Prepared_Map &);
+        Prepared_Map &operator=(const Prepared_Map &);
+    };
+
+    /*!
+        Choose, fetch and index the map to play after the given one. Maps which can't be
+        played are skipped, but every map is only tried once.
+        \param list Maps to choose from. Must not be empty.
+        \param last_id Index of the map being played, or -1 if there isn't one.
+        \param technique How to choose.
+        \return New prepared map, owned by the caller.
+        \throws std::runtime_error if no map can be played, or a map can't be fetched.
+    */
+    Prepared_Map *prepare_map(const Ice::StringSeq &list, int last_id,
+                              const SelectionMode technique)
+    {
+        for (Ice::StringSeq::size_type attempt = 0; attempt < list.size(); attempt++) {
+            // TODO: Decide which map we want to play on more intelligently.
+            const int id = select_map(list, last_id, technique);
+
+            std::auto_ptr<Prepared_Map> prepared(new Prepared_Map());
+            prepared->map = fetch_map(list[id]);
+            prepared->filename = list[id];
+            prepared->map_id = id;
+
+            if (is_legal(prepared->map)) {
+                prepared->game_mode = select_game_mode(prepared->map);
+                find_spawn_points(prepared->map, prepared->game_mode,
+                    prepared->generated_positions, prepared->red_positions,
+                    prepared->blue_positions, prepared->utility_positions);
+
+                return prepared.release();
             }
-            
-            bool selecting_map = true;
-            while (selecting_map) {
-                // TODO: Decide which map we want to play on more intelligently.
-                select_map();
-
-		        download_map();
-                
-                selecting_map = !is_legal();
-				if (selecting_map) {
-					std::ostringstream formatter;
-					formatter << "Skipping map " << current_map_filename << ".";
-
-					Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
-				}
+
+			std::ostringstream formatter;
+			formatter << "Skipping map " << list[id] << ".";
+
+			Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
+
+            last_id = id;
+        }
+
+        throw std::runtime_error("None of the maps can be played.");
+    }
+
+    /*!
+        Body of an arena's prefetch thread, which prepares the next map while the current
+        one is played. The map is left in the arena's prefetched_map.
+    */
+    void prefetch_next_map(Game_Instance *arena, const Ice::StringSeq list,
+                           const int last_id, const SelectionMode technique)
+    {
+        // Not named for tracing: it has no trace points, and a thread is started for
+        // every rotation while trace buffers are never freed.
+        try {
+            Prepared_Map *const prepared = prepare_map(list, last_id, technique);
+
+            LOG_STREAM(Logger::LOG_LEVEL_DEBUG, "Prefetched map " << prepared->filename
+                << " for arena " << arena->get_id() << ".");
+
+            boost::lock_guard<boost::mutex> guard(arena->prefetch_mutex);
+            delete arena->prefetched_map;
+            arena->prefetched_map = prepared;
+        }
+        catch (const std::exception &e) {
+            // Rotation will try again itself.
+            LOG_STREAM(Logger::LOG_LEVEL_WARNING, "Unable to prefetch the next map: " << e.what());
+        }
+        catch (...) {
+            Logger::log(Logger::LOG_LEVEL_WARNING, "Unable to prefetch the next map.");
+        }
+    }
+
+    //! Start preparing the map to play after the current one.
+    void start_prefetch()
+    {
+        Game_Instance &arena = Game_Instance::current();
+        if (map_list.size() == 0) {
+            return;
+        }
+
+        SelectionMode technique;
+        {
+            boost::lock_guard<boost::mutex> guard(arena.rotate_mutex);
+            technique = arena.selection_technique;
+        }
+
+        arena.prefetch_thread = boost::thread(
+            boost::bind(&prefetch_next_map, &arena, map_list, arena.current_map_id, technique));
+    }
+
+    /*!
+        Take the map the prefetch thread prepared, waiting for it to finish if it hasn't.
+        \return Prepared map owned by the caller, or NULL if there is none or it is no
+        longer in the map list.
+    */
+    Prepared_Map *take_prefetched_map()
+    {
+        Game_Instance &arena = Game_Instance::current();
+        if (arena.prefetch_thread.joinable()) {
+            arena.prefetch_thread.join();
+        }
+
+        Prepared_Map *prepared = NULL;
+        {
+            boost::lock_guard<boost::mutex> guard(arena.prefetch_mutex);
+            std::swap(prepared, arena.prefetched_map);
+        }
+
+        if (prepared != NULL) {
+            // The server may have sent a new map list since the prefetch started.
+            const Ice::StringSeq::iterator i = std::find(map_list.begin(), map_list.end(),
+                prepared->filename);
+            if (i == map_list.end()) {
+                delete prepared;
+                return NULL;
             }
+            prepared->map_id = static_cast<int>(i - map_list.begin());
+        }
+
+        return prepared;
+    }
 
-            select_game_mode();
+    //! Log that the main server couldn't be told which map an arena is playing.
+    void set_arena_map_failed(const Ice::Exception &ex)
+    {
+        LOG_STREAM(Logger::LOG_LEVEL_ERROR,
+            "Unable to tell the main server about the new map: " << ex.what());
+    }
 
-            generate_positions();
+    void rotate()
+    {
+        Game_Instance &arena = Game_Instance::current();
+        //set_rotating(true);
 
-            Players::nodes.set_map(current_map);
-            Server::mtg_service.get_proxy()->SetCurrentMap(current_map_filename);
-            Server::mtg_service.get_proxy()->SetCurrentGameMode(current_game_mode);
+        if (map_list.size() == 0) {
+            // Nothing to do, no maps.
+            return;
+        }
 
-            std::ostringstream formatter;
-            formatter << "Rotated to the next map: " << current_map->get_title()
-                << ", game mode: " << Utility::to_string(current_game_mode);
+        Prepared_Map *prepared = take_prefetched_map();
+        if (prepared == NULL) {
+            // Nothing was prefetched, as on the first rotation, so prepare it now. The
+            // current map stays in play if this fails.
+            SelectionMode technique;
+            {
+                boost::lock_guard<boost::mutex> guard(arena.rotate_mutex);
+                technique = arena.selection_technique;
+            }
+            prepared = prepare_map(map_list, arena.current_map_id, technique);
+        }
 
-            Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
+        Map *old_map = NULL;
+        {
+            boost::unique_lock<boost::shared_mutex> guard(arena.map_mutex);
+            old_map = arena.current_map;
+            arena.current_map = prepared->map;
+            prepared->map = NULL;
+
+            arena.current_map_filename = prepared->filename;
+            arena.current_map_id = prepared->map_id;
+            arena.current_game_mode = prepared->game_mode;
+
+            arena.generated_positions.swap(prepared->generated_positions);
+            arena.red_positions.swap(prepared->red_positions);
+            arena.blue_positions.swap(prepared->blue_positions);
+            arena.utility_positions.swap(prepared->utility_positions);
+            arena.position_index = 0;
+            arena.red_index = 0;
+            arena.blue_index = 0;
+
+            arena.nodes.set_map(arena.current_map);
         }
 
+        // Unmapping or freeing the old map doesn't need to hold up readers.
+        delete prepared;
+        delete old_map;
+
+        // The main server isn't waited for, so a slow one can't hold up the arena.
+        try {
+            Server::mtg_service.get_proxy()->SetArenaMap_async(new VoidAsyncCallback<
+                MainToGameSession::AMI_MTGSession_SetArenaMap>(&set_arena_map_failed),
+                arena.get_id(), arena.current_map_filename, arena.current_game_mode);
+        }
+        catch (const Ice::Exception &ex) {
+            set_arena_map_failed(ex);
+        }
+
+        std::ostringstream formatter;
+        formatter << "Arena " << arena.get_id() << " rotated to the next map: " << arena.current_map->get_title()
+            << ", game mode: " << Utility::to_string(arena.current_game_mode);
+
+        Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
+
+        start_prefetch();
+
         //set_rotating(false);
     }
 
     const Map * const get_current_map()
     {
-        boost::shared_lock<boost::shared_mutex> guard(mutex);
-        return current_map;
+        Game_Instance &arena = Game_Instance::current();
+        boost::shared_lock<boost::shared_mutex> guard(arena.map_mutex);
+        return arena.current_map;
     }
 
     const std::string get_current_map_filename()
     {
-        boost::shared_lock<boost::shared_mutex> guard(mutex);
-        return current_map_filename;
+        Game_Instance &arena = Game_Instance::current();
+        boost::shared_lock<boost::shared_mutex> guard(arena.map_mutex);
+        return arena.current_map_filename;
     }
 
     const VTankObject::GameMode get_current_mode()
     {
-        boost::shared_lock<boost::shared_mutex> guard(mutex);
-        return current_game_mode;
+        Game_Instance &arena = Game_Instance::current();
+        boost::shared_lock<boost::shared_mutex> guard(arena.map_mutex);
+        return arena.current_game_mode;
     }
 
-    void generate_positions()
+    const std::vector<VTankObject::Point> get_utility_positions()
     {
-        generated_positions.clear();
-        red_positions.clear();
-        blue_positions.clear();
-        if (current_game_mode == VTankObject::DEATHMATCH) {
-            for (int y = 0; y < current_map->get_height(); y++) {
-                for (int x = 0; x < current_map->get_width(); x++) {
-                    const Tile tile = current_map->get_tile(x, y);
-                    if (tile.event_id == EVENT_DEATHMATCH_SPAWN) {
-                        // Spawn point found.
-                        VTankObject::Point point;
-                        point.x = (x * TILE_SIZE) + (TILE_SIZE / 2);
-                        point.y = -((y * TILE_SIZE) + (TILE_SIZE / 2));
-
-                        generated_positions.push_back(point);
-                    }
-                }
-            }
-
-            std::random_shuffle(generated_positions.begin(), generated_positions.end());
-        }
-        else /*if (current_game_mode == VTankObject::TEAMDEATHMATCH)*/ {
-            for (int y = 0; y < current_map->get_height(); y++) {
-                for (int x = 0; x < current_map->get_width(); x++) {
-                    const Tile tile = current_map->get_tile(x, y);
-                    if (tile.event_id == EVENT_TEAM_DEATHMATCH_RED) {
-                        VTankObject::Point point;
-                        point.x = (x * TILE_SIZE) + (TILE_SIZE / 2);
-                        point.y = -((y * TILE_SIZE) + (TILE_SIZE / 2));
-
-                        red_positions.push_back(point);
-                    }
-                    else if (tile.event_id == EVENT_TEAM_DEATHMATCH_BLUE) {
-                        VTankObject::Point point;
-                        point.x = (x * TILE_SIZE) + (TILE_SIZE / 2);
-                        point.y = -((y * TILE_SIZE) + (TILE_SIZE / 2));
-
-                        blue_positions.push_back(point);
-                    }
-                }
-            }
-
-            std::random_shuffle(red_positions.begin(), red_positions.end());
-            std::random_shuffle(blue_positions.begin(), blue_positions.end());
-        }
+        Game_Instance &arena = Game_Instance::current();
+        boost::shared_lock<boost::shared_mutex> guard(arena.map_mutex);
+        return arena.utility_positions;
+    }
 
-        position_index = 0;
-        red_index = 0;
-        blue_index = 0;
+    void generate_positions()
+    {
+        Game_Instance &arena = Game_Instance::current();
+        find_spawn_points(arena.current_map, arena.current_game_mode,
+            arena.generated_positions, arena.red_positions, arena.blue_positions,
+            arena.utility_positions);
+
+        arena.position_index = 0;
+        arena.red_index = 0;
+        arena.blue_index = 0;
     }
 
     void set_spawn_position_team_deathmatch(tank_ptr tank)
     {
         VTANK_ASSERT(tank->get_team() != GameSession::NONE);
 
+        Game_Instance &arena = Game_Instance::current();
+
         const GameSession::Alliance team = tank->get_team();
         if (team == GameSession::RED) {
-            VTankObject::Point p = red_positions[red_index++];
+            VTankObject::Point p = arena.red_positions[arena.red_index++];
 
-            if (red_index >= red_positions.size()) {
-                std::random_shuffle(red_positions.begin(), red_positions.end());
-                red_index = 0;
+            if (arena.red_index >= arena.red_positions.size()) {
+                std::random_shuffle(arena.red_positions.begin(), arena.red_positions.end());
+                arena.red_index = 0;
             }
 
             tank->set_position(p);
         }
         else if (team == GameSession::BLUE) {
-            VTankObject::Point p = blue_positions[blue_index++];
+            VTankObject::Point p = arena.blue_positions[arena.blue_index++];
 
-            if (blue_index >= blue_positions.size()) {
-                std::random_shuffle(blue_positions.begin(), blue_positions.end());
-                blue_index = 0;
+            if (arena.blue_index >= arena.blue_positions.size()) {
+                std::random_shuffle(arena.blue_positions.begin(), arena.blue_positions.end());
+                arena.blue_index = 0;
             }
 
             tank->set_position(p);
@@ -458,13 +785,15 @@ namespace MapManager
 
     void generate_spawn_position(tank_ptr tank)
     {
-        boost::unique_lock<boost::shared_mutex> guard(mutex);
-        if (current_game_mode != VTankObject::DEATHMATCH) {
+        Game_Instance &arena = Game_Instance::current();
+        boost::unique_lock<boost::shared_mutex> guard(arena.map_mutex);
+        if (arena.current_game_mode != VTankObject::DEATHMATCH) {
             set_spawn_position_team_deathmatch(tank);
         }
         else {
             try {
-                VTANK_ASSERT(position_index >= 0 && position_index < generated_positions.size());
+                VTANK_ASSERT(arena.position_index >= 0 &&
+                    arena.position_index < arena.generated_positions.size());
             }
             catch (const std::logic_error &e) {
                 std::ostringstream formatter;
@@ -473,11 +802,12 @@ namespace MapManager
             }
             /*std::cout << "Generating spawn at position " << position_index << 
                 " (size=" << generated_positions.size() << ")" << std::endl;*/
-            VTankObject::Point p = generated_positions[position_index++];
+            VTankObject::Point p = arena.generated_positions[arena.position_index++];
 
-            if (position_index >= generated_positions.size()) {
-                std::random_shuffle(generated_positions.begin(), generated_positions.end());
-                position_index = 0;
+            if (arena.position_index >= arena.generated_positions.size()) {
+                std::random_shuffle(arena.generated_positions.begin(),
+                    arena.generated_positions.end());
+                arena.position_index = 0;
             }
 
             tank->set_position(p);
@@ -486,12 +816,17 @@ namespace MapManager
 
     void shutdown()
     {
-        boost::unique_lock<boost::shared_mutex> guard(mutex);
+        Game_Instance &arena = Game_Instance::current();
+
+        // The prefetch thread can't be interrupted, so wait for it to finish.
+        delete take_prefetched_map();
+
+        boost::unique_lock<boost::shared_mutex> guard(arena.map_mutex);
         // If a map is loaded into memory, de-allocate it.
-        if (current_map != NULL) {
-            delete current_map;
+        if (arena.current_map != NULL) {
+            delete arena.current_map;
             // Point current_map to NULL to satisfy any further checks for current_map != NULL.
-            current_map = NULL;
+            arena.current_map = NULL;
         }
     }
 };
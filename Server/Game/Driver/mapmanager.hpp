@@ -15,6 +15,10 @@
     map object being worked with, as well as selecting a new map based on
     factors such as the number of players in a game and what the previous 
     map was playing. In other words, map selection is not random.
+
+    Each arena plays its own map: everything but start() and the map list works on the
+    arena bound to the calling thread (see Game_Instance), whose map is guarded by a
+    shared mutex since it barely ever changes.
 */
 namespace MapManager
 {
@@ -24,16 +28,7 @@ namespace MapManager
         SELECT_ROUND_ROBIN
     };
 
-    //! Thread safety is done via a shared mutex, since the map barely ever changes.
-    extern boost::shared_mutex mutex;
-
-    //! The current map object being worked with.
-    extern Map * current_map;
-
-    //! The current map file name.
-    extern std::string current_map_filename;
-
-    //! List of maps by filename.
+    //! List of maps by filename, shared by every arena.
     extern Ice::StringSeq map_list;
 
     /*!
@@ -55,13 +50,16 @@ namespace MapManager
 
     /*!
         Initializes the map manager. It will download a list of maps from the server
-        during initialization.
+        during initialization. Called once, for every arena.
     */
     void start();
 
     /*!
-        Rotate the map. The map manager will select a new map, download it (if
-        required), and replace the old map object.
+        Rotate the map. The next map is normally selected, downloaded (if required),
+        loaded and indexed on a background thread during the previous round, so this only
+        swaps it in and starts preparing the one after. If nothing was prepared, as on
+        the first rotation, the work is done here instead.
+        \throws std::runtime_error if no map can be played; the old map stays current.
     */
     void rotate();
 
@@ -83,6 +81,13 @@ namespace MapManager
     */
     const VTankObject::GameMode get_current_mode();
 
+    /*!
+        Get the tiles of the current map which utilities spawn on, found when the map
+        was prepared.
+        \return Shuffled list of positions.
+    */
+    const std::vector<VTankObject::Point> get_utility_positions();
+
     /*!
         Generate starting positions initially by first gathering a list of all potential
         spawn points and then organizing them into a randomized list.
@@ -98,8 +103,8 @@ namespace MapManager
     void generate_spawn_position(tank_ptr);
 
     /*!
-        De-initializes the map manager. Pretty much just deletes the current_map object
-        if it is not null.
+        De-initializes the bound arena's maps. Waits for any map being prefetched, then
+        deletes it and the current map if they are not null.
     */
     void shutdown();
 }
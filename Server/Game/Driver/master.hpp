@@ -13,6 +13,7 @@
 
 // Standard
 #include <algorithm>
+#include <deque>
 #include <exception>
 #include <fstream>
 #include <iostream>
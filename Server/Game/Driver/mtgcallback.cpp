@@ -10,6 +10,7 @@
 #include <mapmanager.hpp>
 #include <logger.hpp>
 #include <gamemanager.hpp>
+#include <gameinstance.hpp>
 
 MTGCallback::MTGCallback()
 {
@@ -35,8 +36,21 @@ void MTGCallback::AddPlayer(const std::string& key, const std::string& username,
                             Ice::Int level, const VTankObject::TankAttributes& tank, 
                             const Ice::Current&)
 {
+    AddPlayerToArena(Arenas::get_least_loaded().get_id(), key, username, level, tank);
+}
+
+void MTGCallback::AddPlayerToArena(Ice::Int arena, const std::string& key,
+                                   const std::string&, Ice::Int,
+                                   const VTankObject::TankAttributes& tank, const Ice::Current&)
+{
+    if (arena < 0 || arena >= Arenas::count()) {
+        throw Exceptions::BadInformationException("No such arena.");
+    }
+    const Game_Instance::Scope scope(Arenas::get(arena));
+
     std::ostringstream formatter;
-    formatter << "Adding player " << tank.name << " (key=" << key << ")";
+    formatter << "Adding player " << tank.name << " to arena " << arena << " (key=" << key
+        << ")";
 
     Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
 
@@ -55,9 +69,14 @@ void MTGCallback::RemovePlayer(const std::string& username, const Ice::Current&)
 
     Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
     
-    const int id = Players::get_player_id_by_name(username);
-    if (id >= 0) {
-        Players::remove_player(id);
+    // Names are unique across arenas, so at most one arena has the player.
+    for (int i = 0; i < Arenas::count(); ++i) {
+        const Game_Instance::Scope scope(Arenas::get(i));
+        const int id = Players::get_player_id_by_name(username);
+        if (id >= 0) {
+            Players::remove_player(id);
+            break;
+        }
     }
 }
 
@@ -68,7 +87,8 @@ void MTGCallback::ForceMaxPlayerLimit(Ice::Int limit, const Ice::Current&)
     
     Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
 
-    Players::player_limit = limit;
+    // The limit is for the whole server; each arena takes an equal share.
+    Players::player_limit = std::max(1, limit / Arenas::count());
 }
 
 void MTGCallback::UpdateMapList(const Ice::StringSeq& mapList, const Ice::Current&)
@@ -84,10 +104,95 @@ void MTGCallback::UpdateMapList(const Ice::StringSeq& mapList, const Ice::Curren
 
 Ice::Int MTGCallback::GetPlayerLimit(const ::Ice::Current&)
 {
-    return Players::player_limit;
+    return Players::player_limit * Arenas::count();
 }
 
 void MTGCallback::UpdateUtilities(const VTankObject::UtilityList &list, const Ice::Current &)
 {
-	Players::update_utility_list(list);
+	for (int i = 0; i < Arenas::count(); ++i) {
+		const Game_Instance::Scope scope(Arenas::get(i));
+		Players::update_utility_list(list);
+	}
+}
+
+namespace {
+	VTankObject::LatencyStatistics make_latency_statistics(const std::string &name,
+		const Latency_Histogram &histogram)
+	{
+		VTankObject::LatencyStatistics statistics;
+		statistics.name = name;
+		statistics.samples = histogram.get_count();
+		statistics.mean = static_cast<float>(histogram.get_mean());
+		statistics.p50 = static_cast<float>(histogram.get_percentile(0.5));
+		statistics.p99 = static_cast<float>(histogram.get_percentile(0.99));
+		statistics.p999 = static_cast<float>(histogram.get_percentile(0.999));
+		statistics.max = static_cast<float>(histogram.get_max());
+
+		return statistics;
+	}
+}
+
+VTankObject::HealthSnapshot MTGCallback::GetHealth(const Ice::Current &)
+{
+	// The machine's own usage is reported by its backup daemon, not the game server.
+	VTankObject::HealthSnapshot health = VTankObject::HealthSnapshot();
+
+	// Every arena's ticks and timings are summed into one report.
+	std::ostringstream formatter;
+	Frame_Report report = Frame_Report();
+	for (int i = 0; i < Arenas::count(); ++i) {
+		const Game_Instance::Scope scope(Arenas::get(i));
+		if (i > 0) {
+			formatter << "; ";
+		}
+		formatter << "Arena " << i << " map: " << MapManager::get_current_map_filename()
+			<< ", players: " << Players::get_tank_manager()->size();
+
+		const Players::Tick_Statistics ticks = Players::get_tick_statistics();
+		health.ticks += ticks.ticks;
+		health.overruns += ticks.overruns;
+		health.droppedTicks += ticks.dropped_ticks;
+
+		report.add(Players::get_frame_report());
+
+		const tank_array tanks = Players::get_tank_manager()->get_tank_list();
+		for (tank_array::size_type j = 0; j < tanks.size(); ++j) {
+			const Clock_Estimate clock = tanks[j]->get_clock();
+
+			VTankObject::ClockStatistics statistics;
+			statistics.arena = i;
+			statistics.playerId = tanks[j]->get_id();
+			statistics.name = tanks[j]->get_name();
+			statistics.offset = static_cast<float>(clock.offset_at(get_precise_time()));
+			statistics.jitter = static_cast<float>(clock.jitter);
+			statistics.delay = static_cast<float>(clock.delay);
+			statistics.drift = static_cast<float>(clock.drift * 1000000.0);
+			statistics.samples = clock.samples;
+			health.clocks.push_back(statistics);
+		}
+	}
+	health.additionalNotes = formatter.str();
+
+	for (int i = 0; i < Profiler::PHASE_COUNT; ++i) {
+		health.phases.push_back(make_latency_statistics(
+			Profiler::get_phase_name(static_cast<Profiler::Phase>(i)), report.phases[i]));
+	}
+
+	health.latencies.push_back(
+		make_latency_statistics("input to broadcast", report.input_latency));
+	health.latencies.push_back(
+		make_latency_statistics("queue to send", report.send_latency));
+
+	for (int i = 0; i < Profiler::COUNTER_COUNT; ++i) {
+		const Counter_Statistics &counter = report.counters[i];
+
+		VTankObject::CounterStatistics statistics;
+		statistics.name = Profiler::get_counter_name(static_cast<Profiler::Counter>(i));
+		statistics.ticks = counter.ticks;
+		statistics.mean = static_cast<float>(counter.get_mean());
+		statistics.peak = counter.peak;
+		health.counters.push_back(statistics);
+	}
+
+	return health;
 }
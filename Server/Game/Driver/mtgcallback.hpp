@@ -19,11 +19,14 @@ public:
     virtual void KeepAlive(const ::Ice::Current& = ::Ice::Current());
     virtual void AddPlayer(const std::string&, const std::string&, Ice::Int, 
         const VTankObject::TankAttributes&, const Ice::Current& = Ice::Current());
+    virtual void AddPlayerToArena(Ice::Int, const std::string&, const std::string&, Ice::Int,
+        const VTankObject::TankAttributes&, const Ice::Current& = Ice::Current());
 	virtual void RemovePlayer(const std::string&, const Ice::Current& = Ice::Current());
 	virtual void ForceMaxPlayerLimit(Ice::Int, const Ice::Current& = Ice::Current());
     virtual void UpdateMapList(const Ice::StringSeq&, const Ice::Current& = Ice::Current());
     virtual Ice::Int GetPlayerLimit(const Ice::Current& = Ice::Current());
 	virtual void UpdateUtilities(const VTankObject::UtilityList &,const Ice::Current &);
+	virtual VTankObject::HealthSnapshot GetHealth(const Ice::Current& = Ice::Current());
 };
 
 #endif
@@ -9,6 +9,12 @@
 #include <logger.hpp>
 #include <mtgcallback.hpp>
 #include <playermanager.hpp>
+#include <gamemanager.hpp>
+#include <gameinstance.hpp>
+#include <trace.hpp>
+#include <interest.hpp>
+#include <lagcompensation.hpp>
+#include <statisticsupload.hpp>
 
 MTGService::MTGService() : Ice::Service()
 {
@@ -155,6 +161,37 @@ bool MTGService::start(int argc, char* argv[], int &)
             getPropertyAsInt("Glacier2Port");
         const bool connect_glacier2 = static_cast<bool>(communicator()->getProperties()->
             getPropertyAsInt("ConnectThroughGlacier2"));
+
+        // Matches hosted side by side, each with its own simulation thread.
+        Arenas::create(
+            communicator()->getProperties()->getPropertyAsIntWithDefault("Arenas",
+                DEFAULT_ARENA_COUNT),
+            communicator()->getProperties()->getPropertyAsIntWithDefault("PinArenas", 0) != 0);
+
+        // Size of the nodes which decide which players hear about each other.
+        const int node_width = communicator()->getProperties()->
+            getPropertyAsIntWithDefault("NodeWidth", NODE_WIDTH);
+        const int node_height = communicator()->getProperties()->
+            getPropertyAsIntWithDefault("NodeHeight", NODE_HEIGHT);
+        for (int i = 0; i < Arenas::count(); ++i) {
+            Arenas::get(i).nodes.set_node_size(node_width, node_height);
+        }
+
+        // Events every player hears about, not just those near them.
+        Interest::set_always_broadcast(communicator()->getProperties()->
+            getPropertyWithDefault("AlwaysBroadcast", DEFAULT_ALWAYS_BROADCAST));
+
+        // How far back shots from lagging players may be judged.
+        Lag_Compensation::set_max_rewind(communicator()->getProperties()->
+            getPropertyAsIntWithDefault("MaxRewind", DEFAULT_MAX_REWIND));
+
+        // Where rounds the main server hasn't accepted yet are kept.
+        Statistics_Upload::start(communicator()->getProperties()->
+            getPropertyWithDefault("StatisticsSpool", DEFAULT_STATISTICS_SPOOL));
+
+        // How many scopes per trace point are recorded, if tracing is compiled in.
+        Trace::set_sample_rate(communicator()->getProperties()->
+            getPropertyAsIntWithDefault("TraceSampleRate", TRACE_SAMPLE_RATE));
         
         Main::SessionFactoryPrx login_proxy = NULL;
         MainToGameSession::ClientSessionPrx callback_proxy = NULL;
@@ -213,7 +250,8 @@ bool MTGService::start(int argc, char* argv[], int &)
         service_thread = boost::thread(
             boost::bind<void>(run_server_service, argc, argv));
 
-        mtg_proxy->SetMaxPlayerLimit(Players::player_limit);
+        mtg_proxy->SetArenaCount(Arenas::count());
+        mtg_proxy->SetMaxPlayerLimit(Players::player_limit * Arenas::count());
 
         return true;
     }
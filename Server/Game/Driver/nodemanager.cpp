@@ -5,198 +5,178 @@
 */
 #include <master.hpp>
 #include <nodemanager.hpp>
+#include <utility.hpp>
 #include <vtassert.hpp>
 
 NodeManager::NodeManager()
-    : nodes(NULL), size(0)
+    : size(0), width(0), height(0), node_width(NODE_WIDTH), node_height(NODE_HEIGHT),
+    neighborhood_start(1, 0)
 {
 }
 
-NodeManager::~NodeManager()
+int NodeManager::node_at(const VTankObject::Point &position) const
 {
-    deallocate_nodes();
-}
-
-void NodeManager::allocate_nodes(const int &node_size)
-{
-    VTANK_ASSERT(node_size > 0);
-
-    nodes = new Node[node_size];
-    for (int i = 0; i < node_size; i++) {
-        nodes[i].set_id(i);
+    // The map runs right along +x and down along -y.
+    const int x = static_cast<int>(floor(position.x / node_width));
+    const int y = static_cast<int>(floor(-position.y / node_height));
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return -1;
     }
 
-    size = node_size;
+    return y * width + x;
 }
 
-void NodeManager::deallocate_nodes()
+void NodeManager::set_node_size(const int new_width, const int new_height)
 {
-    if (nodes != NULL) {
-        delete [] nodes;
+    VTANK_ASSERT(new_width > 0 && new_height > 0);
 
-        nodes = NULL;
-    }
+    boost::lock_guard<boost::mutex> guard(mutex);
+    node_width = new_width;
+    node_height = new_height;
 }
 
 void NodeManager::set_map(const Map *const map)
 {
     boost::lock_guard<boost::mutex> guard(mutex);
     
-    deallocate_nodes();
-
     const double map_width = map->get_width() * TILE_SIZE;
     const double map_height = map->get_height() * TILE_SIZE;
-    width  = static_cast<int>(ceil(map_width / NODE_WIDTH));
-    height = static_cast<int>(ceil(map_height / NODE_HEIGHT));
+    width  = static_cast<int>(ceil(map_width / node_width));
+    height = static_cast<int>(ceil(map_height / node_height));
+    size = width * height;
+
+    VTANK_ASSERT(size > 0);
 
-    allocate_nodes(width * height);
+    neighborhoods.clear();
+    neighborhood_start.assign(size + 1, 0);
+    fill_position.assign(size, 0);
 }
 
 int NodeManager::get_node_at(const VTankObject::Point &position)
 {
 	boost::lock_guard<boost::mutex> guard(mutex);
-	const int x = static_cast<int>(position.x / NODE_WIDTH);
-    const int y = static_cast<int>(-position.y / NODE_HEIGHT);
-	const int node_position = y * width + x;
-	if (node_position < 0 || node_position >= size) {
-		return -1;
-	}
-
-	return node_position;
+	return node_at(position);
 }
 
 bool NodeManager::is_near(int node1, int node2) const
 {
-	bool result = false;
-
-	if (node1 == node2) {
-		// Check equal.
-		result = true;
-	}
-	else if (node1 - width == node2 || node1 + width == node2) {
-		// Check top/bottom.
-		result = true;
-	}
-	else if (node1 + 1 == node2 || node1 - 1 == node2) {
-		// Check left/right.
-		result = true;
-	}
-	else if (node1 - width - 1 == node2 || node1 + width - 1 == node2 ||
-			node1 - width + 1 == node2 || node1 + width + 1 == node2) {
-		// Check all corners.
-		result = true;
-	}
-	
-	return result;
+    if (node1 < 0 || node2 < 0 || width <= 0) {
+        return false;
+    }
+
+    // Compare grid coordinates so nodes on opposite edges of the map don't match.
+    const int dx = node1 % width - node2 % width;
+    const int dy = node1 / width - node2 / width;
+
+    return dx >= -1 && dx <= 1 && dy >= -1 && dy <= 1;
 }
 
 void NodeManager::process_position(tank_ptr player)
 {
     boost::lock_guard<boost::mutex> guard(mutex);
+    player->set_node_id(node_at(player->get_position()));
+}
 
-    // Calculate the player's node position.
-    // (y / NODE_HEIGHT) * width + (x / NODE_WIDTH)
-    const int x = static_cast<int>(player->get_position().x / NODE_WIDTH);
-    const int y = static_cast<int>(-player->get_position().y / NODE_HEIGHT);
-    const int node_position = y * width + x;
-	const int current_node = player->get_node_id();
-    if (node_position < 0 || node_position >= size) {
-        // Nothing to do: Can't process a tank not on the map.
-		if (current_node >= 0) {
-			// Unregister from existing nodes.
-			nodes[current_node].unregister_player(player->get_id());
-		}
-
-        player->set_node_id(-1);
-
-        return;
-    }
-	
-    if (current_node != node_position) {
-        // Change nodes.
-        player->set_node_id(node_position);
-
-        if (current_node >= 0 && current_node < size)
-            nodes[current_node].unregister_player(player->get_id());
-        nodes[node_position].register_player(player->get_id(), player);
+void NodeManager::process_projectiles(const std::vector<double> &x, const std::vector<double> &y,
+    std::vector<int> &node_ids)
+{
+    VTANK_ASSERT(x.size() == y.size() && x.size() == node_ids.size());
+
+    boost::lock_guard<boost::mutex> guard(mutex);
+    VTankObject::Point position;
+    for (std::vector<int>::size_type i = 0; i < node_ids.size(); i++) {
+        position.x = x[i];
+        position.y = y[i];
+        node_ids[i] = node_at(position);
     }
 }
 
-void NodeManager::process_projectile(projectile_ptr projectile)
+void NodeManager::rebuild(const tank_array &tanks)
 {
     boost::lock_guard<boost::mutex> guard(mutex);
 
-    // Calculate the projectile's node position.
-    // (y / NODE_HEIGHT) * width + (x / NODE_WIDTH)
-    const int x = static_cast<int>(projectile->position.x / NODE_WIDTH);
-    const int y = static_cast<int>(-projectile->position.y / NODE_HEIGHT);
-    const int node_position = y * width + x;
-    if (node_position < 0 || node_position > size) {
-        // Nothing to do: Can't process a tank not on the map.
-        projectile->node_id = -1;
+    // Counting sort: each tank is listed under its own node and its eight neighbors.
+    std::fill(neighborhood_start.begin(), neighborhood_start.end(), 0);
+    for (tank_array::size_type i = 0; i < tanks.size(); i++) {
+        const int node_id = tanks[i]->get_node_id();
+        if (node_id < 0 || node_id >= size) {
+            continue;
+        }
 
-        return;
+        const int x = node_id % width;
+        const int y = node_id / width;
+        for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ny++) {
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++) {
+                ++neighborhood_start[ny * width + nx + 1];
+            }
+        }
     }
-    
-    const int current_node = projectile->node_id;
-    if (current_node != node_position) {
-        // Change nodes.
-        projectile->node_id = node_position;
+
+    for (int i = 0; i < size; i++) {
+        neighborhood_start[i + 1] += neighborhood_start[i];
+        fill_position[i] = neighborhood_start[i];
+    }
+
+    // Overwriting in place keeps the vector's storage from one tick to the next.
+    neighborhoods.resize(neighborhood_start[size]);
+    for (tank_array::size_type i = 0; i < tanks.size(); i++) {
+        const int node_id = tanks[i]->get_node_id();
+        if (node_id < 0 || node_id >= size) {
+            continue;
+        }
+
+        const int x = node_id % width;
+        const int y = node_id / width;
+        for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, height - 1); ny++) {
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, width - 1); nx++) {
+                neighborhoods[fill_position[ny * width + nx]++] = tanks[i];
+            }
+        }
     }
 }
 
-void NodeManager::unregister_player(const int &id, const int &node_id)
+Node_Span NodeManager::get_neighbors(const int node_id) const
 {
-    boost::lock_guard<boost::mutex> guard(mutex);
-    if (node_id < 0) {
-        // Player is not registered.
-        return;
+    if (node_id < 0 || node_id >= size) {
+        return Node_Span();
     }
 
-    VTANK_ASSERT(node_id >= 0 && node_id < size);
+    const int first = neighborhood_start[node_id];
+    const int last = neighborhood_start[node_id + 1];
+    if (first == last) {
+        return Node_Span();
+    }
 
-    nodes[node_id].unregister_player(id);
+    return Node_Span(&neighborhoods[0] + first, &neighborhoods[0] + last);
 }
 
-tank_array NodeManager::get_relevant_players(const int &node_id)
+void NodeManager::get_players_near_line(const double x1, const double y1,
+    const double x2, const double y2, tank_array &players) const
 {
-    boost::lock_guard<boost::mutex> guard(mutex);
-    if (node_id < 0) {
-        return tank_array();
-    }
+    players.clear();
 
-    // Some pre-calculations.
-    const int top_row = node_id - width;
-    const int bottom_row = node_id + width;
-
-	// Find which nodes we are looking at.
-    const int relevant_nodes[9] = {
-                        // Moving clock-wise...
-        top_row - 1,    // Northwest
-        top_row,        // North
-        top_row + 1,    // Northeast
-        node_id + 1,    // East
-        bottom_row + 1, // Southeast
-        bottom_row,     // South
-        bottom_row - 1, // Southwest
-        node_id - 1,    // West
-        node_id         // Middle
-    };
-
-    tank_array players;
-    for (int i = 0; i < 9; i++) {
-        const int node_id = relevant_nodes[i];
-        if (node_id < 0 || node_id >= size) {
-            // Node is out of range.
+    Utility::Grid_Traversal nodes(Utility::Line(x1, y1, x2, y2), node_width, node_height);
+    do {
+        const int x = nodes.get_x();
+        const int y = nodes.get_y();
+        if (x < 0 || x >= width || y < 0 || y >= height) {
             continue;
         }
 
-        const tank_array temp_array = nodes[node_id].get_players();
-        // TODO: "Back inserter"
-        for (tank_array::size_type j = 0; j < temp_array.size(); j++) {
-            players.push_back(temp_array[j]);
+        // Neighborhoods of consecutive nodes overlap, so skip tanks already listed.
+        const Node_Span span = get_neighbors(y * width + x);
+        for (Node_Span::const_iterator i = span.begin(); i != span.end(); ++i) {
+            if (std::find(players.begin(), players.end(), *i) == players.end()) {
+                players.push_back(*i);
+            }
         }
-    }
+    } while (nodes.next());
+}
+
+tank_array NodeManager::get_relevant_players(const int &node_id)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
 
-    return players;
+    const Node_Span span = get_neighbors(node_id);
+    return tank_array(span.begin(), span.end());
 }
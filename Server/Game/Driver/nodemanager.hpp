@@ -7,15 +7,38 @@
 #ifndef NODEMANAGER_HPP
 #define NODEMANAGER_HPP
 
-// This could be dynamically sized, perhaps 10% of the map. To be continued.
+// Default node size in pixels; see NodeManager::set_node_size().
 #define NODE_WIDTH 832
 #define NODE_HEIGHT 640
 
-#include <node.hpp>
 #include <Map.hpp>
 #include <tank.hpp>
 #include <projectile.hpp>
 
+/*!
+    A read-only, contiguous run of tanks owned by the NodeManager. Spans are
+    only valid until the next call to NodeManager::rebuild() or set_map().
+*/
+class Node_Span
+{
+private:
+    const tank_ptr *first;
+    const tank_ptr *last;
+
+public:
+    typedef const tank_ptr *const_iterator;
+    typedef std::size_t size_type;
+
+    Node_Span() : first(NULL), last(NULL) {}
+    Node_Span(const tank_ptr *begin, const tank_ptr *end) : first(begin), last(end) {}
+
+    const_iterator begin() const { return first; }
+    const_iterator end() const { return last; }
+    size_type size() const { return static_cast<size_type>(last - first); }
+    bool empty() const { return first == last; }
+    const tank_ptr &operator[](const size_type index) const { return first[index]; }
+};
+
 /*!
     The NodeManager class is a specially created graph class that tracks
     each section of the map as a grid. The map is split into large parts
@@ -24,46 +47,57 @@
     relevant nodes. For example, if a tank in Node (1, 1) performs an action,
     only tanks in node (0, 0), (0, 1), (1, 0) -- every node in all eight 
     directions -- are notified of the action.
+
+    Membership is a flat spatial hash rebuilt once per tick: for every node, the
+    tanks in it and its eight neighbors are stored back to back in one array, so
+    a neighbor query is a single contiguous span. Only the simulation thread
+    rebuilds and calls get_neighbors(); get_relevant_players() copies under the
+    lock and may be called from anywhere.
 */
 class NodeManager
 {
 private:
     boost::mutex mutex;
-    Node *nodes;
     int size;
 	int width;
 	int height;
+    int node_width;
+    int node_height;
 
-    /*!
-        Allocate the nodes.
-        \param node_size Number of nodes to allocate.
-        \throws std::exception Exception may be thrown if it tries to allocate
-        nodes with too many elements.
-    */
-    void allocate_nodes(const int &);
+    //! Tanks in each node's neighborhood, grouped by node.
+    std::vector<tank_ptr> neighborhoods;
+
+    //! Index of each node's first entry in neighborhoods; entry size is the end.
+    std::vector<int> neighborhood_start;
+
+    //! Scratch space for rebuild(), kept to avoid reallocating every tick.
+    std::vector<int> fill_position;
 
     /*!
-        Deallocate the nodes. Performs a simple delete[] operation.
+        Compute the node containing a position, without locking.
+        \param position Position to check.
+        \return ID of the node; -1 if it falls off the map.
     */
-    void deallocate_nodes();
+    int node_at(const VTankObject::Point &) const;
 
 public:
     /*!
-        Initializes the thread pool and nothing else. set_map() should be called soon
-        after this constructor.
-        TODO: Maybe current_map can be initialized here.
+        Create a node manager with the default node size. set_map() should be
+        called soon after this constructor.
     */
     NodeManager();
 
     /*!
-        Deallocates the nodes, if they were allocated.
+        Change the size of each node. Takes effect at the next set_map().
+        \param node_width Width of a node in pixels.
+        \param node_height Height of a node in pixels.
     */
-    ~NodeManager();
+    void set_node_size(const int, const int);
 
     /*!
-        Change the map that the manager uses, causing it to deallocate it's
-        current set of nodes and re-allocate them. Note that this clears the
-        list of players, so they must be re-registered.
+        Change the map that the manager uses, causing it to re-create its grid of
+        nodes. Note that this clears the list of players, so they are only known
+        again after the next rebuild().
         \param map Map to set.
     */
     void set_map(const Map *const);
@@ -84,30 +118,55 @@ public:
 	bool is_near(int node1, int node2) const;
 
     /*!
-        Process the position of a player. This will register the player with the 
-        appropriate node, or perhaps will do nothing.
+        Process the position of a player, setting the ID of the node it is in. The
+        player is listed under that node from the next rebuild() on.
         \param player Player to process.
     */
     void process_position(tank_ptr);
 
     /*!
-        Process the position of the projectile. While it doesn't register the projectile
-        internally, it still sets a new node ID for the projectile.
-        \param projectile Projectile to process.
+        Process the positions of a batch of projectiles. While it doesn't register the
+        projectiles internally, it still sets a new node ID for each of them.
+        \param x X position of each projectile.
+        \param y Y position of each projectile.
+        \param node_ids [out] Node ID of each projectile, the same length as x and y.
+    */
+    void process_projectiles(const std::vector<double> &, const std::vector<double> &,
+        std::vector<int> &);
+
+    /*!
+        Re-bucket every tank by the node ID last set by process_position(). Called
+        by the simulation thread once tanks have moved; tanks which have left the
+        game drop out here.
+        \param tanks Every tank in the game.
+    */
+    void rebuild(const tank_array &);
+
+    /*!
+        Get the players relevant to the given node without copying or locking. A
+        relevant node is any node neighboring the given node (including the given
+        node) in all eight directions. Simulation thread only.
+        \param node_id ID of the node that the program is interested in.
+        \return Players in the relevant nodes, valid until the next rebuild().
     */
-    void process_projectile(projectile_ptr projectile);
+    Node_Span get_neighbors(const int) const;
 
     /*!
-        Remove a player from a node. This is used for when a player leaves the game.
-        \param id ID of the player.
-        \param node_id ID of the node.
+        Collect the players relevant to any node that a line segment crosses, each
+        listed once. Anyone whose center lies within one node of the line is found,
+        so this covers every tank the line could touch. Simulation thread only.
+        \param x1 Line starting position X.
+        \param y1 Line starting position Y.
+        \param x2 Line ending position X.
+        \param y2 Line ending position Y.
+        \param players [out] Cleared, then filled with the players found.
     */
-    void unregister_player(const int &, const int &);
-    
+    void get_players_near_line(const double, const double, const double, const double,
+        tank_array &) const;
+
     /*!
-        Get a collection of players who are relevant to the given node. A relevant
-        node is any node neighboring the given node (including the given node) in
-        all eight directions.
+        Get a copy of the players relevant to the given node. Safe to call from any
+        thread; the simulation thread should prefer get_neighbors().
         \param node_id ID of the node that the program is interested in.
         \return Array of players collected from each relevant node.
     */
@@ -118,6 +177,12 @@ public:
 		\return Number of nodes allocated for the node manager.
 	*/
 	const int get_size() const { return size; }
+
+    //! Width of a node in pixels.
+    int get_node_width() const { return node_width; }
+
+    //! Height of a node in pixels.
+    int get_node_height() const { return node_height; }
 };
 
 #endif
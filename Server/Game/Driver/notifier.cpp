@@ -9,701 +9,799 @@
 #include <gamemanager.hpp>
 #include <logger.hpp>
 #include <macros.hpp>
-#include <asynctemplate.hpp>
+#include <outboundqueue.hpp>
 
 namespace Notifier {
-    void handle_player_exception(const int id, const Ice::Exception &ex) 
+    // Each send_ function makes one call for a player's outbound queue. They are bound
+    // into messages once per event and run later by the sender pool; failures are dealt
+    // with by the queue, which disconnects the player.
+
+    void send_update_tanks(const outbound_ptr &queue, const Ice::Long tick,
+        const GameSession::TankUpdateList &updates)
     {
-        std::ostringstream formatter;
-        formatter << "Player #" << id << " was disconnected during an asynchronous "
-            "message notification. Kicking the user off. Exception: " << ex.what();
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_UpdateTanks> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->UpdateTanks_async(callback, tick,
+            updates));
+    }
 
-        Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
+    void send_update_snapshot(const outbound_ptr &queue, const Ice::Long tick,
+        const std::vector<Ice::Byte> &data)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_UpdateSnapshot> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->UpdateSnapshot_async(callback, tick,
+            data));
+    }
 
-        (void)Players::remove_player(id);
+    void send_player_damaged(const outbound_ptr &queue, const int owner_id,
+        const int projectile_id, const int fired_by_id, const int damage_taken,
+        const bool killing_blow)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_PlayerDamaged> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->PlayerDamaged_async(callback, owner_id,
+            projectile_id, fired_by_id, damage_taken, killing_blow));
     }
-    
-    void blanket_notify_player_damaged(const int owner_id, const int projectile_id, 
-        const int fired_by_id, const int damage_taken, const bool killing_blow)
+
+    void send_player_respawned(const outbound_ptr &queue, const int who,
+        const VTankObject::Point &position)
     {
-        const tank_array tanks = Players::tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            try {
-                tank->get_player_info()->get_callback()->PlayerDamaged_async(
-                    new PlayerAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_PlayerDamaged>(
-                            tank->get_id(), handle_player_exception),
-                    owner_id, projectile_id, fired_by_id, damage_taken, killing_blow);
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_PlayerRespawned> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->PlayerRespawned_async(callback, who,
+            position));
+    }
+
+    void send_player_left(const outbound_ptr &queue, const int id)
+    {
+        typedef Queued_Callback<GameSession::AMI_ClientEventCallback_PlayerLeft> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->PlayerLeft_async(callback, id));
+    }
+
+    void send_player_joined(const outbound_ptr &queue, const GameSession::Tank &tank)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_PlayerJoined> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->PlayerJoined_async(callback, tank));
+    }
+
+    void send_rotate_map(const outbound_ptr &queue)
+    {
+        typedef Queued_Callback<GameSession::AMI_ClientEventCallback_RotateMap> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->RotateMap_async(callback));
+    }
+
+    void send_chat_message(const outbound_ptr &queue, const std::string &message,
+        const VTankObject::VTankColor &color)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_ChatMessage> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->ChatMessage_async(callback, message,
+            color));
+    }
+
+    void send_create_projectile(const outbound_ptr &queue, const int owner_id,
+        const int projectile_id, const int projectile_type_id,
+        const VTankObject::Point &end_point)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_CreateProjectile> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->CreateProjectile_async(callback, owner_id,
+            projectile_id, projectile_type_id, end_point));
+    }
+
+    void send_create_projectiles(const outbound_ptr &queue,
+        const GameSession::ProjectileDamageList &list)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_CreateProjectiles> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->CreateProjectiles_async(callback, list));
+    }
+
+    void send_spawn_utility(const outbound_ptr &queue, const int utility_id,
+        const VTankObject::Utility &util, const VTankObject::Point &position)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_SpawnUtility> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->SpawnUtility_async(callback, utility_id,
+            util, position));
+    }
+
+    void send_apply_utility(const outbound_ptr &queue, const int utility_id,
+        const VTankObject::Utility &util, const int tank_id)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_ApplyUtility> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->ApplyUtility_async(callback, utility_id,
+            util, tank_id));
+    }
+
+    void send_flag_spawned(const outbound_ptr &queue, const VTankObject::Point &position,
+        const GameSession::Alliance &color)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_FlagSpawned> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->FlagSpawned_async(callback, position,
+            color));
+    }
+
+    void send_flag_picked_up(const outbound_ptr &queue, const int id,
+        const GameSession::Alliance &color)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_FlagPickedUp> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->FlagPickedUp_async(callback, id, color));
+    }
+
+    void send_flag_dropped(const outbound_ptr &queue, const int id,
+        const VTankObject::Point &position, const GameSession::Alliance &color)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_FlagDropped> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->FlagDropped_async(callback, id, position,
+            color));
+    }
+
+    void send_flag_returned(const outbound_ptr &queue, const int id,
+        const GameSession::Alliance &color)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_FlagReturned> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->FlagReturned_async(callback, id, color));
+    }
+
+    void send_flag_captured(const outbound_ptr &queue, const int id,
+        const GameSession::Alliance &color)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_FlagCaptured> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->FlagCaptured_async(callback, id, color));
+    }
+
+    void send_flag_despawned(const outbound_ptr &queue, const GameSession::Alliance &color)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_FlagDespawned> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->FlagDespawned_async(callback, color));
+    }
+
+    void send_base_captured(const outbound_ptr &queue,
+        const GameSession::Alliance &old_color, const GameSession::Alliance &new_color,
+        const int base_id, const int capturer_id)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_BaseCaptured> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->BaseCaptured_async(callback, old_color,
+            new_color, base_id, capturer_id));
+    }
+
+    void send_set_base_health(const outbound_ptr &queue, const GameSession::Alliance &color,
+        const int base_id, const int health)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_SetBaseHealth> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->SetBaseHealth_async(callback, color,
+            base_id, health));
+    }
+
+    void send_damage_base(const outbound_ptr &queue, const GameSession::Alliance &color,
+        const int base_id, const int damage, const int projectile_id, const int player_id,
+        const bool destroyed)
+    {
+        typedef Queued_Callback<GameSession::AMI_ClientEventCallback_DamageBase> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->DamageBase_async(callback, color, base_id,
+            damage, projectile_id, player_id, destroyed));
+    }
+
+    void send_reset_position(const outbound_ptr &queue, const VTankObject::Point &position)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_ResetPosition> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->ResetPosition_async(callback, position));
+    }
+
+    void send_player_move(const outbound_ptr &queue, const int id,
+        const VTankObject::Point &position, const VTankObject::Direction direction)
+    {
+        typedef Queued_Callback<GameSession::AMI_ClientEventCallback_PlayerMove> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->PlayerMove_async(callback, id, position,
+            direction));
+    }
+
+    void send_player_rotate(const outbound_ptr &queue, const int id, const double angle,
+        const VTankObject::Direction direction)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_PlayerRotate> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->PlayerRotate_async(callback, id, angle,
+            direction));
+    }
+
+    void send_end_round(const outbound_ptr &queue, const GameSession::Alliance &winner)
+    {
+        typedef Queued_Callback<GameSession::AMI_ClientEventCallback_EndRound> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->EndRound_async(callback, winner));
+    }
+
+    void send_spawn_env_effect(const outbound_ptr &queue, const int env_id,
+        const int type_id, const int owner_id, const VTankObject::Point &position)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_SpawnEnvironmentEffect> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->SpawnEnvironmentEffect_async(callback,
+            env_id, type_id, owner_id, position));
+    }
+
+    void send_damage_base_by_env(const outbound_ptr &queue,
+        const GameSession::Alliance &team, const int base_id, const int env_id,
+        const int damage, const bool killing_blow)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_DamageBaseByEnvironment> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->DamageBaseByEnvironment_async(callback,
+            team, base_id, env_id, damage, killing_blow));
+    }
+
+    void send_damage_player_by_env(const outbound_ptr &queue, const int victim_id,
+        const int env_id, const int damage, const bool killing_blow)
+    {
+        typedef Queued_Callback<
+            GameSession::AMI_ClientEventCallback_PlayerDamagedByEnvironment> callback_t;
+        const callback_t::pointer callback = callback_t::acquire(queue);
+        callback->dispatched(queue->get_proxy()->PlayerDamagedByEnvironment_async(callback,
+            victim_id, env_id, damage, killing_blow));
+    }
+
+    /*!
+        Push a message to every player in the arena.
+        \param message Message to send.
+        \param droppable True if a later message supersedes this one.
+        \param except ID of a player not to send it to, or -1.
+    */
+    void queue_for_all(const Outbound_Queue::message_ptr &message,
+        const bool droppable = false, const int except = -1)
+    {
+        const Recipient_List::recipients_ptr recipients = Players::get_recipient_list()->get();
+        for (Recipient_List::recipient_array::size_type i = 0; i < recipients->size(); i++) {
+            const Recipient_List::Recipient &recipient = (*recipients)[i];
+            if (recipient.id != except) {
+                recipient.queue->push(message, droppable);
             }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << "Exception thrown while notifying " 
-                    << tank->get_name() << " of a player getting damaged. Removing him. "
-                    "Exception details: " << e.what();
+        }
+    }
 
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+    /*!
+        Push a per-event movement message to every player, other than the one who moved,
+        who doesn't receive batched updates or snapshots instead. Nothing resends the
+        state it carries, so it is never dropped.
+        \param message Message to send.
+        \param id ID of the player who moved.
+    */
+    void queue_per_event(const Outbound_Queue::message_ptr &message, const int id)
+    {
+        const Recipient_List::recipients_ptr recipients = Players::get_recipient_list()->get();
+        for (Recipient_List::recipient_array::size_type i = 0; i < recipients->size(); i++) {
+            const Recipient_List::Recipient &recipient = (*recipients)[i];
+            if (recipient.id != id && 
+                recipient.player->get_update_mode() == UPDATE_PER_EVENT) {
+                recipient.queue->push(message, false);
             }
-            HANDLE_UNCAUGHT_EXCEPTIONS
         }
     }
 
-    void blanket_notify_player_respawn(const int who, const VTankObject::Point &position)
+    //! Push a message to each player in a list.
+    void queue_for_tanks(const tank_array &tanks, const Outbound_Queue::message_ptr &message)
     {
-        const tank_array tanks = Players::tanks.get_tank_list();
         for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            try {
-                tank->get_player_info()->get_callback()->PlayerRespawned_async(
-                    new PlayerAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_PlayerRespawned>(
-                            tank->get_id(), handle_player_exception), who, position);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << "Exception thrown while notifying " 
-                    << tank->get_name() << " of a player respawning. Removing him. "
-                    "Exception details: " << e.what();
+            tanks[i]->get_player_info()->get_outbound()->push(message, false);
+        }
+    }
 
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-            }
-            HANDLE_UNCAUGHT_EXCEPTIONS
+    //! Push a message to one player.
+    void queue_for_tank(const tank_ptr &tank, const Outbound_Queue::message_ptr &message)
+    {
+        tank->get_player_info()->get_outbound()->push(message, false);
+    }
+
+    /*!
+        Push a message to every player interested in an event, or to every player in the
+        arena if the event is on the always-broadcast list. Simulation thread only.
+        \param area Where the event happens and who it concerns.
+        \param events Interest::Event_Type flags describing the event.
+        \param message Message to send.
+    */
+    void queue_for_area(const Interest_Area &area, const int events,
+        const Outbound_Queue::message_ptr &message)
+    {
+        if (Interest::is_always_broadcast(events)) {
+            queue_for_all(message);
+            return;
         }
+
+        tank_array tanks;
+        area.collect(*Players::get_node_manager(), tanks);
+        queue_for_tanks(tanks, message);
     }
 
-    void blanket_notify_player_left(const int id)
+    //! Order snapshot entries by ID.
+    template <typename T>
+    bool compare_by_id(const T &left, const T &right)
     {
-        const tank_array tanks = Players::tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            if (tank->get_id() != id) {
-                try {
-                    tank->get_player_info()->get_callback()->PlayerLeft_async(
-                        new PlayerAsyncCallback<
-                            GameSession::AMI_ClientEventCallback_PlayerLeft>(
-                                tank->get_id(), handle_player_exception), id);
+        return left.id < right.id;
+    }
+
+    //! Build the batched update describing a tank's current state.
+    GameSession::TankUpdate make_tank_update(const Tank_State &tank)
+    {
+        GameSession::TankUpdate update;
+        update.id = tank.id;
+        update.position = tank.position;
+        update.angle = tank.angle;
+        update.movementDirection = tank.movement_direction;
+        update.rotationDirection = tank.rotation_direction;
+        update.turretAngle = tank.turret_angle;
+        update.turretDirection = tank.turret_direction;
+
+        return update;
+    }
+
+    void broadcast_tank_updates(const Ice::Long tick, const std::vector<int> &changed,
+        const std::vector<int> &relocated)
+    {
+        const bool nothing_changed = changed.empty() && relocated.empty();
+
+        // Each tank's update is built at most once, no matter how many players see it.
+        std::map<int, GameSession::TankUpdate> cache;
+
+        const NodeManager &nodes = *Players::get_node_manager();
+        const Tank_State_Buffer::Reader reader(*Players::get_tank_states());
+        const tank_state_array &states = reader.get_states();
+        for (tank_state_array::size_type i = 0; i < states.size(); i++) {
+            const tank_ptr tank = states[i].tank;
+            if (tank->get_player_info()->get_update_mode() != UPDATE_BATCHED) {
+                // This player gets per-event updates or snapshots instead.
+                continue;
+            }
+
+            // A player who lost an update gets every tank around them again, since the
+            // updates after it only hold what changed.
+            const int id = states[i].id;
+            const outbound_ptr queue = tank->get_player_info()->get_outbound();
+            const bool full_update = queue->take_dropped() ||
+                std::find(relocated.begin(), relocated.end(), id) != relocated.end();
+            if (nothing_changed && !full_update) {
+                continue;
+            }
+
+            GameSession::TankUpdateList updates;
+            const Node_Span relevant = nodes.get_neighbors(states[i].node_id);
+            for (Node_Span::size_type j = 0; j < relevant.size(); j++) {
+                const int other_id = relevant[j]->get_id();
+                if (other_id == id) {
+                    continue;
                 }
-                catch (const Ice::Exception &e) {
-                    std::ostringstream formatter;
-                    formatter << "Exception thrown while notifying " 
-                        << tank->get_name() << " of a player leaving. Removing him. "
-                        "Exception details: " << e.what();
 
-                    Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+                if (full_update ||
+                    std::find(changed.begin(), changed.end(), other_id) != changed.end() ||
+                    std::find(relocated.begin(), relocated.end(), other_id) != relocated.end()) {
+                    std::map<int, GameSession::TankUpdate>::const_iterator cached = 
+                        cache.find(other_id);
+                    if (cached == cache.end()) {
+                        const Tank_State *other = reader.find(other_id);
+                        if (other == NULL) {
+                            // Joined after the states were published.
+                            continue;
+                        }
+
+                        cached = cache.insert(std::make_pair(
+                            other_id, make_tank_update(*other))).first;
+                    }
+
+                    updates.push_back(cached->second);
                 }
-                HANDLE_UNCAUGHT_EXCEPTIONS
             }
+
+            if (updates.empty()) {
+                continue;
+            }
+
+            // A slow player may lose this; the next tick then sends a full update.
+            queue->push(Outbound::make_message(
+                boost::bind(&send_update_tanks, _1, tick, updates)), true);
         }
     }
 
-    void blanket_notify_player_joined(const tank_ptr new_tank)
+    //! Build the quantized snapshot entry describing a tank's current state.
+    Tank_Snapshot make_tank_snapshot(const Tank_State &tank)
     {
-        const tank_array tanks = Players::tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            if (tank->get_id() != new_tank->get_id()) {
-                try {
-                    tank->get_player_info()->get_callback()->PlayerJoined_async(
-                        new PlayerAsyncCallback<
-                            GameSession::AMI_ClientEventCallback_PlayerJoined>(
-                                tank->get_id(), handle_player_exception), 
-                                new_tank->get_tank_object());
+        Tank_Snapshot state;
+        state.id = tank.id;
+        state.x = Snapshot_Codec::quantize_position(tank.position.x);
+        state.y = Snapshot_Codec::quantize_position(tank.position.y);
+        state.angle = Snapshot_Codec::quantize_angle(tank.angle);
+        state.turret_angle = Snapshot_Codec::quantize_angle(tank.turret_angle);
+        state.movement_direction = static_cast<unsigned char>(tank.movement_direction);
+        state.rotation_direction = static_cast<unsigned char>(tank.rotation_direction);
+        state.turret_direction = static_cast<unsigned char>(tank.turret_direction);
+
+        return state;
+    }
+
+    void broadcast_snapshots(const Ice::Long tick)
+    {
+        const NodeManager &nodes = *Players::get_node_manager();
+        const Tank_State_Buffer::Reader reader(*Players::get_tank_states());
+        const tank_state_array &states = reader.get_states();
+        const projectile_array projectiles = 
+            Players::get_projectile_manager()->get_projectiles();
+
+        // Each entity is quantized at most once, no matter how many players see it.
+        std::map<int, Tank_Snapshot> cache;
+
+        std::vector<Ice::Byte> data;
+        for (tank_state_array::size_type i = 0; i < states.size(); i++) {
+            const tank_ptr tank = states[i].tank;
+            const player_ptr player = tank->get_player_info();
+            if (player->get_update_mode() != UPDATE_SNAPSHOT) {
+                continue;
+            }
+
+            const int node_id = states[i].node_id;
+
+            Snapshot snapshot;
+            snapshot.tick = tick;
+
+            const Node_Span relevant = nodes.get_neighbors(node_id);
+            for (Node_Span::size_type j = 0; j < relevant.size(); j++) {
+                const int other_id = relevant[j]->get_id();
+                std::map<int, Tank_Snapshot>::const_iterator cached = cache.find(other_id);
+                if (cached == cache.end()) {
+                    const Tank_State *other = reader.find(other_id);
+                    if (other == NULL) {
+                        // Joined after the states were published.
+                        continue;
+                    }
+
+                    cached = cache.insert(std::make_pair(
+                        other_id, make_tank_snapshot(*other))).first;
                 }
-                catch (const Ice::Exception &e) {
-                    std::ostringstream formatter;
-                    formatter << "Exception thrown while notifying " 
-                        << tank->get_name() << " of a player joining. Removing him. "
-                        "Exception details: " << e.what();
 
-                    Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+                snapshot.tanks.push_back(cached->second);
+            }
+
+            for (projectile_array::size_type j = 0; j < projectiles.size(); j++) {
+                const Active_Projectile &projectile = projectiles[j];
+                if (node_id < 0 || !nodes.is_near(node_id, projectile.node_id)) {
+                    continue;
                 }
-                HANDLE_UNCAUGHT_EXCEPTIONS
+
+                Projectile_Snapshot state;
+                state.id = projectile.id;
+                state.type_id = Players::get_weapon_data()->get_table()->get_weapon(
+                    projectile.weapon).projectile.id;
+                state.x = Snapshot_Codec::quantize_position(projectile.position.x);
+                state.y = Snapshot_Codec::quantize_position(projectile.position.y);
+                state.angle = Snapshot_Codec::quantize_angle(projectile.angle);
+
+                snapshot.projectiles.push_back(state);
             }
+
+            // The codec expects entities sorted by ID.
+            std::sort(snapshot.tanks.begin(), snapshot.tanks.end(), compare_by_id<Tank_Snapshot>);
+            std::sort(snapshot.projectiles.begin(), snapshot.projectiles.end(), 
+                compare_by_id<Projectile_Snapshot>);
+
+            player->get_snapshot_channel().encode(snapshot, data);
+
+            // Snapshots are encoded against the last one acknowledged, so losing one is safe.
+            player->get_outbound()->push(Outbound::make_message(
+                boost::bind(&send_update_snapshot, _1, tick, data)), true);
         }
     }
 
-    void blanket_notify_rotate_map()
+    void broadcast_player_damaged(const tank_ptr &victim, const int projectile_id, 
+        const tank_ptr &shooter, const int damage_taken, const bool killing_blow)
     {
-        const tank_array tanks = Players::tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            try {
-                tank->get_player_info()->get_callback()->RotateMap_async(
-                    new PlayerAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_RotateMap>(
-                            tank->get_id(), handle_player_exception));
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << "Exception thrown while notifying " 
-                    << tank->get_name() << " of a map rotation. Removing him. "
-                    "Exception details: " << e.what();
+        Interest_Area area;
+        area.add_point(victim->get_position());
+        area.add_tank(victim);
+        area.add_tank(shooter);
+
+        queue_for_area(area, Interest::EVENT_PLAYER_DAMAGED |
+            (killing_blow ? Interest::EVENT_KILLING_BLOW : 0),
+            Outbound::make_message(boost::bind(&send_player_damaged, _1, victim->get_id(),
+                projectile_id, shooter->get_id(), damage_taken, killing_blow)));
+    }
 
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-            }
-            HANDLE_UNCAUGHT_EXCEPTIONS
-        }
+    void blanket_notify_player_respawn(const int who, const VTankObject::Point &position)
+    {
+        queue_for_all(Outbound::make_message(
+            boost::bind(&send_player_respawned, _1, who, position)));
+    }
+
+    void blanket_notify_player_left(const int id)
+    {
+        queue_for_all(Outbound::make_message(boost::bind(&send_player_left, _1, id)),
+            false, id);
+    }
+
+    void blanket_notify_player_joined(const tank_ptr new_tank)
+    {
+        queue_for_all(Outbound::make_message(
+            boost::bind(&send_player_joined, _1, new_tank->get_tank_object())),
+            false, new_tank->get_id());
+    }
+
+    void blanket_notify_rotate_map()
+    {
+        queue_for_all(Outbound::make_message(boost::bind(&send_rotate_map, _1)));
     }
     
     void blanket_notify_chat_message(const std::string &message, 
         const VTankObject::VTankColor &color)
     {
-        const tank_array tanks = Players::tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            try {
-                tank->get_player_info()->get_callback()->ChatMessage_async(
-                    new PlayerAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_ChatMessage>(
-                            tank->get_id(), handle_player_exception), message, color);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << "Exception thrown while notifying " 
-                    << tank->get_name() << " of a chat message. Removing him. "
-                    "Exception details: " << e.what();
-
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-            }
-            HANDLE_UNCAUGHT_EXCEPTIONS
-        }
+        queue_for_all(Outbound::make_message(
+            boost::bind(&send_chat_message, _1, message, color)));
     }
 
     void notify_chat_message(const tank_array &tanks, const std::string &message, 
         const VTankObject::VTankColor &color)
     {
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            try {
-                tank->get_player_info()->get_callback()->ChatMessage_async(
-                    new PlayerAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_ChatMessage>(
-                            tank->get_id(), handle_player_exception), message, color);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << "Exception thrown while notifying " 
-                    << tank->get_name() << " of a chat message. Removing him. "
-                    "Exception details: " << e.what();
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_chat_message, _1, message, color)));
+    }
 
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-            }
-            HANDLE_UNCAUGHT_EXCEPTIONS
-        }
+    void broadcast_create_projectile(const tank_ptr &owner, const int projectile_id,
+        const int projectile_type_id, const VTankObject::Point &end_point,
+        const Utility::Line &path)
+    {
+        Interest_Area area;
+        area.add_path(path);
+        area.add_tank(owner);
+
+        queue_for_area(area, Interest::EVENT_CREATE_PROJECTILE,
+            Outbound::make_message(boost::bind(&send_create_projectile, _1,
+                owner->get_id(), projectile_id, projectile_type_id, end_point)));
     }
-	
-	void blanket_notify_create_projectile(const int owner_id, const int projectile_id,
-			const int projectile_type_id, const VTankObject::Point &end_point) {
-		const tank_array tanks = Players::tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const std::string name = tanks[i]->get_name();
-            try {
-		        tanks[i]->get_player_info()->get_callback()->CreateProjectile_async(
-                    new VoidAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_CreateProjectile>(),
-                    owner_id, projectile_id, projectile_type_id, end_point);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << name << " threw an exception while processing "
-                    "creation of projectiles: " << e.what();
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-                
-                (void)Players::remove_player(tanks[i]->get_id());
-            }
-	    }
-	}
-
-	void blanket_notify_utility_spawn(const tank_array &tanks, int utilityID,
-		const VTankObject::Utility &util, const VTankObject::Point &position)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            try {
-                tank->get_player_info()->get_callback()->SpawnUtility_async(
-                    new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_SpawnUtility>(
-                            tank->get_id(), handle_player_exception), utilityID, util, position);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << "Exception thrown while notifying " 
-                    << tank->get_name() << " of util spawn. Removing him. "
-                    "Exception details: " << e.what();
 
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-            }
-            HANDLE_UNCAUGHT_EXCEPTIONS
-        }
-	}
-
-	void blanket_notify_apply_utility(const tank_array &tanks, int tankID, int utilityID,
-		const VTankObject::Utility &util)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-            try {
-                tank->get_player_info()->get_callback()->ApplyUtility_async(
-                    new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_ApplyUtility>(
-                            tank->get_id(), handle_player_exception), utilityID, util, tankID);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << "Exception thrown while notifying " 
-                    << tank->get_name() << " of util apply. Removing him. "
-                    "Exception details: " << e.what();
+    void blanket_notify_utility_spawn(const tank_array &tanks, int utilityID,
+        const VTankObject::Utility &util, const VTankObject::Point &position)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_spawn_utility, _1, utilityID, util, position)));
+    }
 
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-            }
-            HANDLE_UNCAUGHT_EXCEPTIONS
-        }
-	}
-
-	void notify_utility_spawn(const tank_ptr &tank, int utilityID,
-		const VTankObject::Utility &util, const VTankObject::Point &position)
-	{
-        try {
-            tank->get_player_info()->get_callback()->SpawnUtility_async(
-                new PlayerAsyncCallback<
-					GameSession::AMI_ClientEventCallback_SpawnUtility>(
-                        tank->get_id(), handle_player_exception), utilityID, util, position);
-        }
-        catch (const Ice::Exception &e) {
-            std::ostringstream formatter;
-            formatter << "Exception thrown while notifying " 
-                << tank->get_name() << " of util spawn. Removing him. "
-                "Exception details: " << e.what();
+    void blanket_notify_apply_utility(const tank_array &tanks, int tankID, int utilityID,
+        const VTankObject::Utility &util)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_apply_utility, _1, utilityID, util, tankID)));
+    }
+
+    void notify_utility_spawn(const tank_ptr &tank, int utilityID,
+        const VTankObject::Utility &util, const VTankObject::Point &position)
+    {
+        queue_for_tank(tank, Outbound::make_message(
+            boost::bind(&send_spawn_utility, _1, utilityID, util, position)));
+    }
+
+    void notify_flag_spawned(const tank_ptr &tank, const VTankObject::Point &position,
+        const GameSession::Alliance &flagColor)
+    {
+        queue_for_tank(tank, Outbound::make_message(
+            boost::bind(&send_flag_spawned, _1, position, flagColor)));
+    }
+
+    void notify_flag_picked_up(const tank_ptr &tank, int pickedUpId,
+        const GameSession::Alliance &flagColor)
+    {
+        queue_for_tank(tank, Outbound::make_message(
+            boost::bind(&send_flag_picked_up, _1, pickedUpId, flagColor)));
+    }
+
+    void blanket_notify_flag_dropped(const tank_array &tanks, int droppedBy,
+        const VTankObject::Point &position, const GameSession::Alliance &flagColor)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_flag_dropped, _1, droppedBy, position, flagColor)));
+    }
+
+    void blanket_notify_flag_returned(const tank_array &tanks, int returnedById, 
+        const GameSession::Alliance &flagColor)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_flag_returned, _1, returnedById, flagColor)));
+    }
+
+    void blanket_notify_flag_picked_up(const tank_array &tanks, int pickedUpById,
+        const GameSession::Alliance &flagColor)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_flag_picked_up, _1, pickedUpById, flagColor)));
+    }
+
+    void blanket_notify_flag_captured(const tank_array &tanks, int capturedById,
+        const GameSession::Alliance &flagColor)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_flag_captured, _1, capturedById, flagColor)));
+    }
+
+    void blanket_notify_flag_spawned(const tank_array &tanks, 
+        const VTankObject::Point &position, const GameSession::Alliance &flagColor)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_flag_spawned, _1, position, flagColor)));
+    }
+
+    void blanket_notify_flag_despawned(const tank_array &tanks,
+        const GameSession::Alliance &flagColor)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_flag_despawned, _1, flagColor)));
+    }
+
+    void blanket_notify_base_captured(const tank_array &tanks,
+        const GameSession::Alliance &old_base_color,
+        const GameSession::Alliance &new_base_color, int base_id, int capturer_id)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(boost::bind(&send_base_captured, _1,
+            old_base_color, new_base_color, base_id, capturer_id)));
+    }
+
+    void blanket_notify_set_base_status(const tank_array &tanks,
+        const GameSession::Alliance &base_color, const int base_id, const int health)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(
+            boost::bind(&send_set_base_health, _1, base_color, base_id, health)));
+    }
+
+    void notify_set_base_status(const tank_ptr &tank,
+        const GameSession::Alliance &base_color, const int base_id, const int health)
+    {
+        queue_for_tank(tank, Outbound::make_message(
+            boost::bind(&send_set_base_health, _1, base_color, base_id, health)));
+    }
+
+    void blanket_notify_damage_base(const tank_array &tanks,
+        const GameSession::Alliance &base_color, int base_id, int damage, int projectile_id, 
+        int player_id, bool is_destroyed)
+    {
+        queue_for_tanks(tanks, Outbound::make_message(boost::bind(&send_damage_base, _1,
+            base_color, base_id, damage, projectile_id, player_id, is_destroyed)));
+    }
+
+    void notify_reset_position(const tank_ptr &player, const VTankObject::Point &pos)
+    {
+        queue_for_tank(player, Outbound::make_message(
+            boost::bind(&send_reset_position, _1, pos)));
+    }
+
+    void blanket_notify_player_moved(const int who_moved, const VTankObject::Point &pos, 
+        const VTankObject::Direction &direction)
+    {
+        queue_for_all(Outbound::make_message(
+            boost::bind(&send_player_move, _1, who_moved, pos, direction)), false, who_moved);
+    }
+
+    void broadcast_player_move(const int id, const VTankObject::Point &position,
+        const VTankObject::Direction direction)
+    {
+        queue_per_event(Outbound::make_message(
+            boost::bind(&send_player_move, _1, id, position, direction)), id);
+    }
+
+    void broadcast_player_rotate(const int id, const double angle,
+        const VTankObject::Direction direction)
+    {
+        queue_per_event(Outbound::make_message(
+            boost::bind(&send_player_rotate, _1, id, angle, direction)), id);
+    }
+
+    void blanket_notify_end_round(const GameSession::Alliance &winner)
+    {
+        queue_for_all(Outbound::make_message(boost::bind(&send_end_round, _1, winner)));
+    }
+
+    void broadcast_spawn_env_effect(int env_id, int type_id, const tank_ptr &owner,
+        const VTankObject::Point &position)
+    {
+        Interest_Area area;
+        area.add_point(position);
+        area.add_tank(owner);
+
+        queue_for_area(area, Interest::EVENT_SPAWN_ENV_EFFECT,
+            Outbound::make_message(boost::bind(&send_spawn_env_effect, _1,
+                env_id, type_id, owner->get_id(), position)));
+    }
 
-            Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+    void notify_env_effects_entered(const tank_ptr &tank, const int old_node)
+    {
+        if (Interest::is_always_broadcast(Interest::EVENT_SPAWN_ENV_EFFECT)) {
+            // Everyone was told when the effects spawned.
+            return;
         }
-        HANDLE_UNCAUGHT_EXCEPTIONS
-	}
-
-	void notify_flag_spawned(const tank_ptr &tank, const VTankObject::Point &position,
-		const GameSession::Alliance &flagColor)
-	{
-		try {
-			tank->get_player_info()->get_callback()->FlagSpawned_async(
-				new PlayerAsyncCallback<
-					GameSession::AMI_ClientEventCallback_FlagSpawned>(
-						tank->get_id(), handle_player_exception), position, flagColor);
-		}
-		catch (const Ice::Exception &e) {
-			std::ostringstream formatter;
-			formatter << "Exception thrown while notifying " 
-				<< tank->get_name() << " of a flag being spawned. Removing him. "
-				"Exception details: " << e.what();
-
-			Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-		}
-		HANDLE_UNCAUGHT_EXCEPTIONS
-	}
-
-	void notify_flag_picked_up(const tank_ptr &tank, int pickedUpId,
-		const GameSession::Alliance &flagColor)
-	{
-		try {
-			tank->get_player_info()->get_callback()->FlagPickedUp_async(
-				new PlayerAsyncCallback<
-					GameSession::AMI_ClientEventCallback_FlagPickedUp>(
-						tank->get_id(), handle_player_exception), pickedUpId, flagColor);
-		}
-		catch (const Ice::Exception &e) {
-			std::ostringstream formatter;
-			formatter << "Exception thrown while notifying " 
-				<< tank->get_name() << " of a flag being spawned. Removing him. "
-				"Exception details: " << e.what();
-
-			Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-		}
-		HANDLE_UNCAUGHT_EXCEPTIONS
-	}
-
-	void blanket_notify_flag_dropped(const tank_array &tanks, int droppedBy,
-		const VTankObject::Point &position, const GameSession::Alliance &flagColor)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->FlagDropped_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_FlagDropped>(
-							tank->get_id(), handle_player_exception), droppedBy, position, flagColor);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of flag dropping. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void blanket_notify_flag_returned(const tank_array &tanks, int returnedById, 
-		const GameSession::Alliance &flagColor)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->FlagReturned_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_FlagReturned>(
-							tank->get_id(), handle_player_exception), returnedById, flagColor);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of flag returning. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void blanket_notify_flag_picked_up(const tank_array &tanks, int pickedUpById,
-		const GameSession::Alliance &flagColor)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->FlagPickedUp_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_FlagPickedUp>(
-							tank->get_id(), handle_player_exception), pickedUpById, flagColor);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of a flag being picked up. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void blanket_notify_flag_captured(const tank_array &tanks, int capturedById,
-		const GameSession::Alliance &flagColor)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->FlagCaptured_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_FlagCaptured>(
-							tank->get_id(), handle_player_exception), capturedById, flagColor);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of a flag being captured. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void blanket_notify_flag_spawned(const tank_array &tanks, 
-		const VTankObject::Point &position, const GameSession::Alliance &flagColor)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->FlagSpawned_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_FlagSpawned>(
-							tank->get_id(), handle_player_exception), position, flagColor);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of a flag being spawned. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void blanket_notify_flag_despawned(const tank_array &tanks, const GameSession::Alliance &flagColor)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->FlagDespawned_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_FlagDespawned>(
-							tank->get_id(), handle_player_exception), flagColor);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of a flag being despawned. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void blanket_notify_base_captured(const tank_array &tanks,
-		const GameSession::Alliance &old_base_color, const GameSession::Alliance &new_base_color,
-		int base_id, int capturer_id)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->BaseCaptured_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_BaseCaptured>(
-							tank->get_id(), handle_player_exception),
-					old_base_color, new_base_color, base_id, capturer_id);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of BaseCaptured. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void blanket_notify_set_base_status(const tank_array &tanks,
-		const GameSession::Alliance &base_color, const int base_id, const int health)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->SetBaseHealth_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_SetBaseHealth>(
-							tank->get_id(), handle_player_exception),
-					base_color, base_id, health);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of SetBaseStatus. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void notify_set_base_status(const tank_ptr &tank,
-		const GameSession::Alliance &base_color, const int base_id, const int health)
-	{
-		try {
-			tank->get_player_info()->get_callback()->SetBaseHealth_async(
-				new PlayerAsyncCallback<
-					GameSession::AMI_ClientEventCallback_SetBaseHealth>(
-						tank->get_id(), handle_player_exception),
-				base_color, base_id, health);
-		}
-		catch (const Ice::Exception &e) {
-			std::ostringstream formatter;
-			formatter << "Exception thrown while notifying " 
-				<< tank->get_name() << " of SetBaseHealth. Removing him. "
-				"Exception details: " << e.what();
-
-			Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-		}
-		HANDLE_UNCAUGHT_EXCEPTIONS
-	}
-
-	void blanket_notify_damage_base(const tank_array &tanks,
-		const GameSession::Alliance &base_color, int base_id, int damage, int projectile_id, 
-		int player_id, bool is_destroyed)
-	{
-		for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-            const tank_ptr tank = tanks[i];
-			try {
-				tank->get_player_info()->get_callback()->DamageBase_async(
-					new PlayerAsyncCallback<
-						GameSession::AMI_ClientEventCallback_DamageBase>(
-							tank->get_id(), handle_player_exception),
-					base_color, base_id, damage, projectile_id, player_id, is_destroyed);
-			}
-			catch (const Ice::Exception &e) {
-				std::ostringstream formatter;
-				formatter << "Exception thrown while notifying " 
-					<< tank->get_name() << " of DamageBase. Removing him. "
-					"Exception details: " << e.what();
-
-				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-			}
-			HANDLE_UNCAUGHT_EXCEPTIONS
-		}
-	}
-
-	void notify_reset_position(const tank_ptr &player, const VTankObject::Point &pos)
-	{
-		try {
-			player->get_player_info()->get_callback()->ResetPosition_async(
-				new PlayerAsyncCallback<
-					GameSession::AMI_ClientEventCallback_ResetPosition>(
-						player->get_id(), handle_player_exception), pos);
-		}
-		catch (const Ice::Exception &e) {
-			std::ostringstream formatter;
-			formatter << "Exception thrown while notifying " 
-				<< player->get_name() << " of ResetPosition. Removing him. "
-				"Exception details: " << e.what();
-
-			Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
-		}
-		HANDLE_UNCAUGHT_EXCEPTIONS
-	}
-
-	void blanket_notify_player_moved(const int who_moved, const VTankObject::Point &pos, 
-		const VTankObject::Direction &direction)
-	{
-		const tank_array tanks = Players::tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-			const tank_ptr tank = tanks[i];
-            try {
-                if (who_moved != tank->get_id()) {
-			        tank->get_player_info()->get_callback()->PlayerMove_async(
-                        new VoidAsyncCallback<
-                            GameSession::AMI_ClientEventCallback_PlayerMove>(),
-                        who_moved, pos, direction);
-                }
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << tank->get_name() 
-                    << " threw an exception while processing PlayerMove: " << e.what();
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
 
-                (void)Players::remove_player(tank->get_id());
+        const int node_id = tank->get_node_id();
+        NodeManager &nodes = *Players::get_node_manager();
+        const std::vector<environment_effect_ptr> effects =
+            Players::get_projectile_manager()->get_effects();
+        for (std::vector<environment_effect_ptr>::size_type i = 0; i < effects.size(); i++) {
+            const Active_Environment_Effect &effect = *effects[i];
+            if (effect.get_owner_id() == tank->get_id()) {
+                // Owners are told wherever they are.
+                continue;
             }
-	    }
-	}
 
-	void blanket_notify_end_round(const GameSession::Alliance &winner)
-	{
-		const tank_array tanks = Players::tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tanks.size(); i++) {
-			const tank_ptr tank = tanks[i];
-            try {
-		        tank->get_player_info()->get_callback()->EndRound_async(
-                    new VoidAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_EndRound>(), winner);
+            const int effect_node = nodes.get_node_at(effect.get_position());
+            if (!nodes.is_near(node_id, effect_node) || nodes.is_near(old_node, effect_node)) {
+                continue;
             }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << tank->get_name() 
-                    << " threw an exception while processing EndRound: " << e.what();
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
 
-                (void)Players::remove_player(tank->get_id());
-            }
-	    }
-	}
-
-	void blanket_notify_spawn_env_effect(int env_id, int type_id, int owner_id,
-		const VTankObject::Point &position)
-	{
-		const tank_array tanks = Players::tanks.get_tank_list();
-		for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
-			const tank_ptr tank = tanks[i];
-            try {
-		        tank->get_player_info()->get_callback()->SpawnEnvironmentEffect_async(
-                    new VoidAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_SpawnEnvironmentEffect>(),
-							env_id, type_id, owner_id, position);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << tank->get_name() 
-                    << " threw an exception while processing SpawnEnvEffect: " << e.what();
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+            queue_for_tank(tank, Outbound::make_message(boost::bind(&send_spawn_env_effect, _1,
+                effect.get_id(), effect.get_property()->id, effect.get_owner_id(),
+                effect.get_position())));
+        }
+    }
 
-                (void)Players::remove_player(tank->get_id());
-            }
-		}
-	}
-
-	void blanket_notify_create_projectiles(const GameSession::ProjectileDamageList &list)
-	{
-		const tank_array tanks = Players::tanks.get_tank_list();
-		for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
-			const tank_ptr tank = tanks[i];
-            try {
-		        tank->get_player_info()->get_callback()->CreateProjectiles_async(
-                    new VoidAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_CreateProjectiles>(), list);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << tank->get_name() 
-                    << " threw an exception while processing CreateProjectiles: " << e.what();
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+    void broadcast_create_projectiles(const tank_ptr &owner,
+        const GameSession::ProjectileDamageList &list, const std::vector<Utility::Line> &paths)
+    {
+        Interest_Area area;
+        for (std::vector<Utility::Line>::size_type i = 0; i < paths.size(); i++) {
+            area.add_path(paths[i]);
+        }
+        area.add_tank(owner);
 
-                (void)Players::remove_player(tank->get_id());
-            }
-		}
-	}
-
-	void blanket_notify_damage_base_by_env(const GameSession::Alliance &team,
-		const int base_id, const int env_id, const int damage, const bool killing_blow)
-	{
-		const tank_array tanks = Players::tanks.get_tank_list();
-		for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
-			const tank_ptr tank = tanks[i];
-            try {
-		        tank->get_player_info()->get_callback()->DamageBaseByEnvironment_async(
-                    new VoidAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_DamageBaseByEnvironment>(),
-						team, base_id, env_id, damage, killing_blow);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << tank->get_name() 
-                    << " threw an exception while processing DamageBaseByEnv: " << e.what();
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+        queue_for_area(area, Interest::EVENT_CREATE_PROJECTILE,
+            Outbound::make_message(boost::bind(&send_create_projectiles, _1, list)));
+    }
 
-                (void)Players::remove_player(tank->get_id());
-            }
-		}
-	}
-
-	void blanket_notify_damage_player_by_env(const int victim_id,
-		const int env_id, const int damage, const bool killing_blow)
-	{
-		const tank_array tanks = Players::tanks.get_tank_list();
-		for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
-			const tank_ptr tank = tanks[i];
-            try {
-		        tank->get_player_info()->get_callback()->PlayerDamagedByEnvironment_async(
-                    new VoidAsyncCallback<
-                        GameSession::AMI_ClientEventCallback_PlayerDamagedByEnvironment>(),
-						victim_id, env_id, damage, killing_blow);
-            }
-            catch (const Ice::Exception &e) {
-                std::ostringstream formatter;
-                formatter << tank->get_name() 
-                    << " threw an exception while processing DamagePlayerByEnv: " << e.what();
-                Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+    void blanket_notify_damage_base_by_env(const GameSession::Alliance &team,
+        const int base_id, const int env_id, const int damage, const bool killing_blow)
+    {
+        queue_for_all(Outbound::make_message(boost::bind(&send_damage_base_by_env, _1,
+            team, base_id, env_id, damage, killing_blow)));
+    }
 
-                (void)Players::remove_player(tank->get_id());
-            }
-		}
-	}
+    void broadcast_damage_player_by_env(const tank_ptr &victim,
+        const int env_id, const int damage, const bool killing_blow)
+    {
+        Interest_Area area;
+        area.add_point(victim->get_position());
+        area.add_tank(victim);
+
+        queue_for_area(area, Interest::EVENT_ENV_DAMAGE |
+            (killing_blow ? Interest::EVENT_KILLING_BLOW : 0),
+            Outbound::make_message(boost::bind(&send_damage_player_by_env, _1,
+                victim->get_id(), env_id, damage, killing_blow)));
+    }
 }
@@ -7,12 +7,17 @@
 #define NOTIFIER_HPP
 
 #include <tank.hpp>
+#include <interest.hpp>
 
 /*!
     The Notifier namespace contains functions which assist in delivering event
-    messages to players. These functions are meant to be delivered as a threadpool
-    task. The functions implemented in this namespace will also take care of removing
-    players from the game who throw connection-related exceptions.
+    messages to players. The functions only push each message to the outbound queue of
+    every recipient and return; the sender pool makes the calls. Players whose
+    connection fails, or who can't keep up, are removed by their queue.
+
+    Events which happen somewhere on the map, such as projectiles, damage and
+    environment effects, are broadcast only to the players interested in them (see
+    Interest_Area), unless the event is on the always-broadcast list.
 */
 namespace Notifier {
     
@@ -24,14 +29,15 @@ namespace Notifier {
     void blanket_notify_player_respawn(const int, const VTankObject::Point &);
     
     /*!
-        Perform a blanket notify of a projectile hit.
-        \param owner_id Player who got shot.
+        Notify the players near a projectile hit, the victim and the shooter of it. By
+        default damage is on the always-broadcast list, so every player is told.
+        \param victim Player who got shot.
         \param projectile_id ID of the projectile that hit the player.
-        \param fired_by_id ID of the player who fired the projectile.
+        \param shooter Player who fired the projectile.
         \param damage_taken Amount of damage taken.
 		\param killing_blow True if the blow was a killing blow; false otherwise.
     */
-    void blanket_notify_player_damaged(const int, const int, const int, const int,
+    void broadcast_player_damaged(const tank_ptr &, const int, const tank_ptr &, const int,
 		const bool);
 
     /*!
@@ -46,6 +52,43 @@ namespace Notifier {
     */
     void blanket_notify_player_joined(const tank_ptr);
 
+    /*!
+        Send each player which has enabled update batching one UpdateTanks message
+        holding every nearby tank that changed this tick. Players which moved to a new
+        node, or whose queue threw an update away, also receive every tank around them,
+        so they never see stale positions.
+        \param tick Number of the tick being broadcast.
+        \param changed IDs of tanks whose movement, rotation or turret changed.
+        \param relocated IDs of tanks which moved to a different node.
+    */
+    void broadcast_tank_updates(const Ice::Long, const std::vector<int> &,
+        const std::vector<int> &);
+
+    /*!
+        Send a player's movement to every other player who receives per-event updates.
+        \param id ID of the player who moved.
+        \param position New position of the player.
+        \param direction Direction the player is moving in.
+    */
+    void broadcast_player_move(const int, const VTankObject::Point &,
+        const VTankObject::Direction);
+
+    /*!
+        Send a player's rotation to every other player who receives per-event updates.
+        \param id ID of the player who rotated.
+        \param angle New angle of the player.
+        \param direction Direction the player is rotating in.
+    */
+    void broadcast_player_rotate(const int, const double, const VTankObject::Direction);
+
+    /*!
+        Send each player which has enabled snapshot updates an encoded snapshot of the
+        tanks and projectiles near them, delta-compressed against the last snapshot the
+        player acknowledged.
+        \param tick Number of the tick being broadcast.
+    */
+    void broadcast_snapshots(const Ice::Long);
+
     /*!
         Perform a blanket notification that the map is rotating.
     */
@@ -59,14 +102,16 @@ namespace Notifier {
 	void blanket_notify_chat_message(const std::string &, const VTankObject::VTankColor &);
 
 	/*!
-		Notify everyone of a new projectile being created.
-		\param owner_id ID of the person firing the projectile.
+		Notify the players along a new projectile's path, and its owner, of it.
+		\param owner Tank firing the projectile.
 		\param projectile_id ID of the projectile.
 		\param projectile_type_id Type of the projectile being fired.
 		\param end_point Targeted position.
+		\param path Line the projectile may cover (see Interest::get_projectile_path()).
 	*/
-	void blanket_notify_create_projectile(const int owner_id, const int projectile_id,
-			const int projectile_type_id, const VTankObject::Point &end_point);
+	void broadcast_create_projectile(const tank_ptr &owner, const int projectile_id,
+			const int projectile_type_id, const VTankObject::Point &end_point,
+			const Utility::Line &path);
 	
 	/*!
 		Notify only a certain group of a new chat message.
@@ -200,15 +245,47 @@ namespace Notifier {
 
 	void blanket_notify_end_round(const GameSession::Alliance &winner);
 
-	void blanket_notify_spawn_env_effect(int env_id, int type_id, int owner_id,
+	/*!
+		Notify the players near a new environment effect, and its owner, of it.
+		\param env_id ID of the effect.
+		\param type_id Type of the effect.
+		\param owner Tank of the player who caused the effect.
+		\param position Position of the effect.
+	*/
+	void broadcast_spawn_env_effect(int env_id, int type_id, const tank_ptr &owner,
 		const VTankObject::Point &position);
 
-	void blanket_notify_create_projectiles(const GameSession::ProjectileDamageList &list);
+	/*!
+		Tell a player who came near environment effects already on the ground about
+		them, since they weren't near when the effects spawned. Effects near the node
+		the player left were sent already. Safe to call from any thread.
+		\param tank Tank of the player, in its new node.
+		\param old_node Node the tank was in before, or -1 if it just joined.
+	*/
+	void notify_env_effects_entered(const tank_ptr &tank, const int old_node);
+
+	/*!
+		Notify the players along the paths of several projectiles fired at once, and
+		their owner, of them.
+		\param owner Tank firing the projectiles.
+		\param list Projectiles fired.
+		\param paths Line each projectile may cover.
+	*/
+	void broadcast_create_projectiles(const tank_ptr &owner,
+		const GameSession::ProjectileDamageList &list, const std::vector<Utility::Line> &paths);
 
 	void blanket_notify_damage_base_by_env(const GameSession::Alliance &team,
 		const int base_id, const int env_id, const int damage, const bool killing_blow);
 
-	void blanket_notify_damage_player_by_env(const int victim_id,
+	/*!
+		Notify the players near a player damaged by an environment effect, and the
+		victim, of it. By default every player is told, like other damage.
+		\param victim Player who was damaged.
+		\param env_id ID of the effect.
+		\param damage Amount of damage taken.
+		\param killing_blow True if the damage killed the player.
+	*/
+	void broadcast_damage_player_by_env(const tank_ptr &victim,
 		const int env_id, const int damage, const bool killing_blow);
 }
 
@@ -0,0 +1,266 @@
+/*!
+    \file   outboundqueue.cpp
+    \brief  Implementation of the Outbound_Queue and Recipient_List classes.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <outboundqueue.hpp>
+#include <gameinstance.hpp>
+#include <logger.hpp>
+
+namespace Outbound
+{
+    boost::threadpool::pool sender_pool(SENDER_THREADS);
+
+    Outbound_Queue::message_ptr make_message(const Outbound_Queue::send_function &send)
+    {
+        return Outbound_Queue::message_ptr(new Outbound_Queue::send_function(send));
+    }
+
+    /*!
+        Remove a player whose queue gave up on them. The ID may have been given to
+        someone else by the time this runs, so the player is only removed if the tank
+        with that ID still owns the queue.
+    */
+    void remove_player(Game_Instance *arena, const outbound_ptr queue, const int id)
+    {
+        const Game_Instance::Scope scope(*arena);
+        try {
+            const tank_ptr tank = Players::get_tank_manager()->get(id);
+            if (tank->get_player_info()->get_outbound() != queue) {
+                return;
+            }
+        }
+        catch (const TankNotExistException &) {
+            // Already gone.
+            return;
+        }
+
+        (void)Players::remove_player(id);
+    }
+}
+
+Outbound_Queue::Outbound_Queue(const GameSession::ClientEventCallbackPrx &player_proxy,
+                               Game_Instance &player_arena, const int id)
+    : proxy(player_proxy), arena(&player_arena), player_id(id), in_flight(0),
+      scheduled(false), closed(false), dropped(false)
+{
+}
+
+void Outbound_Queue::schedule()
+{
+    scheduled = true;
+    (void)Outbound::sender_pool.schedule(
+        boost::bind(&Outbound_Queue::flush, shared_from_this()));
+}
+
+void Outbound_Queue::discard_entries()
+{
+    (void)Atomic::fetch_and_add(arena->queued_messages, -static_cast<long>(entries.size()));
+    entries.clear();
+}
+
+void Outbound_Queue::disconnect(const std::string &reason)
+{
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+        if (closed) {
+            return;
+        }
+        closed = true;
+        discard_entries();
+    }
+
+    drop_player(reason);
+}
+
+void Outbound_Queue::drop_player(const std::string &reason)
+{
+    LOG_STREAM(Logger::LOG_LEVEL_WARNING, "Disconnecting player #" << player_id
+        << " from arena " << arena->get_id() << ": " << reason);
+
+    // The player isn't removed here: this may be running inside a broadcast which holds
+    // locks that removing a player takes.
+    (void)Outbound::sender_pool.schedule(boost::bind(
+        &Outbound::remove_player, arena, shared_from_this(), player_id));
+}
+
+void Outbound_Queue::push(const message_ptr &message, const bool droppable)
+{
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+        if (closed) {
+            return;
+        }
+
+        if (entries.size() >= OUTBOUND_QUEUE_CAPACITY) {
+            (void)Atomic::increment(arena->dropped_messages);
+            dropped = true;
+
+            // Make room by dropping the oldest update; the newest is the one worth sending.
+            std::deque<Entry>::iterator i = entries.begin();
+            while (i != entries.end() && !i->droppable) {
+                ++i;
+            }
+
+            if (i != entries.end()) {
+                (void)entries.erase(i);
+                (void)Atomic::decrement(arena->queued_messages);
+            }
+            else if (droppable) {
+                return;
+            }
+            else {
+                closed = true;
+                discard_entries();
+            }
+        }
+
+        if (!closed) {
+            Entry entry;
+            entry.message = message;
+            entry.droppable = droppable;
+            entry.queued = get_precise_time();
+            entries.push_back(entry);
+            (void)Atomic::increment(arena->queued_messages);
+
+            if (!scheduled && in_flight < OUTBOUND_MAX_IN_FLIGHT) {
+                schedule();
+            }
+
+            return;
+        }
+    }
+
+    drop_player("the client isn't keeping up with its messages.");
+}
+
+void Outbound_Queue::flush()
+{
+    const Game_Instance::Scope scope(*arena);
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+        while (!entries.empty() && batch.size() < OUTBOUND_BATCH_SIZE &&
+            in_flight < OUTBOUND_MAX_IN_FLIGHT) {
+            batch.push_back(entries.front());
+            entries.pop_front();
+            ++in_flight;
+        }
+        (void)Atomic::fetch_and_add(arena->queued_messages, -static_cast<long>(batch.size()));
+    }
+
+    const outbound_ptr self = shared_from_this();
+    const double now = get_precise_time();
+    for (std::vector<Entry>::size_type i = 0; i < batch.size(); ++i) {
+        latencies.push_back(now - batch[i].queued);
+        try {
+            (*batch[i].message)(self);
+        }
+        catch (const Ice::Exception &e) {
+            disconnect(e.what());
+            break;
+        }
+        HANDLE_UNCAUGHT_EXCEPTIONS
+    }
+
+    arena->profiler.record_sends(latencies);
+    batch.clear();
+    latencies.clear();
+
+    boost::lock_guard<boost::mutex> guard(mutex);
+    scheduled = false;
+    if (!closed && !entries.empty() && in_flight < OUTBOUND_MAX_IN_FLIGHT) {
+        schedule();
+    }
+}
+
+void Outbound_Queue::count_sent()
+{
+    (void)Atomic::increment(arena->sent_messages);
+}
+
+void Outbound_Queue::complete()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+    if (in_flight > 0) {
+        --in_flight;
+    }
+
+    if (!scheduled && !closed && !entries.empty()) {
+        schedule();
+    }
+}
+
+void Outbound_Queue::fail(const Ice::Exception &ex)
+{
+    complete();
+    disconnect(ex.what());
+}
+
+void Outbound_Queue::close()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+    closed = true;
+    discard_entries();
+}
+
+bool Outbound_Queue::take_dropped()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+    const bool result = dropped;
+    dropped = false;
+    return result;
+}
+
+std::size_t Outbound_Queue::size()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+    return entries.size();
+}
+
+Recipient_List::Recipient_List()
+    : recipients(new recipient_array())
+{
+}
+
+void Recipient_List::add(const int id, const boost::shared_ptr<PlayerInfo> &player)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    const boost::shared_ptr<recipient_array> copy(new recipient_array());
+    copy->reserve(recipients->size() + 1);
+    for (recipient_array::size_type i = 0; i < recipients->size(); ++i) {
+        if ((*recipients)[i].id != id) {
+            copy->push_back((*recipients)[i]);
+        }
+    }
+
+    Recipient recipient;
+    recipient.id = id;
+    recipient.player = player;
+    recipient.queue = player->get_outbound();
+    copy->push_back(recipient);
+
+    recipients = copy;
+}
+
+void Recipient_List::remove(const int id)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    const boost::shared_ptr<recipient_array> copy(new recipient_array());
+    copy->reserve(recipients->size());
+    for (recipient_array::size_type i = 0; i < recipients->size(); ++i) {
+        if ((*recipients)[i].id != id) {
+            copy->push_back((*recipients)[i]);
+        }
+    }
+
+    recipients = copy;
+}
+
+Recipient_List::recipients_ptr Recipient_List::get()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+    return recipients;
+}
@@ -0,0 +1,310 @@
+/*!
+    \file   outboundqueue.hpp
+    \brief  Declares the Outbound_Queue class, which holds the messages waiting to be sent
+            to one player.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef OUTBOUNDQUEUE_HPP
+#define OUTBOUNDQUEUE_HPP
+
+#include <atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/enable_shared_from_this.hpp>
+
+class Game_Instance;
+class Outbound_Queue;
+struct PlayerInfo;
+
+typedef boost::shared_ptr<Outbound_Queue> outbound_ptr;
+
+/*!
+    Messages for a player are not sent by the thread which produced them. They wait in
+    the player's Outbound_Queue until a thread of the sender pool takes up to
+    OUTBOUND_BATCH_SIZE of them and hands them to Ice, so the simulation thread and Ice
+    dispatch threads never wait on a client's connection.
+
+    At most OUTBOUND_MAX_IN_FLIGHT messages of a player may be handed to Ice but not yet
+    written to the network. A client which reads slower than the server writes stops
+    its own queue there, and the queue fills instead of Ice's buffers. A full queue first
+    throws away its oldest droppable message, which is one the client can recover from
+    without; once it holds nothing droppable and another message which isn't arrives,
+    the player is disconnected. Senders whose droppable messages only carry changes
+    check take_dropped() and send everything again after a loss.
+
+    Queues must be given oneway proxies, since a message is finished once it is written.
+*/
+class Outbound_Queue : public boost::enable_shared_from_this<Outbound_Queue>
+{
+public:
+    //! Makes one asynchronous call on the player's callback proxy.
+    typedef boost::function<void (const outbound_ptr &)> send_function;
+
+    //! A message, shared by every queue it is pushed to.
+    typedef boost::shared_ptr<const send_function> message_ptr;
+
+private:
+    //! One waiting message.
+    struct Entry
+    {
+        message_ptr message;
+        bool droppable;
+        double queued;
+    };
+
+    const GameSession::ClientEventCallbackPrx proxy;
+    Game_Instance *const arena;
+    const int player_id;
+
+    // Guarded by mutex.
+    boost::mutex mutex;
+    std::deque<Entry> entries;
+    std::size_t in_flight;
+    bool scheduled;
+    bool closed;
+    bool dropped;
+
+    // Only touched by the one sender thread flushing the queue.
+    std::vector<Entry> batch;
+    std::vector<double> latencies;
+
+    Outbound_Queue(const Outbound_Queue &);
+    Outbound_Queue &operator=(const Outbound_Queue &);
+
+    //! Hand the queue to the sender pool. The mutex must be held.
+    void schedule();
+
+    //! Forget every waiting message. The mutex must be held.
+    void discard_entries();
+
+    /*!
+        Close the queue and drop the player, because messages can't be delivered to them.
+        \param reason Why, for the log.
+    */
+    void disconnect(const std::string &);
+
+    /*!
+        Log why a closed queue gave up and have the sender pool remove the player.
+        \param reason Why, for the log.
+    */
+    void drop_player(const std::string &);
+
+public:
+    /*!
+        \param player_proxy Oneway proxy of the player's event callback.
+        \param player_arena Arena the player is in.
+        \param id ID of the player.
+    */
+    Outbound_Queue(const GameSession::ClientEventCallbackPrx &, Game_Instance &, const int);
+
+    //! Get the proxy messages are sent through.
+    const GameSession::ClientEventCallbackPrx &get_proxy() const
+    {
+        return proxy;
+    }
+
+    /*!
+        Add a message to the end of the queue. Never blocks on the network. If the queue
+        is full, the oldest droppable message waiting makes room. If there is none, a
+        droppable message is thrown away instead, and any other disconnects the player.
+        \param message Message to send.
+        \param droppable True if the client can do without this message.
+    */
+    void push(const message_ptr &, const bool);
+
+    /*!
+        Find out whether a message was thrown away since the last call.
+        \return True if one was.
+    */
+    bool take_dropped();
+
+    /*!
+        Send the next batch of messages. Run by the sender pool; the queue is only ever
+        flushed by one thread at a time.
+    */
+    void flush();
+
+    //! Count a message handed to Ice against the player's arena.
+    void count_sent();
+
+    //! Note that a message handed to Ice has been written. Safe to call from any thread.
+    void complete();
+
+    /*!
+        Note that a message couldn't be sent. The player is disconnected.
+        \param ex Exception Ice reported.
+    */
+    void fail(const Ice::Exception &);
+
+    //! Throw away every waiting message and refuse any more. Used when the player leaves.
+    void close();
+
+    //! Get the number of messages waiting.
+    std::size_t size();
+};
+
+/*!
+    AMI callback for messages sent from an Outbound_Queue. Callbacks are kept in a pool
+    for each type of call and reused, rather than allocated for every message. Ice waits
+    for a callback's previous call to finish before starting another with it, so one
+    which is still being cleaned up when it is taken from the pool is simply waited for.
+*/
+template<class T>
+class Queued_Callback : public T, public Ice::AMISentCallback
+{
+public:
+    typedef IceUtil::Handle<Queued_Callback> pointer;
+
+private:
+    outbound_ptr queue;
+    volatile long sending;
+
+    static boost::mutex pool_mutex;
+    static std::vector<pointer> pool;
+
+    Queued_Callback() : sending(0) {}
+
+    //! Finish the current message, once, and return the callback to the pool.
+    void finish(const Ice::Exception *ex)
+    {
+        if (Atomic::compare_and_swap(sending, 1, 0) != 1) {
+            return;
+        }
+
+        const outbound_ptr owner = queue;
+        queue.reset();
+        {
+            boost::lock_guard<boost::mutex> guard(pool_mutex);
+            if (pool.size() < OUTBOUND_CALLBACK_POOL_SIZE) {
+                pool.push_back(this);
+            }
+        }
+
+        if (ex != NULL) {
+            owner->fail(*ex);
+        }
+        else {
+            owner->complete();
+        }
+    }
+
+public:
+    /*!
+        Take a callback from the pool, or make one if the pool is empty.
+        \param owner Queue the message is sent for.
+    */
+    static pointer acquire(const outbound_ptr &owner)
+    {
+        // Every callback goes with one outgoing message.
+        owner->count_sent();
+
+        pointer callback;
+        {
+            boost::lock_guard<boost::mutex> guard(pool_mutex);
+            if (!pool.empty()) {
+                callback = pool.back();
+                pool.pop_back();
+            }
+        }
+        if (!callback) {
+            callback = new Queued_Callback();
+        }
+
+        callback->queue = owner;
+        Atomic::store(callback->sending, 1);
+        return callback;
+    }
+
+    /*!
+        Report what the asynchronous call returned.
+        \param sent True if Ice wrote the message at once; otherwise ice_sent() follows.
+    */
+    void dispatched(const bool sent)
+    {
+        if (sent) {
+            finish(NULL);
+        }
+    }
+
+    virtual void ice_sent()
+    {
+        finish(NULL);
+    }
+
+    virtual void ice_exception(const Ice::Exception &ex)
+    {
+        finish(&ex);
+    }
+
+    virtual void ice_response()
+    {}
+};
+
+template<class T>
+boost::mutex Queued_Callback<T>::pool_mutex;
+
+template<class T>
+std::vector<typename Queued_Callback<T>::pointer> Queued_Callback<T>::pool;
+
+/*!
+    List of the players in an arena and their queues. Broadcasts read it on every event,
+    while it only changes when a player joins or leaves, so it is copied on write: a
+    reader takes the current list with one short lock and walks it with none held.
+*/
+class Recipient_List
+{
+public:
+    //! One player who receives messages.
+    struct Recipient
+    {
+        int id;
+        boost::shared_ptr<PlayerInfo> player;
+        outbound_ptr queue;
+    };
+
+    typedef std::vector<Recipient> recipient_array;
+    typedef boost::shared_ptr<const recipient_array> recipients_ptr;
+
+private:
+    boost::mutex mutex;
+    recipients_ptr recipients;
+
+    Recipient_List(const Recipient_List &);
+    Recipient_List &operator=(const Recipient_List &);
+
+public:
+    Recipient_List();
+
+    /*!
+        Add a player. A player already in the list with the same ID is replaced.
+        \param id ID of the player.
+        \param player Player to add.
+    */
+    void add(const int, const boost::shared_ptr<PlayerInfo> &);
+
+    /*!
+        Remove a player.
+        \param id ID of the player.
+    */
+    void remove(const int);
+
+    //! Get the current list. It never changes once returned.
+    recipients_ptr get();
+};
+
+/*!
+    The Outbound namespace holds the sender pool shared by every queue.
+*/
+namespace Outbound
+{
+    //! Threads which flush queues and disconnect slow players.
+    extern boost::threadpool::pool sender_pool;
+
+    /*!
+        Wrap a call so it can be pushed to any number of queues without being copied.
+        \param send Call to make for each player.
+        \return Shared message.
+    */
+    Outbound_Queue::message_ptr make_message(const Outbound_Queue::send_function &);
+}
+
+#endif
@@ -12,10 +12,23 @@
 #include <server.hpp>
 #include <notifier.hpp>
 #include <pointmanager.hpp>
+#include <trace.hpp>
+#include <gameinstance.hpp>
 
-Player::Player(const int player_id) : GameSession::GameInfo()
+namespace
+{
+    //! Check whether a tank is in the most recently published tank states.
+    bool is_published(const int id)
+    {
+        const Tank_State_Buffer::Reader reader(*Players::get_tank_states());
+
+        return reader.find(id) != NULL;
+    }
+}
+
+Player::Player(Game_Instance &player_arena, const int player_id)
+    : GameSession::GameInfo(), id(player_id), arena(&player_arena)
 {
-    id = player_id;
 }
 
 Player::~Player()
@@ -25,6 +38,7 @@ Player::~Player()
 // Ice methods:
 void Player::destroy(const Ice::Current &)
 {
+    const Game_Instance::Scope scope(*arena);
     Logger::Stack_Logger stack("destroy()", false);
 
     try {
@@ -37,12 +51,13 @@ void Player::destroy(const Ice::Current &)
 
 void Player::Ready(const Ice::Current&)
 {
+	const Game_Instance::Scope scope(*arena);
 	try {
 		while (MapManager::is_rotating()) {
 			boost::this_thread::sleep(boost::posix_time::milliseconds(10));
 		}
 
-		const tank_ptr tank = Players::tanks.get(id);
+		const tank_ptr tank = Players::get_tank_manager()->get(id);
 		tank->get_player_info()->refresh_timeout();
 		tank->set_ready(true);
 
@@ -63,19 +78,33 @@ void Player::Ready(const Ice::Current&)
 
 GameSession::PlayerList Player::GetPlayerList(const Ice::Current&)
 {
-    const tank_ptr tank = Players::tanks.get(id);
+    const Game_Instance::Scope scope(*arena);
+    const tank_ptr tank = Players::get_tank_manager()->get(id);
     tank->get_player_info()->refresh_timeout();
 
 	while (MapManager::is_rotating()) {
 		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
 	}
 
+    // A player who just joined is published with the next tick. Rather than hold a
+    // dispatch thread until then, answer from the live tanks.
+    if (!is_published(id)) {
+        GameSession::PlayerList list;
+        const tank_array tanks = Players::get_tank_manager()->get_tank_list();
+        for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
+            list.push_back(tanks[i]->get_tank_object());
+        }
+
+        return list;
+    }
+
     return Players::get_player_list();
 }
 
 std::string Player::GetCurrentMapName(const Ice::Current&)
 {
-    const tank_ptr tank = Players::tanks.get(id);
+    const Game_Instance::Scope scope(*arena);
+    const tank_ptr tank = Players::get_tank_manager()->get(id);
     tank->get_player_info()->refresh_timeout();
 
 	while (MapManager::is_rotating()) {
@@ -87,12 +116,13 @@ std::string Player::GetCurrentMapName(const Ice::Current&)
 
 Ice::Double Player::GetTimeLeft(const Ice::Current&)
 {
+	const Game_Instance::Scope scope(*arena);
 	while (MapManager::is_rotating()) {
 		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
 	}
     
     try {
-        const tank_ptr tank = Players::tanks.get(id);
+        const tank_ptr tank = Players::get_tank_manager()->get(id);
         tank->get_player_info()->refresh_timeout();
 
         return Players::get_time_left();
@@ -107,11 +137,13 @@ Ice::Double Player::GetTimeLeft(const Ice::Current&)
 
 VTankObject::GameMode Player::GetGameMode(const Ice::Current&)
 {
+    const Game_Instance::Scope scope(*arena);
     return MapManager::get_current_mode();
 }
 
 VTankObject::StatisticsList Player::GetScoreboard(const Ice::Current&)
 {
+    const Game_Instance::Scope scope(*arena);
     while (MapManager::is_rotating()) {
 		boost::this_thread::sleep(boost::posix_time::milliseconds(10));
 	}
@@ -121,6 +153,7 @@ VTankObject::StatisticsList Player::GetScoreboard(const Ice::Current&)
 
 GameSession::ScoreboardTotals Player::GetTeamTotals(const Ice::Current&)
 {
+	const Game_Instance::Scope scope(*arena);
 	// TODO: This doesn't do what it's supposed to yet.
 	GameSession::ScoreboardTotals totals;
 	totals.completedRed = 0;
@@ -135,8 +168,9 @@ GameSession::ScoreboardTotals Player::GetTeamTotals(const Ice::Current&)
 
 void Player::KeepAlive(const Ice::Current&)
 {
+    const Game_Instance::Scope scope(*arena);
     try {
-        const tank_ptr tank = Players::tanks.get(id);
+        const tank_ptr tank = Players::get_tank_manager()->get(id);
         tank->get_player_info()->refresh_timeout();
     }
     HANDLE_UNCAUGHT_EXCEPTIONS
@@ -145,14 +179,19 @@ void Player::KeepAlive(const Ice::Current&)
 void Player::Move(Ice::Long timestamp, const VTankObject::Point& position, 
 				  const VTankObject::Direction direction, const Ice::Current&)
 {
+    const Game_Instance::Scope scope(*arena);
     try {
-        const tank_ptr tank = Players::tanks.get(id);
+        const tank_ptr tank = Players::get_tank_manager()->get(id);
         tank->get_player_info()->refresh_timeout();
 
         if (MapManager::is_rotating()) {
             return;
         }
 
+        if (!Players::accept_input(tank)) {
+            return;
+        }
+
         Players::move(id, timestamp, direction, position);
     }
     HANDLE_UNCAUGHT_EXCEPTIONS;
@@ -161,13 +200,18 @@ void Player::Move(Ice::Long timestamp, const VTankObject::Point& position,
 void Player::Rotate(Ice::Long timestamp, Ice::Double angle, VTankObject::Direction direction, 
     const Ice::Current&)
 {
+    const Game_Instance::Scope scope(*arena);
     try {
-        const tank_ptr tank = Players::tanks.get(id);
+        const tank_ptr tank = Players::get_tank_manager()->get(id);
         tank->get_player_info()->refresh_timeout();
         
         if (MapManager::is_rotating()) {
             return;
         }
+
+        if (!Players::accept_input(tank)) {
+            return;
+        }
         
         Players::rotate(id, timestamp, angle, direction);
     }
@@ -177,14 +221,19 @@ void Player::Rotate(Ice::Long timestamp, Ice::Double angle, VTankObject::Directi
 void Player::SpinTurret(Ice::Long timestamp, Ice::Double angle, VTankObject::Direction direction, 
     const Ice::Current&)
 {
+    const Game_Instance::Scope scope(*arena);
     try {
-        const tank_ptr tank = Players::tanks.get(id);
+        const tank_ptr tank = Players::get_tank_manager()->get(id);
         tank->get_player_info()->refresh_timeout();
 
         if (MapManager::is_rotating()) {
             return;
         }
 
+        if (!Players::accept_input(tank)) {
+            return;
+        }
+
         Players::spin_turret(id, timestamp, angle, direction);
     }
     HANDLE_UNCAUGHT_EXCEPTIONS;
@@ -192,13 +241,18 @@ void Player::SpinTurret(Ice::Long timestamp, Ice::Double angle, VTankObject::Dir
 
 void Player::Fire(Ice::Long timestamp, const VTankObject::Point &point, const Ice::Current&)
 {
+    const Game_Instance::Scope scope(*arena);
     try {
-        const tank_ptr tank = Players::tanks.get(id);
+        const tank_ptr tank = Players::get_tank_manager()->get(id);
         tank->get_player_info()->refresh_timeout();
         
         if (MapManager::is_rotating()) {
             return;
         }
+
+        if (!Players::accept_input(tank)) {
+            return;
+        }
 		
 		// TODO: Ask if the tank "can charge".
 		/*charge_ptr charger = tank->get_charge_timer();
@@ -214,6 +268,7 @@ void Player::Fire(Ice::Long timestamp, const VTankObject::Point &point, const Ic
 
 void Player::SendMessage(const std::string& message, const Ice::Current&)
 {
+    const Game_Instance::Scope scope(*arena);
     //TODO: We'll process commands in a more complex way in the future.
     // For now, just distribute what they typed.
     VTankObject::VTankColor message_color;
@@ -222,11 +277,11 @@ void Player::SendMessage(const std::string& message, const Ice::Current&)
     message_color.blue  = 255;
     
     try {
-        const tank_ptr tank = Players::tanks.get(id);
+        const tank_ptr tank = Players::get_tank_manager()->get(id);
         tank->get_player_info()->refresh_timeout();
         
         if (message == "/nodes") {
-            const tank_array tanks = Players::tanks.get_tank_list();
+            const tank_array tanks = Players::get_tank_manager()->get_tank_list();
             for (std::vector<tank_ptr>::size_type i = 0; i < tanks.size(); i++) {
                 std::stringstream formatter;
                 formatter << tanks[i]->get_name() << ": " << tanks[i]->get_node_id();
@@ -236,7 +291,7 @@ void Player::SendMessage(const std::string& message, const Ice::Current&)
             }
         }
         else if (message == "/positions" || message == "/pos") {
-            const tank_array tanks = Players::tanks.get_tank_list();
+            const tank_array tanks = Players::get_tank_manager()->get_tank_list();
             for (std::vector<tank_ptr>::size_type i = 0; i < tanks.size(); i++) {
                 std::stringstream formatter;
                 formatter << tanks[i]->get_name() << ": (" 
@@ -249,6 +304,19 @@ void Player::SendMessage(const std::string& message, const Ice::Current&)
 		else if (message == "/forcerotate" || message == "/rotate") {
 			Players::force_timer_zero();
 		}
+		else if (message == "/trace") {
+			std::string reply = "This server was built without tracing.";
+			if (Trace::is_compiled_in()) {
+				try {
+					reply = "Trace written to " + Trace::dump();
+				}
+				catch (const std::runtime_error &ex) {
+					reply = ex.what();
+				}
+			}
+
+			tank->get_player_info()->get_callback()->ChatMessage(reply, message_color);
+		}
         else {
             Notifier::blanket_notify_chat_message(
                 tank->get_name() + ": " + message, message_color);
@@ -259,8 +327,9 @@ void Player::SendMessage(const std::string& message, const Ice::Current&)
 
 void Player::StartCharging(const Ice::Current &)
 {
+	const Game_Instance::Scope scope(*arena);
 	try {
-		const tank_ptr tank = Players::tanks.get(id);
+		const tank_ptr tank = Players::get_tank_manager()->get(id);
 		tank->get_player_info()->refresh_timeout();
 		if (tank->get_weapon().max_charge_time_seconds == 0) {
 			// Weapon cannot charge: ignore packet.
@@ -279,3 +348,47 @@ void Player::StartCharging(const Ice::Current &)
 	}
 	HANDLE_UNCAUGHT_EXCEPTIONS
 }
+
+void Player::SetUpdateBatching(bool enabled, const Ice::Current &)
+{
+	const Game_Instance::Scope scope(*arena);
+	try {
+		const tank_ptr tank = Players::get_tank_manager()->get(id);
+		tank->get_player_info()->refresh_timeout();
+		tank->get_player_info()->set_update_mode(enabled ? UPDATE_BATCHED : UPDATE_PER_EVENT);
+	}
+	catch (const TankNotExistException &) {
+		// Ignore.
+	}
+	HANDLE_UNCAUGHT_EXCEPTIONS
+}
+
+void Player::SetSnapshotUpdates(bool enabled, const Ice::Current &)
+{
+	const Game_Instance::Scope scope(*arena);
+	try {
+		const tank_ptr tank = Players::get_tank_manager()->get(id);
+		tank->get_player_info()->refresh_timeout();
+
+		// Nothing has been acknowledged yet, so the first snapshot is sent in full.
+		tank->get_player_info()->get_snapshot_channel().acknowledge(-1);
+		tank->get_player_info()->set_update_mode(enabled ? UPDATE_SNAPSHOT : UPDATE_PER_EVENT);
+	}
+	catch (const TankNotExistException &) {
+		// Ignore.
+	}
+	HANDLE_UNCAUGHT_EXCEPTIONS
+}
+
+void Player::AcknowledgeSnapshot(Ice::Long tick, const Ice::Current &)
+{
+	const Game_Instance::Scope scope(*arena);
+	try {
+		const tank_ptr tank = Players::get_tank_manager()->get(id);
+		tank->get_player_info()->get_snapshot_channel().acknowledge(tick);
+	}
+	catch (const TankNotExistException &) {
+		// Ignore.
+	}
+	HANDLE_UNCAUGHT_EXCEPTIONS
+}
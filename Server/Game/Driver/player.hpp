@@ -6,10 +6,28 @@
 #ifndef PLAYER_HPP
 #define PLAYER_HPP
 
-//! How many times do we request a clock synchronization?
+//! How many clock requests are sent, CLOCK_SYNC_BURST_INTERVAL apart, when a player joins.
 #define SYNC_REQUESTS 6
 
 #include <vtassert.hpp>
+#include <ratelimiter.hpp>
+#include <snapshot.hpp>
+#include <outboundqueue.hpp>
+
+class Game_Instance;
+
+//! How tank movement is delivered to a player.
+enum Update_Mode
+{
+    //! PlayerMove, PlayerRotate for every piece of input (the default).
+    UPDATE_PER_EVENT,
+
+    //! One UpdateTanks call per tick.
+    UPDATE_BATCHED,
+
+    //! Delta-compressed UpdateSnapshot calls.
+    UPDATE_SNAPSHOT
+};
 
 /*!
     The Player class is an Ice servant. It implements the GameSession::CurrentGame 
@@ -21,6 +39,9 @@ class Player : virtual public GameSession::GameInfo
 private:
     int id;
 
+    //! Arena the player is in, bound to the dispatching thread by every call.
+    Game_Instance *arena;
+
 protected:
     /*!
         The destructor does not do anything. It's up to whatever manages players to
@@ -31,9 +52,10 @@ protected:
 public:
 	/*!
         Simple constructor.
+        \param player_arena Arena the player joined.
         \param player_id ID of the player.
     */
-    Player(const int);
+    Player(Game_Instance &, const int);
 	
 	/* The following functions are implemented by the generated GameSession.hpp file.
 	 * Please see the documentation for GameSession in the file: GameSession.ice.
@@ -56,6 +78,9 @@ public:
     virtual void SendMessage(const std::string&, const Ice::Current& = Ice::Current());
 	virtual void Ready(const Ice::Current& = Ice::Current());
 	virtual void StartCharging(const Ice::Current & = Ice::Current());
+	virtual void SetUpdateBatching(bool, const Ice::Current & = Ice::Current());
+	virtual void SetSnapshotUpdates(bool, const Ice::Current & = Ice::Current());
+	virtual void AcknowledgeSnapshot(Ice::Long, const Ice::Current & = Ice::Current());
 };
 
 /*!
@@ -69,16 +94,29 @@ struct PlayerInfo
 private:
     GameSession::ClientEventCallbackPrx callback;
     GameSession::ClockSynchronizerPrx   clock_callback;
+    outbound_ptr outbound;
     double last_time;
     double last_time_sync;
 
+    //! Limits how quickly the player may send input.
+    Rate_Limiter input_limiter;
+
+    //! How the player wants tank movement delivered (an Update_Mode value).
+    volatile long update_mode;
+
+    //! Snapshots sent to the player, used when update_mode is UPDATE_SNAPSHOT.
+    Snapshot_Channel snapshots;
+
     // Related to clock:
     long average_latency; // Average latency.
 
 public:
     PlayerInfo(const GameSession::ClientEventCallbackPrx &player_callback,
-        const GameSession::ClockSynchronizerPrx &clock)
-        : callback(player_callback), clock_callback(clock)
+        const GameSession::ClockSynchronizerPrx &clock,
+        const outbound_ptr &queue = outbound_ptr())
+        : callback(player_callback), clock_callback(clock), outbound(queue),
+        input_limiter(MAX_INPUT_PER_SECOND), 
+        update_mode(UPDATE_PER_EVENT)
     {
         refresh_timeout();
     }
@@ -97,6 +135,17 @@ public:
         return callback; 
     }
 
+    /*!
+        Get the queue of messages waiting to be sent to the player. Events should be
+        pushed here rather than sent through the callback proxy directly.
+        \return The player's outbound queue, or an empty pointer if it was made without
+        one, which only the tests do.
+    */
+    const outbound_ptr &get_outbound() const
+    {
+        return outbound;
+    }
+
     /*!
         Access to the ClockSynchronizer interface on the client.
         \return Proxy pointing to the client's clock.
@@ -127,6 +176,12 @@ public:
         last_time_sync = last;
     }
 
+    //! Get how long a message takes to reach the player, in milliseconds.
+    long get_average_latency() const
+    {
+        return average_latency;
+    }
+
     /*!
         Set a new average latency for this player.
         \param latency New average latency.
@@ -136,6 +191,42 @@ public:
         average_latency = latency; 
     }
 
+    /*!
+        Check whether the player is allowed to send another piece of input.
+        \return True if the input is within the player's rate limit; false otherwise.
+    */
+    bool allow_input()
+    {
+        return input_limiter.try_acquire(IceUtil::Time::now().toMilliSeconds());
+    }
+
+    /*!
+        Ask how the player receives tank updates.
+        \return Update mode selected by the player.
+    */
+    Update_Mode get_update_mode() const
+    {
+        return static_cast<Update_Mode>(Atomic::load(update_mode));
+    }
+
+    /*!
+        Choose how the player receives tank updates.
+        \param mode New update mode.
+    */
+    void set_update_mode(const Update_Mode mode)
+    {
+        Atomic::store(update_mode, mode);
+    }
+
+    /*!
+        Access the snapshots sent to this player.
+        \return Snapshot history used to delta-encode the next snapshot.
+    */
+    Snapshot_Channel &get_snapshot_channel()
+    {
+        return snapshots;
+    }
+
     /*!
 		This should be called any time the player sends a message via Ice. This lets the
 		player manager know the last time the player sent a message. If the player is
@@ -11,6 +11,8 @@
 #include <logger.hpp>
 #include <notifier.hpp>
 #include <pointmanager.hpp>
+#include <gameinstance.hpp>
+#include <clocksync.hpp>
 
 namespace Players
 {
@@ -20,21 +22,21 @@ namespace Players
 	//! Maximum amount of players allowed to join.
 	Ice::Int player_limit = DEFAULT_PLAYER_LIMIT;
 
-    // Mutual exclusion object for thread safety.
-    boost::recursive_mutex mutex;
-
-    // Mutual exclusion object specifically for the list of pending players.
-    boost::mutex pending_mutex;
-
     // Occasionally some tasks may need to be spawned to deal with players.
     boost::threadpool::pool task_pool(PLAYER_THREADS);
 
-    // List of people waiting to join.
-	std::map<std::string, pending_ptr> pending_list = std::map<std::string, pending_ptr>();
+    // The tank list, the pending list and their mutexes belong to the bound arena.
+
+    TankManager *get_tank_manager()
+    {
+        return &Game_Instance::current().tanks;
+    }
+
+    Recipient_List *get_recipient_list()
+    {
+        return &Game_Instance::current().recipients;
+    }
 
-    // Tank list.
-    TankManager tanks;
-    
     /*!
         Kick off players who are idle.
     */
@@ -50,14 +52,13 @@ namespace Players
         }
 
         const double now = IceUtil::Time::now().toMilliSecondsDouble();
-        const tank_array tank_list = tanks.get_tank_list();
+        const tank_array tank_list = Game_Instance::current().tanks.get_tank_list();
         for (tank_array::size_type i = 0; i < tank_list.size(); i++)
         {
             const tank_ptr tank = tank_list[i];
 
             const double last_action = tank->get_player_info()->get_last_action_time();
-            const double last_sync = tank->get_player_info()->get_last_sync_time();
-            double elapsed = now - last_action;
+            const double elapsed = now - last_action;
             if (elapsed > timeout) {
                 std::ostringstream formatter;
                 formatter << "Removing player " << tank->get_name() 
@@ -69,14 +70,6 @@ namespace Players
                     Logger::log(Logger::LOG_LEVEL_WARNING,
                         "Warning: Tried to remove player from player list, but couldn't.");
                 }
-
-                continue;
-            }
-            
-            elapsed = now - last_sync;
-            if (elapsed > CLOCK_SYNC_INTERVAL) {
-                // Time for another time sync.
-                tank->do_clock_sync();
             }
         }
 
@@ -86,9 +79,10 @@ namespace Players
     int generate_unique_temp_id()
     {
         Logger::Stack_Logger stack("generate_unique_temp_id()", false);
-        boost::lock_guard<boost::recursive_mutex> guard(mutex);
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::recursive_mutex> guard(arena.player_mutex);
 
-        const tank_array tank_list = tanks.get_tank_list();
+        const tank_array tank_list = arena.tanks.get_tank_list();
         for (tank_array::size_type i = 0; i < tank_list.size() + 20; i++) {
             bool found = false;
 
@@ -112,23 +106,25 @@ namespace Players
 
     void add_pending(const std::string& key, const GameSession::Tank tank)
     {
-		boost::lock_guard<boost::mutex> guard(pending_mutex);
-        const std::map<std::string, pending_ptr>::iterator i = pending_list.find(key);
-		if (i != pending_list.end()) {
+        Game_Instance &arena = Game_Instance::current();
+		boost::lock_guard<boost::mutex> guard(arena.pending_mutex);
+        const std::map<std::string, pending_ptr>::iterator i = arena.pending_list.find(key);
+		if (i != arena.pending_list.end()) {
 			// Warn that the player exists.
             Logger::log(Logger::LOG_LEVEL_WARNING, 
                 "add_pending(): Key already exists. Old value was overwritten.");
 		}
         
         const IceUtil::Int64 start_time = IceUtil::Time::now().toSeconds();
-		pending_list[key] = pending_ptr(new PendingTank(tank, start_time));
+		arena.pending_list[key] = pending_ptr(new PendingTank(tank, start_time));
     }
 
     pending_ptr get_pending(const std::string& key)
     {
-        boost::lock_guard<boost::mutex> guard(pending_mutex);
-        const std::map<std::string, pending_ptr>::iterator i = pending_list.find(key);
-        if (i == pending_list.end()) {
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::mutex> guard(arena.pending_mutex);
+        const std::map<std::string, pending_ptr>::iterator i = arena.pending_list.find(key);
+        if (i == arena.pending_list.end()) {
             std::ostringstream formatter;
             formatter << "get_pending(): Key doesn't exist: " << key;
             Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
@@ -136,15 +132,16 @@ namespace Players
             throw Exceptions::PermissionDeniedException("That session key is invalid.");
         }
 
-        return pending_list[key];
+        return i->second;
     }
 
     bool remove_pending(const std::string& key)
     {
-		boost::lock_guard<boost::mutex> guard(pending_mutex);
+        Game_Instance &arena = Game_Instance::current();
+		boost::lock_guard<boost::mutex> guard(arena.pending_mutex);
 
-		const std::map<std::string, pending_ptr>::iterator it = pending_list.find(key);
-		if (it == pending_list.end()) {
+		const std::map<std::string, pending_ptr>::iterator it = arena.pending_list.find(key);
+		if (it == arena.pending_list.end()) {
 			// Key did not exist.
 			return false;
 		}
@@ -154,7 +151,7 @@ namespace Players
 
         Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
         
-        (void)pending_list.erase(key);
+        arena.pending_list.erase(it);
 
 		return true;
     }
@@ -162,10 +159,11 @@ namespace Players
     void add_player(const tank_ptr player)
     {
         Logger::Stack_Logger stack("add_player()");
-        boost::lock_guard<boost::recursive_mutex> guard(mutex);
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::recursive_mutex> guard(arena.player_mutex);
         
         // First check if the client exists already.
-        const tank_array tank_list = tanks.get_tank_list();
+        const tank_array tank_list = arena.tanks.get_tank_list();
         for (tank_array::size_type i = 0; i < tank_list.size(); i++) {
             if (tank_list[i]->get_name() == player->get_name()) {
                 remove_player(tank_list[i]->get_id());
@@ -184,24 +182,26 @@ namespace Players
         Notifier::blanket_notify_player_joined(player);
 
         // Now add it locally.
-        tanks.add(player);
+        arena.tanks.add(player);
+        arena.recipients.add(player->get_id(), player->get_player_info());
 
         PointManager::add_player(player->get_id());
 	}
 
     const tank_ptr get_player(const int& id)
     {
-        return tanks.get(id);
+        return Game_Instance::current().tanks.get(id);
     }
 
     bool remove_player(const int& id)
     {
         Logger::Stack_Logger stack("remove_player()");
+        Game_Instance &arena = Game_Instance::current();
 
         try {
-            const tank_ptr tank = tanks.get(id);
+            const tank_ptr tank = arena.tanks.get(id);
             
-            boost::lock_guard<boost::recursive_mutex> guard(mutex);
+            boost::lock_guard<boost::recursive_mutex> guard(arena.player_mutex);
 
             std::ostringstream formatter;
             formatter << "Removing player " << tank->get_name()
@@ -209,8 +209,13 @@ namespace Players
 
 	        Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
             
-            Players::nodes.unregister_player(id, tank->get_node_id());
-            if (!tanks.remove(id)) {
+            // Nothing more is sent to the player.
+            arena.recipients.remove(id);
+            tank->get_player_info()->get_outbound()->close();
+            Clock_Sync::remove(arena, id);
+
+            // The node manager drops the tank at its next rebuild.
+            if (!arena.tanks.remove(id)) {
                 formatter.clear();
                 formatter << "Couldn't find player #" << id << ", " << tank->get_name() 
                     << " to remove him.";
@@ -241,7 +246,7 @@ namespace Players
     {
 		Logger::Stack_Logger stack("get_player_id_by_name()", false);
 
-        const tank_array tank_list = tanks.get_tank_list();
+        const tank_array tank_list = Game_Instance::current().tanks.get_tank_list();
         for (tank_array::size_type i = 0; i < tank_list.size(); i++) {
             if (tank_list[i]->get_name() == username) {
                 return tank_list[i]->get_id();
@@ -257,9 +262,21 @@ namespace Players
 
         GameSession::PlayerList list;
 
-        const tank_array tank_list = tanks.get_tank_list();
-        for (tank_array::size_type i = 0; i < tank_list.size(); i++) {
-            list.push_back(tank_list[i]->get_tank_object());
+        const Tank_State_Buffer::Reader reader(Game_Instance::current().tank_states);
+        const tank_state_array &states = reader.get_states();
+        for (tank_state_array::size_type i = 0; i < states.size(); i++) {
+            const Tank_State &state = states[i];
+
+            GameSession::Tank tank;
+            tank.id = state.id;
+            tank.angle = state.angle;
+            tank.alive = state.alive;
+            tank.position = state.position;
+            tank.team = state.team;
+            tank.attributes = state.tank->get_attributes();
+            tank.attributes.health = state.health;
+
+            list.push_back(tank);
         }
 
         return list;
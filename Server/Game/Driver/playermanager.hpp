@@ -19,14 +19,14 @@
 /*!
     The Players namespace is responsible for managing players who are in-game.
     The point of the namespace is to be globally accessible and to be thread-safe.
+    Players and pending players belong to the arena bound to the calling thread (see
+    Game_Instance); the player limit is the limit of each arena.
 */
 namespace Players
 {
-    extern boost::recursive_mutex mutex;
     extern Ice::Int player_limit;
     extern double timeout;
     extern boost::threadpool::pool task_pool;
-    extern TankManager tanks;
 
     //! Collects the player's tank, and how long the player has been pending.
     struct PendingTank
@@ -46,6 +46,17 @@ namespace Players
     };
     typedef boost::shared_ptr<PendingTank> pending_ptr;
 
+    /*!
+        Get the tanks playing in the arena bound to the calling thread.
+    */
+    TankManager *get_tank_manager();
+
+    /*!
+        Get the players in the arena bound to the calling thread who receive messages,
+        with their outbound queues.
+    */
+    Recipient_List *get_recipient_list();
+
     bool manage_players();
 
     /*!
@@ -111,7 +122,8 @@ namespace Players
     int get_player_id_by_name(const std::string&);
 
     /*!
-        Get a list of players currently logged into the game server.
+        Get a list of players currently logged into the game server, as of the last
+        published tank states. This takes no locks.
         \return GameSession::PlayerList object containing the name of each player.
     */
     GameSession::PlayerList get_player_list();
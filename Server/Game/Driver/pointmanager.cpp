@@ -8,101 +8,69 @@
 #include <macros.hpp>
 #include <tank.hpp>
 #include <playermanager.hpp>
-
-//! Holds a list of types that can be executed as a task.
-enum Task_Type
-{
-    RESET_TASK,
-    ADD_TASK,
-    KILL_TASK,
-    ASSIST_TASK,
-    DEATH_TASK,
-    OBJECTIVE_TASK,
-    CAPTURE_TASK
-};
+#include <gameinstance.hpp>
+#include <atomic.hpp>
+#include <logger.hpp>
 
 namespace PointManager
 {
-    // The thread pool should keep a size of 1 so that thread safety isn't an issue.
-    boost::threadpool::pool thread_pool(STATISTICS_THREADS);
-    boost::shared_mutex mutex;
+    Statistics_Slot::Statistics_Slot()
+        : active(0), kills(0), assists(0), deaths(0), objectives_completed(0),
+          objectives_captured(0)
+    {
+    }
 
-    std::map<int, VTankObject::Statistics> statistics;
+    // Each arena keeps its statistics and their mutex.
 
     /*!
-        Execute a boost::threadpool::pool task.
-        \param type Type of task to execute.
-        \param username Person who is the base of a task.
-        \param change What value to change as part of their statistic.
+        Find the slot of a player in the arena bound to the calling thread.
+        \param id ID of the player.
+        \return The slot, or NULL if the ID is out of range.
     */
-    void do_task(const Task_Type type, const int id, const int change)
+    Statistics_Slot *find_slot(const int id)
     {
-        boost::shared_lock<boost::shared_mutex> guard(mutex);
-        switch (type) {
-        case RESET_TASK:
-            statistics.clear();
-            break;
-
-        case ADD_TASK:
-            // Add a player to the player list.
-            try {
-                const std::map<int, VTankObject::Statistics>::iterator i = statistics.find(id);
-                if (i != statistics.end()) {
-                    // Exists already. Do nothing.
-                    return;
-                }
-
-                const tank_ptr tank = Players::tanks.get(id);
+        if (id < 0 || id >= STATISTICS_SLOTS) {
+            return NULL;
+        }
 
-                VTankObject::Statistics stats = VTankObject::Statistics();
-                stats.tankName = tank->get_name();
-                stats.kills = 0;
-                stats.deaths = 0;
-                stats.assists = 0;
-                stats.objectivesCaptured = 0;
-                stats.objectivesCompleted = 0;
-                stats.calculatedPoints = 0;
+        return &Game_Instance::current().statistics[id];
+    }
 
-                statistics[id] = stats;
-            }
-            catch (const TankNotExistException &) {
-            }
-            
-            break;
-
-        case KILL_TASK:
-            // Add a kill to the player's record.
-            statistics[id].kills += change;
-            break;
-
-        case ASSIST_TASK:
-            // Add an assist to the player's record.
-            statistics[id].assists += change;
-            break;
-
-        case DEATH_TASK:
-            // Add a death to the player's record.
-            statistics[id].deaths += change;
-            break;
-
-        case OBJECTIVE_TASK:
-            // Add an objective completion to the player's record.
-            statistics[id].objectivesCompleted += change;
-            break;
-
-        case CAPTURE_TASK:
-            // Add an objective capture to the player's record.
-            statistics[id].objectivesCaptured += change;
-            break;
+    /*!
+        Add one to a counter of a player who is in the point manager.
+        \param id ID of the player.
+        \param counter Counter to change.
+    */
+    void increment(const int id, volatile long Statistics_Slot::*counter)
+    {
+        Statistics_Slot *slot = find_slot(id);
+        if (slot != NULL && Atomic::load(slot->active)) {
+            (void)Atomic::increment(slot->*counter);
         }
     }
 
+    /*!
+        Read the counters of a slot. The counters may be changing, so each is read once.
+        \param slot Slot to read.
+        \param stats Where to put the counters.
+    */
+    void read_slot(const Statistics_Slot &slot, VTankObject::Statistics &stats)
+    {
+        stats.tankName = slot.name;
+        stats.kills = Atomic::load(slot.kills);
+        stats.deaths = Atomic::load(slot.deaths);
+        stats.assists = Atomic::load(slot.assists);
+        stats.objectivesCaptured = Atomic::load(slot.objectives_captured);
+        stats.objectivesCompleted = Atomic::load(slot.objectives_completed);
+        stats.calculatedPoints = 0;
+    }
+
     /*!
         Calculate the points that a player has earned. This function does not
         return a value, instead modifying the given statistics object.
         \param stats Reference to a statistics object.
     */
-    void calculate_points(VTankObject::Statistics& stats) 
+    void calculate_points(VTankObject::Statistics& stats)
     {
         // TODO: Right now we'll just use arbitrary values.
         // We'll use structured values in the future.
@@ -111,7 +79,7 @@ namespace PointManager
         const int KILL_VALUE = 10;
         const int OBJECTIVE_VALUE = 20;
         const int CAPTURE_VALUE = 20;
-        
+
         //stats.calculatedPoints += (stats.deaths * DEATH_VALUE);
         stats.calculatedPoints += (stats.kills * KILL_VALUE);
         stats.calculatedPoints += (stats.assists * ASSIST_VALUE);
@@ -121,62 +89,120 @@ namespace PointManager
 
     void reset()
     {
-        (void)thread_pool.schedule(boost::bind<void>(do_task, RESET_TASK, -1, 0));
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::mutex> guard(arena.statistics_mutex);
+
+        for (int i = 0; i < STATISTICS_SLOTS; ++i) {
+            Statistics_Slot &slot = arena.statistics[i];
+            Atomic::store(slot.active, 0);
+            Atomic::store(slot.kills, 0);
+            Atomic::store(slot.assists, 0);
+            Atomic::store(slot.deaths, 0);
+            Atomic::store(slot.objectives_completed, 0);
+            Atomic::store(slot.objectives_captured, 0);
+            slot.name.clear();
+        }
+        arena.retired_statistics.clear();
     }
 
     void add_player(const int id)
     {
-        (void)thread_pool.schedule(boost::bind<void>(do_task, ADD_TASK, id, 0));
+        Statistics_Slot *slot = find_slot(id);
+        if (slot == NULL) {
+            LOG_STREAM(Logger::LOG_LEVEL_WARNING, "PointManager::add_player(): Player #" << id
+                << " is out of range; no statistics are kept for them.");
+            return;
+        }
+
+        Game_Instance &arena = Game_Instance::current();
+        try {
+            const std::string name = arena.tanks.get(id)->get_name();
+
+            boost::lock_guard<boost::mutex> guard(arena.statistics_mutex);
+            if (Atomic::load(slot->active) && slot->name == name) {
+                // Exists already. Do nothing.
+                return;
+            }
+
+            // The ID was free, or was handed to someone else after its owner left. The
+            // owner's record still counts towards the round.
+            if (Atomic::load(slot->active)) {
+                Atomic::store(slot->active, 0);
+
+                VTankObject::Statistics departed;
+                read_slot(*slot, departed);
+                arena.retired_statistics.push_back(departed);
+            }
+
+            Atomic::store(slot->kills, 0);
+            Atomic::store(slot->assists, 0);
+            Atomic::store(slot->deaths, 0);
+            Atomic::store(slot->objectives_completed, 0);
+            Atomic::store(slot->objectives_captured, 0);
+            slot->name = name;
+            Atomic::store(slot->active, 1);
+        }
+        catch (const TankNotExistException &) {
+        }
     }
 
     void add_kill(const int id)
     {
-        (void)thread_pool.schedule(boost::bind<void>(do_task, KILL_TASK, id, 1));
+        increment(id, &Statistics_Slot::kills);
     }
-    
+
     void add_assist(const int id)
     {
-        (void)thread_pool.schedule(boost::bind<void>(do_task, ASSIST_TASK, id, 1));
+        increment(id, &Statistics_Slot::assists);
     }
 
     void add_death(const int id)
     {
-        (void)thread_pool.schedule(boost::bind<void>(do_task, DEATH_TASK, id, 1));
+        increment(id, &Statistics_Slot::deaths);
     }
 
     void add_objective_completed(const int id)
     {
-        (void)thread_pool.schedule(boost::bind<void>(do_task, OBJECTIVE_TASK, id, 1));
+        increment(id, &Statistics_Slot::objectives_completed);
     }
 
     void add_objective_captured(const int id)
     {
-        (void)thread_pool.schedule(boost::bind<void>(do_task, CAPTURE_TASK, id, 1));
+        increment(id, &Statistics_Slot::objectives_captured);
     }
 
     VTankObject::StatisticsList compile(const bool filter_players)
     {
-        // Wait for the tasks to stop executing.
-        thread_pool.wait();
-
-        boost::unique_lock<boost::shared_mutex> guard(mutex);
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::mutex> guard(arena.statistics_mutex);
 
         // Now gather statistics.
         VTankObject::StatisticsList stats;
 
-        std::map<int, VTankObject::Statistics>::iterator i = statistics.begin();
-        for (; i != statistics.end(); i++) {
+        for (int i = 0; i < STATISTICS_SLOTS; ++i) {
+            const Statistics_Slot &slot = arena.statistics[i];
+            if (!Atomic::load(slot.active)) {
+                continue;
+            }
+
             if (filter_players) {
                 // Do not add players if they aren't in the game.
                 try {
-                    (void)Players::tanks.get(i->first);
+                    (void)arena.tanks.get(i);
                 }
                 catch (const TankNotExistException &) {
                     continue;
                 }
             }
-        
-            stats.push_back(i->second);
+
+            VTankObject::Statistics player_stats;
+            read_slot(slot, player_stats);
+            stats.push_back(player_stats);
+        }
+
+        if (!filter_players) {
+            stats.insert(stats.end(), arena.retired_statistics.begin(),
+                arena.retired_statistics.end());
         }
 
         return stats;
@@ -184,22 +210,37 @@ namespace PointManager
 
     VTankObject::StatisticsList compile_and_calculate()
     {
-        // Wait for the tasks to stop executing.
-        thread_pool.wait();
-
-        boost::unique_lock<boost::shared_mutex> guard(mutex);
+        Game_Instance &arena = Game_Instance::current();
+        boost::lock_guard<boost::mutex> guard(arena.statistics_mutex);
 
         // Now gather statistics.
         VTankObject::StatisticsList stats;
 
-        std::map<int, VTankObject::Statistics>::iterator i = statistics.begin();
-        for (; i != statistics.end(); i++) {
-            calculate_points(i->second);
-			if (i->second.kills == 0 && i->second.assists == 0 && i->second.deaths == 0 &&
-				i->second.objectivesCaptured == 0 && i->second.objectivesCompleted == 0) {
-				continue;
-			}
-            stats.push_back(i->second);
+        VTankObject::StatisticsList players;
+        for (int i = 0; i < STATISTICS_SLOTS; ++i) {
+            const Statistics_Slot &slot = arena.statistics[i];
+            if (!Atomic::load(slot.active)) {
+                continue;
+            }
+
+            VTankObject::Statistics player_stats;
+            read_slot(slot, player_stats);
+            players.push_back(player_stats);
+        }
+
+        // Players whose IDs were given to someone else still count.
+        players.insert(players.end(), arena.retired_statistics.begin(),
+            arena.retired_statistics.end());
+
+        for (VTankObject::StatisticsList::size_type i = 0; i < players.size(); ++i) {
+            VTankObject::Statistics &player_stats = players[i];
+            calculate_points(player_stats);
+            if (player_stats.kills == 0 && player_stats.assists == 0 &&
+                player_stats.deaths == 0 && player_stats.objectivesCaptured == 0 &&
+                player_stats.objectivesCompleted == 0) {
+                continue;
+            }
+            stats.push_back(player_stats);
         }
 
         return stats;
@@ -6,30 +6,50 @@
 #ifndef POINTMANAGER_HPP
 #define POINTMANAGER_HPP
 
+//! Number of player IDs an arena keeps statistics for. IDs are reused from 0 up (see
+//! Players::generate_unique_temp_id()), so this only has to exceed the player limit.
+#define STATISTICS_SLOTS 256
+
 /*!
     The PointManager namespace globally manages statistics for each player. The
     'reset' function should be called first every time a game starts. Finally,
     to package the statistics into a neat StatisticsList (which is sent to Echelon),
     call the 'compile' function. The returned value is ready as-is. However, if the
-    vector object has no values, no players were entered into the pool.
+    vector object has no values, no players were entered into the pool. Statistics are
+    kept for the arena bound to the calling thread (see Game_Instance).
 */
 namespace PointManager
 {
-    //! The thread pool executes tasks in it's own thread.
-    extern boost::threadpool::pool thread_pool;
+    /*!
+        Statistics of one player ID in an arena. The counters are changed and read with
+        atomic operations, so scoring never waits and a scoreboard may be compiled from
+        any thread. Only the name, which is set when a player is added, is guarded by the
+        arena's statistics_mutex.
+    */
+    struct Statistics_Slot
+    {
+        //! 1 if a player was added to the slot since the last reset.
+        volatile long active;
+        volatile long kills;
+        volatile long assists;
+        volatile long deaths;
+        volatile long objectives_completed;
+        volatile long objectives_captured;
+        std::string name;
 
-    //! Stores 
-    extern std::map<int, VTankObject::Statistics> statistics;
+        Statistics_Slot();
+    };
 
     /*!
-        This function resets the point manager, emptying it's cache and killing all
-        executing tasks. Players must be re-added into the manager.
+        This function resets the point manager, emptying every slot. Players must be
+        re-added into the manager.
     */
     void reset();
 
     /*!
         Add a player to the point manager. Note that the player will not be removed
-        until reset() is called (which is intended).
+        until reset() is called (which is intended). If someone else is given the same
+        ID before then, the player's record is set aside until reset().
         \param username Name of the person to add.
     */
     void add_player(const int);
@@ -68,12 +88,15 @@ namespace PointManager
         Compile the statistics list into a VTankObject::StatisticsList object. This
         list is compatible with the Slice-generated functions which sends the 
         statistics to Echelon.
-        \param filter_players Do not compile players who aren't in the game anymore.
+        \param filter_players Do not compile players who aren't in the game anymore,
+        including those whose IDs were given to someone else.
     */
     VTankObject::StatisticsList compile(const bool = true);
 
     /*!
-        Same thing as compile(), except it also calculates the point value of each player.
+        Same thing as compile(), except it also calculates the point value of each player
+        and skips those who did nothing. Players who left are included, even if their IDs
+        were given to someone else.
         \return List of statistics for each player.
     */
     VTankObject::StatisticsList compile_and_calculate();
@@ -0,0 +1,271 @@
+/*!
+    \file   profiler.cpp
+    \brief  Implements the Latency_Histogram and Frame_Profiler classes.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <cmath>
+#include <profiler.hpp>
+
+namespace Profiler
+{
+    const char *get_phase_name(const Phase phase)
+    {
+        switch (phase) {
+        case PHASE_INPUT:               return "input";
+        case PHASE_NODES:               return "nodes";
+        case PHASE_PROJECTILES:         return "projectiles";
+        case PHASE_UTILITY_SPAWNING:    return "utility spawning";
+        case PHASE_GAME_RULES:          return "game rules";
+        case PHASE_TANKS:               return "tanks";
+        case PHASE_PUBLISH:             return "publish";
+        case PHASE_BROADCAST:           return "broadcast";
+        case PHASE_ROTATION:            return "rotation";
+        case PHASE_TICK:                return "tick";
+        default:                        return "unknown";
+        }
+    }
+
+    const char *get_counter_name(const Counter counter)
+    {
+        switch (counter) {
+        case COUNTER_PROJECTILES:       return "projectiles";
+        case COUNTER_EFFECTS:           return "environment effects";
+        case COUNTER_INPUT:             return "input commands";
+        case COUNTER_MESSAGES:          return "messages sent";
+        case COUNTER_QUEUED:            return "messages queued";
+        case COUNTER_DROPPED:           return "messages dropped";
+        default:                        return "unknown";
+        }
+    }
+}
+
+Latency_Histogram::Latency_Histogram()
+{
+    clear();
+}
+
+int Latency_Histogram::get_bucket(const Ice::Long microseconds)
+{
+    if (microseconds < LINEAR_BUCKETS) {
+        return microseconds < 0 ? 0 : static_cast<int>(microseconds);
+    }
+
+    int exponent = 0;
+    for (Ice::Long value = microseconds; value > 1; value >>= 1) {
+        ++exponent;
+    }
+
+    if (exponent >= MAX_EXPONENT) {
+        return BUCKET_COUNT - 1;
+    }
+
+    // The top five bits pick the bucket within the power of two.
+    const Ice::Long top = microseconds >> (exponent - 4);
+    return LINEAR_BUCKETS + (exponent - 5) * SUB_BUCKETS + static_cast<int>(top - SUB_BUCKETS);
+}
+
+Ice::Long Latency_Histogram::get_bucket_limit(const int bucket)
+{
+    if (bucket < LINEAR_BUCKETS) {
+        return bucket + 1;
+    }
+
+    if (bucket >= BUCKET_COUNT - 1) {
+        return static_cast<Ice::Long>(1) << MAX_EXPONENT;
+    }
+
+    const int exponent = 5 + (bucket - LINEAR_BUCKETS) / SUB_BUCKETS;
+    const Ice::Long top = SUB_BUCKETS + (bucket - LINEAR_BUCKETS) % SUB_BUCKETS + 1;
+    return top << (exponent - 4);
+}
+
+void Latency_Histogram::record(const double milliseconds)
+{
+    ++counts[get_bucket(static_cast<Ice::Long>(milliseconds * 1000.0))];
+    ++samples;
+    sum += milliseconds;
+    if (milliseconds > maximum) {
+        maximum = milliseconds;
+    }
+}
+
+void Latency_Histogram::add(const Latency_Histogram &other)
+{
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] += other.counts[i];
+    }
+
+    samples += other.samples;
+    sum += other.sum;
+    if (other.maximum > maximum) {
+        maximum = other.maximum;
+    }
+}
+
+void Latency_Histogram::clear()
+{
+    std::fill(counts, counts + BUCKET_COUNT, 0);
+    samples = 0;
+    sum = 0;
+    maximum = 0;
+}
+
+double Latency_Histogram::get_percentile(const double fraction) const
+{
+    if (samples == 0) {
+        return 0;
+    }
+
+    Ice::Long target = static_cast<Ice::Long>(std::ceil(fraction * samples));
+    if (target < 1) {
+        target = 1;
+    }
+
+    Ice::Long seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            // Report the top of the bucket, but never more than was actually seen.
+            const double limit = get_bucket_limit(i) / 1000.0;
+            return limit < maximum ? limit : maximum;
+        }
+    }
+
+    return maximum;
+}
+
+void Frame_Report::add(const Frame_Report &other)
+{
+    for (int i = 0; i < Profiler::PHASE_COUNT; ++i) {
+        phases[i].add(other.phases[i]);
+    }
+
+    input_latency.add(other.input_latency);
+    send_latency.add(other.send_latency);
+
+    for (int i = 0; i < Profiler::COUNTER_COUNT; ++i) {
+        counters[i].add(other.counters[i]);
+    }
+}
+
+void Frame_Report::clear()
+{
+    for (int i = 0; i < Profiler::PHASE_COUNT; ++i) {
+        phases[i].clear();
+    }
+
+    input_latency.clear();
+    send_latency.clear();
+
+    for (int i = 0; i < Profiler::COUNTER_COUNT; ++i) {
+        counters[i] = Counter_Statistics();
+    }
+}
+
+Frame_Profiler::Frame_Profiler()
+    : tick_start(0), phase_start(0), broadcast_inputs(0)
+{
+    std::fill(pending_phases, pending_phases + Profiler::PHASE_COUNT, -1.0);
+    std::fill(pending_counters, pending_counters + Profiler::COUNTER_COUNT, 0);
+
+    // One tick can apply at most a full input buffer.
+    pending_inputs.reserve(INPUT_BUFFER_CAPACITY);
+}
+
+void Frame_Profiler::begin_tick()
+{
+    tick_start = get_precise_time();
+    phase_start = tick_start;
+}
+
+void Frame_Profiler::end_phase(const Profiler::Phase phase)
+{
+    const double now = get_precise_time();
+    pending_phases[phase] = now - phase_start;
+    phase_start = now;
+}
+
+void Frame_Profiler::record_input(const double received)
+{
+    if (pending_inputs.size() < pending_inputs.capacity()) {
+        pending_inputs.push_back(received);
+    }
+}
+
+void Frame_Profiler::record_broadcast()
+{
+    // Inputs are converted from arrival times to latencies in place.
+    const double now = get_precise_time();
+    for (; broadcast_inputs < pending_inputs.size(); ++broadcast_inputs) {
+        pending_inputs[broadcast_inputs] = now - pending_inputs[broadcast_inputs];
+    }
+}
+
+void Frame_Profiler::record_sends(const std::vector<double> &waits)
+{
+    if (waits.empty()) {
+        return;
+    }
+
+    boost::lock_guard<boost::mutex> guard(mutex);
+    for (std::vector<double>::size_type i = 0; i < waits.size(); ++i) {
+        interval.send_latency.record(waits[i]);
+    }
+}
+
+void Frame_Profiler::set_counter(const Profiler::Counter counter, const Ice::Long value)
+{
+    pending_counters[counter] = value;
+}
+
+void Frame_Profiler::end_tick()
+{
+    pending_phases[Profiler::PHASE_TICK] = get_precise_time() - tick_start;
+
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+
+        // Phases which didn't run this tick, such as rotation, aren't counted.
+        for (int i = 0; i < Profiler::PHASE_COUNT; ++i) {
+            if (pending_phases[i] >= 0) {
+                interval.phases[i].record(pending_phases[i]);
+            }
+        }
+
+        // Input which never made it to a broadcast, because the tick failed, is dropped.
+        for (std::vector<double>::size_type i = 0; i < broadcast_inputs; ++i) {
+            interval.input_latency.record(pending_inputs[i]);
+        }
+
+        for (int i = 0; i < Profiler::COUNTER_COUNT; ++i) {
+            interval.counters[i].record(pending_counters[i]);
+        }
+    }
+
+    std::fill(pending_phases, pending_phases + Profiler::PHASE_COUNT, -1.0);
+    std::fill(pending_counters, pending_counters + Profiler::COUNTER_COUNT, 0);
+    pending_inputs.clear();
+    broadcast_inputs = 0;
+}
+
+Frame_Report Frame_Profiler::get_report()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    Frame_Report report = total;
+    report.add(interval);
+
+    return report;
+}
+
+Frame_Report Frame_Profiler::take_interval()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    const Frame_Report report = interval;
+    total.add(interval);
+    interval.clear();
+
+    return report;
+}
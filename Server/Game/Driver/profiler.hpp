@@ -0,0 +1,256 @@
+/*!
+    \file   profiler.hpp
+    \brief  Per-phase timing and counters for the simulation tick.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+/*!
+    Fixed-size histogram of durations in the style of an HDR histogram. Durations are
+    kept in microseconds: every value below LINEAR_BUCKETS has its own bucket, and every
+    power of two above that is split into SUB_BUCKETS buckets, so any percentile read
+    back is within about 6% of the truth. Recording never allocates, and two histograms
+    can be added together without losing anything.
+*/
+class Latency_Histogram
+{
+public:
+    //! Number of one-microsecond buckets at the bottom of the range.
+    static const int LINEAR_BUCKETS = 32;
+
+    //! Number of buckets each power of two above LINEAR_BUCKETS is split into.
+    static const int SUB_BUCKETS = 16;
+
+    //! Values of 2^MAX_EXPONENT microseconds (about 18 minutes) and up share a bucket.
+    static const int MAX_EXPONENT = 30;
+
+    //! Total number of buckets.
+    static const int BUCKET_COUNT = LINEAR_BUCKETS + (MAX_EXPONENT - 5) * SUB_BUCKETS + 1;
+
+private:
+    Ice::Long counts[BUCKET_COUNT];
+    Ice::Long samples;
+    double sum;
+    double maximum;
+
+public:
+    Latency_Histogram();
+
+    /*!
+        Get the bucket a duration falls in.
+        \param microseconds Duration. Negative durations are counted as zero.
+        \return Index of the bucket.
+    */
+    static int get_bucket(const Ice::Long);
+
+    /*!
+        Get the smallest duration which falls after a bucket.
+        \param bucket Index of the bucket.
+        \return Duration in microseconds.
+    */
+    static Ice::Long get_bucket_limit(const int);
+
+    /*!
+        Count one duration.
+        \param milliseconds Duration to count.
+    */
+    void record(const double);
+
+    //! Add every duration counted by another histogram to this one.
+    void add(const Latency_Histogram &);
+
+    //! Forget every duration counted so far.
+    void clear();
+
+    /*!
+        Get the duration below which a fraction of the samples fall.
+        \param fraction Fraction of the samples, such as 0.99.
+        \return Duration in milliseconds, or 0 if nothing has been counted.
+    */
+    double get_percentile(const double) const;
+
+    //! Get the number of durations counted.
+    Ice::Long get_count() const { return samples; }
+
+    //! Get the mean duration in milliseconds, or 0 if nothing has been counted.
+    double get_mean() const { return samples == 0 ? 0 : sum / samples; }
+
+    //! Get the longest duration in milliseconds.
+    double get_max() const { return maximum; }
+};
+
+//! Running summary of a value sampled once per tick.
+struct Counter_Statistics
+{
+    //! Number of ticks sampled.
+    Ice::Long ticks;
+
+    //! Sum of every sample.
+    Ice::Long total;
+
+    //! Largest sample.
+    Ice::Long peak;
+
+    Counter_Statistics() : ticks(0), total(0), peak(0) {}
+
+    //! Count one tick's value.
+    void record(const Ice::Long value)
+    {
+        ++ticks;
+        total += value;
+        if (value > peak) {
+            peak = value;
+        }
+    }
+
+    //! Add the samples of another counter to this one.
+    void add(const Counter_Statistics &other)
+    {
+        ticks += other.ticks;
+        total += other.total;
+        if (other.peak > peak) {
+            peak = other.peak;
+        }
+    }
+
+    //! Get the mean value per tick.
+    double get_mean() const
+    {
+        return ticks == 0 ? 0 : static_cast<double>(total) / ticks;
+    }
+};
+
+namespace Profiler
+{
+    //! Parts of a tick which are timed separately, in the order they run.
+    enum Phase
+    {
+        PHASE_INPUT,
+        PHASE_NODES,
+        PHASE_PROJECTILES,
+        PHASE_UTILITY_SPAWNING,
+        PHASE_GAME_RULES,
+        PHASE_TANKS,
+        PHASE_PUBLISH,
+        PHASE_BROADCAST,
+        PHASE_ROTATION,
+        PHASE_TICK,
+        PHASE_COUNT
+    };
+
+    //! Values sampled at the end of every tick.
+    enum Counter
+    {
+        COUNTER_PROJECTILES,
+        COUNTER_EFFECTS,
+        COUNTER_INPUT,
+        COUNTER_MESSAGES,
+        COUNTER_QUEUED,
+        COUNTER_DROPPED,
+        COUNTER_COUNT
+    };
+
+    //! Get the display name of a phase.
+    const char *get_phase_name(const Phase);
+
+    //! Get the display name of a counter.
+    const char *get_counter_name(const Counter);
+}
+
+//! Everything a Frame_Profiler has measured over some number of ticks.
+struct Frame_Report
+{
+    //! Time spent in each phase.
+    Latency_Histogram phases[Profiler::PHASE_COUNT];
+
+    //! Time from a player's input reaching the server to the broadcast of its effects.
+    Latency_Histogram input_latency;
+
+    //! Time messages waited in players' outbound queues before being handed to Ice.
+    Latency_Histogram send_latency;
+
+    //! Per-tick counters.
+    Counter_Statistics counters[Profiler::COUNTER_COUNT];
+
+    //! Add everything measured by another report to this one.
+    void add(const Frame_Report &);
+
+    //! Forget everything measured.
+    void clear();
+};
+
+/*!
+    Times the phases of every tick. The simulation thread calls begin_tick(), then
+    end_phase() as each phase finishes, and end_tick() at the end; durations are held in
+    plain members until the end of the tick and then folded into the shared histograms
+    under a single lock. Any thread may read the results.
+*/
+class Frame_Profiler
+{
+private:
+    // Only touched by the simulation thread.
+    double tick_start;
+    double phase_start;
+    double pending_phases[Profiler::PHASE_COUNT];
+    std::vector<double> pending_inputs;
+    std::vector<double>::size_type broadcast_inputs;
+    Ice::Long pending_counters[Profiler::COUNTER_COUNT];
+
+    // Guarded by mutex.
+    boost::mutex mutex;
+    Frame_Report interval;
+    Frame_Report total;
+
+public:
+    Frame_Profiler();
+
+    //! Start timing a tick.
+    void begin_tick();
+
+    /*!
+        Finish a phase. The phase is charged with the time since the previous phase
+        ended, or since the tick began.
+        \param phase Phase which just finished.
+    */
+    void end_phase(const Profiler::Phase);
+
+    /*!
+        Note that a player's input was applied during this tick.
+        \param received Time the input reached the server, from get_precise_time().
+    */
+    void record_input(const double);
+
+    /*!
+        Note that the tick's updates have been handed to Ice. Every input applied so
+        far is counted in the input latency.
+    */
+    void record_broadcast();
+
+    /*!
+        Note how long messages waited in an outbound queue. Safe to call from any thread.
+        \param waits Time each message waited, in milliseconds.
+    */
+    void record_sends(const std::vector<double> &);
+
+    /*!
+        Set a counter's value for this tick.
+        \param counter Counter to set.
+        \param value Value for this tick.
+    */
+    void set_counter(const Profiler::Counter, const Ice::Long);
+
+    //! Finish timing a tick and publish what was measured.
+    void end_tick();
+
+    //! Get everything measured since the server started.
+    Frame_Report get_report();
+
+    /*!
+        Get everything measured since the last call, and start a new interval.
+        \return Report covering only the interval which just ended.
+    */
+    Frame_Report take_interval();
+};
+
+#endif
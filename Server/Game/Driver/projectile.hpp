@@ -11,69 +11,50 @@
 
 /*!
     An active projectile holds data about a projectile that has been fired in-game.
+    Projectiles in flight live in a Projectile_Pool; this is a copy of one of them,
+    made when it is fired, hits something, or is sent to clients.
 */
 struct Active_Projectile
 {
-private:
-	void calculate_alive_time()
-	{
-		if (expireTimeMillis <= 0) {
-			// time = distance / velocity
-			expireTimeMillis = static_cast<long>(
-				(static_cast<float>(type.projectile.range) /
-					type.projectile.initial_velocity) * 1000.0f);
-		}
-	}
-
-public:
     int id;
     int owner;
-    long millisecondsAlive;
-	long expireTimeMillis;
     double angle;
-    double velocity;
     int node_id;
 	VTankObject::Point origin;
 	VTankObject::Point target;
     VTankObject::Point position;
-    Weapon type;
+    weapon_type_index weapon;    // Index in the weapon table.
     float damage;
+    double rewind;               // Ticks the targets are rewound by (see Lag_Compensation).
 	Vector3 tip;				 // for arc calculations.
 	Vector3 velocity_component; // for arc calculations.
 
     Active_Projectile() 
-        : id(-1), owner(-1), millisecondsAlive(0), angle(0), node_id(-1),
-        position(VTankObject::Point()), type(), expireTimeMillis(-1), velocity(0), damage(0)
+        : id(-1), owner(-1), angle(0), node_id(-1), origin(VTankObject::Point()),
+        target(VTankObject::Point()), position(VTankObject::Point()), weapon(0), damage(0),
+        rewind(0)
     {}
 
     Active_Projectile(int projectileId, int ownerId, double projectileAngle,
 		const VTankObject::Point &projectilePosition, const VTankObject::Point &a_target,
-        const Weapon &weaponType)
-        : id(projectileId), owner(ownerId), millisecondsAlive(0), angle(projectileAngle),
-        node_id(-1), position(projectilePosition), origin(projectilePosition), type(weaponType), 
-		damage(0), target(a_target)
+        const weapon_type_index weaponIndex)
+        : id(projectileId), owner(ownerId), angle(projectileAngle), node_id(-1),
+        origin(projectilePosition), target(a_target), position(projectilePosition),
+        weapon(weaponIndex), damage(0), rewind(0)
     {
-        velocity = type.projectile.initial_velocity;
-		calculate_alive_time();
 	}
 
-    //! Increment the alive counter by some delta time.
-    void advance(long delta_time)
+    /*!
+        Milliseconds the projectile lives before expiring, if it doesn't hit anything.
+        \param type Weapon which fired it.
+    */
+    static long get_lifetime(const Weapon &type)
     {
-		calculate_alive_time();
-
-        millisecondsAlive += delta_time;
-    }
-
-    //! Check if the projectile has expired.
-    bool expired()
-    {
-		calculate_alive_time();
-
-		return millisecondsAlive >= expireTimeMillis && type.launch_angle == 0;
+        // time = distance / velocity
+        return static_cast<long>((static_cast<float>(type.projectile.range) /
+            type.projectile.initial_velocity) * 1000.0f);
     }
 };
 
-typedef boost::shared_ptr<Active_Projectile> projectile_ptr;
-typedef std::vector<projectile_ptr> projectile_array;
+typedef std::vector<Active_Projectile> projectile_array;
 #endif
@@ -14,13 +14,14 @@
 #include <playermanager.hpp>
 #include <asynctemplate.hpp>
 #include <gamemanager.hpp>
+#include <trace.hpp>
+#include <lagcompensation.hpp>
 
 namespace {
-	int projectile_count = 0;
-
-	bool compare(double x1, double x2, double incr)
+	//! Get the weapon which fired a projectile from the table in use.
+	const Weapon &get_weapon(const Active_Projectile &projectile)
 	{
-        return abs(x2 - x1) <= incr;
+		return Players::get_weapon_data()->get_table()->get_weapon(projectile.weapon);
 	}
 
 	float calculate_aoe_damage(const float raw_damage, const float decay, const float r, const float d)
@@ -32,19 +33,19 @@ namespace {
 	}
 
 	//! Handle AOE weapon damage. This method assumes a projectile has had impact.
-	void handle_aoe_weapon(const tank_ptr &owner, const projectile_ptr &projectile,
+	void handle_aoe_weapon(const tank_ptr &owner, const Active_Projectile &projectile,
 		const damageable_map &object_list = damageable_map())
 	{
 		using Utility::Circle;
 
-		const Projectile projectile_data = projectile->type.projectile;
-		const Circle splash_area(projectile_data.aoe_radius, projectile->position);
+		const Projectile &projectile_data = get_weapon(projectile).projectile;
+		const Circle splash_area(projectile_data.aoe_radius, projectile.position);
 
-		const int node = Players::get_node_manager()->get_node_at(projectile->position);
-		const tank_array players = Players::get_node_manager()->get_relevant_players(node);
+		const int node = Players::get_node_manager()->get_node_at(projectile.position);
+		const Node_Span players = Players::get_node_manager()->get_neighbors(node);
 		
 		// Detect if players are present in the splash radius.
-		for (tank_array::size_type i = 0; i < players.size(); ++i) {
+		for (Node_Span::size_type i = 0; i < players.size(); ++i) {
 			const tank_ptr player = players[i];
 			if (!player->is_alive() || (player->get_team() != GameSession::NONE &&
 					player->get_team() == owner->get_team()) || 
@@ -58,9 +59,9 @@ namespace {
 				const VTankObject::Point pos = player->get_position();
 				if (splash_area.position.x == pos.x && splash_area.position.y == pos.y) {
 					// The points are exactly the same: Full area damage.
-					final_damage = Utility::round(projectile->damage / player->get_armor_factor());
+					final_damage = Utility::round(projectile.damage / player->get_armor_factor());
 				
-					player->inflict_damage(final_damage, projectile->id, projectile_data.id, owner->get_id());
+					player->inflict_damage(final_damage, projectile.id, projectile_data.id, owner->get_id());
 				}
 				else {
 					// Calculate the damage dealt based on the distance to the target.
@@ -68,15 +69,15 @@ namespace {
 						pow(splash_area.position.y - pos.y, 2) + 
 						pow(splash_area.position.x - pos.x, 2)));
 					
-					const float damage = calculate_aoe_damage(projectile->damage, projectile_data.aoe_decay,
+					const float damage = calculate_aoe_damage(projectile.damage, projectile_data.aoe_decay,
 						projectile_data.aoe_radius, distance);
 					final_damage = Utility::round(damage / player->get_armor_factor());
 					
-					player->inflict_damage(final_damage, projectile->id, projectile_data.id, owner->get_id());
+					player->inflict_damage(final_damage, projectile.id, projectile_data.id, owner->get_id());
 				}
 
-				Notifier::blanket_notify_player_damaged(player->get_id(), projectile->id,
-					owner->get_id(), final_damage, !player->is_alive());
+				Notifier::broadcast_player_damaged(player, projectile.id,
+					owner, final_damage, !player->is_alive());
 			}
 		}
 		
@@ -95,11 +96,11 @@ namespace {
 					pow(splash_area.position.y - object->get_position().y, 2) + 
 					pow(splash_area.position.x - object->get_position().x, 2)));
 				
-				float damage = calculate_aoe_damage(projectile->damage, projectile_data.aoe_decay,
+				float damage = calculate_aoe_damage(projectile.damage, projectile_data.aoe_decay,
 					projectile_data.aoe_radius, distance);
 				const int final_damage = Utility::round(damage / object->get_armor_factor());
 				
-				object->inflict_damage(final_damage, projectile->id, projectile_data.id, owner->get_id());
+				object->inflict_damage(final_damage, projectile.id, projectile_data.id, owner->get_id());
 			}
 		}
 	}
@@ -110,19 +111,19 @@ namespace {
 		\param projectile Projectile hitting the player.
 		\param owner Person who fired the projectile.
 	*/
-	void inflict_damage(const tank_ptr &victim, const projectile_ptr &projectile, const tank_ptr &owner,
+	void inflict_damage(const tank_ptr &victim, const Active_Projectile &projectile, const tank_ptr &owner,
 		const std::map<int, Damageable_Object *> &object_list = std::map<int, Damageable_Object *>())
 	{
 		VTANK_ASSERT(victim->is_alive());
 
-		const Projectile projectile_data = projectile->type.projectile;
+		const Projectile &projectile_data = get_weapon(projectile).projectile;
 		if (projectile_data.aoe_radius > 0.0f) {
-			//projectile->position = victim->get_position();
+			//projectile.position = victim->get_position();
 			handle_aoe_weapon(owner, projectile, object_list);
 		}
 		else {
-			const int damage = Utility::round(projectile->damage / victim->get_armor_factor());
-			victim->inflict_damage(damage, projectile->id, projectile_data.id, owner->get_id());
+			const int damage = Utility::round(projectile.damage / victim->get_armor_factor());
+			victim->inflict_damage(damage, projectile.id, projectile_data.id, owner->get_id());
 
 			const bool killing_blow = !victim->is_alive();
 			if (killing_blow) {
@@ -130,8 +131,8 @@ namespace {
 					owner->get_name().c_str(), victim->get_name().c_str(), damage);
 			}
 
-			Notifier::blanket_notify_player_damaged(victim->get_id(), projectile->id, 
-				owner->get_id(), damage, killing_blow);
+			Notifier::broadcast_player_damaged(victim, projectile.id, 
+				owner, damage, killing_blow);
 		}
 	}
 	
@@ -141,19 +142,20 @@ namespace {
 		\param projectile Projectile hitting the player.
 		\param owner Person who fired the projectile.
 	*/
-	void inflict_damage(Damageable_Object *object, const projectile_ptr &projectile, const tank_ptr &owner,
+	void inflict_damage(Damageable_Object *object, const Active_Projectile &projectile, const tank_ptr &owner,
 		const std::map<int, Damageable_Object *> &object_list = std::map<int, Damageable_Object *>())
 	{
 		VTANK_ASSERT(object->is_alive());
 
-		const Projectile projectile_data = projectile->type.projectile;
+		const Projectile &projectile_data = get_weapon(projectile).projectile;
 		if (projectile_data.aoe_radius > 0.0f) {
-			projectile->position = object->get_position();
-			handle_aoe_weapon(owner, projectile, object_list);
+			Active_Projectile at_object(projectile);
+			at_object.position = object->get_position();
+			handle_aoe_weapon(owner, at_object, object_list);
 		}
 		else {
-			const int damage = Utility::round(projectile->damage / object->get_armor_factor());
-			object->inflict_damage(damage, projectile->id, projectile_data.id, owner->get_id());
+			const int damage = Utility::round(projectile.damage / object->get_armor_factor());
+			object->inflict_damage(damage, projectile.id, projectile_data.id, owner->get_id());
 
 			const bool killing_blow = !object->is_alive();
 			if (killing_blow) {
@@ -163,89 +165,91 @@ namespace {
 		}
 	}
 	
-	void handle_instant_weapon(const tank_ptr &owner, const projectile_ptr &projectile, 
-        const damageable_map &objects)
+	/*!
+		Find where a shooter saw a tank when they fired.
+		\param tank Published state of the tank to look for.
+		\param rewind Ticks to rewind the tank by.
+		\param state [out] The tank's position and angle.
+		\return False if the tank wasn't alive when the shot was fired.
+	*/
+	bool get_rewound_state(const Tank_State &tank, const double rewind, Position_Record &state)
+	{
+		const Position_History &history = tank.tank->get_history();
+		if (rewind > 0 && history.rewind(history.get_newest_tick() - rewind, state)) {
+			return state.alive;
+		}
+
+		state.position = tank.position;
+		state.angle = tank.angle;
+		state.alive = true;
+		return true;
+	}
+
+	void handle_instant_weapon(const tank_ptr &owner, const Active_Projectile &projectile, 
+        const damageable_map &objects, const Tank_State_Buffer::Reader &states)
 	{
-        const Weapon type = projectile->type;
+        const Weapon &type = get_weapon(projectile);
 		const double MAX_RANGE = type.projectile.range;
 		const Map * current_map = MapManager::get_current_map();
 
 		// Check for error in the angle; make corrections.
 		const double TWO_PI = PI * 2;
-		double final_angle = projectile->angle;
+		double final_angle = projectile.angle;
 
         Utility::Line path;
-		path.x1 = projectile->position.x;
-		path.y1 = projectile->position.y;
-		path.x2 = projectile->position.x + cos(final_angle) * MAX_RANGE;
-		path.y2 = projectile->position.y + sin(final_angle) * MAX_RANGE;
+		path.x1 = projectile.position.x;
+		path.y1 = projectile.position.y;
+		path.x2 = projectile.position.x + cos(final_angle) * MAX_RANGE;
+		path.y2 = projectile.position.y + sin(final_angle) * MAX_RANGE;
 
 		// Calculate where the weapon's range ends.
-		// TODO: Better way to do this?
-		const double y_inc = 12;
-		const double x_inc = 12;
-		int last_tile_x = -1;
-		int last_tile_y = -1;
-		const int max_increments = 15;
-        double y = path.y1, x = path.x1;
-        while (true) {
-            if (compare(x, path.x2, x_inc) || compare(y, path.y2, y_inc)) {
-                break;
-            }
-            
-            x += cos(final_angle) * x_inc;
-            y += sin(final_angle) * y_inc;
-			
-			const int tile_x = static_cast<int>(floor(x / TILE_SIZE));
-			const int tile_y = static_cast<int>(floor(-y / TILE_SIZE));
-			if (tile_x == last_tile_x && tile_y == last_tile_y) {
-				continue;
-			}
-			last_tile_x = tile_x;
-			last_tile_y = tile_y;
-
-			if (tile_x < 0 || tile_y < 0 || tile_x >= current_map->get_width() || 
-					tile_y >= current_map->get_height()) {
-                // The max range will fall off the map.
-				path.x2 = x;
-				path.y2 = y;
-				break;
-			}
-
-			const Tile tile = current_map->get_tile(tile_x, tile_y);
-			if (!tile.passable) {
-				// Laser hit a wall: done calculation.
-				// Increment slightly to prevent weird effects such as lasers not fully hitting a wall.
-				path.x2 = x += cos(final_angle) * x_inc;
-				path.y2 = y += sin(final_angle) * y_inc;
-				break;
-			}
+		if (Utility::trace_to_wall(current_map, path)) {
+			// Laser hit a wall.
+			// Increment slightly to prevent weird effects such as lasers not fully hitting a wall.
+			const double WALL_OVERSHOOT = 12;
+			path.x2 += cos(final_angle) * WALL_OVERSHOOT;
+			path.y2 += sin(final_angle) * WALL_OVERSHOOT;
 		}
 
-		projectile->target.x = path.x2;
-		projectile->target.y = path.y2;
-        
 		// We now know exactly where the weapon begins and ends. Find out who it hits.
-		const tank_array all_tanks = Players::tanks.get_tank_list();
+		// Only tanks near the nodes the path crosses can be touched by it.
+		tank_array candidates;
+		Players::get_node_manager()->get_players_near_line(path.x1, path.y1, path.x2, path.y2,
+			candidates);
+		// Tanks are hit where the shooter saw them, which is never more than a few
+		// ticks' movement from the nodes they are in now.
 		tank_array hit_tanks;
+		std::vector<VTankObject::Point> hit_positions;
 		damageable_list hit_objects;
 		const double TANK_RADIUS = TANK_SPHERE_RADIUS + 15.0;
-		for (tank_array::const_iterator i = all_tanks.begin(); i != all_tanks.end(); ++i) {
+		const Tank_State *shooter = states.find(owner->get_id());
+		const GameSession::Alliance owner_team = shooter != NULL ? shooter->team : GameSession::NONE;
+		for (tank_array::const_iterator i = candidates.begin(); i != candidates.end(); ++i) {
 			const tank_ptr tank = *i;
-			const VTankObject::Point tank_position = tank->get_position();
+			const Tank_State *state = states.find(tank->get_id());
+			if (state == NULL || (state->team == owner_team && state->team != GameSession::NONE) || 
+					!state->alive || state->id == owner->get_id()) {
+				continue;
+			}
 
-			if ((tank->get_team() == owner->get_team() && tank->get_team() != GameSession::NONE) || 
-					!tank->is_alive() || tank->get_id() == owner->get_id()) {
+			Position_Record seen;
+			if (!get_rewound_state(*state, projectile.rewind, seen)) {
 				continue;
 			}
 
-			if (Utility::line_circle_collision(tank_position.x, tank_position.y, TANK_RADIUS,
-					path.x1, path.y1, path.x2, path.y2)) {
+			// A tank killed earlier this tick is still alive in the published states.
+			if (Utility::line_circle_collision(seen.position.x, seen.position.y, TANK_RADIUS,
+					path.x1, path.y1, path.x2, path.y2) && tank->is_alive()) {
 				// It hit a player.
 				hit_tanks.push_back(tank);
+				hit_positions.push_back(seen.position);
 			}
 		}
 		
+		const double min_x = std::min(path.x1, path.x2);
+		const double max_x = std::max(path.x1, path.x2);
+		const double min_y = std::min(path.y1, path.y2);
+		const double max_y = std::max(path.y1, path.y2);
 		damageable_map::const_iterator j = objects.begin();
 		for (; j != objects.end(); ++j) {
 			Damageable_Object *object = j->second;
@@ -254,8 +258,15 @@ namespace {
 				continue;
 			}
 			const VTankObject::Point pos = object->get_position();
+			const double radius = object->get_radius();
+
+			// Objects clear of the path's bounding box can't be touched by it.
+			if (pos.x + radius < min_x || pos.x - radius > max_x ||
+					pos.y + radius < min_y || pos.y - radius > max_y) {
+				continue;
+			}
 
-			if (Utility::line_circle_collision(pos.x, pos.y, object->get_radius(),
+			if (Utility::line_circle_collision(pos.x, pos.y, radius,
 					path.x1, path.y1, path.x2, path.y2)) {
 				// It hit the object.
 				hit_objects.push_back(object);
@@ -266,13 +277,12 @@ namespace {
 		// This person, and this person only, was affected by the laser.
 		if (hit_tanks.size() == 0 && hit_objects.size() == 0) {
 			// Nobody was hit.
-			// TODO: This should not distribute the message like this.
 			VTankObject::Point end_point;
 			end_point.x = path.x2;
 			end_point.y = path.y2;
 			
-			Notifier::blanket_notify_create_projectile(owner->get_id(), projectile->id,
-				type.projectile.id, end_point);
+			Notifier::broadcast_create_projectile(owner, projectile.id,
+				type.projectile.id, end_point, path);
 
 			return;
 		}
@@ -292,13 +302,12 @@ namespace {
 		else {
 			// Find the closest person or object hit.
 			double max_distance = 99999;
-			for (tank_array::iterator i = hit_tanks.begin(); i != hit_tanks.end(); ++i) {
-				tank_ptr tank = *i;
-				const VTankObject::Point p = tank->get_position();
+			for (tank_array::size_type i = 0; i < hit_tanks.size(); ++i) {
+				const VTankObject::Point &p = hit_positions[i];
 				const double distance = sqrt(pow(path.y1 - p.y, 2) + pow(path.x1 - p.x, 2));
 				if (distance < max_distance) {
 					max_distance = distance;
-					hit_tank = &tank;
+					hit_tank = &hit_tanks[i];
 				}
 			}
 			
@@ -335,86 +344,72 @@ Projectile_Manager::~Projectile_Manager()
 {
 }
 
-int Projectile_Manager::generate_projectile_id()
+void Projectile_Manager::remove_projectile(const Projectile_Pool::size_type slot)
 {
-    Logger::Stack_Logger stack("Projectile_Manager::generate_projectile_id()", false);
-
-    for (std::map<int, Active_Projectile>::size_type i = 0; i < projectiles.size() + 10; i++) {
-        // Check if anyone holds the ID.
-        const std::map<int, projectile_ptr>::iterator it =
-            projectiles.find(static_cast<int>(i));
-        if (it != projectiles.end()) {
-            continue;
-        }
-
-        return i;
-    }
-
-    // It should never reach here.
-    VTANK_ASSERT(false);
-    return -1; // Makes a warning go away.
+    projectile_ids.release(projectiles.id[slot]);
+    projectiles.remove(slot);
 }
 
-bool Projectile_Manager::do_remove(const int &id)
+Active_Projectile Projectile_Manager::get_projectile(const Projectile_Pool::size_type slot) const
 {
-    const std::map<int, projectile_ptr>::iterator i = projectiles.find(id);
-    if (i == projectiles.end()) {
-        std::ostringstream formatter;
-        formatter << "Couldn't find projectile " << id << " to remove it.";
+    VTankObject::Point position;
+    position.x = projectiles.x[slot];
+    position.y = projectiles.y[slot];
 
-        Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+    Active_Projectile projectile(projectiles.id[slot], projectiles.owner[slot], 
+        projectiles.angle[slot], position, position, projectiles.weapon[slot]);
+    projectile.node_id = projectiles.node_id[slot];
+    projectile.damage = projectiles.damage[slot];
+    projectile.rewind = projectiles.rewind[slot];
 
-        return false;
-    }
-
-    (void)projectiles.erase(i);
-	--projectile_count;
-	if (projectile_count <= 0) {
-		/* TODO: There seems to be a case where the projectiles mapping is not properly
-			dealt with. This is a temporary work-around. Delete projectiles reliably. */
-		projectiles.clear();
-		projectile_count = 0;
-	}
-
-    return true;
+    return projectile;
 }
 
 int Projectile_Manager::add(const int &owner, const double &angle,
                             const VTankObject::Point &position,
-							const VTankObject::Point &target, const Weapon &type, 
-							VTankObject::Point &new_target)
+							const VTankObject::Point &target, const weapon_type_index type, 
+							VTankObject::Point &new_target, const double rewind)
 {
-    Logger::Stack_Logger stack("Projectile_Manager::add()", false);
+    TRACE_POINT("Projectile_Manager::add");
     boost::lock_guard<boost::mutex> guard(mutex);
-	const int id = generate_projectile_id();
-    const projectile_ptr projectile = projectile_ptr(
-        new Active_Projectile(id, owner, angle, position, target, type));
+	const int id = projectile_ids.allocate();
+	VTANK_ASSERT(id >= 0);
+	const Weapon &weapon = Players::get_weapon_data()->get_table()->get_weapon(type);
+    Active_Projectile projectile(id, owner, angle, position, target, type);
     do_initial_calculations(projectile);
 
-    projectiles[id] = projectile;
-	++projectile_count;
+	new_target = projectile.target;
 
-	new_target = projectile->target;
+	// Slow and arcing shots can be seen and dodged, so they hit what is there when they land.
+	if (weapon.projectile.is_instantaneous || (weapon.launch_angle <= 0.0f &&
+			weapon.projectile.initial_velocity >= LAG_COMPENSATION_MIN_VELOCITY)) {
+		projectile.rewind = rewind;
+	}
 
-    if (type.projectile.is_instantaneous) {
+    if (weapon.projectile.is_instantaneous) {
         // Instant projectiles are handled internally, differently.
+        instant_projectiles.push_back(projectile);
         return -1;
     }
 
+    projectiles.add(projectile, weapon);
+
     return id;
 }
 
-projectile_ptr Projectile_Manager::get(const int &id)
+Active_Projectile Projectile_Manager::get(const int &id)
 {
-    Logger::Stack_Logger stack("Projectile_Manager::get()", false);
+    TRACE_POINT("Projectile_Manager::get");
     boost::lock_guard<boost::mutex> guard(mutex);
 
-    const std::map<int, projectile_ptr>::const_iterator i = projectiles.find(id);
-    if (i == projectiles.end()) {
+    // A stale ID fails on its generation without searching the pool.
+    const Projectile_Pool::size_type slot = projectile_ids.is_valid(id) ?
+        projectiles.find(id) : projectiles.size();
+    if (slot == projectiles.size()) {
         throw std::runtime_error("Error: No such projectile exists.");
     }
 
-    return i->second;
+    return get_projectile(slot);
 }
 
 void Projectile_Manager::reset()
@@ -422,103 +417,152 @@ void Projectile_Manager::reset()
     boost::lock_guard<boost::mutex> guard(mutex);
 
     projectiles.clear();
+    instant_projectiles.clear();
+    projectile_ids.clear();
     damageable_objects.clear();
+    environment.clear();
 }
 
 bool Projectile_Manager::remove(const int &id)
 {
 	boost::lock_guard<boost::mutex> guard(mutex);
 
-	return do_remove(id);
+    const Projectile_Pool::size_type slot = projectile_ids.is_valid(id) ?
+        projectiles.find(id) : projectiles.size();
+    if (slot == projectiles.size()) {
+        std::ostringstream formatter;
+        formatter << "Couldn't find projectile " << id << " to remove it.";
+
+        Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+
+        return false;
+    }
+
+    remove_projectile(slot);
+
+    return true;
 }
 
 void Projectile_Manager::process(NodeManager &node_manager, const double &delta_time)
 {
-    Logger::Stack_Logger stack("Projectile_Manager::process()", false);
+    TRACE_POINT("Projectile_Manager::process");
     boost::lock_guard<boost::mutex> guard(mutex);
 
-    const long new_delta = static_cast<long>(delta_time * 1000.0);
-    std::vector<int> to_remove;
+    // Tanks only move after projectiles are processed, so the states published at the end
+    // of the last tick are where they are now.
+    const Tank_State_Buffer::Reader states(*Players::get_tank_states());
 
-    std::map<int, projectile_ptr>::iterator i;
-    for (i = projectiles.begin(); i != projectiles.end(); i++) {
-		if (!do_projectile_calculations(i->second, delta_time)) {
-			to_remove.push_back(i->second->id);
+    // Instant projectiles never move; they are taken care of the frame after they are fired.
+    for (projectile_array::size_type i = 0; i < instant_projectiles.size(); i++) {
+        try {
+		    const tank_ptr owner_tank =
+				Players::get_tank_manager()->get(instant_projectiles[i].owner);
 
-			continue;
-		}
+		    handle_instant_weapon(owner_tank, instant_projectiles[i], damageable_objects, states);
+	    }
+	    catch (const TankNotExistException &) {
+	    }
 
-        i->second->millisecondsAlive += new_delta;
-        if (i->second->expired()) {
-            to_remove.push_back(i->second->id);
+        projectile_ids.release(instant_projectiles[i].id);
+    }
+    instant_projectiles.clear();
 
-            continue;
-        }
+    projectiles.integrate(delta_time);
+    node_manager.process_projectiles(projectiles.x, projectiles.y, projectiles.node_id);
+
+	const Map * current_map = MapManager::get_current_map();
 
-        node_manager.process_projectile(i->second);
+    // Removing a projectile moves another one into its slot, so only step past slots
+    // whose projectile stays.
+    Projectile_Pool::size_type i = 0;
+    while (i < projectiles.size()) {
+		if (!do_projectile_calculations(i) || projectiles.expired(i)) {
+			remove_projectile(i);
 
-		if (i->second->type.launch_angle > 0.0f) {
 			continue;
 		}
 
-		const Map * current_map = MapManager::get_current_map();
-		if (Utility::wall_collision(i->second, current_map)) {
-			// Projectile hit a wall.
-			/*std::ostringstream formatter;
-			formatter << "Projectile #" << i->first << " hit a wall.";
+		if (projectiles.is_arcing(i)) {
+			i++;
+			continue;
+		}
 
-			Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());*/
-			
-			if (i->second->type.projectile.aoe_radius > 0) {
+        // Determine the fake "circle" leading the projectile.
+		const float radius = projectiles.radius[i];
+		VTankObject::Point circle;
+        circle.x = projectiles.x[i] + projectiles.dir_x[i] * radius;
+        circle.y = projectiles.y[i] + projectiles.dir_y[i] * radius;
+
+		if (Utility::wall_collision(circle, radius, current_map)) {
+			// Projectile hit a wall.
+			const Weapon &weapon = Players::get_weapon_data()->get_table()->get_weapon(
+				projectiles.weapon[i]);
+			if (weapon.projectile.aoe_radius > 0) {
 				// The projectile has area of effect damage.
 				try {
-					handle_aoe_weapon(Players::tanks.get(i->second->owner), i->second);
+					handle_aoe_weapon(Players::get_tank_manager()->get(projectiles.owner[i]),
+						get_projectile(i));
 				}
 				catch (const TankNotExistException &) {}
 			}
 
-			to_remove.push_back(i->first);
+			remove_projectile(i);
 		}
-        else if (perform_collision_check(node_manager, i->second)) {
-            to_remove.push_back(i->first);
+        else if (perform_collision_check(node_manager, states, i)) {
+            remove_projectile(i);
+        }
+        else {
+            i++;
         }
-    }
-
-    // Remove projectiles that have expired.
-    while (to_remove.size() > 0) {
-        do_remove(to_remove[0]);
-        to_remove.erase(to_remove.begin());
     }
 
 	environment.update(&damageable_objects);
 }
 
-bool Projectile_Manager::perform_collision_check(
-    NodeManager &nodes, const projectile_ptr projectile)
+bool Projectile_Manager::perform_collision_check(NodeManager &nodes,
+    const Tank_State_Buffer::Reader &states, const Projectile_Pool::size_type slot)
 {
-    Logger::Stack_Logger stack("perform_collision_check()", false);
+    TRACE_POINT("perform_collision_check");
 	
-	const tank_ptr owner_tank = Players::get_player(projectile->owner);
-	EnvironmentProperty *env = projectile->type.projectile.environment_property;
-
-	// First check if any players have been hit.
-    const tank_array players = nodes.get_relevant_players(projectile->node_id);
-    for (tank_array::size_type i = 0; i < players.size(); i++) {
+	const int owner = projectiles.owner[slot];
+	const float radius = projectiles.radius[slot];
+	VTankObject::Point circle;
+    circle.x = projectiles.x[slot] + projectiles.dir_x[slot] * radius;
+    circle.y = projectiles.y[slot] + projectiles.dir_y[slot] * radius;
+
+	// First check if any players have been hit, where the shooter saw them.
+    const double rewind = projectiles.rewind[slot];
+    const Tank_State *shooter = states.find(owner);
+    const GameSession::Alliance owner_team = shooter != NULL ? shooter->team : GameSession::NONE;
+    const Node_Span players = nodes.get_neighbors(projectiles.node_id[slot]);
+    for (Node_Span::size_type i = 0; i < players.size(); i++) {
         const tank_ptr player = players[i];
-        if (!player->is_alive() || player->get_id() == projectile->owner
-                || player->is_allied(projectile->owner)) {
+        const Tank_State *state = states.find(player->get_id());
+        if (state == NULL || !state->alive || state->id == owner
+                || (owner_team != GameSession::NONE && state->team == owner_team)) {
             continue;
         }
 
-        if (Utility::projectile_collision(projectile, player)) {
+        Position_Record seen;
+        if (!get_rewound_state(*state, rewind, seen)) {
+            continue;
+        }
+
+        // A tank killed earlier this tick is still alive in the published states.
+        if (Utility::tank_projectile_collision(circle, radius, seen.position, seen.angle)
+                && player->is_alive()) {
+			const tank_ptr owner_tank = Players::get_player(owner);
+			const Active_Projectile projectile = get_projectile(slot);
+			const EnvironmentProperty *env = get_weapon(projectile).projectile.environment_property;
+
 			inflict_damage(player, projectile, owner_tank, damageable_objects);
 			if (env != NULL && env->spawn_on_player_hit) {
 				const int id = environment.spawn(env, owner_tank->get_team(),
-					projectile->position, owner_tank->get_id());
+					projectile.position, owner_tank->get_id());
 				
 				if (id >= 0) {
-					Notifier::blanket_notify_spawn_env_effect(id, env->id,
-						owner_tank->get_id(), projectile->position);
+					Notifier::broadcast_spawn_env_effect(id, env->id,
+						owner_tank, projectile.position);
 				}
 			}
 
@@ -526,9 +570,14 @@ bool Projectile_Manager::perform_collision_check(
         }
     }
 
+	if (damageable_objects.empty()) {
+		return false;
+	}
+
 	// Now check if any damageable objects have been hit.
 	// TODO: This is currently a O(n^2) operation (considering all projectiles).
 	//       This can be reduced if we use the node manager.
+	const tank_ptr owner_tank = Players::get_player(owner);
 	damageable_map::iterator i;
 	for (i = damageable_objects.begin(); i != damageable_objects.end(); ++i) {
 		Damageable_Object *object = i->second;
@@ -538,15 +587,18 @@ bool Projectile_Manager::perform_collision_check(
 			continue;
 		}
 
-		if (Utility::projectile_collision(projectile, object->get_position(), object->get_radius())) {
+		if (Utility::projectile_collision(circle, radius, object->get_position(), object->get_radius())) {
+			const Active_Projectile projectile = get_projectile(slot);
+			const EnvironmentProperty *env = get_weapon(projectile).projectile.environment_property;
+
 			inflict_damage(object, projectile, owner_tank, damageable_objects);
 			if (env != NULL && env->spawn_on_wall_hit) {
 				const int id = environment.spawn(env, owner_tank->get_team(),
-					projectile->position, owner_tank->get_id());
+					projectile.position, owner_tank->get_id());
 				
 				if (id >= 0) {
-					Notifier::blanket_notify_spawn_env_effect(id, env->id,
-						owner_tank->get_id(), projectile->position);
+					Notifier::broadcast_spawn_env_effect(id, env->id,
+						owner_tank, projectile.position);
 				}
 			}
 
@@ -562,159 +614,146 @@ projectile_array Projectile_Manager::get_projectiles()
 	boost::lock_guard<boost::mutex> guard(mutex);
 
 	projectile_array projectile_list;
-	std::map<int, projectile_ptr>::iterator i;
-    for (i = projectiles.begin(); i != projectiles.end(); i++) {
-		projectile_list.push_back(i->second);
+	projectile_list.reserve(projectiles.size());
+    for (Projectile_Pool::size_type i = 0; i < projectiles.size(); i++) {
+		projectile_list.push_back(get_projectile(i));
 	}
 
 	return projectile_list;
 }
 
-bool Projectile_Manager::do_projectile_calculations(
-    const projectile_ptr &projectile, double delta_time)
+std::size_t Projectile_Manager::get_projectile_count()
 {
-    const Weapon weapon_data = projectile->type;
-    const Projectile projectile_data = weapon_data.projectile;
-	EnvironmentProperty *env = projectile_data.environment_property;
-    
-    if (projectile_data.is_instantaneous) {
-        // Immediately take care of this calculation.
-        try {
-		    const tank_ptr owner_tank = Players::tanks.get(projectile->owner);
+	boost::lock_guard<boost::mutex> guard(mutex);
 
-		    handle_instant_weapon(owner_tank, projectile, damageable_objects);
-	    }
-	    catch (const TankNotExistException &) {
-	    }
+	return projectiles.size();
+}
 
-		return false;
-    }
-	else if (weapon_data.launch_angle > 0.0f) {
-		// The weapon is angled.
-		// Find the current (x, y, z) position of the projectile.
-		const double time_elapsed = static_cast<double>(projectile->millisecondsAlive) / 1000.0;
-		const Vector3 tip = projectile->tip;
-		const Vector3 velocity = projectile->velocity_component;
-		const double x = projectile->origin.x + tip.x + (velocity.x * time_elapsed);
-		const double y = projectile->origin.y + tip.y + (velocity.y * time_elapsed);
-		const double z = tip.z + (velocity.z * time_elapsed) + (0.5 * GRAVITY * time_elapsed * time_elapsed);
-		projectile->position.x = x;
-		projectile->position.y = y;
-		
-		if (z <= 0.0) {
-			// The projectile has hit the ground.
-			try {
-				const tank_ptr owner = Players::tanks.get(projectile->owner);
-				handle_aoe_weapon(owner, projectile, damageable_objects);
-
-				if (env != NULL && env->spawn_on_wall_hit) {
-					const int id = environment.spawn(env, owner->get_team(),
-						projectile->position, owner->get_id());
-					
-					if (id >= 0) {
-						Notifier::blanket_notify_spawn_env_effect(id, env->id,
-							owner->get_id(), projectile->position);
-					}
+std::size_t Projectile_Manager::get_effect_count()
+{
+	boost::lock_guard<boost::mutex> guard(mutex);
+
+	return static_cast<std::size_t>(environment.size());
+}
+
+std::vector<environment_effect_ptr> Projectile_Manager::get_effects()
+{
+	boost::lock_guard<boost::mutex> guard(mutex);
+
+	std::vector<environment_effect_ptr> effect_list;
+	environment.get_effects(effect_list);
+
+	return effect_list;
+}
+
+bool Projectile_Manager::do_projectile_calculations(const Projectile_Pool::size_type slot)
+{
+	if (!projectiles.is_arcing(slot)) {
+		return true;
+	}
+
+	// The weapon is angled. Its (x, y, z) position has been found by the pool.
+	const double x = projectiles.x[slot];
+	const double y = projectiles.y[slot];
+	const double z = projectiles.z[slot];
+	
+	if (z <= 0.0) {
+		// The projectile has hit the ground.
+		try {
+			const tank_ptr owner = Players::get_tank_manager()->get(projectiles.owner[slot]);
+			const Active_Projectile projectile = get_projectile(slot);
+			const EnvironmentProperty *env = get_weapon(projectile).projectile.environment_property;
+			handle_aoe_weapon(owner, projectile, damageable_objects);
+
+			if (env != NULL && env->spawn_on_wall_hit) {
+				const int id = environment.spawn(env, owner->get_team(),
+					projectile.position, owner->get_id());
+				
+				if (id >= 0) {
+					Notifier::broadcast_spawn_env_effect(id, env->id,
+						owner, projectile.position);
 				}
 			}
-			catch (const TankNotExistException &) {}
-
-			return false;
 		}
-		
-		// Check to see if it hit a wall.
-		const Map *current_map = MapManager::get_current_map();
-		const int tile_x = Utility::round(x / TILE_SIZE);
-		const int tile_y = Utility::round(-y / TILE_SIZE);
-		
-		if (tile_x >= 0 && tile_x < current_map->get_width() && 
-				tile_y >= 0 && tile_y < current_map->get_height()) {
-			const Tile tile = MapManager::get_current_map()->get_tile(tile_x, tile_y);
-			if (tile.height > 0) {
-				const double tile_height = tile.height * TILE_SIZE;
-				if (z <= tile_height) {
-					// It has collided with the tile that it's on.
-					if (z < TILE_SIZE) {
-						// Do AOE damage if it's near the floor.
-						try {
-							const tank_ptr owner = Players::tanks.get(projectile->owner);
-							handle_aoe_weapon(owner, projectile, damageable_objects);
-						}
-						catch (const TankNotExistException &) {}
-
-						return false;
-					}
-					else {
-						// It does not do AOE damage, but it still hit the wall.
-						return false;
+		catch (const TankNotExistException &) {}
+
+		return false;
+	}
+	
+	// Check to see if it hit a wall.
+	const Map *current_map = MapManager::get_current_map();
+	const int tile_x = Utility::round(x / TILE_SIZE);
+	const int tile_y = Utility::round(-y / TILE_SIZE);
+	
+	if (tile_x >= 0 && tile_x < current_map->get_width() && 
+			tile_y >= 0 && tile_y < current_map->get_height()) {
+		const Tile tile = current_map->get_tile(tile_x, tile_y);
+		if (tile.height > 0) {
+			const double tile_height = tile.height * TILE_SIZE;
+			if (z <= tile_height) {
+				// It has collided with the tile that it's on.
+				if (z < TILE_SIZE) {
+					// Do AOE damage if it's near the floor.
+					try {
+						const tank_ptr owner =
+							Players::get_tank_manager()->get(projectiles.owner[slot]);
+						handle_aoe_weapon(owner, get_projectile(slot), damageable_objects);
 					}
+					catch (const TankNotExistException &) {}
+
+					return false;
+				}
+				else {
+					// It does not do AOE damage, but it still hit the wall.
+					return false;
 				}
 			}
 		}
 	}
-    else {
-        if (projectile_data.initial_velocity != projectile_data.terminal_velocity) {
-            // The projectile accelerates.
-            if (abs(projectile_data.terminal_velocity - projectile->velocity) > 0.001) {
-                // Projectile has not reached terminal velocity.
-                const double acceleration = projectile_data.acceleration;
-				
-                // dv = a * dt
-                projectile->velocity += acceleration * delta_time;
-                if (projectile->velocity > projectile_data.terminal_velocity) {
-                    projectile->velocity = projectile_data.terminal_velocity;
-                }
-            }
-        }
-        
-        const double angle = projectile->angle;
-        projectile->position.x += cos(angle) * (projectile->velocity * delta_time);
-        projectile->position.y += sin(angle) * (projectile->velocity * delta_time);
-    }
 
 	return true;
 }
 
-void Projectile_Manager::do_initial_calculations(const projectile_ptr &projectile)
+void Projectile_Manager::do_initial_calculations(Active_Projectile &projectile)
 {
-    const Weapon weapon_data = projectile->type;
-    const Projectile projectile_data = weapon_data.projectile;
+    const Weapon &weapon_data = get_weapon(projectile);
+    const Projectile &projectile_data = weapon_data.projectile;
     try {
-        const tank_ptr owner = Players::tanks.get(projectile->owner);
+        const tank_ptr owner = Players::get_tank_manager()->get(projectile.owner);
         
 		// Find the maximum point where the projectile could land (for cone calculations).
-		const VTankObject::Point target = projectile->target;
+		const VTankObject::Point target = projectile.target;
 		VTankObject::Point max_point;
-		max_point.x = target.x + cos(projectile->angle) * projectile_data.range;
-		max_point.y = target.y + sin(projectile->angle) * projectile_data.range;
+		max_point.x = target.x + cos(projectile.angle) * projectile_data.range;
+		max_point.y = target.y + sin(projectile.angle) * projectile_data.range;
 		
         if (projectile_data.cone_radius > 0 && !projectile_data.cone_damage_full_area) {
             // The projectile fires with some variance.
 			const float cone_radius = RADIANS_F(projectile_data.cone_radius);
             const double variance = random_next_f(0.0f, cone_radius * 2.0f) - cone_radius;
-			const double new_angle = projectile->angle + variance;
+			const double new_angle = projectile.angle + variance;
 			
 			VTankObject::Point new_target;
-			new_target.x = projectile->position.x + projectile_data.range * cos(new_angle);
-			new_target.y = projectile->position.y + projectile_data.range * sin(new_angle);
+			new_target.x = projectile.position.x + projectile_data.range * cos(new_angle);
+			new_target.y = projectile.position.y + projectile_data.range * sin(new_angle);
 			//new_target.x = max_point.x + cos(new_angle) * projectile_data.cone_radius;
 			//new_target.y = max_point.y + sin(new_angle) * projectile_data.cone_radius;
 			
-			projectile->angle = new_angle;
-			projectile->target = new_target;
+			projectile.angle = new_angle;
+			projectile.target = new_target;
         }
 
 		if (projectile_data.range_variation > 0) {
 			const int new_range = random_next(projectile_data.range,
 				projectile_data.range + projectile_data.range_variation);
 			const double difference = new_range - projectile_data.range;
-			projectile->target.x = projectile->target.x + cos(projectile->angle) * difference;
-			projectile->target.y = projectile->target.y + sin(projectile->angle) * difference;
+			projectile.target.x = projectile.target.x + cos(projectile.angle) * difference;
+			projectile.target.y = projectile.target.y + sin(projectile.angle) * difference;
 		}
 
         const float damage_factor = owner->get_damage_factor();
-	    const int min_damage = projectile->type.projectile.minimum_damage;
-	    const int max_damage = projectile->type.projectile.maximum_damage;
+	    const int min_damage = projectile_data.minimum_damage;
+	    const int max_damage = projectile_data.maximum_damage;
 	    float actual_damage = static_cast<float>(random_next(min_damage, max_damage));
     	
 	    try {
@@ -735,21 +774,21 @@ void Projectile_Manager::do_initial_calculations(const projectile_ptr &projectil
 		    charge->stop_charging();
 	    }
 
-        projectile->damage = raw_damage;
+        projectile.damage = raw_damage;
 
 		if (weapon_data.launch_angle > 0.0f) {
 			// The weapon fires at an angle.
 			const float DEFAULT_CANNON_LENGTH = 60.0f;
 			
 			float distance = static_cast<float>(sqrt(
-				pow(projectile->target.y - projectile->origin.y, 2) + 
-				pow(projectile->target.x - projectile->origin.x, 2)));
+				pow(projectile.target.y - projectile.origin.y, 2) + 
+				pow(projectile.target.x - projectile.origin.x, 2)));
 			const float max_distance = static_cast<float>(projectile_data.range);
 			if (distance > max_distance)
 				distance = max_distance;
 			
 			const float tilt_angle = weapon_data.launch_angle;
-			const float swivel_angle = static_cast<float>(projectile->angle);
+			const float swivel_angle = static_cast<float>(projectile.angle);
 
 			float projection, tipX, tipY, tipZ;
 			projection = DEFAULT_CANNON_LENGTH * cos(tilt_angle);
@@ -757,7 +796,7 @@ void Projectile_Manager::do_initial_calculations(const projectile_ptr &projectil
 			tipY = -projection * sin(swivel_angle);
 			tipZ = abs(DEFAULT_CANNON_LENGTH * sin(swivel_angle));
 			
-			projectile->tip = Vector3(tipX, tipY, tipZ);
+			projectile.tip = Vector3(tipX, tipY, tipZ);
 			
 			// TODO: Work-around. Figure out missing velocity component.
 			float offset = 1.1f;
@@ -770,7 +809,7 @@ void Projectile_Manager::do_initial_calculations(const projectile_ptr &projectil
 			component_velocity.y = (muzzle_velocity) * cos(tilt_angle) * sin(swivel_angle);
 			component_velocity.z = muzzle_velocity * sin(tilt_angle);
 
-			projectile->velocity_component = component_velocity;
+			projectile.velocity_component = component_velocity;
 		}
 		
 		
@@ -8,9 +8,12 @@
 
 #include <player.hpp>
 #include <projectile.hpp>
+#include <projectilepool.hpp>
+#include <slotallocator.hpp>
 #include <nodemanager.hpp>
 #include <damageableobject.hpp>
 #include <environmentmanager.hpp>
+#include <tankstate.hpp>
 
 //! Define how far away a projectile spawns from a tank position.
 #define PROJECTILE_SPAWN_OFFSET 50.0f
@@ -22,7 +25,9 @@ class Projectile_Manager
 {
 private:
     boost::mutex mutex;
-    std::map<int, projectile_ptr> projectiles;
+    Projectile_Pool projectiles;
+    projectile_array instant_projectiles;
+    Slot_Allocator projectile_ids;
     damageable_map damageable_objects;
 	Environment_Manager environment;
 	// TODO: Environment manager doesn't make sense here. We only keep it here because
@@ -30,29 +35,37 @@ private:
 	// somewhere else.
 
     /*!
-        Generate a unique projectile ID.
-        \return Generated ID number.
+        Remove a projectile from the pool and release its ID.
+        \param slot Slot of the projectile.
     */
-    int generate_projectile_id();
+    void remove_projectile(const Projectile_Pool::size_type);
 
 	/*!
-		Actual remove procedure.
+		Copy a projectile out of the pool.
+		\param slot Slot of the projectile.
 	*/
-	bool do_remove(const int &);
+	Active_Projectile get_projectile(const Projectile_Pool::size_type) const;
 
     /*!
         Perform a collision check on a single projectile.
-        \param id Projectile ID.
-        \param projectile Projectile to check.
+        \param nodes Node manager to find nearby players with.
+        \param states Tank states published at the end of the last tick.
+        \param slot Slot of the projectile to check.
         \return True if the projectile collided with a player.
     */
-    bool perform_collision_check(NodeManager &, const projectile_ptr);
+    bool perform_collision_check(NodeManager &, const Tank_State_Buffer::Reader &,
+        const Projectile_Pool::size_type);
     
     //! Do on-fire calculations (i.e. applying variance).
-    void do_initial_calculations(const projectile_ptr &projectile);
+    void do_initial_calculations(Active_Projectile &projectile);
     
-    //! Do projectile delta calculations.
-    bool do_projectile_calculations(const projectile_ptr &, double);
+    /*!
+        Check whether an arcing projectile has come down. Movement itself is done for
+        every projectile at once by Projectile_Pool::integrate().
+        \param slot Slot of the projectile.
+        \return False if the projectile is finished and should be removed.
+    */
+    bool do_projectile_calculations(const Projectile_Pool::size_type);
 
 public:
     Projectile_Manager();
@@ -64,12 +77,14 @@ public:
         \param angle Angle that the projectile is moving towards.
         \param position Position of the projectile.
 		\param target Where the projectile is heading towards.
-        \param type Type of projectile that has been fired.
+        \param type Index of the weapon that fired it in the weapon table.
 		\param new_target New target of the projectile.
+		\param rewind Ticks to rewind the targets by when checking what it hits (see
+		Lag_Compensation). Only instant and fast projectiles are rewound.
    */
    int add(const int &, const double &, 
-       const VTankObject::Point &, const VTankObject::Point &, const Weapon &,
-	   VTankObject::Point &new_target = VTankObject::Point());
+       const VTankObject::Point &, const VTankObject::Point &, const weapon_type_index,
+	   VTankObject::Point &new_target = VTankObject::Point(), const double rewind = 0);
 
    /*!
         Clears all data to a clean slate.
@@ -81,7 +96,7 @@ public:
         \param id ID of the projectile to look for.
         \return Copy of the Active_Projectile object.
    */
-   projectile_ptr get(const int &);
+   Active_Projectile get(const int &);
 
    /*!
         Remove a projectile from the manager.
@@ -100,10 +115,19 @@ public:
 
 	/*!
 		Get a list of projectiles that are stored in this manager.
-		\return Array list of projectiles.
+		\return Array list of copies of the projectiles.
 	*/
 	projectile_array get_projectiles();
 
+	//! Get the number of projectiles in flight.
+	std::size_t get_projectile_count();
+
+	//! Get the number of environment effects on the ground.
+	std::size_t get_effect_count();
+
+	//! Get the environment effects on the ground.
+	std::vector<environment_effect_ptr> get_effects();
+
 	/*!
 		Add a damageable object to consideration to the projectile manager. This object
 		is expected to react to being damaged of it's own implementation.
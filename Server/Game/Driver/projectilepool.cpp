@@ -0,0 +1,243 @@
+/*!
+    \file   projectilepool.cpp
+    \brief  Implements the Projectile_Pool class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <projectilepool.hpp>
+#include <vtassert.hpp>
+
+Projectile_Pool::Projectile_Pool()
+    : linear_count(0)
+{
+}
+
+void Projectile_Pool::move(const size_type from, const size_type to)
+{
+    id[to] = id[from];
+    owner[to] = owner[from];
+    weapon[to] = weapon[from];
+    node_id[to] = node_id[from];
+    damage[to] = damage[from];
+    radius[to] = radius[from];
+    rewind[to] = rewind[from];
+    x[to] = x[from];
+    y[to] = y[from];
+    angle[to] = angle[from];
+    dir_x[to] = dir_x[from];
+    dir_y[to] = dir_y[from];
+    speed[to] = speed[from];
+    acceleration[to] = acceleration[from];
+    terminal_speed[to] = terminal_speed[from];
+    start_x[to] = start_x[from];
+    start_y[to] = start_y[from];
+    start_z[to] = start_z[from];
+    velocity_x[to] = velocity_x[from];
+    velocity_y[to] = velocity_y[from];
+    velocity_z[to] = velocity_z[from];
+    z[to] = z[from];
+    age[to] = age[from];
+    lifetime[to] = lifetime[from];
+}
+
+void Projectile_Pool::push_slot()
+{
+    id.push_back(-1);
+    owner.push_back(-1);
+    weapon.push_back(0);
+    node_id.push_back(-1);
+    damage.push_back(0);
+    radius.push_back(0);
+    rewind.push_back(0);
+    x.push_back(0);
+    y.push_back(0);
+    angle.push_back(0);
+    dir_x.push_back(0);
+    dir_y.push_back(0);
+    speed.push_back(0);
+    acceleration.push_back(0);
+    terminal_speed.push_back(0);
+    start_x.push_back(0);
+    start_y.push_back(0);
+    start_z.push_back(0);
+    velocity_x.push_back(0);
+    velocity_y.push_back(0);
+    velocity_z.push_back(0);
+    z.push_back(0);
+    age.push_back(0);
+    lifetime.push_back(0);
+}
+
+void Projectile_Pool::pop_slot()
+{
+    id.pop_back();
+    owner.pop_back();
+    weapon.pop_back();
+    node_id.pop_back();
+    damage.pop_back();
+    radius.pop_back();
+    rewind.pop_back();
+    x.pop_back();
+    y.pop_back();
+    angle.pop_back();
+    dir_x.pop_back();
+    dir_y.pop_back();
+    speed.pop_back();
+    acceleration.pop_back();
+    terminal_speed.pop_back();
+    start_x.pop_back();
+    start_y.pop_back();
+    start_z.pop_back();
+    velocity_x.pop_back();
+    velocity_y.pop_back();
+    velocity_z.pop_back();
+    z.pop_back();
+    age.pop_back();
+    lifetime.pop_back();
+}
+
+Projectile_Pool::size_type Projectile_Pool::add(const Active_Projectile &projectile,
+                                                const Weapon &type)
+{
+    const bool arcing = type.launch_angle > 0.0f;
+
+    // Linear shots go at the end of their block; the first arcing shot moves aside for it.
+    push_slot();
+    size_type slot = size() - 1;
+    if (!arcing) {
+        if (slot != linear_count) {
+            move(linear_count, slot);
+            slot = linear_count;
+        }
+        ++linear_count;
+    }
+
+    id[slot] = projectile.id;
+    owner[slot] = projectile.owner;
+    weapon[slot] = projectile.weapon;
+    node_id[slot] = projectile.node_id;
+    damage[slot] = projectile.damage;
+    radius[slot] = type.projectile.collision_radius;
+    rewind[slot] = projectile.rewind;
+    x[slot] = projectile.position.x;
+    y[slot] = projectile.position.y;
+    angle[slot] = projectile.angle;
+    dir_x[slot] = cos(projectile.angle);
+    dir_y[slot] = sin(projectile.angle);
+    age[slot] = 0;
+
+    if (arcing) {
+        start_x[slot] = projectile.origin.x + projectile.tip.x;
+        start_y[slot] = projectile.origin.y + projectile.tip.y;
+        start_z[slot] = projectile.tip.z;
+        velocity_x[slot] = projectile.velocity_component.x;
+        velocity_y[slot] = projectile.velocity_component.y;
+        velocity_z[slot] = projectile.velocity_component.z;
+        z[slot] = projectile.tip.z;
+        speed[slot] = 0;
+        acceleration[slot] = 0;
+        terminal_speed[slot] = 0;
+        lifetime[slot] = 0;
+    }
+    else {
+        const Projectile &data = type.projectile;
+        speed[slot] = data.initial_velocity;
+        acceleration[slot] = data.initial_velocity != data.terminal_velocity ? data.acceleration : 0.0;
+        terminal_speed[slot] = data.terminal_velocity;
+        start_x[slot] = 0;
+        start_y[slot] = 0;
+        start_z[slot] = 0;
+        velocity_x[slot] = 0;
+        velocity_y[slot] = 0;
+        velocity_z[slot] = 0;
+        z[slot] = 0;
+        lifetime[slot] = Active_Projectile::get_lifetime(type);
+    }
+
+    return slot;
+}
+
+void Projectile_Pool::remove(const size_type slot)
+{
+    VTANK_ASSERT(slot < size());
+
+    const size_type last = size() - 1;
+    if (slot < linear_count) {
+        // Fill the hole from the end of the linear block, then move the last arcing
+        // shot into the slot that block just gave up.
+        const size_type last_linear = linear_count - 1;
+        if (slot != last_linear) {
+            move(last_linear, slot);
+        }
+        if (last_linear != last) {
+            move(last, last_linear);
+        }
+        --linear_count;
+    }
+    else if (slot != last) {
+        move(last, slot);
+    }
+
+    pop_slot();
+}
+
+void Projectile_Pool::clear()
+{
+    while (!empty()) {
+        pop_slot();
+    }
+    linear_count = 0;
+}
+
+Projectile_Pool::size_type Projectile_Pool::find(const int projectile_id) const
+{
+    const std::vector<int>::const_iterator i = std::find(id.begin(), id.end(), projectile_id);
+    return static_cast<size_type>(i - id.begin());
+}
+
+void Projectile_Pool::integrate(const double delta_time)
+{
+    const size_type count = size();
+    if (count == 0) {
+        return;
+    }
+
+    double *const px = &x[0];
+    double *const py = &y[0];
+    double *const pz = &z[0];
+    long *const page = &age[0];
+
+    // Straight and accelerating shots: dv = a * dt, clamped at terminal velocity, then
+    // a step along the heading worked out when they were fired.
+    const double *const pdir_x = &dir_x[0];
+    const double *const pdir_y = &dir_y[0];
+    const double *const pacceleration = &acceleration[0];
+    const double *const pterminal = &terminal_speed[0];
+    double *const pspeed = &speed[0];
+    for (size_type i = 0; i < linear_count; ++i) {
+        const double v = pspeed[i] + pacceleration[i] * delta_time;
+        const double clamped = pacceleration[i] >= 0.0 ? std::min(v, pterminal[i]) : std::max(v, pterminal[i]);
+        pspeed[i] = clamped;
+        px[i] += pdir_x[i] * clamped * delta_time;
+        py[i] += pdir_y[i] * clamped * delta_time;
+    }
+
+    // Arcing shots: position for their age, before this step is added to it.
+    const double *const pstart_x = &start_x[0];
+    const double *const pstart_y = &start_y[0];
+    const double *const pstart_z = &start_z[0];
+    const double *const pvelocity_x = &velocity_x[0];
+    const double *const pvelocity_y = &velocity_y[0];
+    const double *const pvelocity_z = &velocity_z[0];
+    for (size_type i = linear_count; i < count; ++i) {
+        const double t = static_cast<double>(page[i]) / 1000.0;
+        px[i] = pstart_x[i] + pvelocity_x[i] * t;
+        py[i] = pstart_y[i] + pvelocity_y[i] * t;
+        pz[i] = pstart_z[i] + pvelocity_z[i] * t + 0.5 * GRAVITY * t * t;
+    }
+
+    const long delta_ms = static_cast<long>(delta_time * 1000.0);
+    for (size_type i = 0; i < count; ++i) {
+        page[i] += delta_ms;
+    }
+}
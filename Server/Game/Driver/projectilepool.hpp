@@ -0,0 +1,131 @@
+/*!
+    \file   projectilepool.hpp
+    \brief  Declares the Projectile_Pool class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef PROJECTILEPOOL_HPP
+#define PROJECTILEPOOL_HPP
+
+#include <projectile.hpp>
+
+/*!
+    Dense storage for projectiles in flight, kept as one array per attribute so that
+    moving every projectile is a handful of tight loops over contiguous memory.
+
+    Straight and accelerating shots occupy slots [0, get_linear_count()) and arcing
+    shots follow them, so each kind of motion is integrated by its own loop without
+    branching. remove() moves other projectiles into the freed slot, so slot numbers
+    are only good until the next add() or remove(); projectiles are found by ID.
+
+    The columns are public for reading and for the manager's bookkeeping (node IDs),
+    but only add(), remove() and clear() may change their length.
+*/
+class Projectile_Pool
+{
+public:
+    typedef std::vector<int>::size_type size_type;
+
+    std::vector<int> id;
+    std::vector<int> owner;
+    std::vector<weapon_type_index> weapon; //!< Index into the weapon table.
+    std::vector<int> node_id;
+    std::vector<float> damage;
+    std::vector<float> radius;          //!< Collision radius.
+    std::vector<double> rewind;         //!< Ticks the targets are rewound by.
+
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> angle;
+    std::vector<double> dir_x;          //!< cos(angle), computed once when fired.
+    std::vector<double> dir_y;          //!< sin(angle), computed once when fired.
+
+    // Straight and accelerating shots. Straight shots have no acceleration.
+    std::vector<double> speed;
+    std::vector<double> acceleration;
+    std::vector<double> terminal_speed;
+
+    // Arcing shots follow a closed form from where they left the cannon.
+    std::vector<double> start_x;
+    std::vector<double> start_y;
+    std::vector<double> start_z;
+    std::vector<double> velocity_x;
+    std::vector<double> velocity_y;
+    std::vector<double> velocity_z;
+    std::vector<double> z;              //!< Height; zero for straight shots.
+
+    std::vector<long> age;              //!< Milliseconds alive.
+    std::vector<long> lifetime;         //!< Milliseconds until it expires.
+
+private:
+    size_type linear_count;
+
+    //! Copy every attribute of one slot over another.
+    void move(const size_type, const size_type);
+
+    //! Grow every column by one slot.
+    void push_slot();
+
+    //! Shrink every column by one slot.
+    void pop_slot();
+
+public:
+    Projectile_Pool();
+
+    /*!
+        Add a projectile that has just been fired.
+        \param projectile Projectile with its type, damage and (for arcing shots) launch
+        vectors already worked out.
+        \param type Weapon the projectile's index refers to.
+        \return Slot the projectile was placed in.
+    */
+    size_type add(const Active_Projectile &, const Weapon &);
+
+    /*!
+        Remove the projectile in a slot. The last projectile of the same kind of
+        motion is moved into the freed slot, so a loop removing as it goes should
+        look at the same slot again.
+        \param slot Slot to free.
+    */
+    void remove(const size_type);
+
+    //! Remove every projectile.
+    void clear();
+
+    /*!
+        Find the slot of a projectile.
+        \param projectile_id ID of the projectile.
+        \return Its slot, or size() if it isn't in the pool.
+    */
+    size_type find(const int) const;
+
+    /*!
+        Move every projectile forward by some time and age it. Arcing shots are
+        placed for their age at the start of the step, as they always have been.
+        \param delta_time Seconds since the last step.
+    */
+    void integrate(const double);
+
+    /*!
+        Check whether a projectile has outlived its range. Arcing shots never expire;
+        they come down instead.
+        \param slot Slot to check.
+    */
+    bool expired(const size_type slot) const
+    {
+        return slot < linear_count && age[slot] >= lifetime[slot];
+    }
+
+    //! Check whether the projectile in a slot is an arcing shot.
+    bool is_arcing(const size_type slot) const { return slot >= linear_count; }
+
+    //! Number of straight and accelerating shots, which come first.
+    size_type get_linear_count() const { return linear_count; }
+
+    //! Number of projectiles in the pool.
+    size_type size() const { return id.size(); }
+
+    //! Check whether the pool holds no projectiles.
+    bool empty() const { return id.empty(); }
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*!
+    \file   ratelimiter.hpp
+    \brief  Lock-free fixed-window rate limiter.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef RATELIMITER_HPP
+#define RATELIMITER_HPP
+
+#include <atomic.hpp>
+
+/*!
+    Allows at most a fixed number of actions per one-second window. The check is
+    lock-free, so it can be done on Ice dispatch threads. When two threads cross a
+    window boundary together a few extra actions may slip through, which is acceptable
+    for flood protection.
+*/
+class Rate_Limiter
+{
+private:
+    const long limit;
+    volatile long window;
+    volatile long count;
+
+public:
+    /*!
+        Create a rate limiter.
+        \param actions_per_second Maximum number of actions allowed per second.
+    */
+    explicit Rate_Limiter(const long actions_per_second)
+        : limit(actions_per_second), window(0), count(0)
+    {
+    }
+
+    /*!
+        Attempt to perform an action.
+        \param now_ms Current time in milliseconds.
+        \return True if the action is allowed; false if the limit has been reached.
+    */
+    bool try_acquire(const Ice::Long now_ms)
+    {
+        const long current_window = static_cast<long>(now_ms / 1000);
+        const long last_window = Atomic::load(window);
+        if (last_window != current_window) {
+            if (Atomic::compare_and_swap(window, last_window, current_window) == last_window) {
+                Atomic::store(count, 0);
+            }
+        }
+
+        return Atomic::increment(count) <= limit;
+    }
+};
+
+#endif
@@ -0,0 +1,131 @@
+/*!
+    \file   ringbuffer.hpp
+    \brief  Bounded, lock-free, multiple-producer/single-consumer ring buffer.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef RINGBUFFER_HPP
+#define RINGBUFFER_HPP
+
+#include <atomic.hpp>
+#include <vtassert.hpp>
+
+/*!
+    Fixed-size queue which any number of threads may push onto while one thread pops.
+    Every slot is allocated up front, so neither push() nor pop() allocates or locks.
+    Each slot carries a sequence number telling producers and the consumer whether it
+    is free or filled (see Dmitry Vyukov's bounded queue). Items are copied in and out,
+    so T should be a small POD type.
+*/
+template <typename T>
+class Ring_Buffer
+{
+private:
+    struct Cell
+    {
+        volatile long sequence;
+        T data;
+    };
+
+    Cell *cells;
+    const long mask;
+
+    //! Position of the next slot to write. Shared between producers.
+    volatile long enqueue_position;
+
+    //! Position of the next slot to read. Only touched by the consumer.
+    long dequeue_position;
+
+    // Not copyable.
+    Ring_Buffer(const Ring_Buffer &);
+    Ring_Buffer &operator=(const Ring_Buffer &);
+
+    //! Signed distance between two sequence numbers.
+    static long distance(const long sequence, const long position)
+    {
+        return static_cast<long>(
+            static_cast<unsigned long>(sequence) - static_cast<unsigned long>(position));
+    }
+
+public:
+    /*!
+        Allocate the ring.
+        \param capacity Number of slots. Must be a power of two.
+    */
+    explicit Ring_Buffer(const long capacity)
+        : cells(new Cell[capacity]), mask(capacity - 1), enqueue_position(0), 
+        dequeue_position(0)
+    {
+        VTANK_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+
+        for (long i = 0; i < capacity; ++i) {
+            cells[i].sequence = i;
+        }
+        Atomic::memory_barrier();
+    }
+
+    ~Ring_Buffer()
+    {
+        delete [] cells;
+    }
+
+    //! Get the number of slots in the ring.
+    long capacity() const
+    {
+        return mask + 1;
+    }
+
+    /*!
+        Push an item onto the ring. Safe to call from any thread.
+        \param item Item to copy into the ring.
+        \return True if the item was queued; false if the ring is full.
+    */
+    bool push(const T &item)
+    {
+        long position = Atomic::load(enqueue_position);
+        for (;;) {
+            Cell &cell = cells[position & mask];
+            const long difference = distance(Atomic::load(cell.sequence), position);
+            if (difference == 0) {
+                // Slot is free: try to claim it.
+                const long next = Atomic::wrapping_add(position, 1);
+                if (Atomic::compare_and_swap(enqueue_position, position, next) == position) {
+                    cell.data = item;
+                    Atomic::store(cell.sequence, next);
+                    return true;
+                }
+                position = Atomic::load(enqueue_position);
+            }
+            else if (difference < 0) {
+                // The consumer has not freed this slot yet: the ring is full.
+                return false;
+            }
+            else {
+                // Another producer claimed the slot first.
+                position = Atomic::load(enqueue_position);
+            }
+        }
+    }
+
+    /*!
+        Pop an item off of the ring. Only one thread may call this.
+        \param item [out] Storage for the popped item. Untouched if the ring is empty.
+        \return True if an item was popped; false if the ring is empty.
+    */
+    bool pop(T &item)
+    {
+        Cell &cell = cells[dequeue_position & mask];
+        const long next = Atomic::wrapping_add(dequeue_position, 1);
+        if (distance(Atomic::load(cell.sequence), next) < 0) {
+            // Nothing has been published to this slot yet.
+            return false;
+        }
+
+        item = cell.data;
+        Atomic::store(cell.sequence, Atomic::wrapping_add(dequeue_position, mask + 1));
+        dequeue_position = next;
+
+        return true;
+    }
+};
+
+#endif
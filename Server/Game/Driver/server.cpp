@@ -13,6 +13,9 @@
 #include <mapmanager.hpp>
 #include <playermanager.hpp>
 #include <gamemanager.hpp>
+#include <gameinstance.hpp>
+#include <clocksync.hpp>
+#include <statisticsupload.hpp>
 
 namespace Server {
     // TODO: "Singleton"
@@ -62,9 +65,12 @@ namespace Server {
             adapter->activate();
 
 			MapManager::start();
-			MapManager::rotate();
-            Players::start_game();
-            Players::task_pool.schedule(boost::threadpool::looped_task_func(&Players::manage_players, 1000));
+            for (int i = 0; i < Arenas::count(); ++i) {
+                const Game_Instance::Scope scope(Arenas::get(i));
+                MapManager::rotate();
+                Players::start_game();
+            }
+            Players::task_pool.schedule(boost::threadpool::looped_task_func(&Arenas::manage_players, 1000));
 
             Logger::log(Logger::LOG_LEVEL_INFO, "The ServerService finished initializing.");
         }
@@ -135,7 +141,14 @@ namespace Server {
 
     void ServerService::stop()
     {
+        // Messages still waiting for players would only fail once Ice is down.
+        Outbound::sender_pool.clear();
+        Clock_Sync::stop();
+        Statistics_Upload::stop();
         communicator()->shutdown();
-        MapManager::shutdown();
+        for (int i = 0; i < Arenas::count(); ++i) {
+            const Game_Instance::Scope scope(Arenas::get(i));
+            MapManager::shutdown();
+        }
     }
 }
@@ -0,0 +1,83 @@
+/*!
+    \file   slotallocator.cpp
+    \brief  Implements the Slot_Allocator class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <slotallocator.hpp>
+
+namespace
+{
+    int make_id(const int index, const int generation)
+    {
+        return (index << Slot_Allocator::GENERATION_BITS) | generation;
+    }
+}
+
+Slot_Allocator::Slot_Allocator()
+    : live_count(0)
+{
+}
+
+int Slot_Allocator::allocate()
+{
+    int index;
+    if (!free_slots.empty()) {
+        index = free_slots.back();
+        free_slots.pop_back();
+    }
+    else {
+        index = static_cast<int>(generations.size());
+        if (index >= MAX_SLOTS) {
+            return -1;
+        }
+
+        generations.push_back(0);
+        live.push_back(false);
+    }
+
+    live[index] = true;
+    ++live_count;
+
+    return make_id(index, generations[index]);
+}
+
+bool Slot_Allocator::release(const int id)
+{
+    if (!is_valid(id)) {
+        return false;
+    }
+
+    const int index = get_index(id);
+    live[index] = false;
+    generations[index] = static_cast<unsigned char>((generations[index] + 1) & GENERATION_MASK);
+    free_slots.push_back(index);
+    --live_count;
+
+    return true;
+}
+
+void Slot_Allocator::clear()
+{
+    // Rebuild the free list so that the lowest slots are handed out first again.
+    free_slots.clear();
+    for (int index = capacity() - 1; index >= 0; --index) {
+        if (live[index]) {
+            live[index] = false;
+            generations[index] = static_cast<unsigned char>((generations[index] + 1) & GENERATION_MASK);
+        }
+        free_slots.push_back(index);
+    }
+
+    live_count = 0;
+}
+
+bool Slot_Allocator::is_valid(const int id) const
+{
+    if (id < 0) {
+        return false;
+    }
+
+    const int index = get_index(id);
+    return index < capacity() && live[index] && generations[index] == get_generation(id);
+}
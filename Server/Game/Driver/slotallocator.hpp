@@ -0,0 +1,79 @@
+/*!
+    \file   slotallocator.hpp
+    \brief  Declares the Slot_Allocator class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef SLOTALLOCATOR_HPP
+#define SLOTALLOCATOR_HPP
+
+/*!
+    Hands out ID numbers for short-lived game objects (projectiles, environment effects,
+    utilities) in constant time.
+
+    An ID is a slot index plus the generation of that slot. Released slots go on a free
+    list and are handed out again with their generation bumped, so the indices stay
+    small and dense while an ID which outlived its object (for example one still held
+    by a client) no longer compares equal to the new owner's ID and fails is_valid().
+
+    The generation lives in the low bits so that IDs of objects alive at the same time
+    stay close together, which keeps the delta-encoded IDs in snapshots short. IDs are
+    never negative, so -1 remains free to mean "no object".
+*/
+class Slot_Allocator
+{
+public:
+    //! Bits of the ID which hold the generation of the slot.
+    static const int GENERATION_BITS = 8;
+    static const int GENERATION_MASK = (1 << GENERATION_BITS) - 1;
+
+    //! Number of slots available before allocate() gives up.
+    static const int MAX_SLOTS = 0x7FFFFFFF >> GENERATION_BITS;
+
+private:
+    std::vector<unsigned char> generations;
+    std::vector<bool> live;
+    std::vector<int> free_slots;
+    int live_count;
+
+public:
+    Slot_Allocator();
+
+    /*!
+        Get an unused ID.
+        \return New ID, or -1 if every slot is taken.
+    */
+    int allocate();
+
+    /*!
+        Hand an ID back so that its slot can be reused.
+        \param id ID returned by allocate().
+        \return False if the ID was not live, in which case nothing changes.
+    */
+    bool release(const int id);
+
+    /*!
+        Release every live ID. Generations carry on, so IDs from before the call stay
+        stale afterwards.
+    */
+    void clear();
+
+    /*!
+        Check whether an ID is live, i.e. it was allocated and its slot has not been
+        released since.
+    */
+    bool is_valid(const int id) const;
+
+    //! Number of live IDs.
+    int size() const { return live_count; }
+
+    //! Number of slots ever created.
+    int capacity() const { return static_cast<int>(generations.size()); }
+
+    //! Slot part of an ID.
+    static int get_index(const int id) { return id >> GENERATION_BITS; }
+
+    //! Generation part of an ID.
+    static int get_generation(const int id) { return id & GENERATION_MASK; }
+};
+
+#endif
@@ -0,0 +1,646 @@
+/*!
+    \file   snapshot.cpp
+    \brief  Implements the snapshot codec.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <snapshot.hpp>
+#include <vtassert.hpp>
+
+//! How many snapshots sent to a client are remembered as possible baselines.
+#define SNAPSHOT_HISTORY 32
+
+namespace {
+    //! Number of fixed point steps per pixel.
+    const int POSITION_SCALE = 8;
+
+    //! Bits used for the position inside of a tile: log2(TILE_SIZE * POSITION_SCALE).
+    const int TILE_OFFSET_BITS = 9;
+
+    //! Bits used for the tile index (zig-zag encoded).
+    const int TILE_INDEX_BITS = 16;
+
+    //! Bits used for a small position delta.
+    const int SMALL_DELTA_BITS = 8;
+
+    //! Bits used for a direction.
+    const int DIRECTION_BITS = 3;
+
+    enum Tank_Field
+    {
+        TANK_X                  = 1 << 0,
+        TANK_Y                  = 1 << 1,
+        TANK_ANGLE              = 1 << 2,
+        TANK_TURRET_ANGLE       = 1 << 3,
+        TANK_MOVEMENT           = 1 << 4,
+        TANK_ROTATION           = 1 << 5,
+        TANK_TURRET_DIRECTION   = 1 << 6,
+        TANK_FIELD_BITS         = 7
+    };
+
+    enum Projectile_Field
+    {
+        PROJECTILE_X            = 1 << 0,
+        PROJECTILE_Y            = 1 << 1,
+        PROJECTILE_ANGLE        = 1 << 2,
+        PROJECTILE_FIELD_BITS   = 3
+    };
+
+    //! Writes values of arbitrary bit width, most significant bit first.
+    class Bit_Writer
+    {
+    private:
+        std::vector<Ice::Byte> &output;
+        unsigned int current;
+        int bit_count;
+
+    public:
+        Bit_Writer(std::vector<Ice::Byte> &buffer)
+            : output(buffer), current(0), bit_count(0)
+        {
+        }
+
+        void write(const unsigned int value, const int count)
+        {
+            VTANK_ASSERT(count > 0 && count <= 32);
+
+            int remaining = count;
+            while (remaining > 0) {
+                const int take = std::min(8 - bit_count, remaining);
+                const unsigned int chunk = (value >> (remaining - take)) & ((1u << take) - 1);
+                current = (current << take) | chunk;
+                bit_count += take;
+                remaining -= take;
+
+                if (bit_count == 8) {
+                    output.push_back(static_cast<Ice::Byte>(current));
+                    current = 0;
+                    bit_count = 0;
+                }
+            }
+        }
+
+        void write_bool(const bool value)
+        {
+            write(value ? 1 : 0, 1);
+        }
+
+        //! Write an unsigned number in 3 bit groups, each followed by a continuation bit.
+        void write_varint(unsigned int value)
+        {
+            do {
+                write(value & 0x7, 3);
+                value >>= 3;
+                write_bool(value != 0);
+            } while (value != 0);
+        }
+
+        //! Write any remaining bits, padding the last byte with zeroes.
+        void flush()
+        {
+            if (bit_count > 0) {
+                output.push_back(static_cast<Ice::Byte>(current << (8 - bit_count)));
+                current = 0;
+                bit_count = 0;
+            }
+        }
+    };
+
+    //! Reads values written by Bit_Writer. Reading past the end sets the failed flag.
+    class Bit_Reader
+    {
+    private:
+        const std::vector<Ice::Byte> &input;
+        std::vector<Ice::Byte>::size_type position;
+        int bit_position;
+        bool failed;
+
+    public:
+        Bit_Reader(const std::vector<Ice::Byte> &buffer)
+            : input(buffer), position(0), bit_position(0), failed(false)
+        {
+        }
+
+        unsigned int read(const int count)
+        {
+            VTANK_ASSERT(count > 0 && count <= 32);
+
+            unsigned int value = 0;
+            int remaining = count;
+            while (remaining > 0) {
+                if (position >= input.size()) {
+                    failed = true;
+                    return 0;
+                }
+
+                const int available = 8 - bit_position;
+                const int take = std::min(available, remaining);
+                const unsigned int chunk = 
+                    (input[position] >> (available - take)) & ((1u << take) - 1);
+                value = (value << take) | chunk;
+                bit_position += take;
+                remaining -= take;
+
+                if (bit_position == 8) {
+                    ++position;
+                    bit_position = 0;
+                }
+            }
+
+            return value;
+        }
+
+        bool read_bool()
+        {
+            return read(1) != 0;
+        }
+
+        unsigned int read_varint()
+        {
+            unsigned int value = 0;
+            int shift = 0;
+            bool more = true;
+            while (more && !failed) {
+                if (shift > 30) {
+                    failed = true;
+                    break;
+                }
+
+                value |= read(3) << shift;
+                shift += 3;
+                more = read_bool();
+            }
+
+            return value;
+        }
+
+        bool has_failed() const
+        {
+            return failed;
+        }
+    };
+
+    unsigned int zigzag(const int value)
+    {
+        return (static_cast<unsigned int>(value) << 1) ^ static_cast<unsigned int>(value >> 31);
+    }
+
+    int unzigzag(const unsigned int value)
+    {
+        return static_cast<int>(value >> 1) ^ -static_cast<int>(value & 1);
+    }
+
+    //! Write a fixed point coordinate as a tile index plus an offset into that tile.
+    void write_position(Bit_Writer &writer, const int value)
+    {
+        const int tile = value >> TILE_OFFSET_BITS; // Arithmetic shift: floors negatives.
+        const int offset = value & ((1 << TILE_OFFSET_BITS) - 1);
+        VTANK_ASSERT(zigzag(tile) < (1u << TILE_INDEX_BITS));
+
+        writer.write(zigzag(tile), TILE_INDEX_BITS);
+        writer.write(static_cast<unsigned int>(offset), TILE_OFFSET_BITS);
+    }
+
+    int read_position(Bit_Reader &reader)
+    {
+        const int tile = unzigzag(reader.read(TILE_INDEX_BITS));
+        const int offset = static_cast<int>(reader.read(TILE_OFFSET_BITS));
+
+        return tile * (1 << TILE_OFFSET_BITS) + offset;
+    }
+
+    //! Write a coordinate relative to the baseline, using a small delta when possible.
+    void write_position_delta(Bit_Writer &writer, const int value, const int base)
+    {
+        const int delta = value - base;
+        const int limit = 1 << (SMALL_DELTA_BITS - 1);
+        if (delta >= -limit && delta < limit) {
+            writer.write_bool(true);
+            writer.write(static_cast<unsigned int>(delta) & ((1u << SMALL_DELTA_BITS) - 1), 
+                SMALL_DELTA_BITS);
+        }
+        else {
+            writer.write_bool(false);
+            write_position(writer, value);
+        }
+    }
+
+    int read_position_delta(Bit_Reader &reader, const int base)
+    {
+        if (reader.read_bool()) {
+            const unsigned int raw = reader.read(SMALL_DELTA_BITS);
+            const int sign_bit = 1 << (SMALL_DELTA_BITS - 1);
+            const int delta = (static_cast<int>(raw) ^ sign_bit) - sign_bit;
+
+            return base + delta;
+        }
+
+        return read_position(reader);
+    }
+
+    //! Find which fields of a tank differ from the baseline.
+    unsigned int tank_changes(const Tank_Snapshot &current, const Tank_Snapshot &base)
+    {
+        unsigned int mask = 0;
+        if (current.x != base.x) mask |= TANK_X;
+        if (current.y != base.y) mask |= TANK_Y;
+        if (current.angle != base.angle) mask |= TANK_ANGLE;
+        if (current.turret_angle != base.turret_angle) mask |= TANK_TURRET_ANGLE;
+        if (current.movement_direction != base.movement_direction) mask |= TANK_MOVEMENT;
+        if (current.rotation_direction != base.rotation_direction) mask |= TANK_ROTATION;
+        if (current.turret_direction != base.turret_direction) mask |= TANK_TURRET_DIRECTION;
+
+        return mask;
+    }
+
+    //! Find which fields of a projectile differ from the baseline.
+    unsigned int projectile_changes(const Projectile_Snapshot &current,
+        const Projectile_Snapshot &base)
+    {
+        unsigned int mask = 0;
+        if (current.x != base.x) mask |= PROJECTILE_X;
+        if (current.y != base.y) mask |= PROJECTILE_Y;
+        if (current.angle != base.angle) mask |= PROJECTILE_ANGLE;
+
+        return mask;
+    }
+
+    //! Locate an entity by ID in a sorted list.
+    template <typename T>
+    const T *find_entity(const std::vector<T> &list, const int id)
+    {
+        typename std::vector<T>::const_iterator i = list.begin();
+        for (; i != list.end() && i->id <= id; ++i) {
+            if (i->id == id) {
+                return &(*i);
+            }
+        }
+
+        return NULL;
+    }
+
+    //! Insert or replace an entity, keeping the list sorted by ID.
+    template <typename T>
+    void put_entity(std::vector<T> &list, const T &entity)
+    {
+        typename std::vector<T>::iterator i = list.begin();
+        for (; i != list.end() && i->id < entity.id; ++i);
+        if (i != list.end() && i->id == entity.id) {
+            *i = entity;
+        }
+        else {
+            list.insert(i, entity);
+        }
+    }
+
+    //! Remove an entity by ID.
+    template <typename T>
+    void erase_entity(std::vector<T> &list, const int id)
+    {
+        typename std::vector<T>::iterator i = list.begin();
+        for (; i != list.end(); ++i) {
+            if (i->id == id) {
+                list.erase(i);
+                return;
+            }
+        }
+    }
+
+    //! Write the IDs of entities present in the baseline but missing from current.
+    template <typename T>
+    void write_removed(Bit_Writer &writer, const std::vector<T> &current, 
+        const std::vector<T> *base)
+    {
+        std::vector<int> removed;
+        if (base != NULL) {
+            typename std::vector<T>::const_iterator i = base->begin();
+            for (; i != base->end(); ++i) {
+                if (find_entity(current, i->id) == NULL) {
+                    removed.push_back(i->id);
+                }
+            }
+        }
+
+        writer.write_varint(static_cast<unsigned int>(removed.size()));
+        for (std::vector<int>::size_type i = 0; i < removed.size(); ++i) {
+            writer.write_varint(static_cast<unsigned int>(removed[i]));
+        }
+    }
+
+    template <typename T>
+    bool read_removed(Bit_Reader &reader, std::vector<T> &output)
+    {
+        const unsigned int count = reader.read_varint();
+        for (unsigned int i = 0; i < count && !reader.has_failed(); ++i) {
+            erase_entity(output, static_cast<int>(reader.read_varint()));
+        }
+
+        return !reader.has_failed();
+    }
+
+    void write_tanks(Bit_Writer &writer, const Snapshot &current, const Snapshot *baseline)
+    {
+        // Work out what needs to be written first so the count can lead.
+        std::vector<std::pair<const Tank_Snapshot *, unsigned int> > entries;
+        for (std::vector<Tank_Snapshot>::size_type i = 0; i < current.tanks.size(); ++i) {
+            const Tank_Snapshot &tank = current.tanks[i];
+            const Tank_Snapshot *base = baseline == NULL ? 
+                NULL : find_entity(baseline->tanks, tank.id);
+            if (base == NULL) {
+                entries.push_back(std::make_pair(&tank, 0u));
+            }
+            else {
+                const unsigned int mask = tank_changes(tank, *base);
+                if (mask != 0) {
+                    entries.push_back(std::make_pair(&tank, mask));
+                }
+            }
+        }
+
+        writer.write_varint(static_cast<unsigned int>(entries.size()));
+        int previous_id = -1;
+        for (std::vector<int>::size_type i = 0; i < entries.size(); ++i) {
+            const Tank_Snapshot &tank = *entries[i].first;
+            const unsigned int mask = entries[i].second;
+
+            // IDs are sorted, so the gap from the previous one is written.
+            writer.write_varint(static_cast<unsigned int>(tank.id - previous_id - 1));
+            previous_id = tank.id;
+
+            const bool is_new = (mask == 0);
+            writer.write_bool(is_new);
+            if (is_new) {
+                write_position(writer, tank.x);
+                write_position(writer, tank.y);
+                writer.write(tank.angle, 16);
+                writer.write(tank.turret_angle, 16);
+                writer.write(tank.movement_direction, DIRECTION_BITS);
+                writer.write(tank.rotation_direction, DIRECTION_BITS);
+                writer.write(tank.turret_direction, DIRECTION_BITS);
+                continue;
+            }
+
+            const Tank_Snapshot &base = *find_entity(baseline->tanks, tank.id);
+            writer.write(mask, TANK_FIELD_BITS);
+            if (mask & TANK_X) write_position_delta(writer, tank.x, base.x);
+            if (mask & TANK_Y) write_position_delta(writer, tank.y, base.y);
+            if (mask & TANK_ANGLE) writer.write(tank.angle, 16);
+            if (mask & TANK_TURRET_ANGLE) writer.write(tank.turret_angle, 16);
+            if (mask & TANK_MOVEMENT) writer.write(tank.movement_direction, DIRECTION_BITS);
+            if (mask & TANK_ROTATION) writer.write(tank.rotation_direction, DIRECTION_BITS);
+            if (mask & TANK_TURRET_DIRECTION) writer.write(tank.turret_direction, DIRECTION_BITS);
+        }
+
+        write_removed(writer, current.tanks, baseline == NULL ? NULL : &baseline->tanks);
+    }
+
+    bool read_tanks(Bit_Reader &reader, Snapshot &output)
+    {
+        const unsigned int count = reader.read_varint();
+        int previous_id = -1;
+        for (unsigned int i = 0; i < count && !reader.has_failed(); ++i) {
+            Tank_Snapshot tank;
+            tank.id = previous_id + 1 + static_cast<int>(reader.read_varint());
+            previous_id = tank.id;
+
+            if (reader.read_bool()) {
+                tank.x = read_position(reader);
+                tank.y = read_position(reader);
+                tank.angle = static_cast<unsigned short>(reader.read(16));
+                tank.turret_angle = static_cast<unsigned short>(reader.read(16));
+                tank.movement_direction = static_cast<unsigned char>(reader.read(DIRECTION_BITS));
+                tank.rotation_direction = static_cast<unsigned char>(reader.read(DIRECTION_BITS));
+                tank.turret_direction = static_cast<unsigned char>(reader.read(DIRECTION_BITS));
+            }
+            else {
+                const Tank_Snapshot *base = find_entity(output.tanks, tank.id);
+                if (base == NULL) {
+                    // Delta against something the baseline doesn't have.
+                    return false;
+                }
+
+                tank = *base;
+                const unsigned int mask = reader.read(TANK_FIELD_BITS);
+                if (mask & TANK_X) tank.x = read_position_delta(reader, tank.x);
+                if (mask & TANK_Y) tank.y = read_position_delta(reader, tank.y);
+                if (mask & TANK_ANGLE) 
+                    tank.angle = static_cast<unsigned short>(reader.read(16));
+                if (mask & TANK_TURRET_ANGLE)
+                    tank.turret_angle = static_cast<unsigned short>(reader.read(16));
+                if (mask & TANK_MOVEMENT)
+                    tank.movement_direction = static_cast<unsigned char>(reader.read(DIRECTION_BITS));
+                if (mask & TANK_ROTATION)
+                    tank.rotation_direction = static_cast<unsigned char>(reader.read(DIRECTION_BITS));
+                if (mask & TANK_TURRET_DIRECTION)
+                    tank.turret_direction = static_cast<unsigned char>(reader.read(DIRECTION_BITS));
+            }
+
+            put_entity(output.tanks, tank);
+        }
+
+        return !reader.has_failed() && read_removed(reader, output.tanks);
+    }
+
+    void write_projectiles(Bit_Writer &writer, const Snapshot &current, const Snapshot *baseline)
+    {
+        std::vector<std::pair<const Projectile_Snapshot *, unsigned int> > entries;
+        for (std::vector<Projectile_Snapshot>::size_type i = 0; i < current.projectiles.size(); ++i) {
+            const Projectile_Snapshot &projectile = current.projectiles[i];
+            const Projectile_Snapshot *base = baseline == NULL ? 
+                NULL : find_entity(baseline->projectiles, projectile.id);
+            if (base == NULL || base->type_id != projectile.type_id) {
+                entries.push_back(std::make_pair(&projectile, 0u));
+            }
+            else {
+                const unsigned int mask = projectile_changes(projectile, *base);
+                if (mask != 0) {
+                    entries.push_back(std::make_pair(&projectile, mask));
+                }
+            }
+        }
+
+        writer.write_varint(static_cast<unsigned int>(entries.size()));
+        int previous_id = -1;
+        for (std::vector<int>::size_type i = 0; i < entries.size(); ++i) {
+            const Projectile_Snapshot &projectile = *entries[i].first;
+            const unsigned int mask = entries[i].second;
+
+            writer.write_varint(static_cast<unsigned int>(projectile.id - previous_id - 1));
+            previous_id = projectile.id;
+
+            const bool is_new = (mask == 0);
+            writer.write_bool(is_new);
+            if (is_new) {
+                writer.write_varint(static_cast<unsigned int>(projectile.type_id));
+                write_position(writer, projectile.x);
+                write_position(writer, projectile.y);
+                writer.write(projectile.angle, 16);
+                continue;
+            }
+
+            const Projectile_Snapshot &base = *find_entity(baseline->projectiles, projectile.id);
+            writer.write(mask, PROJECTILE_FIELD_BITS);
+            if (mask & PROJECTILE_X) write_position_delta(writer, projectile.x, base.x);
+            if (mask & PROJECTILE_Y) write_position_delta(writer, projectile.y, base.y);
+            if (mask & PROJECTILE_ANGLE) writer.write(projectile.angle, 16);
+        }
+
+        write_removed(writer, current.projectiles, 
+            baseline == NULL ? NULL : &baseline->projectiles);
+    }
+
+    bool read_projectiles(Bit_Reader &reader, Snapshot &output)
+    {
+        const unsigned int count = reader.read_varint();
+        int previous_id = -1;
+        for (unsigned int i = 0; i < count && !reader.has_failed(); ++i) {
+            Projectile_Snapshot projectile;
+            projectile.id = previous_id + 1 + static_cast<int>(reader.read_varint());
+            previous_id = projectile.id;
+
+            if (reader.read_bool()) {
+                projectile.type_id = static_cast<int>(reader.read_varint());
+                projectile.x = read_position(reader);
+                projectile.y = read_position(reader);
+                projectile.angle = static_cast<unsigned short>(reader.read(16));
+            }
+            else {
+                const Projectile_Snapshot *base = find_entity(output.projectiles, projectile.id);
+                if (base == NULL) {
+                    return false;
+                }
+
+                projectile = *base;
+                const unsigned int mask = reader.read(PROJECTILE_FIELD_BITS);
+                if (mask & PROJECTILE_X) 
+                    projectile.x = read_position_delta(reader, projectile.x);
+                if (mask & PROJECTILE_Y)
+                    projectile.y = read_position_delta(reader, projectile.y);
+                if (mask & PROJECTILE_ANGLE)
+                    projectile.angle = static_cast<unsigned short>(reader.read(16));
+            }
+
+            put_entity(output.projectiles, projectile);
+        }
+
+        return !reader.has_failed() && read_removed(reader, output.projectiles);
+    }
+}
+
+namespace Snapshot_Codec
+{
+    int quantize_position(const double value)
+    {
+        return static_cast<int>(floor(value * POSITION_SCALE + 0.5));
+    }
+
+    double dequantize_position(const int value)
+    {
+        return static_cast<double>(value) / POSITION_SCALE;
+    }
+
+    unsigned short quantize_angle(const double angle)
+    {
+        const double two_pi = 2.0 * 3.14159265358979323846;
+        double normalized = fmod(angle, two_pi);
+        if (normalized < 0) {
+            normalized += two_pi;
+        }
+
+        const unsigned int steps = static_cast<unsigned int>(
+            floor(normalized / two_pi * 65536.0 + 0.5));
+        return static_cast<unsigned short>(steps & 0xFFFF);
+    }
+
+    double dequantize_angle(const unsigned short angle)
+    {
+        return static_cast<double>(angle) / 65536.0 * 2.0 * 3.14159265358979323846;
+    }
+
+    void encode(const Snapshot &current, const Snapshot *baseline, std::vector<Ice::Byte> &output)
+    {
+        VTANK_ASSERT((1 << TILE_OFFSET_BITS) == TILE_SIZE * POSITION_SCALE);
+
+        output.clear();
+        Bit_Writer writer(output);
+
+        writer.write(static_cast<unsigned int>(current.tick & 0xFFFFFFFF), 32);
+        writer.write_bool(baseline != NULL);
+        if (baseline != NULL) {
+            writer.write(static_cast<unsigned int>(baseline->tick & 0xFFFFFFFF), 32);
+        }
+
+        write_tanks(writer, current, baseline);
+        write_projectiles(writer, current, baseline);
+
+        writer.flush();
+    }
+
+    bool decode(const std::vector<Ice::Byte> &input, const Snapshot *baseline, Snapshot &output)
+    {
+        Bit_Reader reader(input);
+
+        const unsigned int tick = reader.read(32);
+        const bool has_baseline = reader.read_bool();
+        if (has_baseline) {
+            const unsigned int baseline_tick = reader.read(32);
+            if (baseline == NULL || 
+                baseline_tick != static_cast<unsigned int>(baseline->tick & 0xFFFFFFFF)) {
+                return false;
+            }
+
+            output = *baseline;
+        }
+        else {
+            output = Snapshot();
+        }
+
+        if (reader.has_failed()) {
+            return false;
+        }
+
+        // Only the low 32 bits of the tick travel; take the rest from the baseline.
+        const Ice::Long high_bits = has_baseline ? (baseline->tick & ~static_cast<Ice::Long>(0xFFFFFFFF)) : 0;
+        output.tick = high_bits | tick;
+        if (has_baseline && output.tick < baseline->tick) {
+            output.tick += static_cast<Ice::Long>(1) << 32;
+        }
+
+        return read_tanks(reader, output) && read_projectiles(reader, output);
+    }
+}
+
+Snapshot_Channel::Snapshot_Channel()
+    : next(0), acknowledged_tick(-1)
+{
+}
+
+void Snapshot_Channel::acknowledge(const Ice::Long tick)
+{
+    Atomic::store(acknowledged_tick, static_cast<long>(tick));
+}
+
+void Snapshot_Channel::encode(const Snapshot &current, std::vector<Ice::Byte> &output)
+{
+    const long acknowledged = Atomic::load(acknowledged_tick);
+    const Snapshot *baseline = NULL;
+    if (acknowledged >= 0) {
+        for (std::vector<Snapshot>::size_type i = 0; i < history.size(); ++i) {
+            if (static_cast<long>(history[i].tick) == acknowledged) {
+                baseline = &history[i];
+                break;
+            }
+        }
+    }
+
+    Snapshot_Codec::encode(current, baseline, output);
+
+    // Remember what was sent, overwriting the oldest entry once the history is full.
+    if (history.size() < SNAPSHOT_HISTORY) {
+        history.push_back(current);
+    }
+    else {
+        history[next] = current;
+        next = (next + 1) % SNAPSHOT_HISTORY;
+    }
+}
@@ -0,0 +1,121 @@
+/*!
+    \file   snapshot.hpp
+    \brief  Compact, delta-compressed encoding of the game state sent to clients.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <atomic.hpp>
+
+//! Quantized state of one tank.
+struct Tank_Snapshot
+{
+    int id;
+
+    //! Position in fixed point (see Snapshot_Codec::quantize_position).
+    int x;
+    int y;
+
+    //! Angles packed into 16 bits (see Snapshot_Codec::quantize_angle).
+    unsigned short angle;
+    unsigned short turret_angle;
+
+    //! VTankObject::Direction values.
+    unsigned char movement_direction;
+    unsigned char rotation_direction;
+    unsigned char turret_direction;
+};
+
+//! Quantized state of one projectile.
+struct Projectile_Snapshot
+{
+    int id;
+    int type_id;
+    int x;
+    int y;
+    unsigned short angle;
+};
+
+//! State of everything a client can see at the end of a tick. Entities are sorted by ID.
+struct Snapshot
+{
+    Ice::Long tick;
+    std::vector<Tank_Snapshot> tanks;
+    std::vector<Projectile_Snapshot> projectiles;
+
+    Snapshot() : tick(0) {}
+};
+
+/*!
+    The Snapshot_Codec namespace turns snapshots into bytes and back. Positions are
+    stored relative to the tile they are on in 1/8th pixel fixed point, angles in 16
+    bits, and directions in 3 bits. When a baseline (the last snapshot the client
+    acknowledged) is given, only entities which changed are written, each with a bit
+    mask of which fields changed, and small position changes are written as deltas.
+*/
+namespace Snapshot_Codec
+{
+    //! Convert a world coordinate to fixed point.
+    int quantize_position(const double);
+
+    //! Convert a fixed point coordinate back to a world coordinate.
+    double dequantize_position(const int);
+
+    //! Pack an angle (in radians, any range) into 16 bits.
+    unsigned short quantize_angle(const double);
+
+    //! Unpack a 16 bit angle into radians in the range [0, 2*PI).
+    double dequantize_angle(const unsigned short);
+
+    /*!
+        Encode a snapshot.
+        \param current Snapshot to encode.
+        \param baseline Snapshot the client already has, or NULL to encode everything.
+        \param output [out] Encoded bytes. Any previous contents are replaced.
+    */
+    void encode(const Snapshot &, const Snapshot *, std::vector<Ice::Byte> &);
+
+    /*!
+        Decode a snapshot.
+        \param input Encoded bytes.
+        \param baseline Snapshot the data was encoded against, or NULL if it was encoded
+        without one.
+        \param output [out] Decoded snapshot.
+        \return True if the data was decoded; false if it is malformed or was encoded
+        against a different baseline.
+    */
+    bool decode(const std::vector<Ice::Byte> &, const Snapshot *, Snapshot &);
+}
+
+/*!
+    Tracks the snapshots sent to one client, so the next one can be encoded against
+    whatever the client last acknowledged. Only the simulation thread encodes; the
+    acknowledgement may arrive on any thread.
+*/
+class Snapshot_Channel
+{
+private:
+    std::vector<Snapshot> history;
+    std::vector<Snapshot>::size_type next;
+    volatile long acknowledged_tick;
+
+public:
+    Snapshot_Channel();
+
+    /*!
+        Record that the client has received a snapshot.
+        \param tick Tick number of the snapshot.
+    */
+    void acknowledge(const Ice::Long);
+
+    /*!
+        Encode a snapshot against the client's last acknowledged snapshot, and remember
+        it as a possible future baseline.
+        \param current Snapshot to send.
+        \param output [out] Encoded bytes.
+    */
+    void encode(const Snapshot &, std::vector<Ice::Byte> &);
+};
+
+#endif
@@ -0,0 +1,409 @@
+/*!
+    \file   statisticsupload.cpp
+    \brief  Implementation of the statistics upload thread and its spool file.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <statisticsupload.hpp>
+#include <server.hpp>
+#include <logger.hpp>
+#include <trace.hpp>
+#include <IceUtil/UUID.h>
+
+namespace Statistics_Upload
+{
+    namespace
+    {
+        //! How the attempt waiting for a reply went.
+        enum Reply_State
+        {
+            REPLY_WAITING,
+            REPLY_ACCEPTED,
+            REPLY_FAILED
+        };
+
+        boost::mutex mutex;
+        boost::condition_variable changed;
+        std::deque<Round> pending;
+        std::string spool_path;
+        boost::thread upload_thread;
+        bool running = false;
+
+        //! Set when a round was queued but isn't in the spool file yet.
+        bool unsaved = false;
+
+        //! Goes up whenever the oldest round leaves the queue.
+        unsigned long front_serial = 0;
+
+        // The attempt waiting for a reply, and its reply.
+        unsigned long attempt = 0;
+        Reply_State reply = REPLY_WAITING;
+
+        //! Keeps writes of the spool file in order.
+        boost::mutex spool_mutex;
+
+        /*!
+            Write every round which is waiting to the spool file, or remove the file if
+            none are. The mutex must not be held.
+        */
+        void save()
+        {
+            boost::lock_guard<boost::mutex> spool_guard(spool_mutex);
+
+            std::deque<Round> rounds;
+            std::string path;
+            {
+                boost::lock_guard<boost::mutex> guard(mutex);
+                rounds = pending;
+                path = spool_path;
+                unsaved = false;
+            }
+
+            if (path.empty()) {
+                return;
+            }
+            if (rounds.empty()) {
+                (void)std::remove(path.c_str());
+                return;
+            }
+
+            // Written aside first, so a crash never leaves half a spool file.
+            const std::string temporary = path + ".tmp";
+            {
+                std::ofstream file(temporary.c_str(), std::ios::out | std::ios::trunc);
+                write_rounds(file, rounds);
+                file.flush();
+                if (!file) {
+                    LOG_STREAM(Logger::LOG_LEVEL_ERROR, "Couldn't write the statistics spool "
+                        << temporary << ".");
+                    return;
+                }
+            }
+
+            (void)std::remove(path.c_str());
+            if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+                LOG_STREAM(Logger::LOG_LEVEL_ERROR, "Couldn't replace the statistics spool "
+                    << path << ".");
+            }
+        }
+
+        //! Record the reply to an attempt, unless it was given up on.
+        void replied(const unsigned long number, const Reply_State state)
+        {
+            {
+                boost::lock_guard<boost::mutex> guard(mutex);
+                if (number != attempt) {
+                    return;
+                }
+                reply = state;
+            }
+
+            changed.notify_all();
+        }
+
+        //! AMI callback for one attempt to send a round.
+        class Send_Callback : public MainToGameSession::AMI_MTGSession_SendStatistics
+        {
+        private:
+            const unsigned long number;
+
+        public:
+            explicit Send_Callback(const unsigned long attempt_number)
+                : number(attempt_number)
+            {}
+
+            virtual void ice_response()
+            {
+                replied(number, REPLY_ACCEPTED);
+            }
+
+            virtual void ice_exception(const Ice::Exception &ex)
+            {
+                LOG_STREAM(Logger::LOG_LEVEL_ERROR,
+                    "Ice threw an exception at SendStatistics: " << ex.what());
+
+                replied(number, REPLY_FAILED);
+            }
+        };
+
+        /*!
+            Send a round and wait for the main server to accept it.
+            \param round Round to send.
+            \return True if it was accepted.
+        */
+        bool send(const Round &round)
+        {
+            const MainToGameSession::MTGSessionPrx proxy = Server::mtg_service.get_proxy();
+            if (!proxy) {
+                Logger::log(Logger::LOG_LEVEL_WARNING,
+                    "Can't send statistics: Not connected to the main server.");
+                return false;
+            }
+
+            unsigned long number;
+            {
+                boost::lock_guard<boost::mutex> guard(mutex);
+                number = ++attempt;
+                reply = REPLY_WAITING;
+            }
+
+            try {
+                (void)proxy->SendStatistics_async(new Send_Callback(number), round.id,
+                    round.statistics);
+            }
+            catch (const Ice::Exception &ex) {
+                LOG_STREAM(Logger::LOG_LEVEL_ERROR,
+                    "Ice threw an exception at SendStatistics: " << ex.what());
+                return false;
+            }
+
+            const boost::system_time timeout = boost::get_system_time() +
+                boost::posix_time::milliseconds(STATISTICS_REPLY_TIMEOUT);
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while (reply == REPLY_WAITING) {
+                if (!changed.timed_wait(lock, timeout)) {
+                    // A late reply is ignored. The round is sent again under the same
+                    // ID, so the main server counts it once even if it arrived.
+                    ++attempt;
+                    lock.unlock();
+
+                    Logger::log(Logger::LOG_LEVEL_ERROR,
+                        "The main server didn't reply to SendStatistics in time.");
+                    return false;
+                }
+            }
+
+            return reply == REPLY_ACCEPTED;
+        }
+
+        /*!
+            Wait before sending again. Rounds queued meanwhile are still written to the
+            spool file straight away.
+            \param delay How long to wait, in milliseconds.
+        */
+        void wait_to_retry(const long delay)
+        {
+            const boost::system_time retry = boost::get_system_time() +
+                boost::posix_time::milliseconds(delay);
+
+            boost::unique_lock<boost::mutex> lock(mutex);
+            for (;;) {
+                if (unsaved) {
+                    lock.unlock();
+                    save();
+                    lock.lock();
+                }
+                else if (!changed.timed_wait(lock, retry)) {
+                    return;
+                }
+            }
+        }
+
+        //! Body of the upload thread.
+        void run()
+        {
+            TRACE_THREAD_NAME("Statistics Upload");
+
+            long delay = STATISTICS_RETRY_DELAY;
+            try {
+                for (;;) {
+                    Round round;
+                    unsigned long serial;
+                    bool spool;
+                    {
+                        boost::unique_lock<boost::mutex> lock(mutex);
+                        while (pending.empty()) {
+                            changed.wait(lock);
+                        }
+                        round = pending.front();
+                        serial = front_serial;
+                        spool = unsaved;
+                    }
+
+                    // Submitted rounds are spooled here, so rotation never waits on the disk.
+                    if (spool) {
+                        save();
+                    }
+
+                    if (send(round)) {
+                        {
+                            boost::lock_guard<boost::mutex> guard(mutex);
+                            // The round may have been dropped to make room meanwhile.
+                            if (serial == front_serial) {
+                                pending.pop_front();
+                                ++front_serial;
+                            }
+                        }
+                        save();
+
+                        delay = STATISTICS_RETRY_DELAY;
+                        continue;
+                    }
+
+                    LOG_STREAM(Logger::LOG_LEVEL_WARNING, "Statistics weren't sent; trying again in "
+                        << delay / 1000 << " seconds.");
+                    wait_to_retry(delay);
+                    delay = std::min(delay * 2, static_cast<long>(STATISTICS_MAX_RETRY_DELAY));
+                }
+            }
+            catch (const boost::thread_interrupted &) {
+                // Server is shutting down.
+            }
+        }
+
+        //! Start the thread if it isn't running. The mutex must be held.
+        void ensure_running()
+        {
+            if (!running) {
+                upload_thread = boost::thread(&run);
+                running = true;
+            }
+        }
+    }
+
+    void start(const std::string &path)
+    {
+        std::deque<Round> rounds;
+        if (!path.empty()) {
+            std::ifstream file(path.c_str());
+            if (file && !read_rounds(file, rounds)) {
+                LOG_STREAM(Logger::LOG_LEVEL_WARNING, "The statistics spool " << path
+                    << " is damaged; only the rounds before the damage will be sent.");
+            }
+        }
+
+        {
+            boost::lock_guard<boost::mutex> guard(mutex);
+            spool_path = path;
+
+            // Rounds from the last run are older than anything queued since.
+            pending.insert(pending.begin(), rounds.begin(), rounds.end());
+            while (pending.size() > STATISTICS_MAX_PENDING) {
+                pending.pop_front();
+                ++front_serial;
+            }
+            if (!pending.empty()) {
+                ensure_running();
+            }
+        }
+
+        if (!rounds.empty()) {
+            LOG_STREAM(Logger::LOG_LEVEL_INFO, "Sending " << rounds.size()
+                << " round(s) of statistics left over from the last run.");
+            changed.notify_all();
+        }
+    }
+
+    void submit(const VTankObject::StatisticsList &statistics)
+    {
+        Round round;
+        round.id = IceUtil::generateUUID();
+        round.statistics = statistics;
+
+        bool dropped = false;
+        {
+            boost::lock_guard<boost::mutex> guard(mutex);
+            pending.push_back(round);
+            unsaved = true;
+            if (pending.size() > STATISTICS_MAX_PENDING) {
+                pending.pop_front();
+                ++front_serial;
+                dropped = true;
+            }
+
+            ensure_running();
+        }
+
+        changed.notify_all();
+
+        if (dropped) {
+            Logger::log(Logger::LOG_LEVEL_WARNING,
+                "Too many rounds of statistics are waiting; the oldest was dropped.");
+        }
+    }
+
+    std::size_t get_pending_count()
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+        return pending.size();
+    }
+
+    void stop()
+    {
+        {
+            boost::lock_guard<boost::mutex> guard(mutex);
+            if (!running) {
+                return;
+            }
+            running = false;
+        }
+
+        upload_thread.interrupt();
+        upload_thread.join();
+
+        // The thread may have stopped before spooling the last rounds submitted.
+        save();
+    }
+
+    void write_rounds(std::ostream &output, const std::deque<Round> &rounds)
+    {
+        for (std::deque<Round>::size_type i = 0; i < rounds.size(); ++i) {
+            const VTankObject::StatisticsList &round = rounds[i].statistics;
+
+            output << "round " << round.size() << ' ' << rounds[i].id << '\n';
+            for (VTankObject::StatisticsList::size_type j = 0; j < round.size(); ++j) {
+                const VTankObject::Statistics &stats = round[j];
+
+                // The name goes last, since it may hold spaces.
+                output << stats.kills << ' ' << stats.assists << ' ' << stats.deaths << ' '
+                    << stats.objectivesCompleted << ' ' << stats.objectivesCaptured << ' '
+                    << stats.calculatedPoints << ' ' << stats.tankName << '\n';
+            }
+        }
+    }
+
+    bool read_rounds(std::istream &input, std::deque<Round> &rounds)
+    {
+        std::string line;
+        while (std::getline(input, line)) {
+            if (line.empty()) {
+                continue;
+            }
+
+            std::istringstream header(line);
+            std::string word;
+            std::size_t count = 0;
+            if (!(header >> word >> count) || word != "round") {
+                return false;
+            }
+
+            Round round;
+            if (!(header >> round.id)) {
+                // Spooled before rounds had IDs.
+                round.id = IceUtil::generateUUID();
+            }
+
+            for (std::size_t i = 0; i < count; ++i) {
+                if (!std::getline(input, line)) {
+                    return false;
+                }
+
+                std::istringstream fields(line);
+                VTankObject::Statistics stats;
+                if (!(fields >> stats.kills >> stats.assists >> stats.deaths
+                    >> stats.objectivesCompleted >> stats.objectivesCaptured
+                    >> stats.calculatedPoints) || fields.get() != ' ') {
+                    return false;
+                }
+                std::getline(fields, stats.tankName);
+
+                round.statistics.push_back(stats);
+            }
+
+            rounds.push_back(round);
+        }
+
+        return true;
+    }
+}
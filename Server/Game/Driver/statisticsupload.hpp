@@ -0,0 +1,85 @@
+/*!
+    \file   statisticsupload.hpp
+    \brief  Declares the Statistics_Upload namespace, which sends the statistics of each
+            round to the main server from its own thread.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef STATISTICSUPLOAD_HPP
+#define STATISTICSUPLOAD_HPP
+
+//! File unsent statistics are kept in unless configured otherwise.
+#define DEFAULT_STATISTICS_SPOOL "statistics.spool"
+
+//! How long (in milliseconds) to wait before sending a round again after a failure.
+#define STATISTICS_RETRY_DELAY 5000
+
+//! Longest (in milliseconds) the wait between attempts grows to.
+#define STATISTICS_MAX_RETRY_DELAY 300000
+
+//! How long (in milliseconds) to wait for the main server to accept a round.
+#define STATISTICS_REPLY_TIMEOUT 30000
+
+//! Most rounds kept waiting; the oldest is dropped to make room for a new one.
+#define STATISTICS_MAX_PENDING 1000
+
+/*!
+    The Statistics_Upload namespace sends the statistics of finished rounds to the main
+    server. Rounds are queued by the simulation thread and sent one at a time by a
+    thread of their own, so a slow or unreachable main server never holds up a map
+    rotation. A round which fails is sent again after STATISTICS_RETRY_DELAY, and the
+    wait doubles with each failure up to STATISTICS_MAX_RETRY_DELAY. Every round not yet
+    accepted is also kept in a spool file, so that rounds survive a restart.
+
+    A round which gets no reply in time may still have been counted, so each round has
+    an ID which it keeps through every attempt and restart. The main server ignores a
+    round whose ID it has counted already.
+*/
+namespace Statistics_Upload
+{
+    //! Statistics of one round, and the ID the main server knows it by.
+    struct Round
+    {
+        std::string id;
+        VTankObject::StatisticsList statistics;
+    };
+
+    /*!
+        Set the spool file and queue the rounds left in it by an earlier run. If no
+        spool file is set, unsent rounds are lost when the server shuts down. Call it
+        before any round is submitted.
+        \param path Path of the spool file, or an empty string to keep none.
+    */
+    void start(const std::string &);
+
+    /*!
+        Queue the statistics of a round to be sent, under a new ID. Doesn't wait for
+        anything: the upload thread writes the round to the spool file.
+        \param statistics Statistics of each player in the round.
+    */
+    void submit(const VTankObject::StatisticsList &);
+
+    //! Get the number of rounds waiting to be sent.
+    std::size_t get_pending_count();
+
+    //! Stop the thread. Rounds not yet sent are left in the spool file.
+    void stop();
+
+    /*!
+        Write rounds in the format of the spool file.
+        \param output Stream to write to.
+        \param rounds Rounds to write, oldest first.
+    */
+    void write_rounds(std::ostream &, const std::deque<Round> &);
+
+    /*!
+        Read rounds written by write_rounds().
+        \param input Stream to read from.
+        \param rounds [out] Rounds read are added to the end. A round written before
+        rounds had IDs is given a new one.
+        \return False if the stream held something other than whole rounds. The rounds
+        before the damage are still added.
+    */
+    bool read_rounds(std::istream &, std::deque<Round> &);
+}
+
+#endif
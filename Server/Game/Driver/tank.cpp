@@ -5,11 +5,14 @@
 */
 #include <master.hpp>
 #include <tank.hpp>
+#include <tankstate.hpp>
 #include <vtassert.hpp>
 #include <logger.hpp>
 #include <playermanager.hpp>
 #include <gamemanager.hpp>
 #include <pointmanager.hpp>
+#include <gameinstance.hpp>
+#include <clocksync.hpp>
 
 #define MAX_TANK_HEALTH 100
 
@@ -29,7 +32,8 @@ Tank::Tank(const GameSession::Tank &player_tank,
         player(player_instance),
         move_direction(VTankObject::NONE), 
         rotate_direction(VTankObject::NONE),
-        offset(0),
+        turret_angle(0),
+        turret_direction(VTankObject::NONE),
         respawns_at(-1),
         node(-1),
 		ready(false)
@@ -45,15 +49,19 @@ Tank::Tank(const GameSession::Tank &player_tank,
     velocity = new_velocity;
     angle_velocity = new_angle_velocity;
     tank.team = team;
-	weapon = Players::get_weapon_data()->get_weapon(tank.attributes.weaponID);
+	weapon = Players::get_weapon_data()->get_weapon_index(tank.attributes.weaponID);
 
 	charge_timer = boost::shared_ptr<InternalChargeTimer>(new InternalChargeTimer());
-    charge_timer->maximum = weapon.max_charge_time_seconds * 1000; // convert to ms
+    charge_timer->maximum = get_weapon().max_charge_time_seconds * 1000; // convert to ms
 }
 
 Tank::~Tank()
 {
-    sync_thread.interrupt();
+}
+
+const Weapon &Tank::get_weapon() const
+{
+	return Players::get_weapon_data()->get_table()->get_weapon(weapon);
 }
 
 const std::string Tank::get_name() const
@@ -95,7 +103,7 @@ const bool Tank::is_allied(const int id)
     boost::lock_guard<boost::mutex> guard(mutex);
     tank_ptr tank;
     try {
-        tank = Players::tanks.get(id);
+        tank = Players::get_tank_manager()->get(id);
     }
     catch (const TankNotExistException &) {
         return false;
@@ -195,6 +203,23 @@ const GameSession::Tank Tank::get_tank_object()
     return tank;
 }
 
+void Tank::copy_state(Tank_State &state)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    state.id = tank.id;
+    state.team = tank.team;
+    state.alive = tank.alive;
+    state.health = tank.attributes.health;
+    state.node_id = node;
+    state.position = tank.position;
+    state.angle = tank.angle;
+    state.turret_angle = turret_angle;
+    state.movement_direction = move_direction;
+    state.rotation_direction = rotate_direction;
+    state.turret_direction = turret_direction;
+}
+
 const VTankObject::Direction Tank::get_movement_direction()
 {
     boost::lock_guard<boost::mutex> guard(mutex);
@@ -227,6 +252,30 @@ void Tank::set_rotation_direction(const VTankObject::Direction direction)
     rotate_direction = direction;
 }
 
+const double Tank::get_turret_angle()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    return turret_angle;
+}
+
+const VTankObject::Direction Tank::get_turret_direction()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    return turret_direction;
+}
+
+void Tank::set_turret(const double angle, const VTankObject::Direction direction)
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    VTANK_ASSERT(direction != VTankObject::FORWARD && direction != VTankObject::REVERSE);
+
+    turret_angle = angle;
+    turret_direction = direction;
+}
+
 const int Tank::get_node_id()
 {
     boost::lock_guard<boost::mutex> guard(mutex);
@@ -276,25 +325,32 @@ void Tank::set_alive(const bool alive)
     }
 }
 
-void Tank::set_offset(const IceUtil::Int64 &new_offset)
+void Tank::set_clock(const Clock_Estimate &estimate)
 {
     boost::lock_guard<boost::mutex> guard(mutex);
 
-    offset = new_offset;
+    clock = estimate;
+}
+
+Clock_Estimate Tank::get_clock()
+{
+    boost::lock_guard<boost::mutex> guard(mutex);
+
+    return clock;
 }
 
 const IceUtil::Int64 Tank::get_offset()
 {
     boost::lock_guard<boost::mutex> guard(mutex);
 
-    return offset;
+    return static_cast<IceUtil::Int64>(clock.offset_at(get_precise_time()));
 }
 
 IceUtil::Int64 Tank::transform_time(const IceUtil::Int64& timestamp)
 {
     boost::lock_guard<boost::mutex> guard(mutex);
 
-    return timestamp - offset;
+    return timestamp - static_cast<IceUtil::Int64>(clock.offset_at(get_precise_time()));
 }
 
 const Ice::Identity Tank::get_ice_id() const
@@ -375,9 +431,8 @@ void Tank::check_utility()
 		if (util.has_expired()) {
 			applied_utilities.erase(i);
 
-			std::ostringstream formatter;
-			formatter << "Utility " << util.utility.model << " has expired from " << get_name() << ".";
-			Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
+			LOG_STREAM(Logger::LOG_LEVEL_DEBUG, "Utility " << util.utility.model
+				<< " has expired from " << get_name() << ".");
 
 			break;
 		}
@@ -398,100 +453,7 @@ void Tank::check_utility()
 	}
 }
 
-/*!
-    Synchronize the clocks between the server and the client. This should
-    be run as a thread.
-*/
-void synchronize_clock_task(tank_ptr player)
-{
-    const int id = player->get_id();
-    const std::string name = player->get_name();
-    const GameSession::ClockSynchronizerPrx clock = player->get_player_info()->get_clock();
-
-    try {
-        player->get_player_info()->set_last_sync_time(IceUtil::Time::now().toMilliSecondsDouble());
-
-        int times_synchronized = 0;
-        long latencies[SYNC_REQUESTS];      // Stores average latency values.
-        long offsets[SYNC_REQUESTS];  // Stores average offset values.
-        // Initialize averages to 0.
-        for (short i = 0; i < SYNC_REQUESTS; i++) {
-            latencies[i] = 0;
-            offsets[i] = 0;
-        }
-        
-        // Milliseconds to wait before sending another request.
-        const boost::posix_time::milliseconds time_to_wait = 
-            boost::posix_time::milliseconds(1000);
-        while (times_synchronized < SYNC_REQUESTS) {
-            boost::this_thread::sleep(time_to_wait);
-            
-            // Stamp the current time to measure (approximate) latency.
-            const long start_time = static_cast<long>(IceUtil::Time::now().toMilliSeconds());
-            const long timestamp  = static_cast<long>(clock->Request());
-            const long end_time   = static_cast<long>(IceUtil::Time::now().toMilliSeconds());
-
-            player->get_player_info()->refresh_timeout();
-
-            // Latency is divided by two to attempt to compensate for round-trip.*
-            // *Note: Temporarily commented this part out. Latency and offset calc is kept separate.
-            latencies[times_synchronized] = (end_time - start_time) / 2;
-            offsets[times_synchronized]   = (timestamp /*+ latencies[times_synchronized]*/) - end_time;
-
-            player->set_offset(offsets[times_synchronized]);
-
-            times_synchronized++;
-        }
-        
-        // Calculate the average 'climb' i.e. how much faster/slower the clock is moving.
-        /*const double offset_climb = ((offsets[1] - offsets[0]) + 
-            (offsets[2] - offsets[1]) + (offsets[3] - offsets[2]) + (offsets[4] - offsets[3]) +
-            (offsets[5] - offsets[4])) / (time_to_wait * (SYNC_REQUESTS - 1));*/
-        
-        long sum = 0;
-        for (int l = 0; l < SYNC_REQUESTS; l++) {
-            sum += latencies[l];
-        }
-        sum /= SYNC_REQUESTS;
-        
-        player->get_player_info()->set_average_latency(sum);
-
-		double offset_sum = 0;
-		for (int o = 0; o < SYNC_REQUESTS; ++o) {
-			offset_sum += offsets[o];
-		}
-		offset_sum /= SYNC_REQUESTS;
-		//player->set_offset(static_cast<long>(offset_sum));
-
-        const double offset_value = static_cast<double>(player->get_offset());
-        
-        std::ostringstream formatter;
-        formatter << name << ": Latency=" << sum << ", Offset=" << offset_value;
-        
-        Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
-    }
-    catch (const Ice::Exception& ex) {
-        std::ostringstream formatter;
-        formatter << "Exception during ClockSync::Request for " << name 
-            << ": " << ex.what();
-
-        Logger::log(Logger::LOG_LEVEL_ERROR, formatter.str());
-
-        (void)Players::remove_player(id);
-    }
-    catch (const boost::thread_interrupted &) {
-        // Thread was interrupted.
-        std::ostringstream formatter;
-        formatter << "Thread interrupt during ClockSync::Request for " << name;
-
-        Logger::log(Logger::LOG_LEVEL_INFO, formatter.str());
-
-        (void)Players::remove_player(id);
-    }
-}
-
 void Tank::do_clock_sync()
 {
-    sync_thread = boost::thread(boost::bind<void>(synchronize_clock_task, 
-        Players::tanks.get(get_id())));
+    Clock_Sync::add(Game_Instance::current(), Players::get_tank_manager()->get(get_id()));
 }
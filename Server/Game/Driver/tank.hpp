@@ -9,6 +9,8 @@
 #include <player.hpp>
 #include <damageableobject.hpp>
 #include <weapon.hpp>
+#include <clockfilter.hpp>
+#include <lagcompensation.hpp>
 
 #define DEFAULT_MAX_CHARGE_TIME 3000
 
@@ -76,6 +78,8 @@ struct InternalChargeTimer
 
 typedef boost::shared_ptr<InternalChargeTimer> charge_ptr;
 
+struct Tank_State;
+
 /*!
     The Tank class is, in reality, an instance of a player. Tank is not an Ice servant;
     instead, it's job is to encapsulate all data belonging to the player. It also prevents
@@ -119,7 +123,10 @@ private:
     player_ptr player;
     VTankObject::Direction move_direction;
     VTankObject::Direction rotate_direction;
-    IceUtil::Int64 offset;
+    double turret_angle;
+    VTankObject::Direction turret_direction;
+    Clock_Estimate clock;
+    Position_History history;           // Simulation thread only.
     long respawns_at;
     int node;
     double velocity;
@@ -128,11 +135,10 @@ private:
 	std::vector<AppliedUtility> applied_utilities;
 	bool ready;
 	charge_ptr charge_timer;
-	Weapon weapon;
+	weapon_type_index weapon;
 
     Ice::Identity ice_id;
     boost::mutex mutex;
-    boost::thread sync_thread; // Thread which executes the clock sync.
 
 public:
     /*!
@@ -291,13 +297,25 @@ public:
 	const float get_damage_factor();
 
 	/*!
-		Get the tank's weapon.
+		Get the tank's weapon from the weapon table in use.
 	*/
-	const Weapon get_weapon() const
+	const Weapon &get_weapon() const;
+
+	//! Get the index of the tank's weapon in the weapon table.
+	weapon_type_index get_weapon_index() const
 	{
 		return weapon;
 	}
 
+    /*!
+        Get the tank's attributes. Everything but the health is fixed when the tank is
+        created; read the health from the tank's published state instead.
+    */
+    const VTankObject::TankAttributes get_attributes() const
+    {
+        return tank.attributes;
+    }
+
     /*!
         Access to a copy of the tank object. This is used to deliver information to the
         player.
@@ -305,6 +323,13 @@ public:
     */
     const GameSession::Tank get_tank_object();
 
+    /*!
+        Copy everything a Tank_State holds (except the tank pointer itself) under a
+        single lock.
+        \param state State to fill in.
+    */
+    void copy_state(Tank_State &);
+
     /*!
         Get the direction in which the tank is moving, if any.
         Possible values are: FORWARD, REVERSE, NONE.
@@ -333,6 +358,26 @@ public:
     */
     void set_rotation_direction(const VTankObject::Direction);
 
+    /*!
+        Get the angle of the tank's turret, as last reported by the client.
+        \return Angle of the turret in radians.
+    */
+    const double get_turret_angle();
+
+    /*!
+        Get the direction in which the turret is spinning, if any.
+        Valid values are: LEFT, RIGHT, NONE.
+        \return Direction that the turret is spinning towards.
+    */
+    const VTankObject::Direction get_turret_direction();
+
+    /*!
+        Set the turret's angle and spin direction.
+        \param angle Angle of the turret in radians.
+        \param direction Accepted values are: LEFT, RIGHT, NONE.
+    */
+    void set_turret(const double, const VTankObject::Direction);
+
     /*!
         Get the node at which this tank is assigned.
         \return Node ID assigned to the tank.
@@ -384,13 +429,19 @@ public:
     void set_alive(const bool);
 
     /*!
-        Set a new average offset for this player.
-        \param new_offset Offset to set.
+        Set what is known about the player's clock.
+        \param estimate New estimate of the clock.
     */
-    void set_offset(const IceUtil::Int64 &);
+    void set_clock(const Clock_Estimate &);
+
+    /*!
+        Get what is known about the player's clock.
+        \return Estimate of the clock.
+    */
+    Clock_Estimate get_clock();
     
     /**
-        Get the offset for this player.
+        Get the offset for this player, allowing for drift since it was measured.
         \return Offset value.
     */
     const IceUtil::Int64 get_offset();
@@ -402,6 +453,14 @@ public:
     */
     IceUtil::Int64 transform_time(const IceUtil::Int64 &);
     
+    /*!
+        Get where the tank has been over the last few ticks. Unlike the rest of the tank,
+        it isn't guarded: only the simulation thread may use it.
+        \return History of the tank's position.
+    */
+    Position_History &get_history()
+        { return history; }
+
     /*!
         Gets the radius of this tank.
         \return Float value containing the tank's circular radius.
@@ -416,7 +475,7 @@ public:
     const player_ptr get_player_info() const;
 
     /*!
-        Perform the clock synchronization task.
+        Start synchronizing the player's clock (see Clock_Sync).
     */
     void do_clock_sync();
 
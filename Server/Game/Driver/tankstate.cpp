@@ -0,0 +1,95 @@
+/*!
+    \file   tankstate.cpp
+    \brief  Implements the per-tick, read-only copies of the tanks' state.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <tankstate.hpp>
+#include <vtassert.hpp>
+
+namespace
+{
+    bool compare_state_to_id(const Tank_State &state, const int id)
+    {
+        return state.id < id;
+    }
+}
+
+Tank_State_Buffer::Reader::Reader(const Tank_State_Buffer &buffer)
+{
+    for (;;) {
+        frame = Atomic::load_pointer(buffer.published);
+        Atomic::increment(frame->readers);
+
+        // The writer may have started refilling this frame before it was pinned; it
+        // is only safe to read if it is still (or once again) the published one.
+        if (Atomic::load_pointer(buffer.published) == frame) {
+            break;
+        }
+
+        Atomic::decrement(frame->readers);
+    }
+}
+
+Tank_State_Buffer::Reader::~Reader()
+{
+    Atomic::decrement(frame->readers);
+}
+
+const Tank_State *Tank_State_Buffer::Reader::find(const int id) const
+{
+    const tank_state_array::const_iterator i = std::lower_bound(
+        frame->states.begin(), frame->states.end(), id, compare_state_to_id);
+    if (i == frame->states.end() || i->id != id) {
+        return NULL;
+    }
+
+    return &(*i);
+}
+
+Tank_State_Buffer::Tank_State_Buffer()
+{
+    Frame *frame = new Frame();
+    frame->tick = 0;
+    frame->readers = 0;
+    frames.push_back(frame);
+
+    published = frame;
+}
+
+Tank_State_Buffer::~Tank_State_Buffer()
+{
+    for (std::vector<Frame *>::size_type i = 0; i < frames.size(); i++) {
+        delete frames[i];
+    }
+}
+
+void Tank_State_Buffer::publish(const tank_array &tanks, const Ice::Long tick)
+{
+    Frame *frame = NULL;
+    for (std::vector<Frame *>::size_type i = 0; i < frames.size(); i++) {
+        if (frames[i] != published && Atomic::load(frames[i]->readers) == 0) {
+            frame = frames[i];
+            break;
+        }
+    }
+
+    if (frame == NULL) {
+        // Every other frame is still being read.
+        frame = new Frame();
+        frame->readers = 0;
+        frames.push_back(frame);
+    }
+
+    frame->tick = tick;
+    frame->states.resize(tanks.size());
+    for (tank_array::size_type i = 0; i < tanks.size(); i++) {
+        Tank_State &state = frame->states[i];
+        state.tank = tanks[i];
+        tanks[i]->copy_state(state);
+
+        VTANK_ASSERT(i == 0 || frame->states[i - 1].id < state.id);
+    }
+
+    Atomic::store_pointer(published, frame);
+}
@@ -0,0 +1,109 @@
+/*!
+    \file   tankstate.hpp
+    \brief  Declares the per-tick, read-only copies of the tanks' state.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef TANKSTATE_HPP
+#define TANKSTATE_HPP
+
+#include <tank.hpp>
+#include <atomic.hpp>
+
+//! Copy of the parts of a tank which are read many times every frame.
+struct Tank_State
+{
+    tank_ptr tank;                      //!< The tank itself, for its name, player and changes.
+    int id;
+    GameSession::Alliance team;
+    bool alive;
+    int health;
+    int node_id;
+    VTankObject::Point position;
+    double angle;
+    double turret_angle;
+    VTankObject::Direction movement_direction;
+    VTankObject::Direction rotation_direction;
+    VTankObject::Direction turret_direction;
+};
+
+//! Tank states, sorted by tank ID.
+typedef std::vector<Tank_State> tank_state_array;
+
+/*!
+    Publishes an immutable array of tank states once per tick, so that the notifier,
+    game modes and Ice threads can read every tank without taking a lock per getter or
+    copying the tank list out of the TankManager.
+
+    The simulation thread fills a frame nobody is reading and then swaps the published
+    pointer to it. Readers pin the published frame for as long as a Reader lives; the
+    writer never touches the published frame or a pinned one, so frames are reused
+    (normally just two of them) and never change while they are read.
+
+    Only the simulation thread may call publish(). Readers may be on any thread.
+*/
+class Tank_State_Buffer
+{
+public:
+    //! One published array of tank states.
+    struct Frame
+    {
+        tank_state_array states;
+        Ice::Long tick;
+        volatile long readers;          //!< Number of Readers pinning this frame.
+    };
+
+    /*!
+        Pins the most recently published frame. Keep it short-lived: a reader which
+        outlives a tick makes the writer allocate another frame.
+    */
+    class Reader
+    {
+    private:
+        Frame *frame;
+
+        Reader(const Reader &);
+        Reader &operator=(const Reader &);
+
+    public:
+        explicit Reader(const Tank_State_Buffer &);
+       ~Reader();
+
+        //! Get every tank's state, sorted by tank ID.
+        const tank_state_array &get_states() const { return frame->states; }
+
+        //! Get the tick at which the states were published.
+        Ice::Long get_tick() const { return frame->tick; }
+
+        /*!
+            Find a tank's state.
+            \param id ID of the tank.
+            \return The tank's state, or NULL if it was not in game when this frame was
+                published.
+        */
+        const Tank_State *find(const int) const;
+    };
+
+private:
+    std::vector<Frame *> frames;        //!< Every frame; only the writer uses this.
+    Frame * volatile published;
+
+    Tank_State_Buffer(const Tank_State_Buffer &);
+    Tank_State_Buffer &operator=(const Tank_State_Buffer &);
+
+public:
+    //! Start with an empty frame published, so readers never see a NULL frame.
+    Tank_State_Buffer();
+   ~Tank_State_Buffer();
+
+    /*!
+        Copy the tanks' state into an idle frame and publish it.
+        \param tanks Tanks in game, sorted by ID as TankManager::get_tank_list() returns them.
+        \param tick Tick being published.
+    */
+    void publish(const tank_array &, const Ice::Long);
+
+    //! Number of frames allocated so far.
+    std::vector<Frame *>::size_type get_frame_count() const { return frames.size(); }
+};
+
+#endif
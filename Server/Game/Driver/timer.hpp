@@ -52,6 +52,21 @@ public:
 
         last_time = current_time;
     }
+
+    /*!
+        Advance the timer by a fixed step rather than by the wall clock. This is
+        used by the fixed-tick simulation so every tick sees the same delta time.
+        \param step Amount of time (in seconds) to advance the timer by.
+    */
+    void advance(const double step)
+    {
+        boost::unique_lock<boost::shared_mutex> guard(timer_lock);
+        delta_time = step;
+
+        time_left -= delta_time;
+
+        last_time += delta_time;
+    }
 	
 	/*!
 		Force the timer to jump ahead to zero.
@@ -0,0 +1,99 @@
+/*!
+    \file   timerwheel.hpp
+    \brief  Hashed timer wheel for scheduling many timers on one thread.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef TIMERWHEEL_HPP
+#define TIMERWHEEL_HPP
+
+#include <vtassert.hpp>
+
+/*!
+    Circle of slots, each one tick wide. A timer waits in the slot its tick falls in,
+    with a count of the whole turns of the wheel still to go, so delays may be longer
+    than the wheel. Scheduling is constant time and each tick only looks at one slot,
+    however many timers are waiting. Timers can't be cancelled; the items should carry
+    a flag saying whether they are still wanted. Not thread safe.
+*/
+template <typename T>
+class Timer_Wheel
+{
+private:
+    struct Timer
+    {
+        T item;
+        std::size_t rounds;
+    };
+
+    std::vector<std::vector<Timer> > slots;
+    std::size_t current;
+    std::size_t count;
+
+    //! Scratch space for advance(), kept to avoid reallocating every tick.
+    std::vector<Timer> waiting;
+
+public:
+    /*!
+        Create an empty wheel.
+        \param slot_count Number of slots; the longest delay without extra turns.
+    */
+    explicit Timer_Wheel(const std::size_t slot_count)
+        : slots(slot_count), current(0), count(0)
+    {
+        VTANK_ASSERT(slot_count > 0);
+    }
+
+    /*!
+        Add a timer.
+        \param item Item handed back by advance() when the timer fires.
+        \param ticks Number of calls to advance() until it fires; 0 counts as 1.
+    */
+    void schedule(const T &item, std::size_t ticks)
+    {
+        if (ticks == 0) {
+            ticks = 1;
+        }
+
+        Timer timer;
+        timer.item = item;
+        timer.rounds = (ticks - 1) / slots.size();
+        slots[(current + ticks) % slots.size()].push_back(timer);
+        ++count;
+    }
+
+    /*!
+        Move to the next tick.
+        \param due [out] The items whose timers fired are appended here.
+    */
+    void advance(std::vector<T> &due)
+    {
+        current = (current + 1) % slots.size();
+
+        std::vector<Timer> &slot = slots[current];
+        if (slot.empty()) {
+            return;
+        }
+
+        waiting.clear();
+        for (typename std::vector<Timer>::size_type i = 0; i < slot.size(); ++i) {
+            if (slot[i].rounds == 0) {
+                due.push_back(slot[i].item);
+                --count;
+            }
+            else {
+                --slot[i].rounds;
+                waiting.push_back(slot[i]);
+            }
+        }
+
+        slot.swap(waiting);
+    }
+
+    //! Get the number of timers waiting.
+    std::size_t size() const
+    {
+        return count;
+    }
+};
+
+#endif
@@ -0,0 +1,237 @@
+/*!
+    \file   trace.cpp
+    \brief  Implements the trace point buffers and the Chrome trace writer.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <trace.hpp>
+#include <ctime>
+
+namespace Trace
+{
+    volatile long sample_rate = TRACE_SAMPLE_RATE;
+
+    namespace
+    {
+        //! Buffers are never freed, so events outlive the threads which recorded them.
+        void keep_buffer(Thread_Buffer *)
+        {
+        }
+
+        boost::thread_specific_ptr<Thread_Buffer> thread_buffer(&keep_buffer);
+
+        //! Every buffer ever created, guarded by buffers_mutex.
+        std::vector<Thread_Buffer *> buffers;
+        boost::mutex buffers_mutex;
+
+        bool compare_by_start(const Event &left, const Event &right)
+        {
+            return left.start < right.start;
+        }
+
+        //! Write a string as a JSON string literal.
+        void write_json_string(std::ostream &out, const std::string &value)
+        {
+            out << '"';
+            for (std::string::size_type i = 0; i < value.size(); ++i) {
+                const char c = value[i];
+                if (c == '"' || c == '\\') {
+                    out << '\\' << c;
+                }
+                else if (static_cast<unsigned char>(c) < 0x20) {
+                    out << ' ';
+                }
+                else {
+                    out << c;
+                }
+            }
+            out << '"';
+        }
+    }
+
+    Thread_Buffer::Thread_Buffer(const int id)
+        : events(TRACE_BUFFER_EVENTS), next(0), wrapped(false), calls(0), thread_id(id)
+    {
+        std::ostringstream formatter;
+        formatter << "Thread " << id;
+        name = formatter.str();
+    }
+
+    void Thread_Buffer::record(const char *scope_name, const Ice::Long start,
+                               const Ice::Long end)
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+
+        Event &event = events[next];
+        event.name = scope_name;
+        event.start = start;
+        event.end = end;
+
+        if (++next == events.size()) {
+            next = 0;
+            wrapped = true;
+        }
+    }
+
+    void Thread_Buffer::copy_events(std::vector<Event> &list)
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+
+        if (wrapped) {
+            list.insert(list.end(), events.begin() + next, events.end());
+        }
+        list.insert(list.end(), events.begin(), events.begin() + next);
+    }
+
+    void Thread_Buffer::clear()
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+
+        next = 0;
+        wrapped = false;
+    }
+
+    void Thread_Buffer::set_name(const std::string &thread_name)
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+        name = thread_name;
+    }
+
+    std::string Thread_Buffer::get_name()
+    {
+        boost::lock_guard<boost::mutex> guard(mutex);
+        return name;
+    }
+
+    Thread_Buffer *get_thread_buffer()
+    {
+        Thread_Buffer *buffer = thread_buffer.get();
+        if (buffer == NULL) {
+            boost::lock_guard<boost::mutex> guard(buffers_mutex);
+
+            buffer = new Thread_Buffer(static_cast<int>(buffers.size()) + 1);
+            buffers.push_back(buffer);
+            thread_buffer.reset(buffer);
+        }
+
+        return buffer;
+    }
+
+    Ice::Long get_clock_frequency()
+    {
+#if TARGET == WINTARGET
+        LARGE_INTEGER frequency;
+        (void)QueryPerformanceFrequency(&frequency);
+        return static_cast<Ice::Long>(frequency.QuadPart);
+#elif TARGET == LINTARGET
+        return 1000000000;
+#endif
+    }
+
+    void set_sample_rate(const long rate)
+    {
+        Atomic::store(sample_rate, rate < 0 ? 0 : rate);
+    }
+
+    void set_thread_name(const std::string &name)
+    {
+        get_thread_buffer()->set_name(name);
+    }
+
+    std::size_t write_chrome_trace(std::ostream &out)
+    {
+        std::vector<Thread_Buffer *> list;
+        {
+            boost::lock_guard<boost::mutex> guard(buffers_mutex);
+            list = buffers;
+        }
+
+        // Gather everything first so timestamps can start from the earliest event.
+        std::vector<std::vector<Event> > thread_events(list.size());
+        Ice::Long origin = 0;
+        bool have_origin = false;
+        for (std::vector<Thread_Buffer *>::size_type i = 0; i < list.size(); ++i) {
+            list[i]->copy_events(thread_events[i]);
+            std::sort(thread_events[i].begin(), thread_events[i].end(), compare_by_start);
+
+            if (!thread_events[i].empty() &&
+                (!have_origin || thread_events[i].front().start < origin)) {
+                origin = thread_events[i].front().start;
+                have_origin = true;
+            }
+        }
+
+        const double microseconds_per_tick = 1000000.0 / get_clock_frequency();
+        std::size_t written = 0;
+
+        out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        for (std::vector<Thread_Buffer *>::size_type i = 0; i < list.size(); ++i) {
+            const int tid = list[i]->get_thread_id();
+            if (i > 0) {
+                out << ",";
+            }
+            out << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":";
+            write_json_string(out, list[i]->get_name());
+            out << "}}";
+
+            const std::vector<Event> &events = thread_events[i];
+            for (std::vector<Event>::size_type j = 0; j < events.size(); ++j) {
+                out << ",\n{\"name\":";
+                write_json_string(out, events[j].name);
+                out << ",\"cat\":\"theater\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << (events[j].start - origin) * microseconds_per_tick
+                    << ",\"dur\":" << (events[j].end - events[j].start) * microseconds_per_tick
+                    << "}";
+                ++written;
+            }
+        }
+        out << "\n]}\n";
+
+        return written;
+    }
+
+    std::string dump()
+    {
+#if TARGET == WINTARGET
+        if (_access("logs", 0) != 0) {
+            (void)_mkdir("logs");
+        }
+        const char format[32] = {"logs\\trace-%m-%d-%H%M%S.json"};
+#elif TARGET == LINTARGET
+        if (access("logs", F_OK) != 0) {
+            (void)mkdir("logs", 0777);
+        }
+        const char format[32] = {"logs/trace-%m-%d-%H%M%S.json"};
+#endif
+        const time_t t = time(0);
+        struct tm current_time = tm();
+#if TARGET == WINTARGET
+        (void)localtime_s(&current_time, &t);
+#elif TARGET == LINTARGET
+        (void)localtime_r(&t, &current_time);
+#endif
+        char file_name[32];
+        (void)strftime(file_name, sizeof(file_name), format, &current_time);
+
+        std::ofstream out(file_name);
+        if (!out.is_open()) {
+            throw std::runtime_error(std::string("Cannot open ") + file_name + ".");
+        }
+
+        (void)write_chrome_trace(out);
+        if (!out) {
+            throw std::runtime_error(std::string("Cannot write ") + file_name + ".");
+        }
+
+        return file_name;
+    }
+
+    void clear()
+    {
+        boost::lock_guard<boost::mutex> guard(buffers_mutex);
+        for (std::vector<Thread_Buffer *>::size_type i = 0; i < buffers.size(); ++i) {
+            buffers[i]->clear();
+        }
+    }
+}
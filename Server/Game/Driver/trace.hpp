@@ -0,0 +1,195 @@
+/*!
+    \file   trace.hpp
+    \brief  Sampling trace points which can be compiled out entirely.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <atomic.hpp>
+
+#if TARGET == WINTARGET
+#include <windows.h>
+#elif TARGET == LINTARGET
+#include <time.h>
+#endif
+
+/*!
+    Time the rest of the enclosing scope under a name, if the thread's sampler picks it.
+    Unless VTANK_TRACE is defined this expands to nothing, so trace points cost nothing
+    in a normal build.
+    \param name String literal naming the scope.
+*/
+#ifdef VTANK_TRACE
+#define TRACE_CONCATENATE_IMPL(a, b) a##b
+#define TRACE_CONCATENATE(a, b) TRACE_CONCATENATE_IMPL(a, b)
+#define TRACE_POINT(name) const Trace::Scope TRACE_CONCATENATE(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) Trace::set_thread_name(name)
+#else
+#define TRACE_POINT(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+/*!
+    The Trace namespace collects timed scopes from trace points into a buffer per
+    thread, and writes them out as a Chrome trace (which Perfetto also reads). Every
+    buffer holds the last TRACE_BUFFER_EVENTS scopes its thread recorded.
+*/
+namespace Trace
+{
+    //! One timed scope.
+    struct Event
+    {
+        //! Name given to the trace point. Must be a string literal.
+        const char *name;
+
+        //! Clock reading when the scope was entered.
+        Ice::Long start;
+
+        //! Clock reading when the scope was left.
+        Ice::Long end;
+    };
+
+    /*!
+        Events recorded by one thread. Only the owning thread records into a buffer, so
+        its lock is only ever contended while the buffers are being written out.
+    */
+    class Thread_Buffer
+    {
+    private:
+        boost::mutex mutex;
+        std::vector<Event> events;
+        std::vector<Event>::size_type next;
+        bool wrapped;
+        long calls;
+        const int thread_id;
+        std::string name;
+
+    public:
+        explicit Thread_Buffer(const int);
+
+        /*!
+            Decide whether to record the scope being entered.
+            \param rate Record one scope in every 'rate'. Zero records nothing.
+            \return True if the scope should be timed.
+        */
+        bool sample(const long rate)
+        {
+            if (rate <= 0 || ++calls < rate) {
+                return false;
+            }
+
+            calls = 0;
+            return true;
+        }
+
+        //! Store a timed scope, replacing the oldest one if the buffer is full.
+        void record(const char *, const Ice::Long, const Ice::Long);
+
+        //! Append a copy of every stored event to a list, oldest first.
+        void copy_events(std::vector<Event> &);
+
+        //! Forget every stored event.
+        void clear();
+
+        int get_thread_id() const { return thread_id; }
+
+        //! Set the name shown for this thread in the trace.
+        void set_name(const std::string &);
+        std::string get_name();
+    };
+
+    //! One scope in every 'sample_rate' is recorded. Zero turns recording off.
+    extern volatile long sample_rate;
+
+    //! Get the calling thread's buffer, creating it on first use.
+    Thread_Buffer *get_thread_buffer();
+
+    //! Read the monotonic clock. \see get_clock_frequency()
+    inline Ice::Long get_clock()
+    {
+#if TARGET == WINTARGET
+        LARGE_INTEGER count;
+        (void)QueryPerformanceCounter(&count);
+        return static_cast<Ice::Long>(count.QuadPart);
+#elif TARGET == LINTARGET
+        struct timespec now;
+        (void)clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<Ice::Long>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#endif
+    }
+
+    //! Get the number of get_clock() ticks per second.
+    Ice::Long get_clock_frequency();
+
+    /*!
+        Set how often trace points record. Safe to call at any time.
+        \param rate Record one scope in every 'rate' on each thread; 1 records them all
+        and 0 records none.
+    */
+    void set_sample_rate(const long);
+
+    //! Name the calling thread in the trace. Use TRACE_THREAD_NAME() instead.
+    void set_thread_name(const std::string &);
+
+    /*!
+        Write every buffered event as Chrome trace JSON, which chrome://tracing and
+        Perfetto can open.
+        \param out Stream to write to.
+        \return Number of events written.
+    */
+    std::size_t write_chrome_trace(std::ostream &);
+
+    /*!
+        Write every buffered event to a new file in the "logs" directory.
+        \return Name of the file.
+        \throws std::runtime_error if the file can't be written.
+    */
+    std::string dump();
+
+    //! Forget every buffered event.
+    void clear();
+
+    //! Check whether this build was compiled with VTANK_TRACE.
+    inline bool is_compiled_in()
+    {
+#ifdef VTANK_TRACE
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    //! Times its own lifetime. Use TRACE_POINT() instead of creating one directly.
+    class Scope
+    {
+    private:
+        Thread_Buffer *buffer;
+        const char *name;
+        Ice::Long start;
+
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+
+    public:
+        explicit Scope(const char *scope_name)
+            : buffer(get_thread_buffer()), name(scope_name), start(0)
+        {
+            if (buffer->sample(Atomic::load(sample_rate))) {
+                start = get_clock();
+            }
+            else {
+                buffer = NULL;
+            }
+        }
+
+        ~Scope()
+        {
+            if (buffer != NULL) {
+                buffer->record(name, start, get_clock());
+            }
+        }
+    };
+}
+
+#endif
@@ -42,36 +42,27 @@ namespace Utility {
 		return sqrt(pow(c1.y - c2.y, 2) + pow(c1.x - c2.x, 2)) < (r1 + r2);
 	}
 
-	bool wall_collision(const projectile_ptr projectile, const Map *current_map)
+	bool wall_collision(const VTankObject::Point &circle, const float radius, const Map *current_map)
 	{
-		// Determine the range of tiles to check.
-        const int tiles_x = static_cast<int>((projectile->position.x / TILE_SIZE) + 2);
-        const int tiles_y = static_cast<int>((-projectile->position.y / TILE_SIZE) + 2);
-
-        const int min_x = static_cast<int>((projectile->position.x / TILE_SIZE) - tiles_x);
-        const int min_y = static_cast<int>((-projectile->position.y / TILE_SIZE) - tiles_y);
-        const int max_x = static_cast<int>((projectile->position.x / TILE_SIZE) + tiles_x);
-        const int max_y = static_cast<int>((-projectile->position.y / TILE_SIZE) + tiles_y);
-
-        // Determine the fake "circles" on the tank.
-        const double angle = projectile->angle;
-		const float radius = projectile->type.projectile.collision_radius;
-		VTankObject::Point circle;
-        // Calculate the offset for the circle.
-        circle.x = projectile->position.x + cos(angle) * radius;
-        circle.y = projectile->position.y + sin(angle) * radius;
-
-        // Iterate through tiles.
-        for (int y = min_y; y < current_map->get_height() && y <= max_y; y++) {
-            if (y < 0)
-                continue;
-
-            for (int x = min_x; x < current_map->get_width() && x <= max_x; x++) {
-                if (x < 0)
-                    continue;
-
-                const Tile tile = current_map->get_tile(x, y);
-				if (!tile.passable) {
+		const int tile_x = static_cast<int>(floor(circle.x / TILE_SIZE));
+		const int tile_y = static_cast<int>(floor(-circle.y / TILE_SIZE));
+
+		// Every point of the circle's tile is within sqrt(2)/2 tiles of its center, and so is
+		// every point of a wall tile, so a wall at distance d is at least d - sqrt(2) tiles away.
+		if (current_map->has_distance_field() && 
+				(current_map->get_wall_distance(tile_x, tile_y) - 1.4143) * TILE_SIZE > radius) {
+			return false;
+		}
+
+		// Only tiles under the circle's bounding box can touch it.
+        const int min_x = static_cast<int>(floor((circle.x - radius) / TILE_SIZE));
+        const int max_x = static_cast<int>(floor((circle.x + radius) / TILE_SIZE));
+        const int min_y = static_cast<int>(floor((-circle.y - radius) / TILE_SIZE));
+        const int max_y = static_cast<int>(floor((-circle.y + radius) / TILE_SIZE));
+
+        for (int y = min_y; y <= max_y; y++) {
+            for (int x = min_x; x <= max_x; x++) {
+				if (current_map->is_wall(x, y)) {
                     // Do collision check.
 					// TODO: Why is an offset necessary here?
                     const Rectangle rect(x * TILE_SIZE, -(y * TILE_SIZE + TILE_SIZE), TILE_SIZE, TILE_SIZE);
@@ -89,6 +80,71 @@ namespace Utility {
 		return false;
 	}
 
+	Grid_Traversal::Grid_Traversal(const Line &line, const double cell_width, const double cell_height)
+		: t(0)
+	{
+		// Work in cell units, with rows increasing down the map.
+		const double x1 = line.x1 / cell_width;
+		const double y1 = -line.y1 / cell_height;
+		const double dx = line.x2 / cell_width - x1;
+		const double dy = -line.y2 / cell_height - y1;
+
+		// Axes the line doesn't move along are never crossed.
+		const double NEVER = 1e30;
+
+		x = static_cast<int>(floor(x1));
+		y = static_cast<int>(floor(y1));
+		step_x = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+		step_y = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+		t_delta_x = step_x != 0 ? fabs(1.0 / dx) : NEVER;
+		t_delta_y = step_y != 0 ? fabs(1.0 / dy) : NEVER;
+		t_max_x = step_x > 0 ? (x + 1 - x1) / dx : (step_x < 0 ? (x - x1) / dx : NEVER);
+		t_max_y = step_y > 0 ? (y + 1 - y1) / dy : (step_y < 0 ? (y - y1) / dy : NEVER);
+	}
+
+	bool Grid_Traversal::next()
+	{
+		if (t_max_x < t_max_y) {
+			if (t_max_x > 1.0) {
+				return false;
+			}
+			t = t_max_x;
+			t_max_x += t_delta_x;
+			x += step_x;
+		}
+		else {
+			if (t_max_y > 1.0) {
+				return false;
+			}
+			t = t_max_y;
+			t_max_y += t_delta_y;
+			y += step_y;
+		}
+
+		return true;
+	}
+
+	bool trace_to_wall(const Map *current_map, Line &path)
+	{
+		const int width = current_map->get_width();
+		const int height = current_map->get_height();
+
+		Grid_Traversal tiles(path, TILE_SIZE, TILE_SIZE);
+		do {
+			const int tile_x = tiles.get_x();
+			const int tile_y = tiles.get_y();
+			const bool off_map = tile_x < 0 || tile_y < 0 || tile_x >= width || tile_y >= height;
+			if (off_map || current_map->is_wall(tile_x, tile_y)) {
+				const double t = tiles.get_entry();
+				path.x2 = path.x1 + (path.x2 - path.x1) * t;
+				path.y2 = path.y1 + (path.y2 - path.y1) * t;
+				return !off_map;
+			}
+		} while (tiles.next());
+
+		return false;
+	}
+
 	bool line_circle_collision(double circle_x, double circle_y,
 		double radius, double x1, double y1, double x2, double y2)
 	{
@@ -125,21 +181,19 @@ namespace Utility {
 		return false;
 	}
 
-	bool projectile_collision(const projectile_ptr projectile, const tank_ptr player)
+	bool projectile_collision(const VTankObject::Point &c1, const float bullet_radius,
+		const tank_ptr player)
 	{
-		double angle = projectile->angle;
-		const float bullet_radius = projectile->type.projectile.collision_radius;
+		return tank_projectile_collision(c1, bullet_radius,
+			player->get_position(), player->get_angle());
+	}
 
-		VTankObject::Point c1;
-        c1.x = projectile->position.x + (cos(angle) * bullet_radius);
-        c1.y = projectile->position.y + (sin(angle) * bullet_radius);
-		
-        angle = player->get_angle();
+	bool tank_projectile_collision(const VTankObject::Point &c1, const float bullet_radius,
+		const VTankObject::Point &original, const double angle)
+	{
 		const double distance_x = cos(angle) * TANK_SPHERE_RADIUS;
 		const double distance_y = sin(angle) * TANK_SPHERE_RADIUS;
 
-        const VTankObject::Point original = player->get_position();
-
 		VTankObject::Point c2(original);
         c2.x += distance_x;
         c2.y += distance_y;
@@ -152,19 +206,11 @@ namespace Utility {
 			circle_collision(c1, bullet_radius, c3, TANK_SPHERE_RADIUS));
 	}
 
-	bool projectile_collision(const projectile_ptr projectile, 
+	bool projectile_collision(const VTankObject::Point &c1, const float bullet_radius,
 		const VTankObject::Point &position, float radius)
 	{
-		double angle = projectile->angle;
-		const float bullet_radius = projectile->type.projectile.collision_radius;
-
-		VTankObject::Point c1;
-        c1.x = projectile->position.x + (cos(angle) * bullet_radius);
-        c1.y = projectile->position.y + (sin(angle) * bullet_radius);
-		
-        angle = 0;
-		const double distance_x = cos(angle) * radius;
-		const double distance_y = sin(angle) * radius;
+		const double distance_x = radius;
+		const double distance_y = 0;
 
         const VTankObject::Point original = position;
 
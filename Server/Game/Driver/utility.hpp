@@ -79,12 +79,69 @@ namespace Utility {
 	}
 
 	/*!
-		Check if a collision exists between a projectile and a wall.
-		\param projectile Projectile to test.
+		Walks the cells of a grid crossed by a line segment, in order, using the
+		Amanatides-Woo traversal: each step crosses exactly one cell boundary, so
+		no cell is skipped and none is visited twice. Rows count down from the top
+		of the map like tiles do, so a world position (x, y) is in cell
+		(floor(x / cell_width), floor(-y / cell_height)).
+	*/
+	class Grid_Traversal
+	{
+	private:
+		int x;
+		int y;
+		int step_x;
+		int step_y;
+		double t;
+		double t_max_x;
+		double t_max_y;
+		double t_delta_x;
+		double t_delta_y;
+
+	public:
+		/*!
+			Start at the cell containing the first point of the line.
+			\param line Segment to follow.
+			\param cell_width Width of a cell in pixels.
+			\param cell_height Height of a cell in pixels.
+		*/
+		Grid_Traversal(const Line &, const double, const double);
+
+		/*!
+			Step into the next cell along the line.
+			\return False if the line ends inside the current cell.
+		*/
+		bool next();
+
+		//! Column of the current cell.
+		int get_x() const { return x; }
+
+		//! Row of the current cell.
+		int get_y() const { return y; }
+
+		//! Fraction of the line, from 0 to 1, travelled before entering the current cell.
+		double get_entry() const { return t; }
+	};
+
+	/*!
+		Follow a line across the map until it enters a wall tile or leaves the map,
+		shortening it to end at that point. The tile the line starts in counts.
+		\param current_map Map to trace across.
+		\param path [in, out] Line to follow; its end is moved to where it stopped.
+		\return True if the line was stopped by a wall; false if it left the map or
+		reached its end first.
+	*/
+	bool trace_to_wall(const Map *, Line &);
+
+	/*!
+		Check if a collision exists between a circle and a wall. This only looks at the
+		tiles under the circle, and uses the map's distance field when it has one.
+		\param circle Center of the circle.
+		\param radius Radius of the circle.
 		\param current_map Map to test against.
 		\return True if a collision exists.
 	*/
-	bool wall_collision(const projectile_ptr, const Map *);
+	bool wall_collision(const VTankObject::Point &, const float, const Map *);
 
 	/*!
 		Check if a collision exists between a line segment and a circle.
@@ -110,20 +167,35 @@ namespace Utility {
 
 	/*!
 		Check if a collision exists between a projectile and a player.
-		\param projectile Projectile to test.
+		\param bullet Center of the projectile's collision circle, which leads the
+		projectile's position by its radius.
+		\param bullet_radius Collision radius of the projectile.
 		\param player Player to test against.
 		\return True if a collision exists.
 	*/
-	bool projectile_collision(const projectile_ptr, const tank_ptr);
+	bool projectile_collision(const VTankObject::Point &, const float, const tank_ptr);
+
+	/*!
+		Check if a collision exists between a projectile and a tank at some position,
+		such as where it was a few ticks ago.
+		\param bullet Center of the projectile's collision circle.
+		\param bullet_radius Collision radius of the projectile.
+		\param position Position of the tank.
+		\param angle Angle of the tank.
+		\return True if a collision exists.
+	*/
+	bool tank_projectile_collision(const VTankObject::Point &, const float,
+		const VTankObject::Point &, const double);
 
 	/*!
 		Check if a collision exists between a projectile and a circle at some point.
-		\param projectile Projectile to test.
+		\param bullet Center of the projectile's collision circle.
+		\param bullet_radius Collision radius of the projectile.
 		\param position Position of the object to test against.
 		\param radius Radius of the circle to test against.
 		\return True if a collision exists; false otherwise.
 	*/
-	bool projectile_collision(const projectile_ptr projectile, 
+	bool projectile_collision(const VTankObject::Point &bullet, const float bullet_radius,
 		const VTankObject::Point &position, float radius);
 
 	/*!
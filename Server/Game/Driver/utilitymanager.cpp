@@ -10,8 +10,6 @@
 #define DEFAULT_SPAWN_TIME 15000
 #define DEFAULT_VARIATION 5000
 
-#define EVENT_UTILITY 7
-
 //static inline double get_current_time()
 //{
 //	return static_cast<double>(IceUtil::Time::now().toMilliSeconds());
@@ -66,8 +64,7 @@ void UtilityManager::generate_spawn_points()
 		Logger::log(Logger::LOG_LEVEL_DEBUG, formatter.str());
 	}
 	
-	position_index = 0;
-	positions.clear();
+	std::vector<VTankObject::Point> spawn_points;
 	for (int y = 0; y < current_map->get_height(); ++y) {
 		for (int x = 0; x < current_map->get_width(); ++x) {
 			const Tile tile = current_map->get_tile(x, y);
@@ -77,11 +74,18 @@ void UtilityManager::generate_spawn_points()
                 point.x = (x * TILE_SIZE) + (TILE_SIZE / 2);
                 point.y = -((y * TILE_SIZE) + (TILE_SIZE / 2));
 
-                positions.push_back(point);
+                spawn_points.push_back(point);
             }
 		}
 	}
-	
+
+	set_spawn_points(spawn_points);
+}
+
+void UtilityManager::set_spawn_points(const std::vector<VTankObject::Point> &spawn_points)
+{
+	position_index = 0;
+	positions = spawn_points;
 	if (positions.size() == 0) {
 		Logger::log(Logger::LOG_LEVEL_WARNING,
 			"There are no spawn points for utilities on this map!");
@@ -7,6 +7,9 @@
 #define UTILITYMANAGER_HPP
 #include <Map.hpp>
 
+//! Event ID of the tiles utilities spawn on.
+#define EVENT_UTILITY 7
+
 //! The UtilityManager class handles when, how, and where utilities (power-ups) spawn on the map.
 /*!
 	UtilityManager must be given a current list of utilities from the server in order to know what power-ups
@@ -30,6 +33,8 @@ private:
 
 	void generate_spawn_points();
 
+	void set_spawn_points(const std::vector<VTankObject::Point> &);
+
 	void shuffle_spawn_points();
 
 public:
@@ -59,6 +64,14 @@ public:
 	*/
 	void update_map(Map *map)
 		{ current_map = map; generate_spawn_points(); }
+
+	//! Update the current map, with spawn points which were found in advance.
+	/*!
+		\param map The new map to take the old one's place.
+		\param spawn_points Every utility spawn point on the map.
+	*/
+	void update_map(Map *map, const std::vector<VTankObject::Point> &spawn_points)
+		{ current_map = map; set_spawn_points(spawn_points); }
 	
 	//! Obtain where the next utility is going to spawn, and obtain what utility that will be.
 	/*!
@@ -6,11 +6,16 @@
 #ifndef WEAPON_HPP
 #define WEAPON_HPP
 
+/*!
+	Position of a weapon, projectile or environment property in the Weapon_Table. These
+	are what tanks and projectiles hold on to; the records themselves are never copied.
+*/
+typedef unsigned short weapon_type_index;
+
 //! Contains information about in-game environmental effects, such as fire on a ground.
 struct EnvironmentProperty
 {
 	int id;
-	std::string name;
 	bool spawn_on_wall_hit;
 	bool spawn_on_player_hit;
 	bool spawn_on_expiration;
@@ -26,7 +31,6 @@ struct EnvironmentProperty
 struct Projectile
 {
 	int id;
-	std::string name;
 	float aoe_radius;
 	bool aoe_is_cone;
 	float aoe_decay;
@@ -46,14 +50,13 @@ struct Projectile
 	float jump_decay;
 	float collision_radius;
 	float object_damage_factor;
-	EnvironmentProperty *environment_property;
+	const EnvironmentProperty *environment_property; // Entry in the same Weapon_Table.
 };
 
 //! Contains information about a weapon.
 struct Weapon
 {
 	int id;
-	std::string name;
 	float cooldown;
 	float launch_angle;
 	float max_charge_time_seconds;
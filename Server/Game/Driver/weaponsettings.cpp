@@ -8,6 +8,22 @@ const static std::string WEAPON_XML_FILE = "Weapons.xml";
 const static std::string PROJECTILE_XML_FILE = "Projectiles.xml";
 const static std::string ENVIRONMENT_XML_FILE = "EnvironmentProperties.xml";
 
+//! Tables kept alive: the one in use and the one it replaced.
+const static std::vector<boost::shared_ptr<const Weapon_Table> >::size_type RETAINED_TABLES = 2;
+
+//! Read a whole file into a string.
+static std::string read_file(const std::string &path)
+{
+	std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+	if (!file) {
+		throw std::runtime_error("Cannot open " + path);
+	}
+
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
 template<class T>
 static T get_node_value(ptree::value_type &v, const std::string &node_name)
 {
@@ -26,7 +42,9 @@ static T get_node_value(ptree::value_type &v, const std::string &node_name, cons
 }
 
 Weapon_Settings::Weapon_Settings()
+	: current_table(NULL), loaded(false)
 {
+	publish(boost::shared_ptr<const Weapon_Table>(new Weapon_Table()));
 }
 
 Weapon_Settings::~Weapon_Settings()
@@ -35,21 +53,57 @@ Weapon_Settings::~Weapon_Settings()
 
 void Weapon_Settings::load()
 {
-	internal_load_environment();
-	internal_load_projectiles();
-	internal_load_weapons();
+	boost::lock_guard<boost::mutex> guard(mutex);
+
+	const std::string environment_text = read_file(ENVIRONMENT_XML_FILE);
+	const std::string projectile_text = read_file(PROJECTILE_XML_FILE);
+	const std::string weapon_text = read_file(WEAPON_XML_FILE);
+	if (loaded && environment_text == loaded_environment &&
+		projectile_text == loaded_projectiles && weapon_text == loaded_weapons) {
+		// Nothing changed; keep the table in use.
+		return;
+	}
+
+	Weapon_Table::environment_map environment_list;
+	Weapon_Table::projectile_map projectile_list;
+	Weapon_Table::weapon_map weapon_list;
+	internal_load_environment(environment_text, environment_list);
+	internal_load_projectiles(projectile_text, environment_list, projectile_list);
+	internal_load_weapons(weapon_text, projectile_list, weapon_list);
+
+	publish(boost::shared_ptr<const Weapon_Table>(new Weapon_Table(
+		environment_list, projectile_list, weapon_list, get_table())));
+
+	loaded_environment = environment_text;
+	loaded_projectiles = projectile_text;
+	loaded_weapons = weapon_text;
+	loaded = true;
+}
+
+void Weapon_Settings::publish(const boost::shared_ptr<const Weapon_Table> &table)
+{
+	tables.push_back(table);
+	Atomic::store_pointer(current_table, table.get());
+
+	// Projectiles and effects from older tables were cleared by the rotations which
+	// replaced them. The table just replaced stays for readers who looked it up a
+	// moment ago.
+	if (tables.size() > RETAINED_TABLES) {
+		tables.erase(tables.begin(), tables.end() - RETAINED_TABLES);
+	}
 }
 
-void Weapon_Settings::internal_load_environment()
+void Weapon_Settings::internal_load_environment(const std::string &text,
+												Weapon_Table::environment_map &environment_list)
 {
 	ptree data_tree;
 
-	read_xml(ENVIRONMENT_XML_FILE, data_tree);
+	std::istringstream input(text);
+	read_xml(input, data_tree);
 	
 	BOOST_FOREACH(ptree::value_type &v, data_tree.get_child("environmentProperties")) {
 		EnvironmentProperty env;
 		env.id					= get_node_value<int>(v, "id");
-		env.name				= get_node_value<std::string>(v, "name");
 		env.spawn_on_wall_hit	= get_node_value<bool>(v, "triggersUponImpactWithEnvironment", false);
 		env.spawn_on_player_hit = get_node_value<bool>(v, "triggersUponImpactWithPlayer", false);
 		env.spawn_on_expiration = get_node_value<bool>(v, "triggersUponExpiration", false);
@@ -64,16 +118,19 @@ void Weapon_Settings::internal_load_environment()
 	}
 }
 
-void Weapon_Settings::internal_load_projectiles()
+void Weapon_Settings::internal_load_projectiles(
+	const std::string &text,
+	const Weapon_Table::environment_map &environment_list,
+	Weapon_Table::projectile_map &projectile_list)
 {
 	ptree data_tree;
 
-	read_xml(PROJECTILE_XML_FILE, data_tree);
+	std::istringstream input(text);
+	read_xml(input, data_tree);
 
 	BOOST_FOREACH(ptree::value_type &v, data_tree.get_child("projectiles")) {
 		Projectile projectile;
 		projectile.id					 = get_node_value<int>(v, "id");
-		projectile.name					 = get_node_value<std::string>(v, "name");
 		projectile.aoe_radius			 = get_node_value<float>(v, "areaOfEffectRadius", 0.0f);
 		projectile.aoe_is_cone			 = get_node_value<bool>(v, "areaOfEffectUsesCone", false);
 		projectile.aoe_decay			 = get_node_value<float>(v, "areaOfEffectDecay", 0.0f);
@@ -95,25 +152,37 @@ void Weapon_Settings::internal_load_projectiles()
 		projectile.object_damage_factor  = get_node_value<float>(v, "objectDamageFactor", 1.0f);
 		int environment_id				 = get_node_value<int>(v, "environmentEffectID", -1);
 		
-		if (environment_id > -1)
-			projectile.environment_property = &environment_list[environment_id];
-		else
-			projectile.environment_property = NULL;
+		projectile.environment_property = NULL;
+		if (environment_id > -1) {
+			const Weapon_Table::environment_map::const_iterator i =
+				environment_list.find(environment_id);
+			if (i != environment_list.end()) {
+				projectile.environment_property = &i->second;
+			}
+			else {
+				std::ostringstream formatter;
+				formatter << "Projectile " << projectile.id
+					<< " refers to a missing environment property: " << environment_id;
+				Logger::log(Logger::LOG_LEVEL_WARNING, formatter.str());
+			}
+		}
 
 		projectile_list[projectile.id] = projectile;
 	}
 }
 
-void Weapon_Settings::internal_load_weapons()
+void Weapon_Settings::internal_load_weapons(const std::string &text,
+											const Weapon_Table::projectile_map &projectile_list,
+											Weapon_Table::weapon_map &weapon_list)
 {
 	ptree data_tree;
 
-	read_xml(WEAPON_XML_FILE, data_tree);
+	std::istringstream input(text);
+	read_xml(input, data_tree);
 
 	BOOST_FOREACH(ptree::value_type &v, data_tree.get_child("weapons")) {
 		Weapon weapon;
 		weapon.id								   = get_node_value<int>(v, "id");
-		weapon.name								   = get_node_value<std::string>(v, "name");
 		weapon.cooldown							   = get_node_value<float>(v, "cooldown", 0.0f);
 		weapon.launch_angle						   = RADIANS_F(get_node_value<float>(v, "launchAngle", 0.0f));
 		weapon.max_charge_time_seconds			   = get_node_value<float>(v, "maxChargeTime", 0.0f);
@@ -125,44 +194,61 @@ void Weapon_Settings::internal_load_weapons()
 		weapon.overheat_recover_start_time		   = get_node_value<float>(v, "overheatRecoverStartTime", 0.0f);
 		weapon.linear_factor					   = get_node_value<float>(v, "linearFactor", 0.0f);
 		weapon.exponent							   = get_node_value<float>(v, "exponent", 0.0f);
-		weapon.projectile						   = projectile_list[get_node_value<int>(v, "projectileID")];
-		
+		const int projectile_id					   = get_node_value<int>(v, "projectileID");
+
+		const Weapon_Table::projectile_map::const_iterator i = projectile_list.find(projectile_id);
+		if (i == projectile_list.end()) {
+			std::ostringstream formatter;
+			formatter << "Weapon " << weapon.id
+				<< " refers to a missing projectile: " << projectile_id;
+			Logger::log(Logger::LOG_LEVEL_ERROR, formatter.str());
+			continue;
+		}
+
+		weapon.projectile = i->second;
 		weapon_list[weapon.id] = weapon;
 	}
 }
 
-const EnvironmentProperty Weapon_Settings::get_environment_property(const int &id) const
+weapon_type_index Weapon_Settings::get_weapon_index(const int &id) const
 {
-	std::map<int, EnvironmentProperty>::const_iterator i = environment_list.find(id);
-	if (i == environment_list.end()) {
+	weapon_type_index index;
+	if (!get_table()->find_weapon(id, index)) {
 		std::ostringstream formatter;
-		formatter << "Environment property not found: " << id;
+		formatter << "Weapon not found: " << id;
 		throw ItemNotFoundException(formatter.str());
 	}
 
-	return i->second;
+	return index;
 }
 
-const Projectile Weapon_Settings::get_projectile(const int &id) const
+const EnvironmentProperty &Weapon_Settings::get_environment_property(const int &id) const
 {
-	std::map<int, Projectile>::const_iterator i = projectile_list.find(id);
-	if (i == projectile_list.end()) {
+	const Weapon_Table *table = get_table();
+	weapon_type_index index;
+	if (!table->find_environment_property(id, index)) {
 		std::ostringstream formatter;
-		formatter << "Projectile not found: " << id;
+		formatter << "Environment property not found: " << id;
 		throw ItemNotFoundException(formatter.str());
 	}
 
-	return i->second;
+	return table->get_environment_property(index);
 }
 
-const Weapon Weapon_Settings::get_weapon(const int &id) const
+const Projectile &Weapon_Settings::get_projectile(const int &id) const
 {
-	std::map<int, Weapon>::const_iterator i = weapon_list.find(id);
-	if (i == weapon_list.end()) {
+	const Weapon_Table *table = get_table();
+	weapon_type_index index;
+	if (!table->find_projectile(id, index)) {
 		std::ostringstream formatter;
-		formatter << "Weapon not found: " << id;
+		formatter << "Projectile not found: " << id;
 		throw ItemNotFoundException(formatter.str());
 	}
 
-	return i->second;
+	return table->get_projectile(index);
+}
+
+const Weapon &Weapon_Settings::get_weapon(const int &id) const
+{
+	return get_table()->get_weapon(get_weapon_index(id));
 }
@@ -8,7 +8,8 @@
 
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
-#include <weapon.hpp>
+#include <weapontable.hpp>
+#include <atomic.hpp>
 
 //! Exception thrown when an item wasn't found.
 class ItemNotFoundException : std::exception
@@ -21,42 +22,78 @@ public:
 		: std::exception(message.c_str()) {}
 };
 
-//! Loads weapon and projectile data from a XML database file.
+/*!
+	Loads weapon and projectile data from a XML database file into a Weapon_Table.
+	The table in use is published through a pointer, so the data can be loaded again
+	while a match is being played: readers see either the old table or the new one.
+	Files which haven't changed since the last load aren't parsed again. Only the
+	table in use and the one it replaced are kept; loads happen at map rotation,
+	after the projectiles and environment effects holding records were cleared.
+*/
 class Weapon_Settings
 {
 private:
-	std::map<int, EnvironmentProperty> environment_list;
-	std::map<int, Projectile> projectile_list;
-	std::map<int, Weapon> weapon_list;
+	boost::mutex mutex;
+	std::vector<boost::shared_ptr<const Weapon_Table> > tables;
+	const Weapon_Table * volatile current_table;
+
+	// Contents of the files behind the table in use.
+	bool loaded;
+	std::string loaded_environment;
+	std::string loaded_projectiles;
+	std::string loaded_weapons;
 	
 	//! Load environment data.
-	void internal_load_environment();
+	void internal_load_environment(const std::string &, Weapon_Table::environment_map &);
 	
 	//! Load projectile data.
-	void internal_load_projectiles();
+	void internal_load_projectiles(const std::string &, const Weapon_Table::environment_map &,
+		Weapon_Table::projectile_map &);
 	
 	//! Load weapon data.
-	void internal_load_weapons();
+	void internal_load_weapons(const std::string &, const Weapon_Table::projectile_map &,
+		Weapon_Table::weapon_map &);
+
+	//! Make a table the one in use, keeping it and the one it replaces alive.
+	void publish(const boost::shared_ptr<const Weapon_Table> &);
 	
 public:
 	Weapon_Settings();
 	~Weapon_Settings();
 	
-	//! Load weapon settings into memory.
+	//! Load weapon settings into memory, replacing any that were loaded before.
 	/*!
-		\throws Throws an exception from Boost's internal XML parser if the file
-		doesn't exist, or if the file is corrupted.
+		Safe to call while the game is running. If loading fails, or none of the
+		files changed, the table in use is left alone.
+		\throws std::runtime_error if a file can't be opened.
+		\throws Throws an exception from Boost's internal XML parser if a file is
+		corrupted.
 	*/
 	void load();
+
+	/*!
+		Get the table in use. It stays valid until the table replacing it is
+		replaced in turn, so keep indices rather than the table.
+	*/
+	const Weapon_Table *get_table() const
+	{
+		return Atomic::load_pointer(current_table);
+	}
+
+	/*!
+		Get the index of a weapon in the table.
+		\throws ItemNotFoundException if there is no weapon with the ID.
+	*/
+	weapon_type_index get_weapon_index(const int &id) const;
 	
 	//! Get an environment property from this database.
-	const EnvironmentProperty get_environment_property(const int &id) const;
+	const EnvironmentProperty &get_environment_property(const int &id) const;
 	
 	//! Get a projectile from this database.
-	const Projectile get_projectile(const int &id) const;
+	const Projectile &get_projectile(const int &id) const;
 	
 	//! Get a weapon from this database.
-	const Weapon get_weapon(const int &id) const;
+	const Weapon &get_weapon(const int &id) const;
 };
 
 #endif
@@ -0,0 +1,121 @@
+/*!
+	\file weapontable.cpp
+	\brief Implements the Weapon_Table class.
+	\author Copyright (C) 2010 by Vermont Technical College
+*/
+#include <master.hpp>
+#include <weapontable.hpp>
+
+namespace {
+	/*!
+		Lay out one kind of record. Indices from the previous table are kept, records
+		which are still defined are replaced, and new IDs are added at the end.
+		\param list New records by ID.
+		\param previous Records of the previous table, in index order.
+		\param previous_indices Index of each ID in the previous table.
+		\param records Set to the records in index order.
+		\param indices Set to the index of each ID.
+	*/
+	template <typename T>
+	void compile_records(const std::map<int, T> &list, const Record_Array<T> &previous,
+		const Weapon_Table::index_map &previous_indices, std::vector<T> &records,
+		Weapon_Table::index_map &indices)
+	{
+		records.clear();
+		for (std::size_t i = 0; i < previous.size(); ++i) {
+			records.push_back(previous[i]);
+		}
+		indices = previous_indices;
+
+		typename std::map<int, T>::const_iterator i;
+		for (i = list.begin(); i != list.end(); ++i) {
+			const Weapon_Table::index_map::const_iterator existing = indices.find(i->first);
+			if (existing != indices.end()) {
+				records[existing->second] = i->second;
+				continue;
+			}
+
+			if (records.size() >= Weapon_Table::MAX_RECORDS) {
+				std::ostringstream formatter;
+				formatter << "Too many weapon table records: " << records.size();
+				throw std::runtime_error(formatter.str());
+			}
+
+			indices[i->first] = static_cast<weapon_type_index>(records.size());
+			records.push_back(i->second);
+		}
+	}
+
+	bool find_index(const Weapon_Table::index_map &indices, const int id,
+		weapon_type_index &index)
+	{
+		const Weapon_Table::index_map::const_iterator i = indices.find(id);
+		if (i == indices.end()) {
+			return false;
+		}
+
+		index = i->second;
+		return true;
+	}
+}
+
+Weapon_Table::Weapon_Table()
+{
+}
+
+Weapon_Table::Weapon_Table(const environment_map &environment_list,
+						   const projectile_map &projectile_list,
+						   const weapon_map &weapon_list, const Weapon_Table *previous)
+{
+	const Weapon_Table empty_table;
+	if (previous == NULL) {
+		previous = &empty_table;
+	}
+
+	std::vector<EnvironmentProperty> environment_records;
+	compile_records(environment_list, previous->environments, previous->environment_indices,
+		environment_records, environment_indices);
+	environments.assign(environment_records);
+
+	// Projectiles and weapons are fixed up to point at this table's records before
+	// they are copied in, since the records can't be changed afterwards.
+	std::vector<Projectile> projectile_records;
+	compile_records(projectile_list, previous->projectiles, previous->projectile_indices,
+		projectile_records, projectile_indices);
+	for (std::size_t i = 0; i < projectile_records.size(); ++i) {
+		Projectile &projectile = projectile_records[i];
+		weapon_type_index index;
+		if (projectile.environment_property != NULL &&
+			find_environment_property(projectile.environment_property->id, index)) {
+			projectile.environment_property = &environments[index];
+		}
+	}
+	projectiles.assign(projectile_records);
+
+	std::vector<Weapon> weapon_records;
+	compile_records(weapon_list, previous->weapons, previous->weapon_indices,
+		weapon_records, weapon_indices);
+	for (std::size_t i = 0; i < weapon_records.size(); ++i) {
+		Weapon &weapon = weapon_records[i];
+		weapon_type_index index;
+		if (find_projectile(weapon.projectile.id, index)) {
+			weapon.projectile = projectiles[index];
+		}
+	}
+	weapons.assign(weapon_records);
+}
+
+bool Weapon_Table::find_environment_property(const int id, weapon_type_index &index) const
+{
+	return find_index(environment_indices, id, index);
+}
+
+bool Weapon_Table::find_projectile(const int id, weapon_type_index &index) const
+{
+	return find_index(projectile_indices, id, index);
+}
+
+bool Weapon_Table::find_weapon(const int id, weapon_type_index &index) const
+{
+	return find_index(weapon_indices, id, index);
+}
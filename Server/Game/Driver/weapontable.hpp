@@ -0,0 +1,145 @@
+/*!
+	\file weapontable.hpp
+	\brief Read-only table of weapons, projectiles and environment properties.
+	\author Copyright (C) 2010 by Vermont Technical College
+*/
+#ifndef WEAPONTABLE_HPP
+#define WEAPONTABLE_HPP
+
+#include <weapon.hpp>
+
+/*!
+	Fixed array of records which starts on a cache line, with every record padded out to
+	a whole number of cache lines so that reading one never drags in part of another.
+	Records must be plain data: they are copied in once and never destroyed.
+*/
+template <typename T>
+class Record_Array
+{
+private:
+	std::vector<char> storage;
+	char *first;
+	std::size_t count;
+
+	// Records are handed out by address, so the array can't be copied.
+	Record_Array(const Record_Array &);
+	Record_Array &operator=(const Record_Array &);
+
+public:
+	//! Distance in bytes from one record to the next.
+	static const std::size_t STRIDE =
+		((sizeof(T) + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+
+	Record_Array() : first(NULL), count(0) {}
+
+	/*!
+		Fill the array. Only called while the owning table is being built.
+		\param records Records to copy in, in index order.
+	*/
+	void assign(const std::vector<T> &records)
+	{
+		count = records.size();
+		storage.assign(count * STRIDE + CACHE_LINE_SIZE, 0);
+
+		const std::size_t address = reinterpret_cast<std::size_t>(&storage[0]);
+		first = &storage[0] + (CACHE_LINE_SIZE - address % CACHE_LINE_SIZE) % CACHE_LINE_SIZE;
+		for (std::size_t i = 0; i < count; ++i) {
+			*reinterpret_cast<T *>(first + i * STRIDE) = records[i];
+		}
+	}
+
+	const T &operator[](const std::size_t index) const
+	{
+		return *reinterpret_cast<const T *>(first + index * STRIDE);
+	}
+
+	std::size_t size() const { return count; }
+};
+
+/*!
+	Weapons, projectiles and environment properties compiled into flat arrays which never
+	change once built. Tanks and projectiles refer to their type by a 16-bit index into
+	the table, and each weapon carries its own projectile, so finding everything about a
+	shot costs one lookup and no copies.
+
+	A table can be built from the one it replaces, in which case every ID keeps the index
+	it had before and IDs that have gone away keep their old record. Indices held by
+	tanks and projectiles in play therefore stay good across a reload.
+*/
+class Weapon_Table
+{
+public:
+	typedef std::map<int, EnvironmentProperty> environment_map;
+	typedef std::map<int, Projectile> projectile_map;
+	typedef std::map<int, Weapon> weapon_map;
+	typedef std::map<int, weapon_type_index> index_map;
+
+	//! Most records of one kind that a table can hold.
+	static const std::size_t MAX_RECORDS = 0xFFFF;
+
+private:
+	Record_Array<EnvironmentProperty> environments;
+	Record_Array<Projectile> projectiles;
+	Record_Array<Weapon> weapons;
+	index_map environment_indices;
+	index_map projectile_indices;
+	index_map weapon_indices;
+
+	Weapon_Table(const Weapon_Table &);
+	Weapon_Table &operator=(const Weapon_Table &);
+
+public:
+	//! Build an empty table.
+	Weapon_Table();
+
+	/*!
+		Compile parsed weapon data into a table.
+		\param environment_list Environment properties by ID.
+		\param projectile_list Projectiles by ID. Their environment property pointers
+		may point anywhere; they are matched up with the new records by ID.
+		\param weapon_list Weapons by ID. Their projectile is replaced by the new record
+		with the same ID.
+		\param previous Table this one replaces, or NULL.
+		\throws std::runtime_error if there are more than MAX_RECORDS of one kind.
+	*/
+	Weapon_Table(const environment_map &, const projectile_map &, const weapon_map &,
+		const Weapon_Table *previous = NULL);
+
+	//! Get an environment property by index.
+	const EnvironmentProperty &get_environment_property(const weapon_type_index index) const
+	{
+		return environments[index];
+	}
+
+	//! Get a projectile by index.
+	const Projectile &get_projectile(const weapon_type_index index) const
+	{
+		return projectiles[index];
+	}
+
+	//! Get a weapon by index.
+	const Weapon &get_weapon(const weapon_type_index index) const
+	{
+		return weapons[index];
+	}
+
+	/*!
+		Find the index of an environment property.
+		\param id ID of the environment property.
+		\param index Set to its index if it was found.
+		\return True if the environment property is in the table.
+	*/
+	bool find_environment_property(const int, weapon_type_index &) const;
+
+	//! Find the index of a projectile. \see find_environment_property()
+	bool find_projectile(const int, weapon_type_index &) const;
+
+	//! Find the index of a weapon. \see find_environment_property()
+	bool find_weapon(const int, weapon_type_index &) const;
+
+	std::size_t get_environment_count() const { return environments.size(); }
+	std::size_t get_projectile_count() const { return projectiles.size(); }
+	std::size_t get_weapon_count() const { return weapons.size(); }
+};
+
+#endif
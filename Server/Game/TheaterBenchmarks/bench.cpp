@@ -0,0 +1,43 @@
+/*!
+    \file   bench.cpp
+    \brief  Entry point for the Theater benchmarks.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <benchmark.hpp>
+#include <snapshotbenchmarks.hpp>
+#include <collisionbenchmarks.hpp>
+#include <instantweaponbenchmarks.hpp>
+#include <projectilebenchmarks.hpp>
+#include <loadbenchmarks.hpp>
+#include <lagcompensationbenchmarks.hpp>
+
+void register_benchmarks()
+{
+    snapshot_register_benchmarks();
+    collision_register_benchmarks();
+    instant_weapon_register_benchmarks();
+    projectile_register_benchmarks();
+    load_register_benchmarks();
+    lag_compensation_register_benchmarks();
+}
+
+int main(int argc, char* argv[])
+{
+    std::ostream *output = &std::cout;
+    std::ofstream output_file;
+
+    if (argc == 2) {
+        output_file.open(argv[1]);
+        if (!output_file) {
+            std::cerr << "Unable to open " << argv[1] << " for output!\n";
+            return EXIT_FAILURE;
+        }
+        output = &output_file;
+    }
+
+    register_benchmarks();
+    return Benchmark::execute_benchmarks(*output) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,61 @@
+/*!
+    \file   benchmark.cpp
+    \brief  Implementation of the Theater benchmark registry.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <benchmark.hpp>
+
+namespace {
+    struct Registered_Benchmark
+    {
+        Benchmark::benchmark_t function;
+        const char *title;
+    };
+
+    std::vector<Registered_Benchmark> benchmarks;
+}
+
+namespace Benchmark {
+    void register_benchmark(benchmark_t benchmark_function, const char *benchmark_title)
+    {
+        Registered_Benchmark benchmark;
+        benchmark.function = benchmark_function;
+        benchmark.title = benchmark_title;
+        benchmarks.push_back(benchmark);
+    }
+
+    int execute_benchmarks(std::ostream &output)
+    {
+        int failures = 0;
+        for (std::vector<Registered_Benchmark>::size_type i = 0; i < benchmarks.size(); ++i) {
+            output << "== " << benchmarks[i].title << " ==" << std::endl;
+            try {
+                benchmarks[i].function(output);
+            }
+            catch (const std::exception &e) {
+                output << "FAILED: " << e.what() << std::endl;
+                ++failures;
+            }
+            output << std::endl;
+        }
+
+        return failures;
+    }
+
+    Stopwatch::Stopwatch()
+        : start(get_precise_time())
+    {
+    }
+
+    void Stopwatch::restart()
+    {
+        start = get_precise_time();
+    }
+
+    double Stopwatch::elapsed_ms() const
+    {
+        return get_precise_time() - start;
+    }
+}
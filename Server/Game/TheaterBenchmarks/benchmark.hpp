@@ -0,0 +1,46 @@
+/*!
+    \file   benchmark.hpp
+    \brief  Minimal registry and timing helpers for the Theater benchmarks.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <iostream>
+
+namespace Benchmark {
+    //! A benchmark writes its results, one "name: value unit" line per figure, to the stream.
+    typedef void (*benchmark_t)(std::ostream &);
+
+    /*!
+        Add a benchmark to the list run by execute_benchmarks().
+        \param benchmark_function Function to run.
+        \param benchmark_title Title printed above the results.
+    */
+    void register_benchmark(benchmark_t, const char *);
+
+    /*!
+        Run every registered benchmark in the order they were registered.
+        \param output Stream to write the results to.
+        \return Number of benchmarks which threw an exception.
+    */
+    int execute_benchmarks(std::ostream &);
+
+    //! Measures elapsed wall time with sub-millisecond precision.
+    class Stopwatch
+    {
+    private:
+        double start;
+
+    public:
+        Stopwatch();
+
+        //! Start timing again from now.
+        void restart();
+
+        //! Milliseconds since construction or the last restart().
+        double elapsed_ms() const;
+    };
+}
+
+#endif
@@ -0,0 +1,153 @@
+/*!
+    \file   collisionbenchmarks.cpp
+    \brief  Cost of projectile wall collision checks on a large map.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <Map.hpp>
+#include <tank.hpp>
+#include <utility.hpp>
+#include <benchmark.hpp>
+#include <collisionbenchmarks.hpp>
+
+namespace {
+    const int MAP_SIZE = 200;
+    const int CHECK_COUNT = 200000;
+
+    //! Projectile collision radius used by every projectile in Projectiles.xml.
+    const float RADIUS = 8.0f;
+
+    //! Deterministic generator, so runs are comparable.
+    class Random
+    {
+    private:
+        unsigned long state;
+
+    public:
+        Random() : state(4321) {}
+
+        double next()
+        {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            return static_cast<double>(state) / 0x7FFFFFFF;
+        }
+    };
+
+    //! The wall check as it was before the map kept a wall bitset: it scans every tile
+    //! from -2 to about twice the circle's tile coordinates, copying each one.
+    bool scanning_wall_collision(const VTankObject::Point &circle, const float radius, const Map *current_map)
+    {
+        const int tiles_x = static_cast<int>((circle.x / TILE_SIZE) + 2);
+        const int tiles_y = static_cast<int>((-circle.y / TILE_SIZE) + 2);
+
+        const int min_x = static_cast<int>((circle.x / TILE_SIZE) - tiles_x);
+        const int min_y = static_cast<int>((-circle.y / TILE_SIZE) - tiles_y);
+        const int max_x = static_cast<int>((circle.x / TILE_SIZE) + tiles_x);
+        const int max_y = static_cast<int>((-circle.y / TILE_SIZE) + tiles_y);
+
+        for (int y = min_y; y < current_map->get_height() && y <= max_y; y++) {
+            if (y < 0)
+                continue;
+
+            for (int x = min_x; x < current_map->get_width() && x <= max_x; x++) {
+                if (x < 0)
+                    continue;
+
+                const Tile tile = current_map->get_tile(x, y);
+                if (!tile.passable) {
+                    const Utility::Rectangle rect(x * TILE_SIZE, -(y * TILE_SIZE + TILE_SIZE), TILE_SIZE, TILE_SIZE);
+                    if (Utility::circle_to_rectangle_collision(circle, radius, rect))
+                        return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    //! Scatter walls over the map: single blocks plus a few long walls.
+    void build_map(Map &map, Random &random, const double block_density)
+    {
+        map.create(MAP_SIZE, MAP_SIZE, "benchmark");
+        for (int y = 0; y < MAP_SIZE; ++y) {
+            for (int x = 0; x < MAP_SIZE; ++x) {
+                if (random.next() < block_density) {
+                    map.set_tile_collision(x, y, false);
+                }
+            }
+        }
+        for (int i = 0; i < MAP_SIZE / 4; ++i) {
+            const int x = static_cast<int>(random.next() * MAP_SIZE);
+            const int y = static_cast<int>(random.next() * MAP_SIZE);
+            for (int j = 0; j < 12 && x + j < MAP_SIZE; ++j) {
+                map.set_tile_collision(x + j, y, false);
+            }
+        }
+    }
+
+    typedef bool (*wall_check_t)(const VTankObject::Point &, const float, const Map *);
+
+    double time_checks(wall_check_t check, const Map &map, 
+        const std::vector<VTankObject::Point> &points, std::vector<bool> &results)
+    {
+        results.assign(points.size(), false);
+        Benchmark::Stopwatch stopwatch;
+        for (std::vector<VTankObject::Point>::size_type i = 0; i < points.size(); ++i) {
+            results[i] = check(points[i], RADIUS, &map);
+        }
+        return stopwatch.elapsed_ms();
+    }
+
+    void run_wall_collision_benchmark(std::ostream &output, const double block_density)
+    {
+        Random random;
+        Map map;
+        build_map(map, random, block_density);
+
+        Map map_with_field(map);
+        map_with_field.build_distance_field();
+
+        // Projectiles anywhere on the map; the old scan gets slower further from the origin.
+        std::vector<VTankObject::Point> points(CHECK_COUNT);
+        for (std::vector<VTankObject::Point>::size_type i = 0; i < points.size(); ++i) {
+            points[i].x = random.next() * MAP_SIZE * TILE_SIZE;
+            points[i].y = -random.next() * MAP_SIZE * TILE_SIZE;
+        }
+
+        std::vector<bool> scan_results, bitset_results, field_results;
+        const double scan_ms = time_checks(scanning_wall_collision, map, points, scan_results);
+        const double bitset_ms = time_checks(Utility::wall_collision, map, points, bitset_results);
+        const double field_ms = time_checks(Utility::wall_collision, map_with_field, points, field_results);
+
+        if (scan_results != bitset_results || scan_results != field_results) {
+            throw std::logic_error("Wall collision results differ from the tile scan.");
+        }
+
+        Benchmark::Stopwatch stopwatch;
+        Map field_timing(map);
+        field_timing.build_distance_field();
+        const double build_ms = stopwatch.elapsed_ms();
+
+        const long hits = static_cast<long>(std::count(scan_results.begin(), scan_results.end(), true));
+        const double to_ns = 1000000.0 / CHECK_COUNT;
+
+        output << "map: " << MAP_SIZE << "x" << MAP_SIZE << " tiles, " << block_density * 100 
+               << "% scattered blocks, checks: " << CHECK_COUNT << ", hits: " << hits << std::endl;
+        output << "tile scan: " << scan_ms * to_ns << " ns/check" << std::endl;
+        output << "wall bitset: " << bitset_ms * to_ns << " ns/check" << std::endl;
+        output << "bitset + distance field: " << field_ms * to_ns << " ns/check" << std::endl;
+        output << "distance field build: " << build_ms << " ms" << std::endl;
+    }
+
+    void wall_collision_benchmark(std::ostream &output)
+    {
+        run_wall_collision_benchmark(output, 0.05);
+        run_wall_collision_benchmark(output, 0.002);
+    }
+}
+
+void collision_register_benchmarks()
+{
+    Benchmark::register_benchmark(wall_collision_benchmark, "Projectile Wall Collision");
+}
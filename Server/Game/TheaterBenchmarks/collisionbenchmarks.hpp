@@ -0,0 +1,11 @@
+/*!
+    \file   collisionbenchmarks.hpp
+    \brief  Benchmarks for wall collision checks.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef COLLISIONBENCHMARKS_HPP
+#define COLLISIONBENCHMARKS_HPP
+
+extern void collision_register_benchmarks();
+
+#endif
@@ -0,0 +1,214 @@
+/*!
+    \file   instantweaponbenchmarks.cpp
+    \brief  Cost of finding what a long range instant weapon hits with 64 tanks in play.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <nodemanager.hpp>
+#include <utility.hpp>
+#include <benchmark.hpp>
+#include <instantweaponbenchmarks.hpp>
+#include <GameSession.h>
+
+namespace {
+    const int MAP_SIZE = 100;
+    const int TANK_COUNT = 64;
+    const int SHOT_COUNT = 20000;
+
+    //! Range of the longest instant weapon in Projectiles.xml.
+    const double RANGE = 5000;
+
+    const double TANK_RADIUS = TANK_SPHERE_RADIUS + 15.0;
+
+    //! Deterministic generator, so runs are comparable.
+    class Random
+    {
+    private:
+        unsigned long state;
+
+    public:
+        Random() : state(8642) {}
+
+        double next()
+        {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            return static_cast<double>(state) / 0x7FFFFFFF;
+        }
+    };
+
+    struct Shot
+    {
+        VTankObject::Point origin;
+        double angle;
+    };
+
+    //! How handle_instant_weapon() found the end of the path before the grid traversal.
+    void march_to_wall(const Map *current_map, const double angle, Utility::Line &path)
+    {
+        const double x_inc = 12;
+        const double y_inc = 12;
+        int last_tile_x = -1;
+        int last_tile_y = -1;
+        double y = path.y1, x = path.x1;
+        while (true) {
+            if (abs(x - path.x2) <= x_inc || abs(y - path.y2) <= y_inc) {
+                return;
+            }
+
+            x += cos(angle) * x_inc;
+            y += sin(angle) * y_inc;
+
+            const int tile_x = static_cast<int>(floor(x / TILE_SIZE));
+            const int tile_y = static_cast<int>(floor(-y / TILE_SIZE));
+            if (tile_x == last_tile_x && tile_y == last_tile_y) {
+                continue;
+            }
+            last_tile_x = tile_x;
+            last_tile_y = tile_y;
+
+            if (tile_x < 0 || tile_y < 0 || tile_x >= current_map->get_width() || 
+                    tile_y >= current_map->get_height()) {
+                path.x2 = x;
+                path.y2 = y;
+                return;
+            }
+
+            if (current_map->is_wall(tile_x, tile_y)) {
+                path.x2 = x + cos(angle) * x_inc;
+                path.y2 = y + sin(angle) * y_inc;
+                return;
+            }
+        }
+    }
+
+    int count_hits(const tank_array &tanks, const Utility::Line &path)
+    {
+        int hits = 0;
+        for (tank_array::const_iterator i = tanks.begin(); i != tanks.end(); ++i) {
+            const VTankObject::Point pos = (*i)->get_position();
+            if (Utility::line_circle_collision(pos.x, pos.y, TANK_RADIUS,
+                    path.x1, path.y1, path.x2, path.y2)) {
+                ++hits;
+            }
+        }
+        return hits;
+    }
+
+    Utility::Line make_path(const Shot &shot)
+    {
+        return Utility::Line(shot.origin.x, shot.origin.y,
+            shot.origin.x + cos(shot.angle) * RANGE, shot.origin.y + sin(shot.angle) * RANGE);
+    }
+
+    //! The old path: march, then copy and scan every tank.
+    double time_marching(const Map &map, const tank_array &tanks, const std::vector<Shot> &shots,
+        std::vector<int> &hits)
+    {
+        hits.assign(shots.size(), 0);
+        Benchmark::Stopwatch stopwatch;
+        for (std::vector<Shot>::size_type i = 0; i < shots.size(); ++i) {
+            Utility::Line path = make_path(shots[i]);
+            march_to_wall(&map, shots[i].angle, path);
+            const tank_array all_tanks(tanks);
+            hits[i] = count_hits(all_tanks, path);
+        }
+        return stopwatch.elapsed_ms();
+    }
+
+    //! The new path: trace the tiles, then scan tanks near the nodes crossed.
+    double time_tracing(const Map &map, const NodeManager &nodes, const std::vector<Shot> &shots,
+        std::vector<Utility::Line> &paths, std::vector<int> &hits)
+    {
+        paths.assign(shots.size(), Utility::Line());
+        hits.assign(shots.size(), 0);
+        tank_array candidates;
+        Benchmark::Stopwatch stopwatch;
+        for (std::vector<Shot>::size_type i = 0; i < shots.size(); ++i) {
+            Utility::Line path = make_path(shots[i]);
+            Utility::trace_to_wall(&map, path);
+            nodes.get_players_near_line(path.x1, path.y1, path.x2, path.y2, candidates);
+            hits[i] = count_hits(candidates, path);
+            paths[i] = path;
+        }
+        return stopwatch.elapsed_ms();
+    }
+
+    void run_instant_weapon_benchmark(std::ostream &output, const double block_density)
+    {
+        Random random;
+        Map map;
+        map.create(MAP_SIZE, MAP_SIZE, "benchmark");
+        for (int y = 0; y < MAP_SIZE; ++y) {
+            for (int x = 0; x < MAP_SIZE; ++x) {
+                if (random.next() < block_density) {
+                    map.set_tile_collision(x, y, false);
+                }
+            }
+        }
+
+        NodeManager nodes;
+        nodes.set_map(&map);
+
+        tank_array tanks;
+        for (int i = 0; i < TANK_COUNT; ++i) {
+            GameSession::Tank data;
+            data.id = i;
+            tank_ptr tank(new Tank(data, player_ptr(new PlayerInfo(NULL, NULL)), GameSession::NONE));
+
+            VTankObject::Point pos;
+            pos.x = random.next() * MAP_SIZE * TILE_SIZE;
+            pos.y = -random.next() * MAP_SIZE * TILE_SIZE;
+            tank->set_position(pos);
+            nodes.process_position(tank);
+            tanks.push_back(tank);
+        }
+        nodes.rebuild(tanks);
+
+        // Every shot comes from a tank, in any direction.
+        std::vector<Shot> shots(SHOT_COUNT);
+        for (std::vector<Shot>::size_type i = 0; i < shots.size(); ++i) {
+            shots[i].origin = tanks[i % tanks.size()]->get_position();
+            shots[i].angle = random.next() * 2 * PI;
+        }
+
+        std::vector<int> marching_hits, tracing_hits;
+        std::vector<Utility::Line> paths;
+        const double marching_ms = time_marching(map, tanks, shots, marching_hits);
+        const double tracing_ms = time_tracing(map, nodes, shots, paths, tracing_hits);
+
+        // The march stops at slightly different points, so check the candidates against
+        // a scan of every tank along the traced paths instead.
+        long hits = 0;
+        for (std::vector<Utility::Line>::size_type i = 0; i < paths.size(); ++i) {
+            // The shooter always counts itself here; the game skips the owner.
+            if (count_hits(tanks, paths[i]) != tracing_hits[i]) {
+                throw std::logic_error("Tanks near the line missed a hit found by scanning every tank.");
+            }
+            hits += tracing_hits[i];
+        }
+
+        double traced_length = 0;
+        for (std::vector<Utility::Line>::size_type i = 0; i < paths.size(); ++i) {
+            traced_length += sqrt(pow(paths[i].x2 - paths[i].x1, 2) + pow(paths[i].y2 - paths[i].y1, 2));
+        }
+
+        const double to_us = 1000.0 / SHOT_COUNT;
+        output << "map: " << MAP_SIZE << "x" << MAP_SIZE << " tiles, " << block_density * 100
+               << "% walls, tanks: " << TANK_COUNT << ", shots: " << SHOT_COUNT << ", range: " << RANGE
+               << ", mean path: " << traced_length / SHOT_COUNT << ", hits: " << hits << std::endl;
+        output << "march + every tank: " << marching_ms * to_us << " us/shot" << std::endl;
+        output << "grid traversal + nearby tanks: " << tracing_ms * to_us << " us/shot" << std::endl;
+    }
+
+    void instant_weapon_benchmark(std::ostream &output)
+    {
+        run_instant_weapon_benchmark(output, 0.02);
+        run_instant_weapon_benchmark(output, 0.0);
+    }
+}
+
+void instant_weapon_register_benchmarks()
+{
+    Benchmark::register_benchmark(instant_weapon_benchmark, "Instant Weapon Hit Detection");
+}
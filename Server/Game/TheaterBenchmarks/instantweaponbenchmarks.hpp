@@ -0,0 +1,11 @@
+/*!
+    \file   instantweaponbenchmarks.hpp
+    \brief  Benchmarks for instant weapon hit detection.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef INSTANTWEAPONBENCHMARKS_HPP
+#define INSTANTWEAPONBENCHMARKS_HPP
+
+extern void instant_weapon_register_benchmarks();
+
+#endif
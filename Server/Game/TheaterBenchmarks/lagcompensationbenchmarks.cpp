@@ -0,0 +1,165 @@
+/*!
+    \file   lagcompensationbenchmarks.cpp
+    \brief  Cost of recording and rewinding the position histories of 64 tanks.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <Map.hpp>
+#include <tank.hpp>
+#include <lagcompensation.hpp>
+#include <utility.hpp>
+#include <benchmark.hpp>
+#include <lagcompensationbenchmarks.hpp>
+#include <GameSession.h>
+
+namespace {
+    const int TANK_COUNT = 64;
+    const int TICK_COUNT = 20000;
+    const int SHOT_COUNT = 20000;
+    const double ARENA_SIZE = 5000;
+    const double RANGE = 5000;
+    const double TANK_RADIUS = TANK_SPHERE_RADIUS + 15.0;
+
+    //! Deterministic generator, so runs are comparable.
+    class Random
+    {
+    private:
+        unsigned long state;
+
+    public:
+        Random() : state(1357) {}
+
+        double next()
+        {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            return static_cast<double>(state) / 0x7FFFFFFF;
+        }
+    };
+
+    struct Shot
+    {
+        Utility::Line path;
+        double rewind;
+    };
+
+    //! Tank positions as a function of the tick: each tank drives in its own circle.
+    VTankObject::Point position_at(const int tank, const Ice::Long tick)
+    {
+        const double angle = tank + tick * 0.01;
+        VTankObject::Point position;
+        position.x = (tank % 8 + 0.5) * ARENA_SIZE / 8 + cos(angle) * 200;
+        position.y = -(tank / 8 + 0.5) * ARENA_SIZE / 8 + sin(angle) * 200;
+        return position;
+    }
+
+    //! Hits along every shot against the tanks where they are now.
+    double time_current(const tank_array &tanks, const std::vector<Shot> &shots, long &hits)
+    {
+        hits = 0;
+        Benchmark::Stopwatch stopwatch;
+        for (std::vector<Shot>::size_type i = 0; i < shots.size(); ++i) {
+            const Utility::Line &path = shots[i].path;
+            for (tank_array::size_type j = 0; j < tanks.size(); ++j) {
+                const VTankObject::Point position = tanks[j]->get_position();
+                if (Utility::line_circle_collision(position.x, position.y, TANK_RADIUS,
+                        path.x1, path.y1, path.x2, path.y2)) {
+                    ++hits;
+                }
+            }
+        }
+        return stopwatch.elapsed_ms();
+    }
+
+    //! Hits along every shot against the tanks where the shooter saw them.
+    double time_rewound(const tank_array &tanks, const std::vector<Shot> &shots, long &hits)
+    {
+        hits = 0;
+        Benchmark::Stopwatch stopwatch;
+        for (std::vector<Shot>::size_type i = 0; i < shots.size(); ++i) {
+            const Utility::Line &path = shots[i].path;
+            for (tank_array::size_type j = 0; j < tanks.size(); ++j) {
+                const Position_History &history = tanks[j]->get_history();
+                Position_Record seen;
+                if (!history.rewind(history.get_newest_tick() - shots[i].rewind, seen) ||
+                        !seen.alive) {
+                    continue;
+                }
+
+                if (Utility::line_circle_collision(seen.position.x, seen.position.y, TANK_RADIUS,
+                        path.x1, path.y1, path.x2, path.y2)) {
+                    ++hits;
+                }
+            }
+        }
+        return stopwatch.elapsed_ms();
+    }
+
+    void lag_compensation_benchmark(std::ostream &output)
+    {
+        Random random;
+        tank_array tanks;
+        for (int i = 0; i < TANK_COUNT; ++i) {
+            GameSession::Tank data;
+            data.id = i;
+            tanks.push_back(tank_ptr(
+                new Tank(data, player_ptr(new PlayerInfo(NULL, NULL)), GameSession::NONE)));
+        }
+
+        // What the simulation does at the end of every tick.
+        std::vector<VTankObject::Point> positions(TANK_COUNT);
+        Benchmark::Stopwatch record_stopwatch;
+        for (Ice::Long tick = 0; tick < TICK_COUNT; ++tick) {
+            for (int i = 0; i < TANK_COUNT; ++i) {
+                positions[i] = position_at(i, tick);
+                tanks[i]->get_history().record(tick, positions[i], 0, true);
+            }
+        }
+        const double record_ms = record_stopwatch.elapsed_ms();
+
+        for (int i = 0; i < TANK_COUNT; ++i) {
+            tanks[i]->set_position(positions[i]);
+        }
+
+        // Shots from any tank in any direction, by players up to the longest rewind behind.
+        const double max_ticks = static_cast<double>(DEFAULT_MAX_REWIND) / FRAME_PROCESS_INTERVAL;
+        std::vector<Shot> shots(SHOT_COUNT);
+        for (std::vector<Shot>::size_type i = 0; i < shots.size(); ++i) {
+            const VTankObject::Point &origin = positions[i % TANK_COUNT];
+            const double angle = random.next() * 2 * PI;
+            shots[i].path = Utility::Line(origin.x, origin.y,
+                origin.x + cos(angle) * RANGE, origin.y + sin(angle) * RANGE);
+            shots[i].rewind = random.next() * max_ticks;
+        }
+
+        long current_hits = 0;
+        long rewound_hits = 0;
+        const double current_ms = time_current(tanks, shots, current_hits);
+        const double rewound_ms = time_rewound(tanks, shots, rewound_hits);
+
+        // A shot rewound by nothing must see what is there now.
+        for (std::vector<Shot>::size_type i = 0; i < shots.size(); ++i) {
+            shots[i].rewind = 0;
+        }
+        long unrewound_hits = 0;
+        (void)time_rewound(tanks, shots, unrewound_hits);
+        if (unrewound_hits != current_hits) {
+            throw std::logic_error("Rewinding by no ticks found different hits.");
+        }
+
+        const double per_shot = 1000.0 / SHOT_COUNT;
+        output << "tanks: " << TANK_COUNT << ", history: " << POSITION_HISTORY_TICKS
+               << " ticks, shots: " << SHOT_COUNT << ", rewind: up to " << DEFAULT_MAX_REWIND
+               << " ms, hits now: " << current_hits << ", hits rewound: " << rewound_hits << std::endl;
+        output << "record every tank: " << record_ms * 1000.0 / TICK_COUNT << " us/tick" << std::endl;
+        output << "check every tank now: " << current_ms * per_shot << " us/shot" << std::endl;
+        output << "check every tank rewound: " << rewound_ms * per_shot << " us/shot" << std::endl;
+        output << "rewind one tank: " << (rewound_ms - current_ms) * per_shot * 1000.0 / TANK_COUNT
+               << " ns more" << std::endl;
+    }
+}
+
+void lag_compensation_register_benchmarks()
+{
+    Benchmark::register_benchmark(lag_compensation_benchmark, "Lag Compensation Rewind");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   lagcompensationbenchmarks.hpp
+    \brief  Benchmarks for rewinding tanks to judge lagging players' shots.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef LAGCOMPENSATIONBENCHMARKS_HPP
+#define LAGCOMPENSATIONBENCHMARKS_HPP
+
+extern void lag_compensation_register_benchmarks();
+
+#endif
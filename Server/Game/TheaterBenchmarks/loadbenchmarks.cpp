@@ -0,0 +1,473 @@
+/*!
+    \file   loadbenchmarks.cpp
+    \brief  Headless load test: scripted bots move, turn and fire on a map while the game
+            is stepped as fast as it will go, for growing numbers of bots.
+    \author (C) Copyright 2010 by Vermont Technical College
+
+    Every bot's ClientEventCallback is a local servant which only counts what it is sent,
+    reached over loopback TCP the way a real client would be. Set VTANK_LOAD_TEST_MAP to
+    the path of a .vtmap to play on it; otherwise the bots play on a generated arena.
+    Weapons.xml, Projectiles.xml and EnvironmentProperties.xml must be in the working
+    directory.
+*/
+
+#include <master.hpp>
+#include <memory>
+#include <gamemanager.hpp>
+#include <playermanager.hpp>
+#include <pointmanager.hpp>
+#include <mapmanager.hpp>
+#include <gameinstance.hpp>
+#include <logger.hpp>
+#include <benchmark.hpp>
+#include <loadbenchmarks.hpp>
+
+namespace {
+    //! Allocations are only counted on the thread stepping the game, while it steps.
+    volatile bool counting_allocations = false;
+    IceUtil::ThreadControl counted_thread;
+    long allocations = 0;
+}
+
+// Count every allocation made by the simulation. Replacing these affects the whole
+// benchmark program, which is why they do nothing else.
+void *operator new(std::size_t size) throw(std::bad_alloc)
+{
+    if (counting_allocations && IceUtil::ThreadControl() == counted_thread) {
+        ++allocations;
+    }
+
+    void * const memory = malloc(size == 0 ? 1 : size);
+    if (memory == NULL) {
+        throw std::bad_alloc();
+    }
+
+    return memory;
+}
+
+void *operator new[](std::size_t size) throw(std::bad_alloc)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) throw()
+{
+    free(memory);
+}
+
+void operator delete[](void *memory) throw()
+{
+    free(memory);
+}
+
+namespace {
+    const int BOT_COUNTS[] = { 8, 16, 32, 64, 128, 256, 512 };
+
+    // The game clock runs on simulated time, so the whole run has to fit in one game
+    // (TIME_PER_GAME_MS) or the map would try to rotate through the master server.
+    const int WARM_UP_TICKS = 200;
+    const int MEASURED_TICKS = 2000;
+
+    const int ARENA_SIZE = 100;
+    const double ARENA_WALL_DENSITY = 0.03;
+
+    //! How far away a bot aims, in pixels.
+    const double AIM_DISTANCE = 300;
+
+    //! Chance per tick that a bot does each thing; about 17 commands a second at 200 ticks/s.
+    const double MOVE_CHANCE = 0.01;
+    const double ROTATE_CHANCE = 0.015;
+    const double TURRET_CHANCE = 0.04;
+    const double FIRE_CHANCE = 0.025;
+
+    //! How long to wait for callbacks to stop arriving before counting them.
+    const int DELIVERY_CHECK_MS = 100;
+    const int DELIVERY_CHECKS = 100;
+
+    //! Stock weapons from Weapons.xml, handed out to the bots in turn.
+    const int WEAPON_IDS[] = { 1, 2, 3, 4, 5, 6, 7 };
+
+    //! Deterministic generator, so runs are comparable.
+    class Random
+    {
+    private:
+        unsigned long state;
+
+    public:
+        Random() : state(8642) {}
+
+        double next()
+        {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            return static_cast<double>(state) / 0x7FFFFFFF;
+        }
+
+        bool chance(const double probability)
+        {
+            return next() < probability;
+        }
+    };
+
+    /*!
+        Stands in for the ClientEventCallback of every bot, accepting any operation and
+        counting the messages and bytes the server sent.
+    */
+    class Callback_Counter : public Ice::Blobject
+    {
+    private:
+        boost::mutex mutex;
+        Ice::Long messages;
+        Ice::Long bytes;
+
+    public:
+        Callback_Counter() : messages(0), bytes(0) {}
+
+        virtual bool ice_invoke(const std::vector<Ice::Byte> &in_params,
+            std::vector<Ice::Byte> &, const Ice::Current &)
+        {
+            boost::lock_guard<boost::mutex> guard(mutex);
+            ++messages;
+            bytes += static_cast<Ice::Long>(in_params.size());
+
+            return true;
+        }
+
+        void get(Ice::Long &message_count, Ice::Long &byte_count)
+        {
+            boost::lock_guard<boost::mutex> guard(mutex);
+            message_count = messages;
+            byte_count = bytes;
+        }
+
+        void reset()
+        {
+            boost::lock_guard<boost::mutex> guard(mutex);
+            messages = 0;
+            bytes = 0;
+        }
+    };
+
+    typedef IceUtil::Handle<Callback_Counter> callback_counter_ptr;
+
+    //! Build an open arena with a few scattered walls and plenty of spawn points.
+    Map *make_arena(Random &random)
+    {
+        Map *map = new Map();
+        map->create(ARENA_SIZE, ARENA_SIZE, "Load Test Arena");
+        map->add_supported_game_mode(DEATH_MATCH);
+        for (int y = 0; y < ARENA_SIZE; ++y) {
+            for (int x = 0; x < ARENA_SIZE; ++x) {
+                const bool border = x == 0 || y == 0 || x == ARENA_SIZE - 1 ||
+                    y == ARENA_SIZE - 1;
+                if (border || random.chance(ARENA_WALL_DENSITY)) {
+                    map->set_tile_collision(x, y, false);
+                }
+                else if (x % 4 == 2 && y % 4 == 2) {
+                    map->set_tile_event(x, y, SPAWN_POINT);
+                }
+            }
+        }
+
+        return map;
+    }
+
+    //! Load the map named by VTANK_LOAD_TEST_MAP, or generate an arena.
+    Map *make_map(Random &random, std::string &name)
+    {
+        const char * const path = getenv("VTANK_LOAD_TEST_MAP");
+        if (path == NULL) {
+            name = "generated arena";
+            return make_arena(random);
+        }
+
+        std::auto_ptr<Map> map(new Map());
+        if (!map->load(path)) {
+            throw std::runtime_error("Unable to load " + std::string(path) + ": " +
+                map->get_last_error());
+        }
+
+        name = path;
+        return map.release();
+    }
+
+    //! Put a map into play the way MapManager::rotate() does, without the master server.
+    void use_map(Map *map, const std::string &name)
+    {
+        map->build_distance_field();
+
+        Game_Instance &arena = Game_Instance::current();
+        boost::unique_lock<boost::shared_mutex> guard(arena.map_mutex);
+        delete arena.current_map;
+        arena.current_map = map;
+        arena.current_map_filename = name;
+        MapManager::generate_positions();
+        arena.nodes.set_map(map);
+    }
+
+    //! A scripted player.
+    struct Bot
+    {
+        tank_ptr tank;
+        int id;
+    };
+
+    /*!
+        Owns the Ice side of the load test and the bots in play. Bots are taken out of
+        the game before the communicator their callbacks belong to is destroyed.
+    */
+    class Load_Test
+    {
+    private:
+        Ice::CommunicatorPtr communicator;
+        Ice::ObjectAdapterPtr adapter;
+        callback_counter_ptr counter;
+        std::vector<int> weapon_ids;
+        std::vector<Bot> bots;
+
+    public:
+        Load_Test()
+        {
+            for (std::size_t i = 0; i < sizeof(WEAPON_IDS) / sizeof(WEAPON_IDS[0]); ++i) {
+                weapon_type_index index;
+                if (Players::get_weapon_data()->get_table()->find_weapon(WEAPON_IDS[i], index)) {
+                    weapon_ids.push_back(WEAPON_IDS[i]);
+                }
+            }
+            if (weapon_ids.empty()) {
+                throw std::runtime_error("None of the stock weapons are in Weapons.xml.");
+            }
+
+            Ice::InitializationData data;
+            data.properties = Ice::createProperties();
+            data.properties->setProperty("Ice.Warn.Connections", "0");
+            communicator = Ice::initialize(data);
+
+            adapter = communicator->createObjectAdapterWithEndpoints(
+                "LoadTestClients", "tcp -h 127.0.0.1");
+            counter = new Callback_Counter();
+            adapter->activate();
+        }
+
+        ~Load_Test()
+        {
+            remove_bots();
+
+            // Queues being flushed still use the bots' proxies.
+            Outbound::sender_pool.wait();
+            communicator->destroy();
+        }
+
+        //! Join bots until there are 'count' of them, as LoginSessionFactory would.
+        void add_bots(const std::size_t count)
+        {
+            while (bots.size() < count) {
+                Bot bot;
+                bot.id = static_cast<int>(bots.size());
+
+                std::ostringstream name;
+                name << "bot-" << bot.id;
+
+                // Each bot gets its own connection, like a real client.
+                const Ice::ObjectPrx object = adapter->add(counter,
+                    communicator->stringToIdentity(name.str()));
+                const GameSession::ClientEventCallbackPrx callback =
+                    GameSession::ClientEventCallbackPrx::uncheckedCast(
+                        object->ice_connectionId(name.str())->ice_collocationOptimized(false)
+                        ->ice_oneway());
+
+                GameSession::Tank data;
+                data.id = bot.id;
+                data.angle = 0;
+                data.alive = true;
+                data.attributes.name = name.str();
+                data.attributes.speedFactor = 1.0f;
+                data.attributes.armorFactor = 1.0f;
+                data.attributes.points = 0;
+                data.attributes.health = DEFAULT_MAX_HEALTH;
+                data.attributes.weaponID = weapon_ids[bots.size() % weapon_ids.size()];
+
+                const player_ptr player(new PlayerInfo(callback, NULL, outbound_ptr(
+                    new Outbound_Queue(callback, Game_Instance::current(), bot.id))));
+                player->set_update_mode(UPDATE_BATCHED);
+                bot.tank = tank_ptr(new Tank(data, player,
+                    Players::get_tank_manager()->get_next_team_assignment()));
+
+                Players::generate_spawn_position(bot.tank);
+                Players::add_player(bot.tank);
+                Players::get_node_manager()->process_position(bot.tank);
+                bots.push_back(bot);
+            }
+        }
+
+        //! Take every bot out of the game and clear what they left behind.
+        void remove_bots()
+        {
+            for (std::vector<Bot>::size_type i = 0; i < bots.size(); ++i) {
+                (void)Players::get_tank_manager()->remove(bots[i].id);
+                Players::get_recipient_list()->remove(bots[i].id);
+                bots[i].tank->get_player_info()->get_outbound()->close();
+                adapter->remove(bots[i].tank->get_player_info()->get_callback()->ice_getIdentity());
+            }
+            bots.clear();
+
+            Players::get_projectile_manager()->reset();
+            PointManager::reset();
+        }
+
+        //! Queue each bot's input for the next tick.
+        void play(Random &random)
+        {
+            const Ice::Long now = IceUtil::Time::now().toMilliSeconds();
+            for (std::vector<Bot>::size_type i = 0; i < bots.size(); ++i) {
+                const Bot &bot = bots[i];
+                if (!bot.tank->is_alive()) {
+                    continue;
+                }
+
+                const VTankObject::Point position = bot.tank->get_position();
+                if (random.chance(MOVE_CHANCE)) {
+                    const double pick = random.next();
+                    Players::move(bot.id, now, pick < 0.6 ? VTankObject::FORWARD :
+                        (pick < 0.8 ? VTankObject::REVERSE : VTankObject::NONE), position);
+                }
+                if (random.chance(ROTATE_CHANCE)) {
+                    const double pick = random.next();
+                    Players::rotate(bot.id, now, bot.tank->get_angle(), pick < 0.4 ?
+                        VTankObject::LEFT : (pick < 0.8 ? VTankObject::RIGHT : VTankObject::NONE));
+                }
+                if (random.chance(TURRET_CHANCE)) {
+                    const double pick = random.next();
+                    Players::spin_turret(bot.id, now, random.next() * 2 * PI, pick < 0.4 ?
+                        VTankObject::LEFT : (pick < 0.8 ? VTankObject::RIGHT : VTankObject::NONE));
+                }
+                if (random.chance(FIRE_CHANCE)) {
+                    const double aim = random.next() * 2 * PI;
+                    VTankObject::Point target;
+                    target.x = position.x + cos(aim) * AIM_DISTANCE;
+                    target.y = position.y + sin(aim) * AIM_DISTANCE;
+                    Players::fire(bot.id, now, target);
+                }
+            }
+        }
+
+        //! Wait until callbacks stop arriving, then read the counters.
+        void wait_for_delivery(Ice::Long &messages, Ice::Long &bytes)
+        {
+            Ice::Long last = -1;
+            for (int i = 0; i < DELIVERY_CHECKS; ++i) {
+                counter->get(messages, bytes);
+                if (messages == last) {
+                    return;
+                }
+                last = messages;
+                boost::this_thread::sleep(boost::posix_time::milliseconds(DELIVERY_CHECK_MS));
+            }
+        }
+
+        void reset_counters()
+        {
+            Ice::Long messages, bytes;
+            wait_for_delivery(messages, bytes);
+            counter->reset();
+        }
+    };
+
+    double percentile(const std::vector<double> &sorted, const double fraction)
+    {
+        std::vector<double>::size_type index = static_cast<std::vector<double>::size_type>(
+            ceil(fraction * sorted.size()));
+        if (index > 0) {
+            --index;
+        }
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    void run_load_benchmark(std::ostream &output, Load_Test &test, const int bot_count)
+    {
+        Random random;
+        test.add_bots(bot_count);
+
+        for (int tick = 0; tick < WARM_UP_TICKS; ++tick) {
+            test.play(random);
+            (void)Players::step();
+        }
+        test.reset_counters();
+
+        std::vector<double> frame_ms;
+        frame_ms.reserve(MEASURED_TICKS);
+        long tick_allocations = 0;
+        counted_thread = IceUtil::ThreadControl();
+        for (int tick = 0; tick < MEASURED_TICKS; ++tick) {
+            test.play(random);
+
+            allocations = 0;
+            counting_allocations = true;
+            const double start = get_precise_time();
+            (void)Players::step();
+            const double elapsed = get_precise_time() - start;
+            counting_allocations = false;
+
+            frame_ms.push_back(elapsed);
+            tick_allocations += allocations;
+        }
+
+        Ice::Long messages, bytes;
+        test.wait_for_delivery(messages, bytes);
+
+        double total_ms = 0;
+        for (std::vector<double>::size_type i = 0; i < frame_ms.size(); ++i) {
+            total_ms += frame_ms[i];
+        }
+        std::sort(frame_ms.begin(), frame_ms.end());
+
+        output << "bots: " << bot_count << std::endl;
+        output << "  ticks/s: " << MEASURED_TICKS / (total_ms / 1000.0)
+               << " (" << 1000 / FRAME_PROCESS_INTERVAL << " needed)" << std::endl;
+        output << "  frame p50/p99/p999: " << percentile(frame_ms, 0.5) << " / "
+               << percentile(frame_ms, 0.99) << " / " << percentile(frame_ms, 0.999)
+               << " ms" << std::endl;
+        output << "  allocations: " << static_cast<double>(tick_allocations) / MEASURED_TICKS
+               << " /tick" << std::endl;
+        output << "  outbound messages: " << static_cast<double>(messages) / MEASURED_TICKS
+               << " /tick, " << static_cast<double>(bytes) / MEASURED_TICKS / 1024.0
+               << " KB/tick" << std::endl;
+    }
+
+    void load_benchmark(std::ostream &output)
+    {
+        Logger::set_log_level(Logger::LOG_LEVEL_WARNING);
+
+        // The bots play in an arena of their own, stepped on this thread.
+        const std::auto_ptr<Game_Instance> arena(new Game_Instance(0, -1));
+        const Game_Instance::Scope scope(*arena);
+
+        try {
+            Players::get_weapon_data()->load();
+        }
+        catch (const std::exception &e) {
+            throw std::runtime_error(std::string("Cannot load weapon data; run from the "
+                "directory holding Weapons.xml: ") + e.what());
+        }
+
+        Random random;
+        std::string map_name;
+        use_map(make_map(random, map_name), map_name);
+
+        output << "map: " << map_name << ", tick: " << FRAME_PROCESS_INTERVAL
+               << " ms, ticks measured: " << MEASURED_TICKS << ", updates: batched" << std::endl;
+
+        {
+            Load_Test test;
+            for (std::size_t i = 0; i < sizeof(BOT_COUNTS) / sizeof(BOT_COUNTS[0]); ++i) {
+                run_load_benchmark(output, test, BOT_COUNTS[i]);
+            }
+        }
+
+        MapManager::shutdown();
+    }
+}
+
+void load_register_benchmarks()
+{
+    Benchmark::register_benchmark(load_benchmark, "Load Test");
+}
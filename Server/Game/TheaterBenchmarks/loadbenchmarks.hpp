@@ -0,0 +1,11 @@
+/*!
+    \file   loadbenchmarks.hpp
+    \brief  Headless load test of the whole simulation with scripted bot tanks.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef LOADBENCHMARKS_HPP
+#define LOADBENCHMARKS_HPP
+
+extern void load_register_benchmarks();
+
+#endif
@@ -0,0 +1,195 @@
+/*!
+    \file   projectilebenchmarks.cpp
+    \brief  Cost of moving, aging and replacing projectiles each frame, as shotguns
+            push the number in flight up.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <projectilepool.hpp>
+#include <benchmark.hpp>
+#include <projectilebenchmarks.hpp>
+
+namespace {
+    const int FRAME_COUNT = 600;
+    const double DELTA_TIME = 0.033;
+
+    //! Projectiles per shot for the Shotgun in Weapons.xml.
+    const int PELLETS = 6;
+
+    Weapon make_weapon(const int id, const float initial_velocity, const float terminal_velocity,
+        const float acceleration)
+    {
+        Weapon weapon = Weapon();
+        weapon.id = id;
+        weapon.projectiles_per_shot = PELLETS;
+        weapon.projectile = Projectile();
+        weapon.projectile.id = id;
+        weapon.projectile.initial_velocity = initial_velocity;
+        weapon.projectile.terminal_velocity = terminal_velocity;
+        weapon.projectile.acceleration = acceleration;
+        weapon.projectile.range = 1000;
+        weapon.projectile.collision_radius = 8.0f;
+        weapon.projectile.environment_property = NULL;
+
+        return weapon;
+    }
+
+    //! A projectile as Projectile_Manager stored it before the pool: on the heap, with
+    //! its own copy of the weapon.
+    struct Legacy_Projectile
+    {
+        int id;
+        long alive;
+        long expire;
+        double angle;
+        double velocity;
+        VTankObject::Point position;
+        Weapon type;
+    };
+
+    typedef boost::shared_ptr<Legacy_Projectile> legacy_ptr;
+
+    //! The old per-frame work: copy the weapon data, move with cos/sin, age, and erase
+    //! expired projectiles from the map.
+    void legacy_frame(std::map<int, legacy_ptr> &projectiles)
+    {
+        const long delta_ms = static_cast<long>(DELTA_TIME * 1000.0);
+        std::vector<int> to_remove;
+        std::map<int, legacy_ptr>::iterator i;
+        for (i = projectiles.begin(); i != projectiles.end(); ++i) {
+            Legacy_Projectile &projectile = *i->second;
+            const Weapon weapon_data = projectile.type;
+            const Projectile projectile_data = weapon_data.projectile;
+
+            if (projectile_data.initial_velocity != projectile_data.terminal_velocity) {
+                if (abs(projectile_data.terminal_velocity - projectile.velocity) > 0.001) {
+                    projectile.velocity += projectile_data.acceleration * DELTA_TIME;
+                    if (projectile.velocity > projectile_data.terminal_velocity) {
+                        projectile.velocity = projectile_data.terminal_velocity;
+                    }
+                }
+            }
+            projectile.position.x += cos(projectile.angle) * (projectile.velocity * DELTA_TIME);
+            projectile.position.y += sin(projectile.angle) * (projectile.velocity * DELTA_TIME);
+
+            projectile.alive += delta_ms;
+            if (projectile.alive >= projectile.expire) {
+                to_remove.push_back(i->first);
+            }
+        }
+
+        while (to_remove.size() > 0) {
+            projectiles.erase(to_remove[0]);
+            to_remove.erase(to_remove.begin());
+        }
+    }
+
+    void pool_frame(Projectile_Pool &pool)
+    {
+        pool.integrate(DELTA_TIME);
+
+        Projectile_Pool::size_type i = 0;
+        while (i < pool.size()) {
+            if (pool.expired(i)) {
+                pool.remove(i);
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+
+    /*!
+        Fire enough shotgun blasts each frame to keep about 'in_flight' pellets alive,
+        and time both ways of moving them.
+    */
+    void run_projectile_benchmark(std::ostream &output, const int in_flight)
+    {
+        const Weapon shotgun = make_weapon(6, 1800, 1800, 0);
+        const Weapon rocket = make_weapon(5, 1000, 1500, 250);
+
+        // Pellets live 1000 / 1800 seconds, about 17 frames.
+        const long lifetime = static_cast<long>((1000.0f / 1800.0f) * 1000.0f);
+        const int frames_alive = static_cast<int>(lifetime / (DELTA_TIME * 1000.0)) + 1;
+        const int shots_per_frame = std::max(1, in_flight / (frames_alive * PELLETS));
+
+        std::map<int, legacy_ptr> legacy;
+        Projectile_Pool pool;
+        double legacy_ms = 0;
+        double pool_ms = 0;
+        int next_id = 0;
+        long legacy_total = 0;
+        long pool_total = 0;
+        for (int frame = 0; frame < FRAME_COUNT; ++frame) {
+            // Fire outside the timed sections; both sides fire the same shots.
+            for (int shot = 0; shot < shots_per_frame; ++shot) {
+                const Weapon &type = shot % 8 == 0 ? rocket : shotgun;
+                for (int pellet = 0; pellet < PELLETS; ++pellet) {
+                    VTankObject::Point position;
+                    position.x = (next_id * 37) % 6000;
+                    position.y = -((next_id * 53) % 6000);
+                    const double angle = (next_id % 628) / 100.0;
+
+                    const legacy_ptr old(new Legacy_Projectile());
+                    old->id = next_id;
+                    old->alive = 0;
+                    old->expire = static_cast<long>((static_cast<float>(type.projectile.range) /
+                        type.projectile.initial_velocity) * 1000.0f);
+                    old->angle = angle;
+                    old->velocity = type.projectile.initial_velocity;
+                    old->position = position;
+                    old->type = type;
+                    legacy[next_id] = old;
+
+                    Active_Projectile projectile(next_id, 0, angle, position, position,
+                        static_cast<weapon_type_index>(type.id));
+                    pool.add(projectile, type);
+                    ++next_id;
+                }
+            }
+
+            Benchmark::Stopwatch legacy_watch;
+            legacy_frame(legacy);
+            legacy_ms += legacy_watch.elapsed_ms();
+
+            Benchmark::Stopwatch pool_watch;
+            pool_frame(pool);
+            pool_ms += pool_watch.elapsed_ms();
+
+            if (legacy.size() != pool.size()) {
+                throw std::logic_error("The pool and the old map hold different projectiles.");
+            }
+            legacy_total += static_cast<long>(legacy.size());
+            pool_total += static_cast<long>(pool.size());
+        }
+
+        // Both should have moved every projectile to the same place.
+        std::map<int, legacy_ptr>::const_iterator i;
+        for (i = legacy.begin(); i != legacy.end(); ++i) {
+            const Projectile_Pool::size_type slot = pool.find(i->first);
+            if (slot == pool.size() || abs(pool.x[slot] - i->second->position.x) > 0.001 ||
+                    abs(pool.y[slot] - i->second->position.y) > 0.001) {
+                throw std::logic_error("The pool moved a projectile somewhere else.");
+            }
+        }
+
+        const double to_us = 1000.0 / FRAME_COUNT;
+        output << "in flight: " << pool_total / FRAME_COUNT << " projectiles, " << shots_per_frame
+               << " shots of " << PELLETS << " per frame, frames: " << FRAME_COUNT << std::endl;
+        output << "map of heap projectiles: " << legacy_ms * to_us << " us/frame" << std::endl;
+        output << "projectile pool: " << pool_ms * to_us << " us/frame" << std::endl;
+    }
+
+    void projectile_benchmark(std::ostream &output)
+    {
+        run_projectile_benchmark(output, 100);
+        run_projectile_benchmark(output, 1000);
+        run_projectile_benchmark(output, 10000);
+    }
+}
+
+void projectile_register_benchmarks()
+{
+    Benchmark::register_benchmark(projectile_benchmark, "Projectile Movement");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   projectilebenchmarks.hpp
+    \brief  Benchmarks for projectile movement.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef PROJECTILEBENCHMARKS_HPP
+#define PROJECTILEBENCHMARKS_HPP
+
+extern void projectile_register_benchmarks();
+
+#endif
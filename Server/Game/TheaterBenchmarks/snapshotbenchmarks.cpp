@@ -0,0 +1,204 @@
+/*!
+    \file   snapshotbenchmarks.cpp
+    \brief  Bandwidth and encode cost of snapshot updates in a busy game.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <snapshot.hpp>
+#include <benchmark.hpp>
+#include <snapshotbenchmarks.hpp>
+
+namespace {
+    const int PLAYER_COUNT = 64;
+    const int PROJECTILE_COUNT = 48;
+    const int SIMULATED_SECONDS = 30;
+
+    //! How many snapshots behind the server the client's acknowledgements arrive.
+    const int ACKNOWLEDGEMENT_LAG = 2;
+
+    //! Bytes an UpdateTanks entry takes on the wire: id, x, y, angle, two directions,
+    //! turret angle and turret direction.
+    const int TANK_UPDATE_BYTES = 4 + 8 + 8 + 8 + 1 + 1 + 8 + 1;
+
+    //! Deterministic generator, so runs are comparable.
+    class Random
+    {
+    private:
+        unsigned long state;
+
+    public:
+        Random() : state(12345) {}
+
+        double next()
+        {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            return static_cast<double>(state) / 0x7FFFFFFF;
+        }
+    };
+
+    struct Bot
+    {
+        double x, y, angle, turret_angle, speed;
+        VTankObject::Direction movement, rotation, turret;
+    };
+
+    /*!
+        Drive the bots around for one tick, occasionally changing what they do.
+        \return Number of bots whose input changed, i.e. the tank updates a batched
+        client would be sent this tick.
+    */
+    int step(std::vector<Bot> &bots, Random &random, const double seconds)
+    {
+        int changed = 0;
+        for (std::vector<Bot>::size_type i = 0; i < bots.size(); ++i) {
+            Bot &bot = bots[i];
+            bool input = false;
+            if (random.next() < 0.01) {
+                bot.movement = static_cast<VTankObject::Direction>(static_cast<int>(random.next() * 3));
+                input = true;
+            }
+            if (random.next() < 0.01) {
+                bot.rotation = random.next() < 0.5 ? VTankObject::NONE :
+                    (random.next() < 0.5 ? VTankObject::LEFT : VTankObject::RIGHT);
+                input = true;
+            }
+            if (random.next() < 0.02) {
+                bot.turret = random.next() < 0.5 ? VTankObject::NONE : VTankObject::LEFT;
+                input = true;
+            }
+            if (input) {
+                ++changed;
+            }
+
+            if (bot.rotation == VTankObject::LEFT) {
+                bot.angle += 2.0 * seconds;
+            }
+            else if (bot.rotation == VTankObject::RIGHT) {
+                bot.angle -= 2.0 * seconds;
+            }
+            if (bot.turret != VTankObject::NONE) {
+                bot.turret_angle += 3.0 * seconds;
+            }
+
+            const double sign = bot.movement == VTankObject::FORWARD ? 1.0 :
+                (bot.movement == VTankObject::REVERSE ? -1.0 : 0.0);
+            bot.x += sign * bot.speed * seconds * std::cos(bot.angle);
+            bot.y += sign * bot.speed * seconds * std::sin(bot.angle);
+        }
+        return changed;
+    }
+
+    Snapshot capture(const std::vector<Bot> &bots, const Ice::Long tick, const int projectile_base)
+    {
+        Snapshot snapshot;
+        snapshot.tick = tick;
+        for (std::vector<Bot>::size_type i = 0; i < bots.size(); ++i) {
+            const Bot &bot = bots[i];
+            Tank_Snapshot tank;
+            tank.id = static_cast<int>(i);
+            tank.x = Snapshot_Codec::quantize_position(bot.x);
+            tank.y = Snapshot_Codec::quantize_position(bot.y);
+            tank.angle = Snapshot_Codec::quantize_angle(bot.angle);
+            tank.turret_angle = Snapshot_Codec::quantize_angle(bot.turret_angle);
+            tank.movement_direction = static_cast<unsigned char>(bot.movement);
+            tank.rotation_direction = static_cast<unsigned char>(bot.rotation);
+            tank.turret_direction = static_cast<unsigned char>(bot.turret);
+            snapshot.tanks.push_back(tank);
+        }
+
+        // Projectiles fly in straight lines and live for a few snapshots, so IDs keep
+        // rolling over.
+        const double seconds = tick * FRAME_PROCESS_INTERVAL / 1000.0;
+        for (int i = 0; i < PROJECTILE_COUNT; ++i) {
+            const int id = projectile_base + i;
+            const double angle = (id % 63) * 0.1;
+            Projectile_Snapshot projectile;
+            projectile.id = id;
+            projectile.type_id = id % 4;
+            projectile.x = Snapshot_Codec::quantize_position((id * 37) % 2000 + 400 * seconds * std::cos(angle));
+            projectile.y = Snapshot_Codec::quantize_position(-((id * 53) % 2000) + 400 * seconds * std::sin(angle));
+            projectile.angle = Snapshot_Codec::quantize_angle(angle);
+            snapshot.projectiles.push_back(projectile);
+        }
+        return snapshot;
+    }
+
+    void bandwidth_benchmark(std::ostream &output)
+    {
+        Random random;
+        std::vector<Bot> bots(PLAYER_COUNT);
+        for (std::vector<Bot>::size_type i = 0; i < bots.size(); ++i) {
+            bots[i].x = random.next() * 3000;
+            bots[i].y = -random.next() * 3000;
+            bots[i].angle = random.next() * 6.28;
+            bots[i].turret_angle = 0;
+            bots[i].speed = 150;
+            bots[i].movement = VTankObject::FORWARD;
+            bots[i].rotation = VTankObject::NONE;
+            bots[i].turret = VTankObject::NONE;
+        }
+
+        const int ticks_per_second = 1000 / FRAME_PROCESS_INTERVAL;
+        const int total_ticks = ticks_per_second * SIMULATED_SECONDS;
+        const double seconds_per_tick = FRAME_PROCESS_INTERVAL / 1000.0;
+
+        // Every client sees every tank: the worst case for bandwidth.
+        std::vector<Snapshot_Channel> channels(PLAYER_COUNT);
+        std::vector<Ice::Long> sent_ticks;
+        std::vector<Ice::Byte> data;
+        double full_bytes = 0;
+        double delta_bytes = 0;
+        double encode_ms = 0;
+        double batched_bytes = 0;
+        int snapshots = 0;
+        int projectile_base = 0;
+
+        for (int tick = 1; tick <= total_ticks; ++tick) {
+            batched_bytes += static_cast<double>(step(bots, random, seconds_per_tick)) * TANK_UPDATE_BYTES;
+            if (tick % SNAPSHOT_INTERVAL_TICKS != 0) {
+                continue;
+            }
+
+            if (snapshots % 3 == 0) {
+                projectile_base += PROJECTILE_COUNT / 2;
+            }
+            const Snapshot current = capture(bots, tick, projectile_base);
+
+            Snapshot_Codec::encode(current, NULL, data);
+            full_bytes += static_cast<double>(data.size()) * PLAYER_COUNT;
+
+            if (sent_ticks.size() >= ACKNOWLEDGEMENT_LAG) {
+                const Ice::Long acknowledged = sent_ticks[sent_ticks.size() - ACKNOWLEDGEMENT_LAG];
+                for (int player = 0; player < PLAYER_COUNT; ++player) {
+                    channels[player].acknowledge(acknowledged);
+                }
+            }
+
+            Benchmark::Stopwatch stopwatch;
+            for (int player = 0; player < PLAYER_COUNT; ++player) {
+                channels[player].encode(current, data);
+                delta_bytes += static_cast<double>(data.size());
+            }
+            encode_ms += stopwatch.elapsed_ms();
+
+            sent_ticks.push_back(current.tick);
+            ++snapshots;
+        }
+
+        const double player_seconds = static_cast<double>(PLAYER_COUNT) * SIMULATED_SECONDS;
+
+        output << "players: " << PLAYER_COUNT << std::endl;
+        output << "snapshots per second: " << ticks_per_second / SNAPSHOT_INTERVAL_TICKS << std::endl;
+        output << "full snapshot: " << full_bytes / player_seconds << " bytes/player/s" << std::endl;
+        output << "delta snapshot: " << delta_bytes / player_seconds << " bytes/player/s" << std::endl;
+        output << "batched tank updates: " << batched_bytes / SIMULATED_SECONDS << " bytes/player/s" << std::endl;
+        output << "encode: " << (encode_ms * 1000.0) / (static_cast<double>(snapshots) * PLAYER_COUNT)
+               << " us/player/snapshot" << std::endl;
+    }
+}
+
+void snapshot_register_benchmarks()
+{
+    Benchmark::register_benchmark(bandwidth_benchmark, "Snapshot Bandwidth (64 players)");
+}
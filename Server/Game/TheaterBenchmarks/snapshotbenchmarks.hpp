@@ -0,0 +1,11 @@
+/*!
+    \file   snapshotbenchmarks.hpp
+    \brief  Benchmarks for the snapshot codec.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef SNAPSHOTBENCHMARKS_HPP
+#define SNAPSHOTBENCHMARKS_HPP
+
+extern void snapshot_register_benchmarks();
+
+#endif
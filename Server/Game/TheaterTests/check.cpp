@@ -7,10 +7,42 @@
 #include <fstream>
 #include <UnitTestManager.hpp>
 #include <nodemanagertests.hpp>
+#include <snapshottests.hpp>
+#include <instantweapontests.hpp>
+#include <projectilepooltests.hpp>
+#include <slotallocatortests.hpp>
+#include <tankstatetests.hpp>
+#include <weapontabletests.hpp>
+#include <profilertests.hpp>
+#include <tracetests.hpp>
+#include <maphashindextests.hpp>
+#include <gameinstancetests.hpp>
+#include <outboundqueuetests.hpp>
+#include <interesttests.hpp>
+#include <clocksynctests.hpp>
+#include <lagcompensationtests.hpp>
+#include <pointmanagertests.hpp>
+#include <statisticsuploadtests.hpp>
 
 void register_tests()
 {
     node_manager_register_tests();
+    snapshot_register_tests();
+    instant_weapon_register_tests();
+    projectile_pool_register_tests();
+    slot_allocator_register_tests();
+    tank_state_register_tests();
+    weapon_table_register_tests();
+    profiler_register_tests();
+    trace_register_tests();
+    map_hash_index_register_tests();
+    game_instance_register_tests();
+    outbound_queue_register_tests();
+    interest_register_tests();
+    clock_sync_register_tests();
+    lag_compensation_register_tests();
+    point_manager_register_tests();
+    statistics_upload_register_tests();
 }
 
 int main(int argc, char* argv[])
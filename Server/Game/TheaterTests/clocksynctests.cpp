@@ -0,0 +1,149 @@
+/*!
+    \file   clocksynctests.cpp
+    \brief  Unit tests for the Timer_Wheel and Clock_Filter classes.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <timerwheel.hpp>
+#include <clockfilter.hpp>
+#include <clocksynctests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    //! Sample a client whose clock is 'offset' ahead at time 0 and gains 'drift' per millisecond.
+    const Clock_Estimate &sample(Clock_Filter &filter, const double sent, const double delay,
+        const double offset, const double drift = 0)
+    {
+        const double midpoint = sent + delay / 2.0;
+        const Ice::Long client_time = static_cast<Ice::Long>(midpoint + offset + drift * midpoint);
+
+        return filter.add_sample(sent, client_time, sent + delay);
+    }
+
+    bool timer_wheel_test()
+    {
+        Timer_Wheel<int> wheel(4);
+        wheel.schedule(1, 1);
+        wheel.schedule(3, 3);
+        wheel.schedule(4, 4);
+        wheel.schedule(9, 9);
+        wheel.schedule(0, 0);
+        UNIT_CHECK(wheel.size() == 5);
+
+        std::vector<int> due;
+        wheel.advance(due);
+        UNIT_CHECK(due.size() == 2);
+        UNIT_CHECK(std::count(due.begin(), due.end(), 0) == 1);
+        UNIT_CHECK(std::count(due.begin(), due.end(), 1) == 1);
+
+        due.clear();
+        wheel.advance(due);
+        UNIT_CHECK(due.empty());
+        wheel.advance(due);
+        UNIT_CHECK(due.size() == 1 && due[0] == 3);
+
+        due.clear();
+        wheel.advance(due);
+        UNIT_CHECK(due.size() == 1 && due[0] == 4);
+
+        // The longer delay goes round the wheel twice before firing.
+        due.clear();
+        for (int i = 5; i < 9; ++i) {
+            wheel.advance(due);
+        }
+        UNIT_CHECK(due.empty());
+        UNIT_CHECK(wheel.size() == 1);
+
+        wheel.advance(due);
+        UNIT_CHECK(due.size() == 1 && due[0] == 9);
+        UNIT_CHECK(wheel.size() == 0);
+
+        return true;
+    }
+
+    bool minimum_delay_test()
+    {
+        Clock_Filter filter;
+
+        // The replies took longer coming back than going, except for the quick one.
+        (void)filter.add_sample(1000, 5000 + 1030, 1100);
+        (void)filter.add_sample(2000, 5000 + 2040, 2140);
+        const Clock_Estimate &estimate = filter.add_sample(3000, 5000 + 3010, 3020);
+        UNIT_CHECK(estimate.offset == 5000);
+        UNIT_CHECK(estimate.delay == 20);
+        UNIT_CHECK(estimate.measured == 3020);
+        UNIT_CHECK(estimate.samples == 3);
+
+        // A slower sample doesn't replace it.
+        (void)filter.add_sample(4000, 5000 + 4080, 4100);
+        UNIT_CHECK(filter.get_estimate().offset == 5000);
+        UNIT_CHECK(filter.get_estimate().measured == 3020);
+
+        // Once it falls out of the window, the best of the rest is trusted.
+        for (int i = 0; i < CLOCK_SYNC_SAMPLES - 1; ++i) {
+            (void)filter.add_sample(5000 + i * 1000, 7000 + 5000 + i * 1000 + 20, 5000 + i * 1000 + 40);
+        }
+        UNIT_CHECK(filter.get_estimate().offset == 7000);
+        UNIT_CHECK(filter.get_estimate().delay == 40);
+
+        return true;
+    }
+
+    bool drift_test()
+    {
+        Clock_Filter filter;
+
+        // The client gains 50 milliseconds every 100 seconds.
+        const double drift = 0.0005;
+        double time = 0;
+        for (; time < CLOCK_SYNC_MIN_DRIFT_SPAN; time += 1000) {
+            (void)sample(filter, time, 40, -2000, drift);
+        }
+        UNIT_CHECK(filter.get_estimate().drift == 0);
+
+        for (; time <= 4 * CLOCK_SYNC_MIN_DRIFT_SPAN; time += 1000) {
+            (void)sample(filter, time, 40, -2000, drift);
+        }
+
+        const Clock_Estimate &estimate = filter.get_estimate();
+        UNIT_CHECK(fabs(estimate.drift - drift) < 0.00005);
+
+        const double later = time + 60000;
+        UNIT_CHECK(fabs(estimate.offset_at(later) - (-2000 + drift * later)) < 5);
+
+        // No clock is that far off; drift is kept within bounds.
+        Clock_Filter runaway;
+        for (time = 0; time <= 2 * CLOCK_SYNC_MIN_DRIFT_SPAN; time += 1000) {
+            (void)sample(runaway, time, 40, 0, 0.1);
+        }
+        UNIT_CHECK(runaway.get_estimate().drift == CLOCK_SYNC_MAX_DRIFT);
+
+        return true;
+    }
+
+    bool jitter_test()
+    {
+        Clock_Filter steady;
+        Clock_Filter shaky;
+        for (int i = 0; i < CLOCK_SYNC_SAMPLES; ++i) {
+            const double time = i * 1000;
+            (void)sample(steady, time, 40, 300);
+            (void)sample(shaky, time, 40 + i, 300 + (i % 2 == 0 ? 30 : -30));
+        }
+
+        UNIT_CHECK(steady.get_estimate().jitter < 1);
+        UNIT_CHECK(shaky.get_estimate().offset == 330);
+        UNIT_CHECK(shaky.get_estimate().jitter > 30);
+
+        return true;
+    }
+}
+
+void clock_sync_register_tests()
+{
+    UnitTestManager::register_test(timer_wheel_test, "Clock Sync Timer Wheel Test");
+    UnitTestManager::register_test(minimum_delay_test, "Clock Sync Minimum Delay Test");
+    UnitTestManager::register_test(drift_test, "Clock Sync Drift Test");
+    UnitTestManager::register_test(jitter_test, "Clock Sync Jitter Test");
+}
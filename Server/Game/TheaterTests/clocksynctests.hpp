@@ -0,0 +1,11 @@
+/*!
+    \file   clocksynctests.hpp
+    \brief  Unit tests for the Timer_Wheel and Clock_Filter classes.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef CLOCKSYNCTESTS_HPP
+#define CLOCKSYNCTESTS_HPP
+
+extern void clock_sync_register_tests();
+
+#endif
@@ -0,0 +1,77 @@
+/*!
+    \file   gameinstancetests.cpp
+    \brief  Unit tests for the Game_Instance class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <gameinstance.hpp>
+#include <gameinstancetests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    //! Record which arena a thread sees, to check bindings don't leak between threads.
+    void find_arena(Game_Instance **found)
+    {
+        *found = Game_Instance::find_current();
+    }
+
+    bool unbound_test()
+    {
+        UNIT_CHECK(Game_Instance::find_current() == NULL);
+
+        bool thrown = false;
+        try {
+            (void)Game_Instance::current();
+        }
+        catch (const std::logic_error &) {
+            thrown = true;
+        }
+        UNIT_CHECK(thrown);
+
+        return true;
+    }
+
+    bool scope_test()
+    {
+        Game_Instance first(0, -1);
+        Game_Instance second(1, -1);
+        {
+            const Game_Instance::Scope outer(first);
+            UNIT_CHECK(&Game_Instance::current() == &first);
+            {
+                const Game_Instance::Scope inner(second);
+                UNIT_CHECK(&Game_Instance::current() == &second);
+                UNIT_CHECK(Game_Instance::current().get_id() == 1);
+            }
+            UNIT_CHECK(&Game_Instance::current() == &first);
+
+            // Another thread has nothing bound, whatever this one has.
+            Game_Instance *found = &first;
+            boost::thread other(boost::bind(&find_arena, &found));
+            other.join();
+            UNIT_CHECK(found == NULL);
+        }
+        UNIT_CHECK(Game_Instance::find_current() == NULL);
+
+        return true;
+    }
+
+    bool player_count_test()
+    {
+        Game_Instance arena(0, -1);
+        UNIT_CHECK(arena.get_player_count() == 0);
+
+        arena.pending_list["key"] = Players::pending_ptr();
+        UNIT_CHECK(arena.get_player_count() == 1);
+
+        return true;
+    }
+}
+
+void game_instance_register_tests()
+{
+    UnitTestManager::register_test(unbound_test, "Game Instance Unbound Test");
+    UnitTestManager::register_test(scope_test, "Game Instance Scope Test");
+    UnitTestManager::register_test(player_count_test, "Game Instance Player Count Test");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   gameinstancetests.hpp
+    \brief  Unit tests for the Game_Instance class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef GAMEINSTANCETESTS_HPP
+#define GAMEINSTANCETESTS_HPP
+
+extern void game_instance_register_tests();
+
+#endif
@@ -0,0 +1,303 @@
+/*!
+    \file   instantweapontests.cpp
+    \brief  Unit tests for the grid traversal used by instant weapons, checked against
+            the tile march and full tank scan they replaced.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <nodemanager.hpp>
+#include <utility.hpp>
+#include <instantweapontests.hpp>
+#include <testtanks.hpp>
+#include <UnitTestManager.hpp>
+#include <Map.hpp>
+#include <GameSession.h>
+
+namespace {
+    const double TANK_RADIUS = TANK_SPHERE_RADIUS + 15.0;
+
+    //! Deterministic generator, so failures can be reproduced.
+    class Random
+    {
+    private:
+        unsigned long state;
+
+    public:
+        Random() : state(2468) {}
+
+        double next()
+        {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            return static_cast<double>(state) / 0x7FFFFFFF;
+        }
+    };
+
+    /*!
+        The range calculation handle_instant_weapon() used before the grid traversal:
+        march in 12 pixel steps until the line leaves the map, enters a wall, or
+        comes within a step of its end on either axis.
+        \return True if it stopped at a wall.
+    */
+    bool march_to_wall(const Map *current_map, const double angle, Utility::Line &path)
+    {
+        const double x_inc = 12;
+        const double y_inc = 12;
+        int last_tile_x = -1;
+        int last_tile_y = -1;
+        double y = path.y1, x = path.x1;
+        while (true) {
+            if (abs(x - path.x2) <= x_inc || abs(y - path.y2) <= y_inc) {
+                return false;
+            }
+
+            x += cos(angle) * x_inc;
+            y += sin(angle) * y_inc;
+
+            const int tile_x = static_cast<int>(floor(x / TILE_SIZE));
+            const int tile_y = static_cast<int>(floor(-y / TILE_SIZE));
+            if (tile_x == last_tile_x && tile_y == last_tile_y) {
+                continue;
+            }
+            last_tile_x = tile_x;
+            last_tile_y = tile_y;
+
+            if (tile_x < 0 || tile_y < 0 || tile_x >= current_map->get_width() || 
+                    tile_y >= current_map->get_height()) {
+                path.x2 = x;
+                path.y2 = y;
+                return false;
+            }
+
+            if (current_map->is_wall(tile_x, tile_y)) {
+                path.x2 = x + cos(angle) * x_inc;
+                path.y2 = y + sin(angle) * y_inc;
+                return true;
+            }
+        }
+    }
+
+    double length(const Utility::Line &path)
+    {
+        return sqrt(pow(path.x2 - path.x1, 2) + pow(path.y2 - path.y1, 2));
+    }
+
+    Utility::Line make_path(const double x, const double y, const double angle, const double range)
+    {
+        return Utility::Line(x, y, x + cos(angle) * range, y + sin(angle) * range);
+    }
+
+    //! IDs of the tanks a path touches, in the order they are listed.
+    std::vector<int> hit_ids(const tank_array &tanks, const Utility::Line &path)
+    {
+        std::vector<int> ids;
+        for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
+            const VTankObject::Point pos = tanks[i]->get_position();
+            if (Utility::line_circle_collision(pos.x, pos.y, TANK_RADIUS,
+                    path.x1, path.y1, path.x2, path.y2)) {
+                ids.push_back(tanks[i]->get_id());
+            }
+        }
+        std::sort(ids.begin(), ids.end());
+        return ids;
+    }
+
+    bool grid_traversal_test()
+    {
+        Random random;
+        const double CELL = 64.0;
+        for (int n = 0; n < 200; ++n) {
+            const Utility::Line line(random.next() * 1000, -random.next() * 1000,
+                random.next() * 1000, -random.next() * 1000);
+
+            // Sample the line finely; every cell it passes through should show up in order.
+            std::vector<std::pair<int, int> > sampled;
+            const int samples = static_cast<int>(length(line) * 20) + 1;
+            for (int i = 0; i <= samples; ++i) {
+                const double t = static_cast<double>(i) / samples;
+                const std::pair<int, int> cell(
+                    static_cast<int>(floor((line.x1 + (line.x2 - line.x1) * t) / CELL)),
+                    static_cast<int>(floor(-(line.y1 + (line.y2 - line.y1) * t) / CELL)));
+                if (sampled.empty() || sampled.back() != cell) {
+                    sampled.push_back(cell);
+                }
+            }
+
+            std::vector<std::pair<int, int> > traversed;
+            Utility::Grid_Traversal cells(line, CELL, CELL);
+            double last_entry = 0;
+            do {
+                UNIT_CHECK(cells.get_entry() >= last_entry && cells.get_entry() <= 1.0);
+                last_entry = cells.get_entry();
+                traversed.push_back(std::make_pair(cells.get_x(), cells.get_y()));
+            } while (cells.next());
+
+            // Each step crosses exactly one edge.
+            for (std::vector<std::pair<int, int> >::size_type i = 1; i < traversed.size(); ++i) {
+                const int step = abs(traversed[i].first - traversed[i - 1].first) +
+                    abs(traversed[i].second - traversed[i - 1].second);
+                UNIT_CHECK(step == 1);
+            }
+
+            // Sampling can jump diagonally across a corner the line only just clips.
+            for (std::vector<std::pair<int, int> >::size_type i = 0; i < sampled.size(); ++i) {
+                UNIT_CHECK(std::find(traversed.begin(), traversed.end(), sampled[i]) != traversed.end());
+            }
+            UNIT_CHECK(traversed.front() == sampled.front());
+            UNIT_CHECK(traversed.back() == sampled.back());
+        }
+
+        return true;
+    }
+
+    bool trace_to_wall_test()
+    {
+        Map map;
+        UNIT_CHECK(map.create(20, 20, "test"));
+        for (int y = 0; y < 20; ++y) {
+            map.set_tile_collision(10, y, false);
+        }
+        map.set_tile_collision(2, 4, false);
+
+        // Straight right into the column of walls.
+        Utility::Line path = make_path(TILE_SIZE * 2.5, -TILE_SIZE * 7.5, 0, 5000);
+        UNIT_CHECK(Utility::trace_to_wall(&map, path));
+        UNIT_CHECK(abs(path.x2 - TILE_SIZE * 10) < 0.001);
+        UNIT_CHECK(abs(path.y2 + TILE_SIZE * 7.5) < 0.001);
+
+        // Straight up into a single block. The old march never looked at walls when
+        // the shot ran along an axis.
+        path = make_path(TILE_SIZE * 2.5, -TILE_SIZE * 7.5, PI / 2, 5000);
+        Utility::Line marched = path;
+        UNIT_CHECK(!march_to_wall(&map, PI / 2, marched));
+        UNIT_CHECK(Utility::trace_to_wall(&map, path));
+        UNIT_CHECK(abs(path.y2 + TILE_SIZE * 5) < 0.001);
+
+        // Left, off the edge of the map.
+        path = make_path(TILE_SIZE * 2.5, -TILE_SIZE * 7.5, PI, 5000);
+        UNIT_CHECK(!Utility::trace_to_wall(&map, path));
+        UNIT_CHECK(abs(path.x2) < 0.001);
+
+        // Short range in the open: the line is left alone.
+        path = make_path(TILE_SIZE * 2.5, -TILE_SIZE * 7.5, 0.3, 100);
+        const Utility::Line untouched = path;
+        UNIT_CHECK(!Utility::trace_to_wall(&map, path));
+        UNIT_CHECK(path == untouched);
+
+        // Starting inside a wall stops immediately.
+        path = make_path(TILE_SIZE * 10.5, -TILE_SIZE * 7.5, 1.0, 5000);
+        UNIT_CHECK(Utility::trace_to_wall(&map, path));
+        UNIT_CHECK(length(path) < 0.001);
+
+        return true;
+    }
+
+    bool trace_against_march_test()
+    {
+        Random random;
+        Map map;
+        UNIT_CHECK(map.create(60, 60, "test"));
+        for (int i = 0; i < 150; ++i) {
+            const int x = static_cast<int>(random.next() * 59);
+            const int y = static_cast<int>(random.next() * 59);
+            map.set_tile_collision(x, y, false);
+            map.set_tile_collision(x + 1, y, false);
+            map.set_tile_collision(x, y + 1, false);
+            map.set_tile_collision(x + 1, y + 1, false);
+        }
+
+        int walls = 0;
+        for (int n = 0; n < 300; ++n) {
+            const double x = random.next() * 60 * TILE_SIZE;
+            const double y = -random.next() * 60 * TILE_SIZE;
+            const double angle = random.next() * 2 * PI;
+            const double range = 500 + random.next() * 4500;
+
+            Utility::Line traced = make_path(x, y, angle, range);
+            const bool traced_wall = Utility::trace_to_wall(&map, traced);
+
+            // Walking the line in tiny steps finds the same stopping point.
+            const Utility::Line full = make_path(x, y, angle, range);
+            const double STEP = 0.05;
+            double stop = range;
+            for (double d = 0; d < range; d += STEP) {
+                const int tile_x = static_cast<int>(floor((x + cos(angle) * d) / TILE_SIZE));
+                const int tile_y = static_cast<int>(floor(-(y + sin(angle) * d) / TILE_SIZE));
+                if (tile_x < 0 || tile_y < 0 || tile_x >= 60 || tile_y >= 60 || map.is_wall(tile_x, tile_y)) {
+                    stop = d;
+                    break;
+                }
+            }
+            UNIT_CHECK(abs(length(traced) - stop) <= STEP * 2);
+            UNIT_CHECK(length(full) >= length(traced));
+
+            // Wherever the old march stopped at a wall, the trace stops there or sooner,
+            // and with the same 12 pixel overshoot it never reaches further.
+            Utility::Line marched = make_path(x, y, angle, range);
+            if (march_to_wall(&map, angle, marched)) {
+                ++walls;
+                UNIT_CHECK(traced_wall);
+                UNIT_CHECK(length(traced) + 12 <= length(marched) + 0.001);
+            }
+        }
+        UNIT_CHECK(walls > 50);
+
+        return true;
+    }
+
+    bool players_near_line_test()
+    {
+        Random random;
+        Map map;
+        UNIT_CHECK(map.create(100, 100, "test"));
+
+        NodeManager node_manager;
+        node_manager.set_map(&map);
+
+        // Clusters make some lines pass through several tanks at once.
+        tank_array tanks;
+        for (int i = 0; i < 64; ++i) {
+            const double cx = (i % 4 + 0.5) * 25 * TILE_SIZE;
+            const double cy = -(i / 16 + 0.5) * 25 * TILE_SIZE;
+            tanks.push_back(make_tank(i, cx + (random.next() - 0.5) * 1200,
+                cy + (random.next() - 0.5) * 1200));
+            node_manager.process_position(tanks.back());
+        }
+        node_manager.rebuild(tanks);
+
+        int hits = 0;
+        tank_array candidates;
+        for (int n = 0; n < 2000; ++n) {
+            const tank_ptr shooter = tanks[n % tanks.size()];
+            const VTankObject::Point pos = shooter->get_position();
+            Utility::Line path = make_path(pos.x, pos.y, random.next() * 2 * PI, 5000);
+            Utility::trace_to_wall(&map, path);
+
+            node_manager.get_players_near_line(path.x1, path.y1, path.x2, path.y2, candidates);
+
+            // Nobody is listed twice.
+            std::vector<int> candidate_ids;
+            for (tank_array::size_type i = 0; i < candidates.size(); ++i) {
+                candidate_ids.push_back(candidates[i]->get_id());
+            }
+            std::sort(candidate_ids.begin(), candidate_ids.end());
+            UNIT_CHECK(std::adjacent_find(candidate_ids.begin(), candidate_ids.end()) == candidate_ids.end());
+
+            // The candidates find exactly who a scan of every tank finds.
+            const std::vector<int> expected = hit_ids(tanks, path);
+            UNIT_CHECK(hit_ids(candidates, path) == expected);
+            hits += static_cast<int>(expected.size());
+        }
+        UNIT_CHECK(hits > 2000);
+
+        return true;
+    }
+}
+
+void instant_weapon_register_tests()
+{
+    UnitTestManager::register_test(grid_traversal_test, "Instant Weapon Grid Traversal Test");
+    UnitTestManager::register_test(trace_to_wall_test, "Instant Weapon Trace To Wall Test");
+    UnitTestManager::register_test(trace_against_march_test, "Instant Weapon Trace Against March Test");
+    UnitTestManager::register_test(players_near_line_test, "Instant Weapon Players Near Line Test");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   instantweapontests.hpp
+    \brief  Unit tests for instant weapon ray tracing.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef INSTANTWEAPONTESTS_HPP
+#define INSTANTWEAPONTESTS_HPP
+
+extern void instant_weapon_register_tests();
+
+#endif
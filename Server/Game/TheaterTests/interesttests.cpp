@@ -0,0 +1,130 @@
+/*!
+    \file   interesttests.cpp
+    \brief  Unit tests for the Interest_Area class and the Interest namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <interest.hpp>
+#include <interesttests.hpp>
+#include <testtanks.hpp>
+#include <UnitTestManager.hpp>
+#include <Map.hpp>
+#include <GameSession.h>
+
+namespace {
+    bool area_test()
+    {
+        // 5x5 nodes.
+        Map test_map;
+        UNIT_CHECK(test_map.create((NODE_WIDTH * 5) / TILE_SIZE, (NODE_HEIGHT * 5) / TILE_SIZE, "test"));
+
+        NodeManager node_manager;
+        node_manager.set_map(&test_map);
+
+        // Top left, top right, bottom left and bottom right corners.
+        tank_array tanks;
+        tanks.push_back(make_tank(1, 10, -10));
+        tanks.push_back(make_tank(2, NODE_WIDTH * 4 + 10, -10));
+        tanks.push_back(make_tank(3, 10, -NODE_HEIGHT * 4 - 10));
+        tanks.push_back(make_tank(4, NODE_WIDTH * 4 + 10, -NODE_HEIGHT * 4 - 10));
+        for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
+            node_manager.process_position(tanks[i]);
+        }
+        node_manager.rebuild(tanks);
+
+        tank_array players;
+
+        // Only the tank in the corner sees something happen there.
+        Interest_Area point;
+        point.add_point(tanks[0]->get_position());
+        point.collect(node_manager, players);
+        UNIT_CHECK(players.size() == 1 && contains(players, 1));
+
+        // Involved players hear of it from anywhere, and are listed once.
+        point.add_tank(tanks[3]);
+        point.add_tank(tanks[0]);
+        point.collect(node_manager, players);
+        UNIT_CHECK(players.size() == 2 && contains(players, 1) && contains(players, 4));
+
+        // A path along the top of the map is seen from both top corners.
+        Interest_Area path;
+        path.add_path(Utility::Line(10, -10, NODE_WIDTH * 4 + 10, -10));
+        path.collect(node_manager, players);
+        UNIT_CHECK(players.size() == 2 && contains(players, 1) && contains(players, 2));
+
+        // Nobody is near the middle of the map, or off it.
+        Interest_Area empty;
+        VTankObject::Point middle;
+        middle.x = NODE_WIDTH * 2 + 10;
+        middle.y = -NODE_HEIGHT * 2 - 10;
+        empty.add_point(middle);
+        middle.x = -NODE_WIDTH * 2;
+        empty.add_point(middle);
+        empty.collect(node_manager, players);
+        UNIT_CHECK(players.empty());
+
+        return true;
+    }
+
+    bool always_broadcast_test()
+    {
+        // Damage and scoring are broadcast unless configured otherwise.
+        UNIT_CHECK(Interest::is_always_broadcast(Interest::EVENT_PLAYER_DAMAGED));
+        UNIT_CHECK(Interest::is_always_broadcast(Interest::EVENT_ENV_DAMAGE));
+        UNIT_CHECK(Interest::is_always_broadcast(Interest::EVENT_KILLING_BLOW));
+        UNIT_CHECK(!Interest::is_always_broadcast(
+            Interest::EVENT_CREATE_PROJECTILE | Interest::EVENT_SPAWN_ENV_EFFECT));
+
+        // Unknown names are ignored.
+        Interest::set_always_broadcast("PlayerDamaged,SpawnEnvEffect Nonsense");
+        UNIT_CHECK(Interest::is_always_broadcast(Interest::EVENT_PLAYER_DAMAGED));
+        UNIT_CHECK(Interest::is_always_broadcast(Interest::EVENT_SPAWN_ENV_EFFECT));
+        UNIT_CHECK(!Interest::is_always_broadcast(Interest::EVENT_KILLING_BLOW));
+        UNIT_CHECK(!Interest::is_always_broadcast(Interest::EVENT_CREATE_PROJECTILE));
+
+        Interest::set_always_broadcast("");
+        UNIT_CHECK(!Interest::is_always_broadcast(Interest::EVENT_PLAYER_DAMAGED |
+            Interest::EVENT_SPAWN_ENV_EFFECT | Interest::EVENT_KILLING_BLOW));
+
+        Interest::set_always_broadcast(DEFAULT_ALWAYS_BROADCAST);
+        UNIT_CHECK(Interest::is_always_broadcast(Interest::EVENT_PLAYER_DAMAGED));
+        UNIT_CHECK(Interest::is_always_broadcast(Interest::EVENT_ENV_DAMAGE));
+        UNIT_CHECK(Interest::is_always_broadcast(Interest::EVENT_KILLING_BLOW));
+
+        return true;
+    }
+
+    bool projectile_path_test()
+    {
+        Projectile type = Projectile();
+        type.range = 300;
+        type.range_variation = 50;
+
+        VTankObject::Point origin;
+        origin.x = 100;
+        origin.y = -100;
+
+        // The path runs the whole reach, whether the target is short of it or past it.
+        VTankObject::Point target;
+        target.x = 200;
+        target.y = -100;
+        Utility::Line path = Interest::get_projectile_path(origin, target, type);
+        UNIT_CHECK(path.x1 == 100 && path.y1 == -100);
+        UNIT_CHECK(fabs(path.x2 - 450) < 0.001 && fabs(path.y2 + 100) < 0.001);
+
+        target.x = 100;
+        target.y = -1000;
+        path = Interest::get_projectile_path(origin, target, type);
+        UNIT_CHECK(fabs(path.x2 - 100) < 0.001 && fabs(path.y2 + 450) < 0.001);
+
+        return true;
+    }
+}
+
+void interest_register_tests()
+{
+    UnitTestManager::register_test(area_test, "Interest Area Test");
+    UnitTestManager::register_test(always_broadcast_test, "Interest Always Broadcast Test");
+    UnitTestManager::register_test(projectile_path_test, "Interest Projectile Path Test");
+}
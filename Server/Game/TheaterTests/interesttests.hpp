@@ -0,0 +1,11 @@
+/*!
+    \file   interesttests.hpp
+    \brief  Unit tests for the Interest_Area class and the Interest namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef INTERESTTESTS_HPP
+#define INTERESTTESTS_HPP
+
+extern void interest_register_tests();
+
+#endif
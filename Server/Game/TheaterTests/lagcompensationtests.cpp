@@ -0,0 +1,140 @@
+/*!
+    \file   lagcompensationtests.cpp
+    \brief  Unit tests for the Position_History class and the Lag_Compensation namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <lagcompensation.hpp>
+#include <lagcompensationtests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    //! Record a tank which moves 10 units right every tick.
+    void record_ticks(Position_History &history, const Ice::Long from, const Ice::Long to,
+        const bool alive = true)
+    {
+        for (Ice::Long tick = from; tick <= to; ++tick) {
+            VTankObject::Point position;
+            position.x = static_cast<double>(tick * 10);
+            position.y = -100;
+            history.record(tick, position, static_cast<double>(tick), alive);
+        }
+    }
+
+    bool rewind_test()
+    {
+        Position_History history;
+        Position_Record state;
+        UNIT_CHECK(!history.rewind(0, state));
+        UNIT_CHECK(history.get_newest_tick() == -1);
+
+        record_ticks(history, 100, 120);
+        UNIT_CHECK(history.get_newest_tick() == 120);
+
+        UNIT_CHECK(history.rewind(110, state));
+        UNIT_CHECK(state.tick == 110 && state.alive);
+        UNIT_CHECK(state.position.x == 1100 && state.position.y == -100);
+        UNIT_CHECK(state.angle == 110);
+
+        // Between ticks the position is interpolated and the angle taken from the nearer one.
+        UNIT_CHECK(history.rewind(110.25, state));
+        UNIT_CHECK(fabs(state.position.x - 1102.5) < 0.001);
+        UNIT_CHECK(state.angle == 110);
+        UNIT_CHECK(history.rewind(110.75, state));
+        UNIT_CHECK(state.angle == 111);
+
+        // Times outside the history are moved to its ends.
+        UNIT_CHECK(history.rewind(50, state));
+        UNIT_CHECK(state.tick == 100);
+        UNIT_CHECK(history.rewind(200, state));
+        UNIT_CHECK(state.tick == 120);
+
+        history.clear();
+        UNIT_CHECK(!history.rewind(110, state));
+
+        return true;
+    }
+
+    bool wrap_test()
+    {
+        Position_History history;
+        record_ticks(history, 0, 3 * POSITION_HISTORY_TICKS + 5);
+
+        // Only the last POSITION_HISTORY_TICKS are kept.
+        const Ice::Long newest = 3 * POSITION_HISTORY_TICKS + 5;
+        const Ice::Long oldest = newest - POSITION_HISTORY_TICKS + 1;
+        Position_Record state;
+        UNIT_CHECK(history.rewind(static_cast<double>(oldest - 1), state));
+        UNIT_CHECK(state.tick == oldest);
+        UNIT_CHECK(state.position.x == oldest * 10);
+
+        UNIT_CHECK(history.rewind(static_cast<double>(newest - 3), state));
+        UNIT_CHECK(state.tick == newest - 3);
+
+        return true;
+    }
+
+    bool death_test()
+    {
+        Position_History history;
+        record_ticks(history, 1, 10);
+        record_ticks(history, 11, 12, false);
+
+        VTankObject::Point spawn;
+        spawn.x = 5000;
+        spawn.y = -5000;
+        history.record(13, spawn, 0, true);
+
+        Position_Record state;
+        UNIT_CHECK(history.rewind(9.5, state));
+        UNIT_CHECK(state.alive);
+        UNIT_CHECK(history.rewind(11, state));
+        UNIT_CHECK(!state.alive);
+
+        // A respawn isn't interpolated across the map.
+        UNIT_CHECK(history.rewind(12.75, state));
+        UNIT_CHECK(!state.alive);
+        UNIT_CHECK(state.position.x == 5000);
+
+        UNIT_CHECK(history.rewind(13, state));
+        UNIT_CHECK(state.alive);
+
+        return true;
+    }
+
+    bool rewind_ticks_test()
+    {
+        const double now = 1000000;
+
+        // Fired 40 ms ago by a player 30 ms away: they saw the tanks 70 ms ago.
+        UNIT_CHECK(fabs(Lag_Compensation::get_rewind_ticks(now - 40, 30, now) -
+            70.0 / FRAME_PROCESS_INTERVAL) < 0.001);
+
+        // A clock running ahead can't make a shot come from the future.
+        UNIT_CHECK(Lag_Compensation::get_rewind_ticks(now + 500, 30, now) == 0);
+
+        UNIT_CHECK(fabs(Lag_Compensation::get_rewind_ticks(now - 5000, 30, now) -
+            static_cast<double>(DEFAULT_MAX_REWIND) / FRAME_PROCESS_INTERVAL) < 0.001);
+
+        // The limit is kept within the history.
+        Lag_Compensation::set_max_rewind(100000);
+        UNIT_CHECK(Lag_Compensation::get_max_rewind() ==
+            (POSITION_HISTORY_TICKS - 1) * FRAME_PROCESS_INTERVAL);
+
+        Lag_Compensation::set_max_rewind(0);
+        UNIT_CHECK(Lag_Compensation::get_rewind_ticks(now - 40, 30, now) == 0);
+
+        Lag_Compensation::set_max_rewind(DEFAULT_MAX_REWIND);
+
+        return true;
+    }
+}
+
+void lag_compensation_register_tests()
+{
+    UnitTestManager::register_test(rewind_test, "Lag Compensation Rewind Test");
+    UnitTestManager::register_test(wrap_test, "Lag Compensation Wrap Test");
+    UnitTestManager::register_test(death_test, "Lag Compensation Death Test");
+    UnitTestManager::register_test(rewind_ticks_test, "Lag Compensation Rewind Ticks Test");
+}
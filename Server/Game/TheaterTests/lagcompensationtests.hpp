@@ -0,0 +1,11 @@
+/*!
+    \file   lagcompensationtests.hpp
+    \brief  Unit tests for the Position_History class and the Lag_Compensation namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef LAGCOMPENSATIONTESTS_HPP
+#define LAGCOMPENSATIONTESTS_HPP
+
+extern void lag_compensation_register_tests();
+
+#endif
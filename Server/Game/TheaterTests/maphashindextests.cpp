@@ -0,0 +1,147 @@
+/*!
+    \file   maphashindextests.cpp
+    \brief  Unit tests for the Map_Hash_Index class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <maphashindex.hpp>
+#include <maphashindextests.hpp>
+#include <UnitTestManager.hpp>
+#include <cstdio>
+
+namespace {
+    const char test_file[] = "maphashindextest.tmp";
+    const char test_index[] = "maphashindextest.idx";
+    const std::string first_digest = "a9993e364706816aba3e25717850c26c9cd0d89d";
+    const std::string second_digest = "34aa973cd4c4daa4f61eeb2bdbad27316534016f";
+
+    //! Write a file holding some text.
+    bool write_file(const char *path, const std::string &contents)
+    {
+        std::ofstream out(path, std::ios_base::binary | std::ios_base::trunc);
+        out << contents;
+        return out.good();
+    }
+
+    bool hash_file_test()
+    {
+        std::string digest;
+        UNIT_CHECK(!Map_Hash_Index::hash_file("no such file.vtmap", digest));
+
+        UNIT_CHECK(write_file(test_file, "abc"));
+        UNIT_CHECK(Map_Hash_Index::hash_file(test_file, digest));
+        UNIT_CHECK(digest == first_digest);
+
+        // Big enough to be read in several blocks.
+        UNIT_CHECK(write_file(test_file, std::string(1000000, 'a')));
+        UNIT_CHECK(Map_Hash_Index::hash_file(test_file, digest));
+        UNIT_CHECK(digest == second_digest);
+
+        Ice::Long size = 0;
+        Ice::Long modified = 0;
+        UNIT_CHECK(Map_Hash_Index::get_file_info(test_file, size, modified));
+        UNIT_CHECK(size == 1000000);
+        UNIT_CHECK(modified > 0);
+        UNIT_CHECK(!Map_Hash_Index::get_file_info("no such file.vtmap", size, modified));
+
+        (void)std::remove(test_file);
+
+        return true;
+    }
+
+    bool lookup_test()
+    {
+        Map_Hash_Index index(test_index);
+        std::string digest;
+        UNIT_CHECK(!index.find_digest("map.vtmap", 100, 5, digest));
+
+        index.set_digest("map.vtmap", 100, 5, first_digest);
+        UNIT_CHECK(index.find_digest("map.vtmap", 100, 5, digest));
+        UNIT_CHECK(digest == first_digest);
+
+        // A different size or modification time means the file has to be hashed again.
+        UNIT_CHECK(!index.find_digest("map.vtmap", 101, 5, digest));
+        UNIT_CHECK(!index.find_digest("map.vtmap", 100, 6, digest));
+        UNIT_CHECK(!index.find_digest("other.vtmap", 100, 5, digest));
+
+        index.remove("map.vtmap");
+        UNIT_CHECK(!index.find_digest("map.vtmap", 100, 5, digest));
+        UNIT_CHECK(index.size() == 0);
+
+        return true;
+    }
+
+    bool verified_test()
+    {
+        Map_Hash_Index index(test_index);
+        index.set_digest("map.vtmap", 100, 5, first_digest);
+        UNIT_CHECK(!index.is_verified("map.vtmap", first_digest, 1000, 60));
+
+        index.set_verified("map.vtmap", first_digest, 1000);
+        UNIT_CHECK(index.is_verified("map.vtmap", first_digest, 1000, 60));
+        UNIT_CHECK(index.is_verified("map.vtmap", first_digest, 1059, 60));
+        UNIT_CHECK(!index.is_verified("map.vtmap", first_digest, 1060, 60));
+        UNIT_CHECK(!index.is_verified("map.vtmap", first_digest, 999, 60));
+        UNIT_CHECK(!index.is_verified("map.vtmap", second_digest, 1000, 60));
+
+        // Touching the file without changing it keeps the server's answer.
+        index.set_digest("map.vtmap", 100, 7, first_digest);
+        UNIT_CHECK(index.is_verified("map.vtmap", first_digest, 1000, 60));
+
+        // A new digest needs a new answer.
+        index.set_digest("map.vtmap", 100, 8, second_digest);
+        UNIT_CHECK(!index.is_verified("map.vtmap", second_digest, 1000, 60));
+
+        // Answers about a digest which isn't stored are ignored.
+        index.set_verified("map.vtmap", first_digest, 1000);
+        UNIT_CHECK(!index.is_verified("map.vtmap", second_digest, 1000, 60));
+        UNIT_CHECK(!index.is_verified("map.vtmap", first_digest, 1000, 60));
+
+        return true;
+    }
+
+    bool save_load_test()
+    {
+        {
+            Map_Hash_Index index(test_index);
+            index.set_digest("map.vtmap", 100, 5, first_digest);
+            index.set_verified("map.vtmap", first_digest, 1000);
+            index.set_digest("a map with spaces.vtmap", 200, 6, second_digest);
+            UNIT_CHECK(index.save());
+        }
+
+        Map_Hash_Index index(test_index);
+        UNIT_CHECK(index.load());
+        UNIT_CHECK(index.size() == 2);
+
+        std::string digest;
+        UNIT_CHECK(index.find_digest("map.vtmap", 100, 5, digest));
+        UNIT_CHECK(digest == first_digest);
+        UNIT_CHECK(index.is_verified("map.vtmap", first_digest, 1000, 60));
+        UNIT_CHECK(index.find_digest("a map with spaces.vtmap", 200, 6, digest));
+        UNIT_CHECK(digest == second_digest);
+        UNIT_CHECK(!index.is_verified("a map with spaces.vtmap", second_digest, 1000, 60));
+
+        // Damaged lines are skipped rather than failing the whole index.
+        UNIT_CHECK(write_file(test_index, "garbage\n" + first_digest + " 100 5 1000 map.vtmap\n"
+            "0123 1 2 3 short.vtmap\n" + second_digest + " 1 2\n"));
+        UNIT_CHECK(index.load());
+        UNIT_CHECK(index.size() == 1);
+        UNIT_CHECK(index.find_digest("map.vtmap", 100, 5, digest));
+
+        (void)std::remove(test_index);
+        UNIT_CHECK(!index.load());
+        UNIT_CHECK(index.size() == 0);
+
+        return true;
+    }
+}
+
+void map_hash_index_register_tests()
+{
+    UnitTestManager::register_test(hash_file_test, "Map Hash File Test");
+    UnitTestManager::register_test(lookup_test, "Map Hash Index Lookup Test");
+    UnitTestManager::register_test(verified_test, "Map Hash Index Verified Test");
+    UnitTestManager::register_test(save_load_test, "Map Hash Index Save and Load Test");
+}
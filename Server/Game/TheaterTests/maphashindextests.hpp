@@ -0,0 +1,11 @@
+/*!
+    \file   maphashindextests.hpp
+    \brief  Unit tests for the map hash index.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef MAPHASHINDEXTESTS_HPP
+#define MAPHASHINDEXTESTS_HPP
+
+extern void map_hash_index_register_tests();
+
+#endif
@@ -7,6 +7,7 @@
 #include <master.hpp>
 #include <nodemanager.hpp>
 #include <nodemanagertests.hpp>
+#include <testtanks.hpp>
 #include <UnitTestManager.hpp>
 #include <Map.hpp>
 #include <GameSession.h>
@@ -65,11 +66,96 @@ namespace {
 
         return true;
     }
+
+    bool neighbors_test()
+    {
+        // 4x4 nodes.
+        Map test_map;
+        UNIT_CHECK(test_map.create((NODE_WIDTH * 4) / TILE_SIZE, (NODE_HEIGHT * 4) / TILE_SIZE, "test"));
+
+        NodeManager node_manager;
+        node_manager.set_map(&test_map);
+
+        // Node 0 (top left), node 5 (next to it diagonally), node 3 (top right) and
+        // node 4 (start of the second row, which must not wrap around to node 3).
+        tank_array tanks;
+        tanks.push_back(make_tank(1, 10, -10));
+        tanks.push_back(make_tank(2, NODE_WIDTH + 10, -NODE_HEIGHT - 10));
+        tanks.push_back(make_tank(3, NODE_WIDTH * 3 + 10, -10));
+        tanks.push_back(make_tank(4, 10, -NODE_HEIGHT - 10));
+        for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
+            node_manager.process_position(tanks[i]);
+        }
+
+        UNIT_CHECK(tanks[2]->get_node_id() == 3);
+        UNIT_CHECK(tanks[3]->get_node_id() == 4);
+
+        // Nothing is listed until the first rebuild.
+        UNIT_CHECK(node_manager.get_neighbors(0).empty());
+
+        node_manager.rebuild(tanks);
+
+        const Node_Span corner = node_manager.get_neighbors(0);
+        UNIT_CHECK(corner.size() == 3);
+        UNIT_CHECK(contains(corner, 1) && contains(corner, 2) && contains(corner, 4));
+
+        const Node_Span right = node_manager.get_neighbors(3);
+        UNIT_CHECK(right.size() == 1);
+        UNIT_CHECK(contains(right, 3));
+        UNIT_CHECK(!node_manager.is_near(3, 4));
+
+        UNIT_CHECK(node_manager.get_neighbors(15).empty());
+        UNIT_CHECK(node_manager.get_neighbors(-1).empty());
+        UNIT_CHECK(node_manager.get_relevant_players(5).size() == 3);
+
+        // Moving a tank only shows up after the next rebuild.
+        tanks[0]->set_position(tanks[2]->get_position());
+        node_manager.process_position(tanks[0]);
+        UNIT_CHECK(contains(node_manager.get_neighbors(0), 1));
+
+        node_manager.rebuild(tanks);
+        UNIT_CHECK(!contains(node_manager.get_neighbors(0), 1));
+        UNIT_CHECK(contains(node_manager.get_neighbors(3), 1));
+
+        // Tanks that left the game drop out at the rebuild.
+        tanks.pop_back();
+        node_manager.rebuild(tanks);
+        UNIT_CHECK(node_manager.get_neighbors(0).size() == 1);
+
+        return true;
+    }
+
+    bool node_size_test()
+    {
+        Map test_map;
+        UNIT_CHECK(test_map.create(32, 32, "test"));
+
+        NodeManager node_manager;
+        node_manager.set_node_size(TILE_SIZE * 8, TILE_SIZE * 16);
+        node_manager.set_map(&test_map);
+
+        UNIT_CHECK(node_manager.get_size() == 4 * 2);
+
+        VTankObject::Point pos;
+        pos.x = TILE_SIZE * 8;
+        pos.y = -TILE_SIZE * 16;
+        UNIT_CHECK(node_manager.get_node_at(pos) == 5);
+
+        // Off the map in any direction.
+        pos.x = -1;
+        UNIT_CHECK(node_manager.get_node_at(pos) == -1);
+        pos.x = TILE_SIZE * 32;
+        UNIT_CHECK(node_manager.get_node_at(pos) == -1);
+
+        return true;
+    }
 }
 
 void node_manager_register_tests()
 {
     UnitTestManager::register_test(set_map_test, "NodeManager Set Map Test");
     UnitTestManager::register_test(node_area_test, "NodeManager Node Area Test");
+    UnitTestManager::register_test(neighbors_test, "NodeManager Neighbors Test");
+    UnitTestManager::register_test(node_size_test, "NodeManager Node Size Test");
 }
 
@@ -0,0 +1,182 @@
+/*!
+    \file   outboundqueuetests.cpp
+    \brief  Unit tests for the Outbound_Queue and Recipient_List classes.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <gameinstance.hpp>
+#include <outboundqueuetests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    //! Messages recorded by deliver(), in the order they were sent.
+    boost::mutex delivered_mutex;
+    std::vector<int> delivered;
+
+    //! Stand in for a call which Ice writes at once.
+    void deliver(const outbound_ptr &queue, const int number)
+    {
+        {
+            boost::lock_guard<boost::mutex> guard(delivered_mutex);
+            delivered.push_back(number);
+        }
+        queue->complete();
+    }
+
+    //! Stand in for a call which a client never reads, so it is never written.
+    void stall(const outbound_ptr &)
+    {
+    }
+
+    outbound_ptr make_queue(Game_Instance &arena)
+    {
+        return outbound_ptr(new Outbound_Queue(
+            GameSession::ClientEventCallbackPrx(), arena, 0));
+    }
+
+    bool delivery_test()
+    {
+        Game_Instance arena(0, -1);
+        const outbound_ptr queue = make_queue(arena);
+        delivered.clear();
+
+        const int count = OUTBOUND_BATCH_SIZE * 3 + 1;
+        for (int i = 0; i < count; ++i) {
+            queue->push(Outbound::make_message(boost::bind(&deliver, _1, i)), false);
+        }
+        Outbound::sender_pool.wait();
+
+        // Every message arrives once, in the order it was queued.
+        UNIT_CHECK(delivered.size() == count);
+        for (int i = 0; i < count; ++i) {
+            UNIT_CHECK(delivered[i] == i);
+        }
+        UNIT_CHECK(queue->size() == 0);
+        UNIT_CHECK(Atomic::load(arena.queued_messages) == 0);
+        UNIT_CHECK(arena.profiler.get_report().send_latency.get_count() == count);
+
+        return true;
+    }
+
+    bool slow_consumer_test()
+    {
+        Game_Instance arena(0, -1);
+        const Game_Instance::Scope scope(arena);
+        const outbound_ptr queue = make_queue(arena);
+        const Outbound_Queue::message_ptr message = Outbound::make_message(&stall);
+
+        // Nothing handed to Ice is ever written, so the queue stops sending once the
+        // limit is reached and starts to fill.
+        for (int i = 0; i < OUTBOUND_MAX_IN_FLIGHT; ++i) {
+            queue->push(message, false);
+        }
+        Outbound::sender_pool.wait();
+        UNIT_CHECK(queue->size() == 0);
+
+        for (int i = 0; i < OUTBOUND_QUEUE_CAPACITY - 1; ++i) {
+            queue->push(message, false);
+        }
+        queue->push(message, true);
+        UNIT_CHECK(queue->size() == OUTBOUND_QUEUE_CAPACITY);
+        UNIT_CHECK(Atomic::load(arena.queued_messages) == OUTBOUND_QUEUE_CAPACITY);
+
+        // A full queue drops its oldest droppable message to make room for a new one...
+        queue->push(message, true);
+        UNIT_CHECK(queue->size() == OUTBOUND_QUEUE_CAPACITY);
+        UNIT_CHECK(Atomic::load(arena.dropped_messages) == 1);
+        UNIT_CHECK(queue->take_dropped());
+        UNIT_CHECK(!queue->take_dropped());
+
+        // ...whether or not that one is droppable.
+        queue->push(message, false);
+        UNIT_CHECK(queue->size() == OUTBOUND_QUEUE_CAPACITY);
+        UNIT_CHECK(Atomic::load(arena.dropped_messages) == 2);
+
+        // With nothing droppable waiting, a droppable message is thrown away instead.
+        queue->push(message, true);
+        UNIT_CHECK(queue->size() == OUTBOUND_QUEUE_CAPACITY);
+        UNIT_CHECK(Atomic::load(arena.dropped_messages) == 3);
+        UNIT_CHECK(queue->take_dropped());
+
+        // With nothing left to drop, the player is given up on.
+        queue->push(message, false);
+        UNIT_CHECK(queue->size() == 0);
+        UNIT_CHECK(Atomic::load(arena.queued_messages) == 0);
+
+        queue->push(message, false);
+        UNIT_CHECK(queue->size() == 0);
+
+        // The removal finds no such player and does nothing.
+        Outbound::sender_pool.wait();
+
+        return true;
+    }
+
+    bool newest_kept_test()
+    {
+        Game_Instance arena(0, -1);
+        const Game_Instance::Scope scope(arena);
+        const outbound_ptr queue = make_queue(arena);
+        delivered.clear();
+
+        for (int i = 0; i < OUTBOUND_MAX_IN_FLIGHT; ++i) {
+            queue->push(Outbound::make_message(&stall), false);
+        }
+        Outbound::sender_pool.wait();
+
+        // One message more than fits; the first is the one dropped.
+        for (int i = 0; i <= OUTBOUND_QUEUE_CAPACITY; ++i) {
+            queue->push(Outbound::make_message(boost::bind(&deliver, _1, i)), true);
+        }
+        UNIT_CHECK(queue->size() == OUTBOUND_QUEUE_CAPACITY);
+
+        // Let the stalled messages finish so the rest are sent.
+        for (int i = 0; i < OUTBOUND_MAX_IN_FLIGHT; ++i) {
+            queue->complete();
+        }
+        Outbound::sender_pool.wait();
+
+        UNIT_CHECK(delivered.size() == OUTBOUND_QUEUE_CAPACITY);
+        UNIT_CHECK(delivered.front() == 1);
+        UNIT_CHECK(delivered.back() == OUTBOUND_QUEUE_CAPACITY);
+
+        return true;
+    }
+
+    bool recipient_list_test()
+    {
+        Game_Instance arena(0, -1);
+        Recipient_List list;
+        UNIT_CHECK(list.get()->empty());
+
+        const player_ptr first(new PlayerInfo(NULL, NULL, make_queue(arena)));
+        const player_ptr second(new PlayerInfo(NULL, NULL, make_queue(arena)));
+        list.add(1, first);
+        list.add(2, second);
+
+        const Recipient_List::recipients_ptr before = list.get();
+        UNIT_CHECK(before->size() == 2);
+        UNIT_CHECK((*before)[0].id == 1);
+        UNIT_CHECK((*before)[0].queue == first->get_outbound());
+
+        // Adding an ID again replaces the player; lists already taken don't change.
+        list.add(1, second);
+        list.remove(2);
+        const Recipient_List::recipients_ptr after = list.get();
+        UNIT_CHECK(after->size() == 1);
+        UNIT_CHECK((*after)[0].id == 1);
+        UNIT_CHECK((*after)[0].player == second);
+        UNIT_CHECK(before->size() == 2);
+
+        return true;
+    }
+}
+
+void outbound_queue_register_tests()
+{
+    UnitTestManager::register_test(delivery_test, "Outbound Queue Delivery Test");
+    UnitTestManager::register_test(slow_consumer_test, "Outbound Queue Slow Consumer Test");
+    UnitTestManager::register_test(newest_kept_test, "Outbound Queue Newest Kept Test");
+    UnitTestManager::register_test(recipient_list_test, "Recipient List Test");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   outboundqueuetests.hpp
+    \brief  Unit tests for the Outbound_Queue and Recipient_List classes.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef OUTBOUNDQUEUETESTS_HPP
+#define OUTBOUNDQUEUETESTS_HPP
+
+extern void outbound_queue_register_tests();
+
+#endif
@@ -0,0 +1,155 @@
+/*!
+    \file   pointmanagertests.cpp
+    \brief  Unit tests for the PointManager namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <pointmanager.hpp>
+#include <gameinstance.hpp>
+#include <pointmanagertests.hpp>
+#include <UnitTestManager.hpp>
+#include <GameSession.h>
+
+namespace {
+    tank_ptr make_tank(const int id, const std::string &name)
+    {
+        GameSession::Tank data;
+        data.id = id;
+        data.attributes.name = name;
+
+        return tank_ptr(new Tank(data, player_ptr(new PlayerInfo(NULL, NULL)), GameSession::NONE));
+    }
+
+    //! Give a player kills from another thread, bound to the same arena.
+    void add_kills(Game_Instance *arena, const int id, const int count)
+    {
+        const Game_Instance::Scope scope(*arena);
+        for (int i = 0; i < count; ++i) {
+            PointManager::add_kill(id);
+        }
+    }
+
+    bool counters_test()
+    {
+        Game_Instance arena(0, -1);
+        const Game_Instance::Scope scope(arena);
+        PointManager::reset();
+
+        arena.tanks.add(make_tank(0, "first"));
+        arena.tanks.add(make_tank(3, "second"));
+        PointManager::add_player(0);
+        PointManager::add_player(3);
+
+        PointManager::add_kill(0);
+        PointManager::add_kill(0);
+        PointManager::add_assist(0);
+        PointManager::add_death(3);
+        PointManager::add_objective_captured(3);
+        PointManager::add_objective_completed(3);
+
+        // Adding a player again keeps their record.
+        PointManager::add_player(0);
+
+        // Nobody was added with these IDs.
+        PointManager::add_kill(1);
+        PointManager::add_kill(-1);
+        PointManager::add_kill(STATISTICS_SLOTS);
+
+        const VTankObject::StatisticsList stats = PointManager::compile();
+        UNIT_CHECK(stats.size() == 2);
+        UNIT_CHECK(stats[0].tankName == "first");
+        UNIT_CHECK(stats[0].kills == 2);
+        UNIT_CHECK(stats[0].assists == 1);
+        UNIT_CHECK(stats[0].deaths == 0);
+        UNIT_CHECK(stats[1].tankName == "second");
+        UNIT_CHECK(stats[1].deaths == 1);
+        UNIT_CHECK(stats[1].objectivesCaptured == 1);
+        UNIT_CHECK(stats[1].objectivesCompleted == 1);
+
+        const VTankObject::StatisticsList points = PointManager::compile_and_calculate();
+        UNIT_CHECK(points.size() == 2);
+        UNIT_CHECK(points[0].calculatedPoints == 25);
+        UNIT_CHECK(points[1].calculatedPoints == 40);
+
+        PointManager::reset();
+        UNIT_CHECK(PointManager::compile(false).empty());
+
+        return true;
+    }
+
+    bool departed_test()
+    {
+        Game_Instance arena(0, -1);
+        const Game_Instance::Scope scope(arena);
+        PointManager::reset();
+
+        arena.tanks.add(make_tank(0, "leaver"));
+        arena.tanks.add(make_tank(1, "idle"));
+        PointManager::add_player(0);
+        PointManager::add_player(1);
+        PointManager::add_kill(0);
+        UNIT_CHECK(arena.tanks.remove(0));
+
+        // The scoreboard only shows who is playing, but the round still counts the leaver.
+        VTankObject::StatisticsList stats = PointManager::compile();
+        UNIT_CHECK(stats.size() == 1);
+        UNIT_CHECK(stats[0].tankName == "idle");
+
+        stats = PointManager::compile_and_calculate();
+        UNIT_CHECK(stats.size() == 1);
+        UNIT_CHECK(stats[0].tankName == "leaver");
+
+        // Someone else given the ID starts with a clean record.
+        arena.tanks.add(make_tank(0, "joiner"));
+        PointManager::add_player(0);
+        stats = PointManager::compile();
+        UNIT_CHECK(stats.size() == 2);
+        UNIT_CHECK(stats[0].tankName == "joiner");
+        UNIT_CHECK(stats[0].kills == 0);
+        UNIT_CHECK(stats[1].tankName == "idle");
+
+        // The leaver's record still counts once the ID is taken.
+        stats = PointManager::compile_and_calculate();
+        UNIT_CHECK(stats.size() == 1);
+        UNIT_CHECK(stats[0].tankName == "leaver");
+        UNIT_CHECK(stats[0].kills == 1);
+
+        return true;
+    }
+
+    bool concurrent_test()
+    {
+        const int THREADS = 4;
+        const int KILLS = 10000;
+
+        Game_Instance arena(0, -1);
+        const Game_Instance::Scope scope(arena);
+        PointManager::reset();
+
+        arena.tanks.add(make_tank(2, "busy"));
+        PointManager::add_player(2);
+
+        boost::thread_group threads;
+        for (int i = 0; i < THREADS; ++i) {
+            threads.create_thread(boost::bind(&add_kills, &arena, 2, KILLS));
+        }
+
+        // Compiling while the counters change doesn't wait for them.
+        (void)PointManager::compile();
+        threads.join_all();
+
+        const VTankObject::StatisticsList stats = PointManager::compile();
+        UNIT_CHECK(stats.size() == 1);
+        UNIT_CHECK(stats[0].kills == THREADS * KILLS);
+
+        return true;
+    }
+}
+
+void point_manager_register_tests()
+{
+    UnitTestManager::register_test(counters_test, "Point Manager Counters Test");
+    UnitTestManager::register_test(departed_test, "Point Manager Departed Player Test");
+    UnitTestManager::register_test(concurrent_test, "Point Manager Concurrent Test");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   pointmanagertests.hpp
+    \brief  Unit tests for the PointManager namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef POINTMANAGERTESTS_HPP
+#define POINTMANAGERTESTS_HPP
+
+extern void point_manager_register_tests();
+
+#endif
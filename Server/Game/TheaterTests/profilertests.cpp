@@ -0,0 +1,140 @@
+/*!
+    \file   profilertests.cpp
+    \brief  Unit tests for the Latency_Histogram and Frame_Profiler classes.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <cmath>
+#include <profiler.hpp>
+#include <profilertests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    bool bucket_test()
+    {
+        UNIT_CHECK(Latency_Histogram::get_bucket(-5) == 0);
+        UNIT_CHECK(Latency_Histogram::get_bucket(0) == 0);
+        UNIT_CHECK(Latency_Histogram::get_bucket(31) == 31);
+        UNIT_CHECK(Latency_Histogram::get_bucket(32) == 32);
+        UNIT_CHECK(Latency_Histogram::get_bucket(static_cast<Ice::Long>(1) << 40) ==
+            Latency_Histogram::BUCKET_COUNT - 1);
+
+        // Buckets never go backwards, and every value falls below its bucket's limit and
+        // at or above the previous bucket's limit.
+        int previous = 0;
+        for (Ice::Long value = 0; value < 5000000; value += 1 + value / 50) {
+            const int bucket = Latency_Histogram::get_bucket(value);
+            UNIT_CHECK(bucket >= previous);
+            UNIT_CHECK(bucket < Latency_Histogram::BUCKET_COUNT);
+            UNIT_CHECK(value < Latency_Histogram::get_bucket_limit(bucket));
+            if (bucket > 0) {
+                UNIT_CHECK(value >= Latency_Histogram::get_bucket_limit(bucket - 1));
+            }
+
+            previous = bucket;
+        }
+
+        return true;
+    }
+
+    bool percentile_test()
+    {
+        Latency_Histogram histogram;
+        UNIT_CHECK(histogram.get_count() == 0);
+        UNIT_CHECK(histogram.get_percentile(0.99) == 0);
+
+        // 1 ms to 1000 ms, one sample each.
+        for (int i = 1; i <= 1000; ++i) {
+            histogram.record(i);
+        }
+
+        UNIT_CHECK(histogram.get_count() == 1000);
+        UNIT_CHECK(std::fabs(histogram.get_mean() - 500.5) < 0.001);
+        UNIT_CHECK(histogram.get_max() == 1000);
+
+        const double fractions[] = { 0.5, 0.9, 0.99, 0.999 };
+        for (int i = 0; i < 4; ++i) {
+            const double exact = fractions[i] * 1000;
+            const double reported = histogram.get_percentile(fractions[i]);
+            UNIT_CHECK(reported >= exact);
+            UNIT_CHECK(reported <= exact * 1.07);
+        }
+
+        UNIT_CHECK(histogram.get_percentile(1.0) == 1000);
+
+        return true;
+    }
+
+    bool add_test()
+    {
+        Latency_Histogram low;
+        Latency_Histogram high;
+        for (int i = 0; i < 99; ++i) {
+            low.record(0.1);
+        }
+        high.record(50);
+
+        low.add(high);
+        UNIT_CHECK(low.get_count() == 100);
+        UNIT_CHECK(low.get_max() == 50);
+        UNIT_CHECK(low.get_percentile(0.99) <= 0.11);
+        UNIT_CHECK(low.get_percentile(0.999) == 50);
+
+        low.clear();
+        UNIT_CHECK(low.get_count() == 0);
+        UNIT_CHECK(low.get_max() == 0);
+
+        return true;
+    }
+
+    bool profiler_test()
+    {
+        Frame_Profiler profiler;
+
+        for (int tick = 0; tick < 10; ++tick) {
+            profiler.begin_tick();
+            profiler.record_input(get_precise_time() - 20);
+            profiler.end_phase(Profiler::PHASE_INPUT);
+            profiler.end_phase(Profiler::PHASE_TANKS);
+            profiler.end_phase(Profiler::PHASE_BROADCAST);
+            profiler.record_broadcast();
+            profiler.set_counter(Profiler::COUNTER_PROJECTILES, tick);
+            profiler.end_tick();
+        }
+
+        Frame_Report report = profiler.take_interval();
+        UNIT_CHECK(report.phases[Profiler::PHASE_TICK].get_count() == 10);
+        UNIT_CHECK(report.phases[Profiler::PHASE_INPUT].get_count() == 10);
+        UNIT_CHECK(report.phases[Profiler::PHASE_ROTATION].get_count() == 0);
+        UNIT_CHECK(report.input_latency.get_count() == 10);
+        UNIT_CHECK(report.input_latency.get_percentile(0.5) >= 19);
+        UNIT_CHECK(report.counters[Profiler::COUNTER_PROJECTILES].ticks == 10);
+        UNIT_CHECK(report.counters[Profiler::COUNTER_PROJECTILES].total == 45);
+        UNIT_CHECK(report.counters[Profiler::COUNTER_PROJECTILES].peak == 9);
+
+        // Input which was never broadcast isn't counted.
+        profiler.begin_tick();
+        profiler.record_input(get_precise_time());
+        profiler.end_tick();
+
+        report = profiler.take_interval();
+        UNIT_CHECK(report.phases[Profiler::PHASE_TICK].get_count() == 1);
+        UNIT_CHECK(report.input_latency.get_count() == 0);
+
+        // The whole run is kept after the intervals are taken.
+        report = profiler.get_report();
+        UNIT_CHECK(report.phases[Profiler::PHASE_TICK].get_count() == 11);
+        UNIT_CHECK(report.input_latency.get_count() == 10);
+
+        return true;
+    }
+}
+
+void profiler_register_tests()
+{
+    UnitTestManager::register_test(bucket_test, "Latency Histogram Bucket Test");
+    UnitTestManager::register_test(percentile_test, "Latency Histogram Percentile Test");
+    UnitTestManager::register_test(add_test, "Latency Histogram Add Test");
+    UnitTestManager::register_test(profiler_test, "Frame Profiler Test");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   profilertests.hpp
+    \brief  Unit tests for Latency_Histogram and Frame_Profiler.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef PROFILERTESTS_HPP
+#define PROFILERTESTS_HPP
+
+extern void profiler_register_tests();
+
+#endif
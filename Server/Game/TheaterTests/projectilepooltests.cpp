@@ -0,0 +1,211 @@
+/*!
+    \file   projectilepooltests.cpp
+    \brief  Unit tests for the Projectile_Pool class, checked against the per-projectile
+            movement it replaced.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <projectilepool.hpp>
+#include <projectilepooltests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    const double DELTA_TIME = 0.033;
+
+    Weapon make_weapon(const int id, const float initial_velocity, const float terminal_velocity,
+        const float acceleration, const float launch_angle)
+    {
+        Weapon weapon = Weapon();
+        weapon.id = id;
+        weapon.launch_angle = launch_angle;
+        weapon.projectiles_per_shot = 1;
+        weapon.projectile = Projectile();
+        weapon.projectile.id = id;
+        weapon.projectile.initial_velocity = initial_velocity;
+        weapon.projectile.terminal_velocity = terminal_velocity;
+        weapon.projectile.acceleration = acceleration;
+        weapon.projectile.range = 1000;
+        weapon.projectile.collision_radius = 8.0f;
+        weapon.projectile.environment_property = NULL;
+
+        return weapon;
+    }
+
+    Active_Projectile make_projectile(const int id, const Weapon *type, const double angle)
+    {
+        VTankObject::Point position;
+        position.x = 100 + id;
+        position.y = -200 - id;
+
+        Active_Projectile projectile(id, id % 7, angle, position, position,
+            static_cast<weapon_type_index>(type->id));
+        projectile.damage = static_cast<float>(id);
+        if (type->launch_angle > 0.0f) {
+            projectile.tip = Vector3(-20, 15, 30);
+            projectile.velocity_component = Vector3(300, -150, 900);
+        }
+
+        return projectile;
+    }
+
+    //! The movement Projectile_Manager did for each projectile before the pool.
+    struct Legacy_Projectile
+    {
+        double x, y, velocity, angle;
+        long alive;
+
+        void step(const Projectile &data, const double delta_time)
+        {
+            if (data.initial_velocity != data.terminal_velocity) {
+                if (abs(data.terminal_velocity - velocity) > 0.001) {
+                    velocity += data.acceleration * delta_time;
+                    if (velocity > data.terminal_velocity) {
+                        velocity = data.terminal_velocity;
+                    }
+                }
+            }
+
+            x += cos(angle) * (velocity * delta_time);
+            y += sin(angle) * (velocity * delta_time);
+            alive += static_cast<long>(delta_time * 1000.0);
+        }
+    };
+
+    bool integrate_linear_test()
+    {
+        const Weapon straight = make_weapon(1, 1800, 1800, 0, 0);
+        const Weapon accelerating = make_weapon(2, 1000, 1500, 250, 0);
+
+        Projectile_Pool pool;
+        std::vector<Legacy_Projectile> legacy;
+        for (int i = 0; i < 20; ++i) {
+            const Weapon *type = i % 2 == 0 ? &straight : &accelerating;
+            const Active_Projectile projectile = make_projectile(i, type, i * 0.37);
+            pool.add(projectile, *type);
+
+            Legacy_Projectile old = {projectile.position.x, projectile.position.y, 
+                type->projectile.initial_velocity, projectile.angle, 0};
+            legacy.push_back(old);
+        }
+        UNIT_CHECK(pool.get_linear_count() == 20);
+
+        for (int frame = 0; frame < 120; ++frame) {
+            pool.integrate(DELTA_TIME);
+            for (int i = 0; i < 20; ++i) {
+                const Weapon &type = i % 2 == 0 ? straight : accelerating;
+                legacy[i].step(type.projectile, DELTA_TIME);
+            }
+        }
+
+        for (int i = 0; i < 20; ++i) {
+            const Projectile_Pool::size_type slot = pool.find(i);
+            UNIT_CHECK(slot < pool.size());
+            UNIT_CHECK(abs(pool.x[slot] - legacy[i].x) < 0.0001);
+            UNIT_CHECK(abs(pool.y[slot] - legacy[i].y) < 0.0001);
+            UNIT_CHECK(abs(pool.speed[slot] - legacy[i].velocity) < 0.0001);
+            UNIT_CHECK(pool.age[slot] == legacy[i].alive);
+        }
+
+        // Accelerating shots stop at terminal velocity.
+        UNIT_CHECK(pool.speed[pool.find(1)] == 1500);
+
+        return true;
+    }
+
+    bool integrate_arcing_test()
+    {
+        const Weapon mortar = make_weapon(3, 1000, 1000, 0, 0.5f);
+
+        Projectile_Pool pool;
+        const Active_Projectile projectile = make_projectile(4, &mortar, 1.0);
+        pool.add(projectile, mortar);
+        UNIT_CHECK(pool.get_linear_count() == 0 && pool.is_arcing(0));
+
+        long alive = 0;
+        for (int frame = 0; frame < 30; ++frame) {
+            pool.integrate(DELTA_TIME);
+
+            // Placed for its age before the step, then aged.
+            const double t = static_cast<double>(alive) / 1000.0;
+            UNIT_CHECK(abs(pool.x[0] - (projectile.origin.x - 20 + 300 * t)) < 0.0001);
+            UNIT_CHECK(abs(pool.y[0] - (projectile.origin.y + 15 - 150 * t)) < 0.0001);
+            UNIT_CHECK(abs(pool.z[0] - (30 + 900 * t + 0.5 * GRAVITY * t * t)) < 0.0001);
+
+            alive += static_cast<long>(DELTA_TIME * 1000.0);
+            UNIT_CHECK(pool.age[0] == alive);
+            UNIT_CHECK(!pool.expired(0));
+        }
+
+        return true;
+    }
+
+    bool expired_test()
+    {
+        // 1000 range at 1000 per second lasts one second.
+        const Weapon slow = make_weapon(4, 1000, 1000, 0, 0);
+
+        Projectile_Pool pool;
+        pool.add(make_projectile(0, &slow, 0), slow);
+        UNIT_CHECK(pool.lifetime[0] == 1000);
+
+        pool.integrate(0.5);
+        UNIT_CHECK(!pool.expired(0));
+        pool.integrate(0.5);
+        UNIT_CHECK(pool.expired(0));
+
+        return true;
+    }
+
+    bool swap_remove_test()
+    {
+        const Weapon straight = make_weapon(1, 1800, 1800, 0, 0);
+        const Weapon mortar = make_weapon(3, 1000, 1000, 0, 0.5f);
+
+        Projectile_Pool pool;
+        std::vector<int> live;
+        unsigned long state = 1357;
+        int next_id = 0;
+        for (int step = 0; step < 2000; ++step) {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            if (live.empty() || state % 3 != 0) {
+                const Weapon *type = state % 5 == 0 ? &mortar : &straight;
+                pool.add(make_projectile(next_id, type, 0.1 * next_id), *type);
+                live.push_back(next_id++);
+            }
+            else {
+                const std::vector<int>::size_type pick = (state / 3) % live.size();
+                const Projectile_Pool::size_type slot = pool.find(live[pick]);
+                UNIT_CHECK(slot < pool.size());
+                pool.remove(slot);
+                live.erase(live.begin() + pick);
+            }
+
+            UNIT_CHECK(pool.size() == live.size());
+        }
+
+        // Every projectile is still whole and in the right block.
+        for (std::vector<int>::size_type i = 0; i < live.size(); ++i) {
+            const Projectile_Pool::size_type slot = pool.find(live[i]);
+            UNIT_CHECK(slot < pool.size());
+            UNIT_CHECK(pool.damage[slot] == static_cast<float>(live[i]));
+            UNIT_CHECK(pool.owner[slot] == live[i] % 7);
+            UNIT_CHECK(abs(pool.angle[slot] - 0.1 * live[i]) < 0.000001);
+            UNIT_CHECK(pool.is_arcing(slot) == (pool.weapon[slot] == mortar.id));
+        }
+
+        pool.clear();
+        UNIT_CHECK(pool.empty() && pool.get_linear_count() == 0);
+        UNIT_CHECK(pool.find(0) == pool.size());
+
+        return true;
+    }
+}
+
+void projectile_pool_register_tests()
+{
+    UnitTestManager::register_test(integrate_linear_test, "Projectile Pool Integrate Linear Test");
+    UnitTestManager::register_test(integrate_arcing_test, "Projectile Pool Integrate Arcing Test");
+    UnitTestManager::register_test(expired_test, "Projectile Pool Expired Test");
+    UnitTestManager::register_test(swap_remove_test, "Projectile Pool Swap Remove Test");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   projectilepooltests.hpp
+    \brief  Unit tests for Projectile_Pool.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef PROJECTILEPOOLTESTS_HPP
+#define PROJECTILEPOOLTESTS_HPP
+
+extern void projectile_pool_register_tests();
+
+#endif
@@ -0,0 +1,149 @@
+/*!
+    \file   slotallocatortests.cpp
+    \brief  Unit tests for the Slot_Allocator class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <set>
+#include <slotallocator.hpp>
+#include <slotallocatortests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    bool allocate_test()
+    {
+        Slot_Allocator ids;
+        UNIT_CHECK(ids.size() == 0);
+        UNIT_CHECK(!ids.is_valid(0));
+        UNIT_CHECK(!ids.is_valid(-1));
+
+        std::set<int> seen;
+        for (int i = 0; i < 100; ++i) {
+            const int id = ids.allocate();
+            UNIT_CHECK(id >= 0);
+            UNIT_CHECK(ids.is_valid(id));
+            UNIT_CHECK(Slot_Allocator::get_index(id) == i);
+            UNIT_CHECK(seen.insert(id).second);
+        }
+
+        UNIT_CHECK(ids.size() == 100);
+        UNIT_CHECK(ids.capacity() == 100);
+
+        return true;
+    }
+
+    bool reuse_test()
+    {
+        Slot_Allocator ids;
+        const int first = ids.allocate();
+        const int second = ids.allocate();
+
+        UNIT_CHECK(ids.release(first));
+        UNIT_CHECK(!ids.is_valid(first));
+        UNIT_CHECK(ids.is_valid(second));
+
+        // Releasing twice is refused.
+        UNIT_CHECK(!ids.release(first));
+        UNIT_CHECK(ids.size() == 1);
+
+        // The slot comes back, but under a new generation.
+        const int third = ids.allocate();
+        UNIT_CHECK(Slot_Allocator::get_index(third) == Slot_Allocator::get_index(first));
+        UNIT_CHECK(third != first);
+        UNIT_CHECK(ids.is_valid(third));
+        UNIT_CHECK(!ids.is_valid(first));
+        UNIT_CHECK(!ids.release(first));
+        UNIT_CHECK(ids.capacity() == 2);
+
+        return true;
+    }
+
+    bool generation_wrap_test()
+    {
+        Slot_Allocator ids;
+        const int first = ids.allocate();
+        int id = first;
+        for (int i = 0; i < Slot_Allocator::GENERATION_MASK; ++i) {
+            UNIT_CHECK(ids.release(id));
+            id = ids.allocate();
+            UNIT_CHECK(id != first);
+            UNIT_CHECK(id >= 0);
+        }
+
+        // After every generation has been used the IDs start over.
+        UNIT_CHECK(ids.release(id));
+        UNIT_CHECK(ids.allocate() == first);
+
+        return true;
+    }
+
+    bool clear_test()
+    {
+        Slot_Allocator ids;
+        std::vector<int> before;
+        for (int i = 0; i < 10; ++i) {
+            before.push_back(ids.allocate());
+        }
+        UNIT_CHECK(ids.release(before[3]));
+
+        ids.clear();
+        UNIT_CHECK(ids.size() == 0);
+        for (int i = 0; i < 10; ++i) {
+            UNIT_CHECK(!ids.is_valid(before[i]));
+        }
+
+        // Slots are handed out again from the lowest index.
+        for (int i = 0; i < 10; ++i) {
+            const int id = ids.allocate();
+            UNIT_CHECK(Slot_Allocator::get_index(id) == i);
+            UNIT_CHECK(std::find(before.begin(), before.end(), id) == before.end());
+        }
+        UNIT_CHECK(ids.capacity() == 10);
+
+        return true;
+    }
+
+    bool random_test()
+    {
+        Slot_Allocator ids;
+        std::vector<int> live;
+        std::set<int> live_set;
+        unsigned long state = 2468;
+        for (int step = 0; step < 5000; ++step) {
+            state = (state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+            if (live.empty() || state % 3 != 0) {
+                const int id = ids.allocate();
+                UNIT_CHECK(live_set.insert(id).second);
+                live.push_back(id);
+            }
+            else {
+                const std::vector<int>::size_type pick = (state / 3) % live.size();
+                UNIT_CHECK(ids.release(live[pick]));
+                UNIT_CHECK(!ids.is_valid(live[pick]));
+                live_set.erase(live[pick]);
+                live.erase(live.begin() + pick);
+            }
+
+            UNIT_CHECK(ids.size() == static_cast<int>(live.size()));
+        }
+
+        // Indices are recycled, so there are never more slots than IDs alive at once.
+        UNIT_CHECK(ids.capacity() <= static_cast<int>(live.size()) + 5000 / 3);
+        for (std::vector<int>::size_type i = 0; i < live.size(); ++i) {
+            UNIT_CHECK(ids.is_valid(live[i]));
+            UNIT_CHECK(Slot_Allocator::get_index(live[i]) < ids.capacity());
+        }
+
+        return true;
+    }
+}
+
+void slot_allocator_register_tests()
+{
+    UnitTestManager::register_test(allocate_test, "Slot Allocator Allocate Test");
+    UnitTestManager::register_test(reuse_test, "Slot Allocator Reuse Test");
+    UnitTestManager::register_test(generation_wrap_test, "Slot Allocator Generation Wrap Test");
+    UnitTestManager::register_test(clear_test, "Slot Allocator Clear Test");
+    UnitTestManager::register_test(random_test, "Slot Allocator Random Test");
+}
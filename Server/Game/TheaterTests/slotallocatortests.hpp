@@ -0,0 +1,11 @@
+/*!
+    \file   slotallocatortests.hpp
+    \brief  Unit tests for Slot_Allocator.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef SLOTALLOCATORTESTS_HPP
+#define SLOTALLOCATORTESTS_HPP
+
+extern void slot_allocator_register_tests();
+
+#endif
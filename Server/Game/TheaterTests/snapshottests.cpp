@@ -0,0 +1,246 @@
+/*!
+    \file   snapshottests.cpp
+    \brief  Unit tests for Snapshot_Codec and Snapshot_Channel.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <snapshot.hpp>
+#include <snapshottests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    Tank_Snapshot make_tank(const int id, const double x, const double y, const double angle)
+    {
+        Tank_Snapshot tank;
+        tank.id = id;
+        tank.x = Snapshot_Codec::quantize_position(x);
+        tank.y = Snapshot_Codec::quantize_position(y);
+        tank.angle = Snapshot_Codec::quantize_angle(angle);
+        tank.turret_angle = Snapshot_Codec::quantize_angle(angle / 2);
+        tank.movement_direction = VTankObject::FORWARD;
+        tank.rotation_direction = VTankObject::NONE;
+        tank.turret_direction = VTankObject::LEFT;
+        return tank;
+    }
+
+    Projectile_Snapshot make_projectile(const int id, const double x, const double y)
+    {
+        Projectile_Snapshot projectile;
+        projectile.id = id;
+        projectile.type_id = 3;
+        projectile.x = Snapshot_Codec::quantize_position(x);
+        projectile.y = Snapshot_Codec::quantize_position(y);
+        projectile.angle = Snapshot_Codec::quantize_angle(1.0);
+        return projectile;
+    }
+
+    //! Build a snapshot with a spread of tanks and projectiles, as a game in progress would.
+    Snapshot make_snapshot(const Ice::Long tick, const int tanks, const int projectiles)
+    {
+        Snapshot snapshot;
+        snapshot.tick = tick;
+        for (int i = 0; i < tanks; ++i) {
+            snapshot.tanks.push_back(make_tank(i * 3 + 1, 100.0 + i * 97.5, -50.0 - i * 61.25, i * 0.3));
+        }
+        for (int i = 0; i < projectiles; ++i) {
+            snapshot.projectiles.push_back(make_projectile(i + 1000, 40.0 * i, -30.0 * i));
+        }
+        return snapshot;
+    }
+
+    bool same_tank(const Tank_Snapshot &a, const Tank_Snapshot &b)
+    {
+        return a.id == b.id && a.x == b.x && a.y == b.y && a.angle == b.angle &&
+            a.turret_angle == b.turret_angle &&
+            a.movement_direction == b.movement_direction &&
+            a.rotation_direction == b.rotation_direction &&
+            a.turret_direction == b.turret_direction;
+    }
+
+    bool same_projectile(const Projectile_Snapshot &a, const Projectile_Snapshot &b)
+    {
+        return a.id == b.id && a.type_id == b.type_id && a.x == b.x && a.y == b.y &&
+            a.angle == b.angle;
+    }
+
+    bool same_snapshot(const Snapshot &a, const Snapshot &b)
+    {
+        if (a.tick != b.tick || a.tanks.size() != b.tanks.size() ||
+            a.projectiles.size() != b.projectiles.size()) {
+            return false;
+        }
+        for (std::vector<Tank_Snapshot>::size_type i = 0; i < a.tanks.size(); ++i) {
+            if (!same_tank(a.tanks[i], b.tanks[i])) {
+                return false;
+            }
+        }
+        for (std::vector<Projectile_Snapshot>::size_type i = 0; i < a.projectiles.size(); ++i) {
+            if (!same_projectile(a.projectiles[i], b.projectiles[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool quantization_test()
+    {
+        const double positions[] = { 0.0, 12.3, -12.3, 1234.5678, -98765.4321 };
+        for (unsigned int i = 0; i < sizeof(positions) / sizeof(positions[0]); ++i) {
+            const double result = Snapshot_Codec::dequantize_position(
+                Snapshot_Codec::quantize_position(positions[i]));
+            UNIT_CHECK(std::abs(result - positions[i]) <= 1.0 / 16);
+        }
+
+        const double angles[] = { 0.0, 1.0, 3.0, 6.0 };
+        for (unsigned int i = 0; i < sizeof(angles) / sizeof(angles[0]); ++i) {
+            const double result = Snapshot_Codec::dequantize_angle(
+                Snapshot_Codec::quantize_angle(angles[i]));
+            UNIT_CHECK(std::abs(result - angles[i]) < 0.001);
+        }
+
+        // Angles outside [0, 2*PI) wrap around.
+        UNIT_CHECK(Snapshot_Codec::quantize_angle(-1.0) ==
+            Snapshot_Codec::quantize_angle(2 * 3.14159265358979 - 1.0));
+
+        return true;
+    }
+
+    bool full_round_trip_test()
+    {
+        const Snapshot original = make_snapshot(1234, 16, 5);
+        std::vector<Ice::Byte> data;
+        Snapshot_Codec::encode(original, NULL, data);
+
+        Snapshot decoded;
+        UNIT_CHECK(Snapshot_Codec::decode(data, NULL, decoded));
+        UNIT_CHECK(same_snapshot(original, decoded));
+
+        // An empty snapshot survives too.
+        const Snapshot empty = make_snapshot(7, 0, 0);
+        Snapshot_Codec::encode(empty, NULL, data);
+        UNIT_CHECK(Snapshot_Codec::decode(data, NULL, decoded));
+        UNIT_CHECK(same_snapshot(empty, decoded));
+
+        return true;
+    }
+
+    bool delta_round_trip_test()
+    {
+        const Snapshot baseline = make_snapshot(100, 16, 5);
+        Snapshot current = baseline;
+        current.tick = 110;
+
+        // Small move, large move, turn, direction change.
+        current.tanks[0].x += 3;
+        current.tanks[1].y -= Snapshot_Codec::quantize_position(500.0);
+        current.tanks[2].angle += 400;
+        current.tanks[3].rotation_direction = VTankObject::RIGHT;
+
+        // One tank leaves, another joins; one projectile dies, another is fired.
+        current.tanks.erase(current.tanks.begin() + 5);
+        current.tanks.push_back(make_tank(999, 10.0, -10.0, 2.0));
+        current.projectiles.erase(current.projectiles.begin());
+        current.projectiles.push_back(make_projectile(2000, 1.0, -1.0));
+        current.projectiles[0].x += 80;
+
+        std::vector<Ice::Byte> full;
+        Snapshot_Codec::encode(current, NULL, full);
+
+        std::vector<Ice::Byte> delta;
+        Snapshot_Codec::encode(current, &baseline, delta);
+        UNIT_CHECK(delta.size() < full.size());
+
+        Snapshot decoded;
+        UNIT_CHECK(Snapshot_Codec::decode(delta, &baseline, decoded));
+        UNIT_CHECK(same_snapshot(current, decoded));
+
+        // Nothing changed at all.
+        Snapshot unchanged = baseline;
+        unchanged.tick = 101;
+        Snapshot_Codec::encode(unchanged, &baseline, delta);
+        UNIT_CHECK(Snapshot_Codec::decode(delta, &baseline, decoded));
+        UNIT_CHECK(same_snapshot(unchanged, decoded));
+
+        return true;
+    }
+
+    bool wrong_baseline_test()
+    {
+        const Snapshot baseline = make_snapshot(100, 4, 1);
+        Snapshot current = baseline;
+        current.tick = 110;
+        current.tanks[0].x += 10;
+
+        std::vector<Ice::Byte> delta;
+        Snapshot_Codec::encode(current, &baseline, delta);
+
+        Snapshot decoded;
+        const Snapshot other = make_snapshot(90, 4, 1);
+        UNIT_CHECK(!Snapshot_Codec::decode(delta, &other, decoded));
+        UNIT_CHECK(!Snapshot_Codec::decode(delta, NULL, decoded));
+
+        return true;
+    }
+
+    bool truncated_data_test()
+    {
+        const Snapshot original = make_snapshot(55, 8, 3);
+        std::vector<Ice::Byte> data;
+        Snapshot_Codec::encode(original, NULL, data);
+
+        Snapshot decoded;
+        for (std::vector<Ice::Byte>::size_type length = 0; length < data.size(); ++length) {
+            const std::vector<Ice::Byte> truncated(data.begin(), data.begin() + length);
+            UNIT_CHECK(!Snapshot_Codec::decode(truncated, NULL, decoded));
+        }
+
+        return true;
+    }
+
+    bool channel_baseline_test()
+    {
+        Snapshot_Channel channel;
+        Snapshot current = make_snapshot(10, 32, 4);
+
+        // Nothing acknowledged yet, so the first snapshot is sent in full.
+        std::vector<Ice::Byte> first;
+        channel.encode(current, first);
+        Snapshot client_state;
+        UNIT_CHECK(Snapshot_Codec::decode(first, NULL, client_state));
+
+        channel.acknowledge(client_state.tick);
+
+        const Snapshot previous = current;
+        current.tick = 20;
+        current.tanks[7].x += 5;
+
+        std::vector<Ice::Byte> second;
+        channel.encode(current, second);
+        UNIT_CHECK(second.size() < first.size());
+
+        Snapshot decoded;
+        UNIT_CHECK(Snapshot_Codec::decode(second, &previous, decoded));
+        UNIT_CHECK(same_snapshot(current, decoded));
+
+        // Acknowledging a tick that was never sent falls back to a full snapshot.
+        channel.acknowledge(15);
+        current.tick = 30;
+        std::vector<Ice::Byte> third;
+        channel.encode(current, third);
+        UNIT_CHECK(Snapshot_Codec::decode(third, NULL, decoded));
+        UNIT_CHECK(same_snapshot(current, decoded));
+
+        return true;
+    }
+}
+
+void snapshot_register_tests()
+{
+    UnitTestManager::register_test(quantization_test, "Snapshot Quantization Test");
+    UnitTestManager::register_test(full_round_trip_test, "Snapshot Full Round Trip Test");
+    UnitTestManager::register_test(delta_round_trip_test, "Snapshot Delta Round Trip Test");
+    UnitTestManager::register_test(wrong_baseline_test, "Snapshot Wrong Baseline Test");
+    UnitTestManager::register_test(truncated_data_test, "Snapshot Truncated Data Test");
+    UnitTestManager::register_test(channel_baseline_test, "Snapshot Channel Baseline Test");
+}
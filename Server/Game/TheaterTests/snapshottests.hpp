@@ -0,0 +1,11 @@
+/*!
+    \file   snapshottests.hpp
+    \brief  Unit tests for the snapshot codec.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef SNAPSHOTTESTS_HPP
+#define SNAPSHOTTESTS_HPP
+
+extern void snapshot_register_tests();
+
+#endif
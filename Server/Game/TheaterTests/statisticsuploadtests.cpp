@@ -0,0 +1,113 @@
+/*!
+    \file   statisticsuploadtests.cpp
+    \brief  Unit tests for the spool file of the Statistics_Upload namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <statisticsupload.hpp>
+#include <statisticsuploadtests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    VTankObject::Statistics make_statistics(const std::string &name, const int kills)
+    {
+        VTankObject::Statistics stats;
+        stats.tankName = name;
+        stats.kills = kills;
+        stats.assists = 2;
+        stats.deaths = 3;
+        stats.objectivesCompleted = 4;
+        stats.objectivesCaptured = 5;
+        stats.calculatedPoints = kills * 10;
+
+        return stats;
+    }
+
+    bool round_trip_test()
+    {
+        std::deque<Statistics_Upload::Round> rounds(3);
+        rounds[0].id = "first-round";
+        rounds[0].statistics.push_back(make_statistics("first", 1));
+        rounds[0].statistics.push_back(make_statistics("name with spaces", 7));
+        rounds[1].id = "empty-round";
+        rounds[2].id = "third-round";
+        rounds[2].statistics.push_back(make_statistics("third", 0));
+
+        std::stringstream spool;
+        Statistics_Upload::write_rounds(spool, rounds);
+
+        std::deque<Statistics_Upload::Round> read;
+        UNIT_CHECK(Statistics_Upload::read_rounds(spool, read));
+        UNIT_CHECK(read.size() == 3);
+        UNIT_CHECK(read[0].id == "first-round");
+        UNIT_CHECK(read[1].id == "empty-round");
+        UNIT_CHECK(read[2].id == "third-round");
+        UNIT_CHECK(read[0].statistics.size() == 2);
+        UNIT_CHECK(read[1].statistics.empty());
+        UNIT_CHECK(read[2].statistics.size() == 1);
+
+        const VTankObject::Statistics &stats = read[0].statistics[1];
+        UNIT_CHECK(stats.tankName == "name with spaces");
+        UNIT_CHECK(stats.kills == 7);
+        UNIT_CHECK(stats.assists == 2);
+        UNIT_CHECK(stats.deaths == 3);
+        UNIT_CHECK(stats.objectivesCompleted == 4);
+        UNIT_CHECK(stats.objectivesCaptured == 5);
+        UNIT_CHECK(stats.calculatedPoints == 70);
+        UNIT_CHECK(read[2].statistics[0].tankName == "third");
+
+        return true;
+    }
+
+    bool damaged_test()
+    {
+        std::deque<Statistics_Upload::Round> rounds(1);
+        rounds[0].id = "whole-round";
+        rounds[0].statistics.push_back(make_statistics("whole", 1));
+
+        std::stringstream spool;
+        Statistics_Upload::write_rounds(spool, rounds);
+
+        // A round cut short by a crash.
+        spool << "round 2\n" << "1 2 3 4 5 10 cut\n";
+
+        std::deque<Statistics_Upload::Round> read;
+        UNIT_CHECK(!Statistics_Upload::read_rounds(spool, read));
+        UNIT_CHECK(read.size() == 1);
+        UNIT_CHECK(read[0].statistics[0].tankName == "whole");
+
+        std::istringstream garbage("not a spool file\n");
+        read.clear();
+        UNIT_CHECK(!Statistics_Upload::read_rounds(garbage, read));
+        UNIT_CHECK(read.empty());
+
+        return true;
+    }
+
+    bool old_format_test()
+    {
+        // Spool files written before rounds had IDs.
+        std::istringstream spool("round 1\n1 2 3 4 5 10 old\nround 0\n");
+
+        std::deque<Statistics_Upload::Round> read;
+        UNIT_CHECK(Statistics_Upload::read_rounds(spool, read));
+        UNIT_CHECK(read.size() == 2);
+        UNIT_CHECK(read[0].statistics.size() == 1);
+        UNIT_CHECK(read[0].statistics[0].tankName == "old");
+
+        // Each is given an ID of its own.
+        UNIT_CHECK(!read[0].id.empty());
+        UNIT_CHECK(!read[1].id.empty());
+        UNIT_CHECK(read[0].id != read[1].id);
+
+        return true;
+    }
+}
+
+void statistics_upload_register_tests()
+{
+    UnitTestManager::register_test(round_trip_test, "Statistics Upload Round Trip Test");
+    UnitTestManager::register_test(damaged_test, "Statistics Upload Damaged Spool Test");
+    UnitTestManager::register_test(old_format_test, "Statistics Upload Old Spool Test");
+}
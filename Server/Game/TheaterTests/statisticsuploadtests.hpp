@@ -0,0 +1,11 @@
+/*!
+    \file   statisticsuploadtests.hpp
+    \brief  Unit tests for the spool file of the Statistics_Upload namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef STATISTICSUPLOADTESTS_HPP
+#define STATISTICSUPLOADTESTS_HPP
+
+extern void statistics_upload_register_tests();
+
+#endif
@@ -0,0 +1,182 @@
+/*!
+    \file   tankstatetests.cpp
+    \brief  Unit tests for the Tank_State_Buffer class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <tankstate.hpp>
+#include <tankstatetests.hpp>
+#include <testtanks.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    void move_all(const tank_array &tanks, const double x)
+    {
+        for (tank_array::size_type i = 0; i < tanks.size(); ++i) {
+            VTankObject::Point pos;
+            pos.x = x;
+            pos.y = -x;
+            tanks[i]->set_position(pos);
+        }
+    }
+
+    bool publish_test()
+    {
+        Tank_State_Buffer buffer;
+        {
+            const Tank_State_Buffer::Reader reader(buffer);
+            UNIT_CHECK(reader.get_states().empty());
+            UNIT_CHECK(reader.find(0) == NULL);
+        }
+
+        tank_array tanks;
+        tanks.push_back(make_tank(2, 10, -20));
+        tanks.push_back(make_tank(5, 30, -40));
+        tanks.push_back(make_tank(9, 50, -60));
+        tanks[1]->set_node_id(7);
+
+        buffer.publish(tanks, 1);
+
+        const Tank_State_Buffer::Reader reader(buffer);
+        UNIT_CHECK(reader.get_tick() == 1);
+        UNIT_CHECK(reader.get_states().size() == 3);
+
+        const Tank_State *state = reader.find(5);
+        UNIT_CHECK(state != NULL);
+        UNIT_CHECK(state->id == 5);
+        UNIT_CHECK(state->tank == tanks[1]);
+        UNIT_CHECK(state->position.x == 30 && state->position.y == -40);
+        UNIT_CHECK(state->node_id == 7);
+
+        UNIT_CHECK(reader.find(2) != NULL && reader.find(9) != NULL);
+        UNIT_CHECK(reader.find(3) == NULL);
+        UNIT_CHECK(reader.find(10) == NULL);
+
+        return true;
+    }
+
+    bool pinned_frame_test()
+    {
+        Tank_State_Buffer buffer;
+        tank_array tanks;
+        tanks.push_back(make_tank(1, 0, 0));
+
+        buffer.publish(tanks, 1);
+        const Tank_State_Buffer::Reader old_reader(buffer);
+
+        // Later ticks must not change what an existing reader sees.
+        for (int tick = 2; tick < 10; ++tick) {
+            move_all(tanks, tick);
+            buffer.publish(tanks, tick);
+
+            const Tank_State_Buffer::Reader reader(buffer);
+            UNIT_CHECK(reader.get_tick() == tick);
+            UNIT_CHECK(reader.find(1)->position.x == tick);
+        }
+
+        UNIT_CHECK(old_reader.get_tick() == 1);
+        UNIT_CHECK(old_reader.find(1)->position.x == 0);
+
+        // One frame is pinned and one is published; the writer alternates between the rest.
+        UNIT_CHECK(buffer.get_frame_count() == 3);
+
+        return true;
+    }
+
+    bool frames_reused_test()
+    {
+        Tank_State_Buffer buffer;
+        tank_array tanks;
+        tanks.push_back(make_tank(1, 0, 0));
+        tanks.push_back(make_tank(2, 0, 0));
+
+        for (int tick = 1; tick < 100; ++tick) {
+            buffer.publish(tanks, tick);
+
+            const Tank_State_Buffer::Reader reader(buffer);
+            UNIT_CHECK(reader.get_tick() == tick);
+        }
+
+        // Without long-lived readers, two frames are enough.
+        UNIT_CHECK(buffer.get_frame_count() == 2);
+
+        // A tank leaving the game shrinks the next frame.
+        tanks.pop_back();
+        buffer.publish(tanks, 100);
+
+        const Tank_State_Buffer::Reader reader(buffer);
+        UNIT_CHECK(reader.get_states().size() == 1);
+        UNIT_CHECK(reader.find(2) == NULL);
+
+        return true;
+    }
+
+    struct Concurrent_Reader
+    {
+        Tank_State_Buffer *buffer;
+        volatile bool *done;
+        bool *consistent;
+        long *frames_read;
+
+        void operator()()
+        {
+            while (!*done) {
+                const Tank_State_Buffer::Reader reader(*buffer);
+                const tank_state_array &states = reader.get_states();
+
+                // Every tank was moved to the tick's position before it was published,
+                // so a frame mixing two ticks has been written while it was read.
+                const double expected = static_cast<double>(reader.get_tick());
+                for (tank_state_array::size_type i = 0; i < states.size(); ++i) {
+                    if (states[i].position.x != expected || states[i].position.y != -expected) {
+                        *consistent = false;
+                    }
+                }
+
+                ++(*frames_read);
+            }
+        }
+    };
+
+    bool concurrent_read_test()
+    {
+        Tank_State_Buffer buffer;
+        tank_array tanks;
+        for (int i = 0; i < 64; ++i) {
+            tanks.push_back(make_tank(i, 0, 0));
+        }
+
+        volatile bool done = false;
+        bool consistent[4] = { true, true, true, true };
+        long frames_read[4] = { 0, 0, 0, 0 };
+
+        boost::thread_group readers;
+        for (int i = 0; i < 4; ++i) {
+            Concurrent_Reader reader = { &buffer, &done, &consistent[i], &frames_read[i] };
+            readers.create_thread(reader);
+        }
+
+        for (int tick = 1; tick <= 5000; ++tick) {
+            move_all(tanks, tick);
+            buffer.publish(tanks, tick);
+        }
+
+        done = true;
+        readers.join_all();
+
+        for (int i = 0; i < 4; ++i) {
+            UNIT_CHECK(consistent[i]);
+        }
+
+        return true;
+    }
+}
+
+void tank_state_register_tests()
+{
+    UnitTestManager::register_test(publish_test, "Tank State Publish Test");
+    UnitTestManager::register_test(pinned_frame_test, "Tank State Pinned Frame Test");
+    UnitTestManager::register_test(frames_reused_test, "Tank State Frames Reused Test");
+    UnitTestManager::register_test(concurrent_read_test, "Tank State Concurrent Read Test");
+}
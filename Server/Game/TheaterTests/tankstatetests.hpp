@@ -0,0 +1,11 @@
+/*!
+    \file   tankstatetests.hpp
+    \brief  Unit tests for Tank_State_Buffer.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef TANKSTATETESTS_HPP
+#define TANKSTATETESTS_HPP
+
+extern void tank_state_register_tests();
+
+#endif
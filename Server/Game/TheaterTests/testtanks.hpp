@@ -0,0 +1,51 @@
+/*!
+    \file   testtanks.hpp
+    \brief  Tanks and lookups shared by the unit tests which place tanks on a map.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef TESTTANKS_HPP
+#define TESTTANKS_HPP
+
+#include <tank.hpp>
+#include <GameSession.h>
+
+/*!
+    Make a tank which has no connection, standing at a position.
+    \param id ID of the tank.
+    \param x X coordinate of the tank.
+    \param y Y coordinate of the tank.
+    \return The new tank.
+*/
+inline tank_ptr make_tank(const int id, const double x, const double y)
+{
+    GameSession::Tank data;
+    data.id = id;
+    tank_ptr tank(new Tank(data, player_ptr(new PlayerInfo(NULL, NULL)), GameSession::NONE));
+
+    VTankObject::Point pos;
+    pos.x = x;
+    pos.y = y;
+    tank->set_position(pos);
+
+    return tank;
+}
+
+/*!
+    Check if a list of tanks, such as a tank_array or a Node_Span, holds a tank.
+    \param tanks List to search.
+    \param id ID of the tank.
+    \return True if the tank is in the list.
+*/
+template <typename T>
+bool contains(const T &tanks, const int id)
+{
+    for (typename T::size_type i = 0; i < tanks.size(); ++i) {
+        if (tanks[i]->get_id() == id) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#endif
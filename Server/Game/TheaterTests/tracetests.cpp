@@ -0,0 +1,144 @@
+/*!
+    \file   tracetests.cpp
+    \brief  Unit tests for the Trace namespace.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <trace.hpp>
+#include <tracetests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    //! Count how many times a string appears in another.
+    std::size_t count(const std::string &text, const std::string &pattern)
+    {
+        std::size_t found = 0;
+        for (std::string::size_type i = text.find(pattern); i != std::string::npos;
+            i = text.find(pattern, i + 1)) {
+            ++found;
+        }
+
+        return found;
+    }
+
+    //! Time a scope directly, since TRACE_POINT() is empty unless VTANK_TRACE is set.
+    void traced_function()
+    {
+        const Trace::Scope scope("traced_function");
+    }
+
+    bool clock_test()
+    {
+        UNIT_CHECK(Trace::get_clock_frequency() > 0);
+
+        const Ice::Long first = Trace::get_clock();
+        const Ice::Long second = Trace::get_clock();
+        UNIT_CHECK(second >= first);
+
+        return true;
+    }
+
+    bool record_test()
+    {
+        Trace::clear();
+        Trace::set_sample_rate(1);
+
+        for (int i = 0; i < 10; ++i) {
+            traced_function();
+        }
+
+        std::vector<Trace::Event> events;
+        Trace::get_thread_buffer()->copy_events(events);
+        UNIT_CHECK(events.size() == 10);
+        for (std::vector<Trace::Event>::size_type i = 0; i < events.size(); ++i) {
+            UNIT_CHECK(std::string(events[i].name) == "traced_function");
+            UNIT_CHECK(events[i].end >= events[i].start);
+        }
+
+        return true;
+    }
+
+    bool sample_test()
+    {
+        Trace::clear();
+        Trace::set_sample_rate(4);
+
+        for (int i = 0; i < 100; ++i) {
+            traced_function();
+        }
+
+        std::vector<Trace::Event> events;
+        Trace::get_thread_buffer()->copy_events(events);
+        UNIT_CHECK(events.size() == 25);
+
+        // Zero turns recording off.
+        Trace::clear();
+        Trace::set_sample_rate(0);
+        traced_function();
+
+        events.clear();
+        Trace::get_thread_buffer()->copy_events(events);
+        UNIT_CHECK(events.empty());
+
+        Trace::set_sample_rate(TRACE_SAMPLE_RATE);
+
+        return true;
+    }
+
+    bool wrap_test()
+    {
+        Trace::clear();
+        Trace::set_sample_rate(1);
+
+        for (int i = 0; i < TRACE_BUFFER_EVENTS + 10; ++i) {
+            traced_function();
+        }
+
+        // Only the newest events are kept, oldest first.
+        std::vector<Trace::Event> events;
+        Trace::get_thread_buffer()->copy_events(events);
+        UNIT_CHECK(events.size() == TRACE_BUFFER_EVENTS);
+        for (std::vector<Trace::Event>::size_type i = 1; i < events.size(); ++i) {
+            UNIT_CHECK(events[i].start >= events[i - 1].start);
+        }
+
+        Trace::set_sample_rate(TRACE_SAMPLE_RATE);
+
+        return true;
+    }
+
+    bool chrome_trace_test()
+    {
+        Trace::clear();
+        Trace::set_sample_rate(1);
+        Trace::set_thread_name("Test \"main\"");
+
+        traced_function();
+        traced_function();
+
+        std::ostringstream out;
+        UNIT_CHECK(Trace::write_chrome_trace(out) == 2);
+
+        const std::string json = out.str();
+        UNIT_CHECK(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+        UNIT_CHECK(json.find("\n]}\n") == json.size() - 4);
+        UNIT_CHECK(count(json, "\"name\":\"traced_function\"") == 2);
+        UNIT_CHECK(count(json, "\"ph\":\"X\"") == 2);
+        UNIT_CHECK(json.find("\"name\":\"Test \\\"main\\\"\"") != std::string::npos);
+
+        Trace::clear();
+        Trace::set_sample_rate(TRACE_SAMPLE_RATE);
+
+        return true;
+    }
+}
+
+void trace_register_tests()
+{
+    UnitTestManager::register_test(clock_test, "Trace Clock Test");
+    UnitTestManager::register_test(record_test, "Trace Record Test");
+    UnitTestManager::register_test(sample_test, "Trace Sample Test");
+    UnitTestManager::register_test(wrap_test, "Trace Wrap Test");
+    UnitTestManager::register_test(chrome_trace_test, "Trace Chrome Trace Test");
+}
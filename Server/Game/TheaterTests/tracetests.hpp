@@ -0,0 +1,11 @@
+/*!
+    \file   tracetests.hpp
+    \brief  Unit tests for the trace points.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef TRACETESTS_HPP
+#define TRACETESTS_HPP
+
+extern void trace_register_tests();
+
+#endif
@@ -0,0 +1,201 @@
+/*!
+    \file   weapontabletests.cpp
+    \brief  Unit tests for the Weapon_Table class.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+
+#include <master.hpp>
+#include <weapontable.hpp>
+#include <weapontabletests.hpp>
+#include <UnitTestManager.hpp>
+
+namespace {
+    EnvironmentProperty make_environment(const int id, const int damage)
+    {
+        EnvironmentProperty environment = EnvironmentProperty();
+        environment.id = id;
+        environment.minimum_damage = damage;
+        environment.maximum_damage = damage;
+
+        return environment;
+    }
+
+    Projectile make_projectile(const int id, const float velocity,
+        const EnvironmentProperty *environment)
+    {
+        Projectile projectile = Projectile();
+        projectile.id = id;
+        projectile.initial_velocity = velocity;
+        projectile.terminal_velocity = velocity;
+        projectile.range = 1000;
+        projectile.environment_property = environment;
+
+        return projectile;
+    }
+
+    Weapon make_weapon(const int id, const float cooldown, const Projectile &projectile)
+    {
+        Weapon weapon = Weapon();
+        weapon.id = id;
+        weapon.cooldown = cooldown;
+        weapon.projectiles_per_shot = 1;
+        weapon.projectile = projectile;
+
+        return weapon;
+    }
+
+    //! Weapon data as Weapon_Settings parses it: projectiles point into the parsed list.
+    struct Parsed_Data
+    {
+        Weapon_Table::environment_map environments;
+        Weapon_Table::projectile_map projectiles;
+        Weapon_Table::weapon_map weapons;
+
+        void add_environment(const int id, const int damage)
+        {
+            environments[id] = make_environment(id, damage);
+        }
+
+        void add_projectile(const int id, const float velocity, const int environment_id)
+        {
+            const EnvironmentProperty *environment = environment_id < 0 ?
+                NULL : &environments[environment_id];
+            projectiles[id] = make_projectile(id, velocity, environment);
+        }
+
+        void add_weapon(const int id, const float cooldown, const int projectile_id)
+        {
+            weapons[id] = make_weapon(id, cooldown, projectiles[projectile_id]);
+        }
+    };
+
+    bool compile_test()
+    {
+        Parsed_Data data;
+        data.add_environment(1, 5);
+        data.add_projectile(3, 1800, -1);
+        data.add_projectile(4, 1000, 1);
+        data.add_weapon(7, 0.5f, 3);
+        data.add_weapon(9, 2.0f, 4);
+
+        const Weapon_Table table(data.environments, data.projectiles, data.weapons);
+        UNIT_CHECK(table.get_environment_count() == 1);
+        UNIT_CHECK(table.get_projectile_count() == 2);
+        UNIT_CHECK(table.get_weapon_count() == 2);
+
+        weapon_type_index index = 0;
+        UNIT_CHECK(!table.find_weapon(8, index));
+        UNIT_CHECK(table.find_weapon(9, index));
+        const Weapon &weapon = table.get_weapon(index);
+        UNIT_CHECK(weapon.id == 9);
+        UNIT_CHECK(weapon.cooldown == 2.0f);
+        UNIT_CHECK(weapon.projectile.id == 4);
+        UNIT_CHECK(weapon.projectile.initial_velocity == 1000);
+
+        // Pointers from the parsed data are moved over to the table's own records.
+        weapon_type_index environment_index = 0;
+        UNIT_CHECK(table.find_environment_property(1, environment_index));
+        const EnvironmentProperty *environment =
+            &table.get_environment_property(environment_index);
+        UNIT_CHECK(weapon.projectile.environment_property == environment);
+        UNIT_CHECK(environment->minimum_damage == 5);
+
+        UNIT_CHECK(table.find_projectile(4, index));
+        UNIT_CHECK(table.get_projectile(index).environment_property == environment);
+        UNIT_CHECK(table.find_projectile(3, index));
+        UNIT_CHECK(table.get_projectile(index).environment_property == NULL);
+
+        return true;
+    }
+
+    bool alignment_test()
+    {
+        Parsed_Data data;
+        for (int i = 0; i < 10; ++i) {
+            data.add_environment(i, i);
+            data.add_projectile(i, 100.0f * (i + 1), i);
+            data.add_weapon(i, 0.1f * i, i);
+        }
+
+        const Weapon_Table table(data.environments, data.projectiles, data.weapons);
+        for (weapon_type_index i = 0; i < 10; ++i) {
+            const std::size_t weapon = reinterpret_cast<std::size_t>(&table.get_weapon(i));
+            const std::size_t projectile =
+                reinterpret_cast<std::size_t>(&table.get_projectile(i));
+            const std::size_t environment =
+                reinterpret_cast<std::size_t>(&table.get_environment_property(i));
+            UNIT_CHECK(weapon % CACHE_LINE_SIZE == 0);
+            UNIT_CHECK(projectile % CACHE_LINE_SIZE == 0);
+            UNIT_CHECK(environment % CACHE_LINE_SIZE == 0);
+            UNIT_CHECK(table.get_weapon(i).id == i);
+            UNIT_CHECK(table.get_projectile(i).id == i);
+        }
+
+        return true;
+    }
+
+    bool reload_test()
+    {
+        Parsed_Data first;
+        first.add_environment(1, 5);
+        first.add_projectile(3, 1800, 1);
+        first.add_projectile(4, 1000, -1);
+        first.add_weapon(7, 0.5f, 3);
+        first.add_weapon(9, 2.0f, 4);
+        const Weapon_Table old_table(first.environments, first.projectiles, first.weapons);
+
+        weapon_type_index old_seven = 0, old_nine = 0;
+        UNIT_CHECK(old_table.find_weapon(7, old_seven));
+        UNIT_CHECK(old_table.find_weapon(9, old_nine));
+
+        // Weapon 7 is rebalanced, weapon 9 is removed, and weapon 2 is added. The new
+        // ID sorts first, but mustn't take anybody's index.
+        Parsed_Data second;
+        second.add_environment(1, 8);
+        second.add_projectile(3, 2000, 1);
+        second.add_projectile(5, 500, -1);
+        second.add_weapon(7, 0.25f, 3);
+        second.add_weapon(2, 1.0f, 5);
+        const Weapon_Table table(second.environments, second.projectiles, second.weapons,
+            &old_table);
+
+        UNIT_CHECK(table.get_weapon_count() == 3);
+        weapon_type_index index = 0;
+        UNIT_CHECK(table.find_weapon(7, index));
+        UNIT_CHECK(index == old_seven);
+        UNIT_CHECK(table.find_weapon(9, index));
+        UNIT_CHECK(index == old_nine);
+        UNIT_CHECK(table.find_weapon(2, index));
+        UNIT_CHECK(index == 2);
+
+        const Weapon &seven = table.get_weapon(old_seven);
+        UNIT_CHECK(seven.cooldown == 0.25f);
+        UNIT_CHECK(seven.projectile.initial_velocity == 2000);
+        UNIT_CHECK(seven.projectile.environment_property->minimum_damage == 8);
+
+        weapon_type_index environment_index = 0;
+        UNIT_CHECK(table.find_environment_property(1, environment_index));
+        UNIT_CHECK(seven.projectile.environment_property ==
+            &table.get_environment_property(environment_index));
+
+        // The removed weapon still works for anybody holding its index.
+        const Weapon &nine = table.get_weapon(old_nine);
+        UNIT_CHECK(nine.id == 9);
+        UNIT_CHECK(nine.cooldown == 2.0f);
+        UNIT_CHECK(nine.projectile.initial_velocity == 1000);
+
+        // The old table is untouched.
+        const Weapon &old_seven_weapon = old_table.get_weapon(old_seven);
+        UNIT_CHECK(old_seven_weapon.cooldown == 0.5f);
+        UNIT_CHECK(old_seven_weapon.projectile.environment_property->minimum_damage == 5);
+
+        return true;
+    }
+}
+
+void weapon_table_register_tests()
+{
+    UnitTestManager::register_test(compile_test, "Weapon Table Compile Test");
+    UnitTestManager::register_test(alignment_test, "Weapon Table Alignment Test");
+    UnitTestManager::register_test(reload_test, "Weapon Table Reload Test");
+}
@@ -0,0 +1,11 @@
+/*!
+    \file   weapontabletests.hpp
+    \brief  Unit tests for Weapon_Table.
+    \author (C) Copyright 2010 by Vermont Technical College
+*/
+#ifndef WEAPONTABLETESTS_HPP
+#define WEAPONTABLETESTS_HPP
+
+extern void weapon_table_register_tests();
+
+#endif
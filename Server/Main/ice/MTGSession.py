@@ -14,9 +14,39 @@ import MainToGameSession;
 import VTankObject;
 import Procedures;
 import Map;
+import threading;
+from collections import deque;
 from time import time;
 from math import sqrt, floor;
 from Base_Servant import Base_Servant;
+from Exceptions import *;
+
+# IDs of the rounds of statistics counted most recently. A game server which didn't hear
+# back in time sends a round again, so the same round may arrive more than once.
+MAX_COUNTED_ROUNDS = 10000;
+counted_rounds = set();
+counted_order = deque();
+counted_lock = threading.Lock();
+
+def mark_round_counted(round_id):
+    """
+    Remember that a round of statistics is being counted.
+    @param round_id ID the game server gave the round.
+    @return True if the round wasn't counted before, otherwise False.
+    """
+    counted_lock.acquire();
+    try:
+        if round_id in counted_rounds:
+            return False;
+        
+        counted_rounds.add(round_id);
+        counted_order.append(round_id);
+        if len(counted_order) > MAX_COUNTED_ROUNDS:
+            counted_rounds.discard(counted_order.popleft());
+        
+        return True;
+    finally:
+        counted_lock.release();
 
 class MTGSession(MainToGameSession.MTGSession, Base_Servant):
     """
@@ -55,6 +85,9 @@ class MTGSession(MainToGameSession.MTGSession, Base_Servant):
         self.threshold = threshold;
         self.current_map = "";
         self.current_mode = VTankObject.GameMode.DEATHMATCH;
+        self.arena_count = 1;
+        self.player_arenas = {};
+        self.arena_maps = {};
     
     def __str__(self):
         return Base_Servant.__str__(self);
@@ -86,6 +119,7 @@ class MTGSession(MainToGameSession.MTGSession, Base_Servant):
             return False;
         
         del self.player_list[name];
+        self.player_arenas.pop(name, None);
         try:
             self.get_callback().RemovePlayer(name);
             
@@ -111,10 +145,27 @@ class MTGSession(MainToGameSession.MTGSession, Base_Servant):
             return False;
         
         self.player_list[tank.name] = tank;
-        self.client_prx.AddPlayer(key, name, userlevel, tank);
+        if self.arena_count > 1:
+            arena = self.get_least_loaded_arena();
+            self.player_arenas[tank.name] = arena;
+            self.client_prx.AddPlayerToArena(arena, key, name, userlevel, tank);
+        else:
+            self.client_prx.AddPlayer(key, name, userlevel, tank);
         
         return True;
     
+    def get_least_loaded_arena(self):
+        """
+        Find the arena of the game server with the fewest players.
+        @return Number of the arena, from 0.
+        """
+        counts = [0] * self.arena_count;
+        for arena in self.player_arenas.values():
+            if arena < self.arena_count:
+                counts[arena] += 1;
+        
+        return counts.index(min(counts));
+    
     def force_player_limit(self, limit):
         """
         Force the game server to accept a certain amount of players.
@@ -215,13 +266,19 @@ class MTGSession(MainToGameSession.MTGSession, Base_Servant):
         self.refresh_action();
         if key in self.player_list:
             del self.player_list[key];
+        self.player_arenas.pop(key, None);
         
-    def SendStatistics(self, statistics, current=None):
+    def SendStatistics(self, roundId, statistics, current=None):
         self.refresh_action();
         
         if len(statistics) == 0:
             return;
         
+        if not mark_round_counted(roundId):
+            self.report("Ignoring statistics round %s from %s: it was counted already." % (
+                roundId, self.name));
+            return;
+        
         # TODO: Only allow for approved servers.
         
         for statistic in statistics:
@@ -326,6 +383,19 @@ class MTGSession(MainToGameSession.MTGSession, Base_Servant):
         
         self.current_mode = mode;
         
+    def SetArenaCount(self, count, current=None):
+        self.refresh_action();
+        
+        self.arena_count = max(1, count);
+        
+    def SetArenaMap(self, arena, mapName, mode, current=None):
+        self.refresh_action();
+        
+        self.arena_maps[arena] = (mapName, mode);
+        if arena == 0:
+            self.current_map = mapName;
+            self.current_mode = mode;
+        
     def DownloadMap(self, mapName, current=None):
         self.refresh_action();
         
@@ -350,6 +420,19 @@ class MTGSession(MainToGameSession.MTGSession, Base_Servant):
         
         return vtank_map;
         
+    def DownloadMapChunk(self, mapName, offset, maxSize, current=None):
+        self.refresh_action();
+        
+        map = Map_Manager.get_manager().get_map_by_filename(mapName);
+        if not map:
+            raise BadInformationException("That map does not exist.");
+        
+        if offset == 0:
+            self.report("%s wants to download the map, %s." % (self.name, mapName));
+        
+        (total_size, data) = map.get_chunk(offset, maxSize);
+        return VTankObject.MapChunk(mapName, map.checksum(), total_size, offset, data);
+        
     def HashIsValid(self, mapFileName, hash, current=None):
         self.refresh_action();
         
@@ -13,7 +13,9 @@ import Map as _Map;
 from Base_Servant import Base_Servant;
 from Exceptions import *;
 from time import time;
-from VTankObject import Map, Tile;
+from hashlib import sha1;
+from VTankObject import Map, Tile, MapChunk;
+import Map_Compression;
 
 class MapEditorSessionI(MapEditor.MapEditorSession, Base_Servant):
     """
@@ -32,6 +34,10 @@ class MapEditorSessionI(MapEditor.MapEditorSession, Base_Servant):
         self.name       = name;
         self.database   = World.get_world().get_database();
         self.threshold  = threshold;
+        
+        # Compressed map being uploaded in chunks, and the name it will be saved under.
+        self.upload_name = None;
+        self.upload_data = None;
     
     def __str__(self):
         return Base_Servant.__str__(self);
@@ -72,6 +78,17 @@ class MapEditorSessionI(MapEditor.MapEditorSession, Base_Servant):
         
         return vtank_map;
     
+    def DownloadMapChunk(self, mapName, offset, maxSize, current=None):
+        map = Map_Manager.get_manager().get_map_by_filename(mapName);
+        if not map:
+            raise BadInformationException("That map does not exist.");
+        
+        if offset == 0:
+            self.report("%s wants to download the map, %s." % (self.name, mapName));
+        
+        (total_size, data) = map.get_chunk(offset, maxSize);
+        return MapChunk(mapName, map.checksum(), total_size, offset, data);
+    
     def UploadMap(self, map, current=None):
         self.report("%s wants to upload the map, %s." % (self.name, map.filename));
         # Validate.
@@ -90,6 +107,52 @@ class MapEditorSessionI(MapEditor.MapEditorSession, Base_Servant):
         if not Map_Manager.get_manager().save(map.filename, map_obj):
             raise BadInformationException("Database upload failed: error unknown.");
     
+    def UploadMapChunk(self, chunk, current=None):
+        if chunk.offset == 0:
+            self.report("%s wants to upload the map, %s." % (self.name, chunk.filename));
+            self.upload_name = chunk.filename;
+            self.upload_data = bytearray();
+        
+        if self.upload_data == None or chunk.filename != self.upload_name:
+            # No upload of this map is under way, so it has to start from the beginning.
+            return 0;
+        
+        if chunk.offset != len(self.upload_data):
+            # Out of order: tell the editor where to carry on from.
+            return len(self.upload_data);
+        
+        if chunk.totalSize < Map_Compression.HEADER_SIZE or \
+            len(self.upload_data) + len(chunk.data) > chunk.totalSize:
+            self.upload_name = None;
+            self.upload_data = None;
+            raise BadInformationException("Map is corrupted: chunk is past the end of the map.");
+        
+        self.upload_data += bytearray(chunk.data);
+        received = len(self.upload_data);
+        if received < chunk.totalSize:
+            return received;
+        
+        compressed = self.upload_data;
+        self.upload_name = None;
+        self.upload_data = None;
+        
+        try:
+            data = Map_Compression.decompress(compressed);
+        except ValueError, e:
+            raise BadInformationException("Map is corrupted: %s" % str(e));
+        
+        if chunk.hash and chunk.hash != sha1(data).hexdigest():
+            raise BadInformationException("Map is corrupted: its hash does not match.");
+        
+        map_obj = _Map.Map(self.reporter);
+        if not map_obj.read_map(data) or not map_obj.title or not map_obj.tiles:
+            raise BadInformationException("Map is corrupted: it cannot be read.");
+        
+        if not Map_Manager.get_manager().save(chunk.filename, map_obj):
+            raise BadInformationException("Database upload failed: error unknown.");
+        
+        return received;
+    
     def RemoveMap(self, mapName, current=None):
         if not Map_Manager.get_manager().delete(mapName):
             raise BadInformationException("Map does not exist.");
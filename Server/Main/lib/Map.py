@@ -5,6 +5,7 @@
 ###########################################################################
 from Utils import bytes_to_int, bytes_to_short, int_to_dword, short_to_word;
 from hashlib import sha1;
+import Map_Compression;
 from cStringIO import StringIO;
 
 # Version of the map format currently supported.
@@ -60,6 +61,7 @@ class Map:
     raw_data    = '';
     game_modes  = [];
     version     = 0;
+    compressed  = None;
     
     def __init__(self, reporter = None):
         """
@@ -118,6 +120,7 @@ class Map:
             self.sum            = sha1(data).hexdigest();
             self.filesize       = len(data);
             self.raw_data       = data;
+            self.compressed     = None;
             
             self.version        = ord(data[0]);
             if self.version != FORMAT_VERSION:
@@ -210,3 +213,25 @@ class Map:
         @return Binary data.
         """
         return self.raw_data;
+    
+    def get_compressed_data(self):
+        """
+        Returns the map compressed for transfer. It is compressed the first time it is asked
+        for, then cached.
+        @return Compressed data, as a string.
+        """
+        if self.compressed == None:
+            self.compressed = bytes(Map_Compression.compress(self.raw_data));
+        return self.compressed;
+    
+    def get_chunk(self, offset, max_size):
+        """
+        Returns part of the compressed map.
+        @param offset Where to start in the compressed map.
+        @param max_size Most bytes to return. Limited to Map_Compression.MAX_CHUNK_SIZE.
+        @return Tuple of (size of the whole compressed map, bytes of the chunk).
+        """
+        data = self.get_compressed_data();
+        offset = max(0, min(offset, len(data)));
+        max_size = max(1, min(max_size, Map_Compression.MAX_CHUNK_SIZE));
+        return (len(data), data[offset : offset + max_size]);
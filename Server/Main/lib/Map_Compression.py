@@ -0,0 +1,131 @@
+###########################################################################
+# \file Map_Compression.py
+# \brief Compression of map files for transfer.
+# \author (C) Copyright 2010 by Vermont Technical College
+#
+# Reads and writes the same format as Common/Cpp/MapCompression.hpp, where the
+# layout is described. Maps are sent to game servers and the map editor as
+# compressed chunks of their version 1 file.
+###########################################################################
+import struct;
+import zlib;
+
+# Shortest copy a token describes.
+MIN_MATCH = 4;
+
+# Size of the header in front of the tokens.
+HEADER_SIZE = 8;
+
+# Largest chunk of a compressed map sent at once.
+MAX_CHUNK_SIZE = 262144;
+
+# Number of slots in the table of recently seen four byte sequences.
+HASH_BITS = 16;
+
+def _write_number(out, value):
+    while value >= 0x80:
+        out.append((value & 0x7F) | 0x80);
+        value >>= 7;
+    out.append(value);
+
+def _read_number(data, pos):
+    value = 0;
+    shift = 0;
+    while pos < len(data):
+        byte = data[pos];
+        pos += 1;
+        value |= (byte & 0x7F) << shift;
+        if not byte & 0x80:
+            return (value, pos);
+        shift += 7;
+        if shift > 63:
+            break;
+    raise ValueError("Compressed map is damaged.");
+
+def _hash(data, pos):
+    value = data[pos] | (data[pos + 1] << 8) | (data[pos + 2] << 16) | (data[pos + 3] << 24);
+    return ((value * 2654435761) & 0xFFFFFFFF) >> (32 - HASH_BITS);
+
+def compress(data):
+    """
+    Compress a map. The result is byte for byte what the C++ compress() makes.
+    @param data Map to compress, usually the bytes of a version 1 map file.
+    @return Compressed map, as a bytearray.
+    """
+    data = bytearray(data);
+    out = bytearray(struct.pack("<II", len(data), zlib.adler32(bytes(data)) & 0xFFFFFFFF));
+    end = len(data);
+    last_seen = {};
+    literals = 0;
+    pos = 0;
+    while end - pos >= MIN_MATCH:
+        h = _hash(data, pos);
+        candidate = last_seen.get(h);
+        last_seen[h] = pos;
+        if candidate is None:
+            pos += 1;
+            continue;
+
+        length = 0;
+        while pos + length < end and data[candidate + length] == data[pos + length]:
+            length += 1;
+        if length < MIN_MATCH:
+            pos += 1;
+            continue;
+
+        if literals != pos:
+            _write_number(out, (pos - literals) * 2);
+            out += data[literals : pos];
+        _write_number(out, (length - MIN_MATCH) * 2 + 1);
+        _write_number(out, pos - candidate);
+
+        # Remember where the copied bytes were, so later matches can start inside them.
+        match_end = pos + length;
+        for p in xrange(pos + 1, min(match_end, end - MIN_MATCH + 1)):
+            last_seen[_hash(data, p)] = p;
+        pos = match_end;
+        literals = pos;
+
+    if literals != end:
+        _write_number(out, (end - literals) * 2);
+        out += data[literals : end];
+    return out;
+
+def decompress(compressed):
+    """
+    Expand a compressed map.
+    @param compressed Map made by compress().
+    @return Original map, as a string of bytes.
+    @raise ValueError Raised if the map is damaged.
+    """
+    compressed = bytearray(compressed);
+    if len(compressed) < HEADER_SIZE:
+        raise ValueError("Compressed map is damaged.");
+    (size, checksum) = struct.unpack("<II", bytes(compressed[:HEADER_SIZE]));
+    out = bytearray();
+    pos = HEADER_SIZE;
+    while pos < len(compressed):
+        (token, pos) = _read_number(compressed, pos);
+        length = token >> 1;
+        if not token & 1:
+            if length == 0 or pos + length > len(compressed) or len(out) + length > size:
+                raise ValueError("Compressed map is damaged.");
+            out += compressed[pos : pos + length];
+            pos += length;
+        else:
+            (distance, pos) = _read_number(compressed, pos);
+            length += MIN_MATCH;
+            if distance == 0 or distance > len(out) or len(out) + length > size:
+                raise ValueError("Compressed map is damaged.");
+            start = len(out) - distance;
+            if distance >= length:
+                out += out[start : start + length];
+            else:
+                # The copy overlaps what it produces, so repeat the last 'distance' bytes.
+                pattern = out[start:];
+                out += (pattern * (length // distance + 1))[:length];
+
+    data = bytes(out);
+    if len(out) != size or zlib.adler32(data) & 0xFFFFFFFF != checksum:
+        raise ValueError("Compressed map is damaged.");
+    return data;